@@ -45,6 +45,9 @@
 #include "ompl/base/StateValidityChecker.h"
 #include "ompl/base/util/random_utils.h"
 
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
 #include <cstdlib>
 #include <vector>
 #include <iostream>
@@ -167,6 +170,19 @@ namespace ompl
 		return m_stateValidityChecker;
 	    }
 	    
+	    /** \brief Set the function that allocates additional validity checkers (one per planning thread).
+		If this is not set, all threads use the instance passed to setStateValidityChecker() */
+	    void setStateValidityCheckerAllocator(const StateValidityCheckerAllocator &svca)
+	    {
+		m_stateValidityCheckerAllocator = svca;
+	    }
+	    
+	    /** \brief Allocate a new validity checker. Returns NULL if no allocator was set. The caller owns the returned memory */
+	    StateValidityChecker* allocStateValidityChecker(void) const
+	    {
+		return m_stateValidityCheckerAllocator ? m_stateValidityCheckerAllocator() : NULL;
+	    }
+	    
 	    /** \brief Return the dimension of the state space */
 	    unsigned int getStateDimension(void) const
 	    {
@@ -259,6 +275,90 @@ namespace ompl
 		
 	    };  
 	    
+	    /** \brief A class that maintains an array of validity
+		checkers, one for each thread of a parallel planner. The
+		checkers are allocated at construction and freed at
+		destruction, so an instance should live only as long as a
+		call to solve(): checkers may hold copies of the
+		environment that become outdated. If the space
+		information has no checker allocator, the shared checker
+		is used by all threads.
+		
+		The array can also check a batch of states in parallel
+		(checkStates()). The worker threads for this are started
+		the first time they are needed and then wait for the next
+		batch, so they are created once per instance, not once
+		per batch. */
+	    class StateValidityCheckerArray
+	    {
+	    public:
+		
+		StateValidityCheckerArray(const SpaceInformation *si, unsigned int count);
+		
+		~StateValidityCheckerArray(void);
+		
+		/** \brief Return the checker to be used by thread \e index */
+		const StateValidityChecker& operator[](unsigned int index) const
+		{
+		    return *m_svc[index];
+		}
+		
+		unsigned int getCount(void) const
+		{
+		    return m_svc.size();
+		}
+		
+		/** \brief Check a set of states. Checker \e i checks
+		    states \e i, \e i + n, \e i + 2n, ... (n is the
+		    number of checkers), so coarse coverage of the whole
+		    set is obtained first. Checker 0 runs on the calling
+		    thread and the others on worker threads. Checking
+		    stops as soon as an invalid state is found. If the
+		    checkers are not owned by this instance (no
+		    allocator was set) or there are only a few states,
+		    all states are checked on the calling thread. This
+		    function must not be called while the checkers are
+		    in use by other threads. */
+		bool checkStates(const std::vector<State*> &states);
+		
+	    private:
+		
+		/** \brief The loop of the worker thread using checker \e index */
+		void workerThread(unsigned int index);
+		
+		/** \brief Check the states of the current batch assigned to checker \e index */
+		void checkStrided(unsigned int index);
+		
+		std::vector<StateValidityChecker*> m_svc;
+		
+		/** \brief Flags indicating which checkers were allocated by this instance */
+		std::vector<bool>                  m_owned;
+		
+		/** \brief The worker threads; m_threads[i] uses checker i + 1 */
+		std::vector<boost::thread*>        m_threads;
+		
+		/* the state of the current batch; guarded by m_lock */
+		boost::mutex                       m_lock;
+		boost::condition                   m_workAvailable;
+		boost::condition                   m_workDone;
+		const std::vector<State*>         *m_states;
+		unsigned int                       m_batch;
+		unsigned int                       m_pending;
+		
+		/** \brief True until an invalid state is found in the
+		    current batch. Only written with m_lock held, but
+		    read without it while checking, so checkers can stop
+		    early without contending for the lock */
+		volatile bool                      m_valid;
+		
+		bool                               m_stop;
+		
+		/* checkers are owned; do not copy */
+		StateValidityCheckerArray(const StateValidityCheckerArray &);
+		StateValidityCheckerArray& operator=(const StateValidityCheckerArray &);
+		
+	    };
+	    
 	    /** \brief Bring the state within the bounds of the state space */
 	    void enforceBounds(base::State *state) const;
 	    
@@ -296,6 +396,7 @@ namespace ompl
 	    unsigned int                 m_stateDimension;
 	    std::vector<StateComponent>  m_stateComponent;
 	    StateValidityChecker        *m_stateValidityChecker;
+	    StateValidityCheckerAllocator m_stateValidityCheckerAllocator;
 	    StateDistanceEvaluator      *m_stateDistanceEvaluator;
 	    
 	    bool                         m_setup;
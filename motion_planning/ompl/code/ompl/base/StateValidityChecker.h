@@ -39,6 +39,7 @@
 
 #include "ompl/base/General.h"
 #include "ompl/base/State.h"
+#include <boost/function.hpp>
 
 namespace ompl
 {
@@ -59,6 +60,11 @@ namespace ompl
 	    virtual bool operator()(const State *state) const = 0;
 	};
 	
+	/** \brief A function that allocates a new validity checker. Parallel planners use it to give each
+	    of their threads its own checker, so a checker may keep per-instance data (for instance, a
+	    clone of the collision environment) instead of synchronizing access to shared data. */
+	typedef boost::function<StateValidityChecker*(void)> StateValidityCheckerAllocator;
+	
 	/** \brief A state validity checker that considers all states valid. */
 	class AllValidStateValidityChecker : public StateValidityChecker
 	{
@@ -37,10 +37,123 @@
 #include "ompl/base/SpaceInformation.h"
 #include <angles/angles.h>
 #include <ros/console.h>
+#include <boost/bind.hpp>
 #include <sstream>
 #include <cstring>
 #include <cassert>
 
+ompl::base::SpaceInformation::StateValidityCheckerArray::StateValidityCheckerArray(const SpaceInformation *si, unsigned int count) : 
+    m_svc(count), m_owned(count), m_states(NULL), m_batch(0), m_pending(0), m_valid(true), m_stop(false)
+{
+    for (unsigned int i = 0 ; i < count ; ++i)
+    {
+	m_svc[i] = si->allocStateValidityChecker();
+	m_owned[i] = m_svc[i] != NULL;
+	if (!m_owned[i])
+	    m_svc[i] = si->getStateValidityChecker();
+    }
+}
+
+ompl::base::SpaceInformation::StateValidityCheckerArray::~StateValidityCheckerArray(void)
+{
+    m_lock.lock();
+    m_stop = true;
+    m_workAvailable.notify_all();
+    m_lock.unlock();
+    for (unsigned int i = 0 ; i < m_threads.size() ; ++i)
+    {
+	m_threads[i]->join();
+	delete m_threads[i];
+    }
+    
+    for (unsigned int i = 0 ; i < m_svc.size() ; ++i)
+	if (m_owned[i])
+	    delete m_svc[i];
+}
+
+bool ompl::base::SpaceInformation::StateValidityCheckerArray::checkStates(const std::vector<State*> &states)
+{
+    /* handing states to a thread is only worth it if it has a few of them to check */
+    const unsigned int minStatesPerThread = 4;
+    const unsigned int n = m_svc.size();
+    
+    bool parallel = n > 1 && states.size() >= n * minStatesPerThread;
+    for (unsigned int i = 0 ; parallel && i < n ; ++i)
+	parallel = m_owned[i];
+    
+    if (!parallel)
+    {
+	for (unsigned int i = 0 ; i < states.size() ; ++i)
+	    if (!(*m_svc[0])(states[i]))
+		return false;
+	return true;
+    }
+    
+    if (m_threads.empty())
+    {
+	m_threads.resize(n - 1);
+	for (unsigned int i = 1 ; i < n ; ++i)
+	    m_threads[i - 1] = new boost::thread(boost::bind(&StateValidityCheckerArray::workerThread, this, i));
+    }
+    
+    m_lock.lock();
+    m_states = &states;
+    m_valid = true;
+    m_pending = n - 1;
+    m_batch++;
+    m_workAvailable.notify_all();
+    m_lock.unlock();
+    
+    checkStrided(0);
+    
+    boost::mutex::scoped_lock lock(m_lock);
+    while (m_pending > 0)
+	m_workDone.wait(lock);
+    m_states = NULL;
+    return m_valid;
+}
+
+void ompl::base::SpaceInformation::StateValidityCheckerArray::workerThread(unsigned int index)
+{
+    unsigned int batch = 0;
+    boost::mutex::scoped_lock lock(m_lock);
+    while (true)
+    {
+	while (!m_stop && m_batch == batch)
+	    m_workAvailable.wait(lock);
+	if (m_stop)
+	    break;
+	batch = m_batch;
+	
+	lock.unlock();
+	checkStrided(index);
+	lock.lock();
+	
+	if (--m_pending == 0)
+	    m_workDone.notify_all();
+    }
+}
+
+void ompl::base::SpaceInformation::StateValidityCheckerArray::checkStrided(unsigned int index)
+{
+    const std::vector<State*> &states = *m_states;
+    const StateValidityChecker &svc = *m_svc[index];
+    const unsigned int stride = m_svc.size();
+    
+    /* m_valid is read without the lock: a stale value only means a
+       few more states are checked before this thread stops */
+    for (unsigned int i = index ; i < states.size() && m_valid ; i += stride)
+    {
+	if (!svc(states[i]))
+	{
+	    m_lock.lock();
+	    m_valid = false;
+	    m_lock.unlock();
+	    break;
+	}
+    }
+}
+
 unsigned int ompl::base::SpaceInformation::StateSamplingCoreArray::getCount(void) const
 {
     return sCore.size();
@@ -55,10 +55,13 @@ namespace ompl
 		m_rangeRatio = 0.2;
 		m_maxSteps = 10;
 		m_maxEmptySteps = 3;
+		m_threadCount = 2;
+		m_svca = NULL;
 	    }
 	    
 	    virtual ~PathSmootherKinematic(void)
 	    {
+		clear();
 	    }
 	    
 	    double getRangeRatio(void) const
@@ -91,11 +94,37 @@ namespace ompl
 		m_maxEmptySteps = maxEmptySteps;
 	    }
 	    
+	    /** \brief Get the number of threads used to check motions */
+	    unsigned int getThreadCount(void) const
+	    {
+		return m_threadCount;
+	    }
+	    
+	    /** \brief Set the number of threads used to check motions. Default is 2. More
+		than one thread is used only if the space information can allocate a
+		validity checker for each thread (see
+		SpaceInformation::setStateValidityCheckerAllocator()) */
+	    void setThreadCount(unsigned int nthreads)
+	    {
+		if (nthreads == 0)
+		    nthreads = 1;
+		if (nthreads != m_threadCount)
+		    clear();
+		m_threadCount = nthreads;
+	    }
+	    
+	    /** \brief Free the validity checkers (and their worker
+		threads) that are kept from one call to the next. The
+		checkers may hold a copy of the environment, so this
+		should be called once the environment changes (at the
+		latest, when a planning request is done) */
+	    void clear(void);
+	    
 	    /** Given a path, attempt to remove vertices from it while keeping the path valid */
 	    virtual void smoothVertices(PathKinematic *path);
 	    
 	    /** Given a path, attempt to reduce redundant commands */
-	    virtual void removeRedundantCommands(PathKinematic *path) const;
+	    virtual void removeRedundantCommands(PathKinematic *path);
 	    
 	    /** Given a path, attempt to remove vertices from it while
 	     * keeping the path valid.  Then, interpolate the path, to add
@@ -106,11 +135,29 @@ namespace ompl
 	    
 	protected:
 	    
+	    /** \brief Return the validity checkers used for motion checks,
+		allocating them on first use */
+	    base::SpaceInformation::StateValidityCheckerArray& getStateValidityCheckers(void);
+	    
+	    void smoothVertices(PathKinematic *path, base::SpaceInformation::StateValidityCheckerArray &svca);
+	    void removeRedundantCommands(PathKinematic *path, base::SpaceInformation::StateValidityCheckerArray &svca) const;
+	    
 	    SpaceInformationKinematic *m_si;
 	    random_utils::RNG          m_rng;
 	    double                     m_rangeRatio;
 	    unsigned int               m_maxSteps;
 	    unsigned int               m_maxEmptySteps;
+	    unsigned int               m_threadCount;
+	    
+	    /** \brief The validity checkers shared by all calls until clear() */
+	    base::SpaceInformation::StateValidityCheckerArray *m_svca;
+	    
+	private:
+	    
+	    /* the validity checkers are owned; do not copy */
+	    PathSmootherKinematic(const PathSmootherKinematic &);
+	    PathSmootherKinematic& operator=(const PathSmootherKinematic &);
+	    
 	};    
     }
 }
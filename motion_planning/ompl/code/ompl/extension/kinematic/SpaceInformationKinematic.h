@@ -69,10 +69,30 @@ namespace ompl
 	    }
 	    
 	    /** \brief Check if the path between two motions is valid using subdivision */
-	    bool checkMotionSubdivision(const base::State *s1, const base::State *s2) const;
+	    bool checkMotionSubdivision(const base::State *s1, const base::State *s2) const
+	    {
+		return checkMotionSubdivision(s1, s2, *m_stateValidityChecker);
+	    }
+	    
+	    /** \brief Check if the path between two motions is valid using subdivision, with a specific validity checker.
+		This is meant for parallel planners, where each thread uses its own checker */
+	    bool checkMotionSubdivision(const base::State *s1, const base::State *s2, const base::StateValidityChecker &svc) const;
+	    
+	    /** \brief Check if the path between two motions is valid using subdivision. The states along the motion are
+		distributed to the checkers in \e svca, each used by a separate thread (see
+		StateValidityCheckerArray::checkStates()). Checking stops as soon as any thread finds an invalid
+		state. Short motions are checked by the calling thread only. */
+	    bool checkMotionParallel(const base::State *s1, const base::State *s2, StateValidityCheckerArray &svca) const;
 
 	    /** \brief Incrementally check if the path between two motions is valid */
 	    bool checkMotionIncremental(const base::State *s1, const base::State *s2,
+					base::State *lastValidState = NULL, double *lastValidTime = NULL) const
+	    {
+		return checkMotionIncremental(s1, s2, *m_stateValidityChecker, lastValidState, lastValidTime);
+	    }
+	    
+	    /** \brief Incrementally check if the path between two motions is valid, with a specific validity checker */
+	    bool checkMotionIncremental(const base::State *s1, const base::State *s2, const base::StateValidityChecker &svc,
 					base::State *lastValidState = NULL, double *lastValidTime = NULL) const;
 	    
 	    /** \brief Get the states that make up a motion. Returns the number of states that were added */
@@ -80,6 +100,9 @@ namespace ompl
 	    
 	    /** \brief Check if the path is valid */
 	    bool checkPath(const PathKinematic *path) const;
+	    
+	    /** \brief Check if the path is valid. The states of all the segments are checked in parallel, using the checkers in \e svca */
+	    bool checkPath(const PathKinematic *path, StateValidityCheckerArray &svca) const;
 	
 	    /** \brief Insert states in a path, at the collision checking resolution */
 	    void interpolatePath(PathKinematic *path, double factor = 1.0) const;
@@ -94,6 +117,10 @@ namespace ompl
 	    int findDifferenceStep(const base::State *s1, const base::State *s2, double factor,
 				   std::valarray<double> &step) const;
 	    
+	    /** \brief Append the states strictly between \e s1 and \e s2 at the collision checking resolution, in the order
+		a subdivision check would visit them (middle first) */
+	    void getSubdivisionStates(const base::State *s1, const base::State *s2, std::vector<base::State*> &states) const;
+	    
 	private:
 	    
 	    base::L2SquareStateDistanceEvaluator m_defaultDistanceEvaluator;
@@ -179,7 +179,7 @@ namespace ompl
 		boost::mutex lock;
 	    };
 
-	    void threadSolve(unsigned int tid, unsigned int seed, ros::WallTime &endTime, SolutionInfo *sol);
+	    void threadSolve(unsigned int tid, unsigned int seed, const base::StateValidityChecker *svc, ros::WallTime &endTime, SolutionInfo *sol);
 	    
 	    void freeMemory(void)
 	    {
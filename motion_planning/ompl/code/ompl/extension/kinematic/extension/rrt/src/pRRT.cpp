@@ -38,7 +38,7 @@
 #include <boost/thread/thread.hpp>
 #include <ros/console.h>
 
-void ompl::kinematic::pRRT::threadSolve(unsigned int tid, unsigned int seed, ros::WallTime &endTime, SolutionInfo *sol)
+void ompl::kinematic::pRRT::threadSolve(unsigned int tid, unsigned int seed, const base::StateValidityChecker *svc, ros::WallTime &endTime, SolutionInfo *sol)
 {
     random_utils::RNG rng(seed);
 
@@ -82,7 +82,7 @@ void ompl::kinematic::pRRT::threadSolve(unsigned int tid, unsigned int seed, ros
 	    xstate->values[i] = fabs(diff) < range[i] ? rmotion->state->values[i] : nmotion->state->values[i] + diff * m_rho;
 	}
 	
-	if (si->checkMotionSubdivision(nmotion->state, xstate))
+	if (si->checkMotionSubdivision(nmotion->state, xstate, *svc))
 	{
 	    /* create a motion */
 	    Motion *motion = new Motion(dim);
@@ -164,9 +164,12 @@ bool ompl::kinematic::pRRT::solve(double solveTime)
     sol.approxsol = NULL;
     sol.approxdif = INFINITY;
     
+    /* each thread checks motions with its own validity checker */
+    base::SpaceInformation::StateValidityCheckerArray svca(m_si, m_threadCount);
+    
     std::vector<boost::thread*> th(m_threadCount);
     for (unsigned int i = 0 ; i < m_threadCount ; ++i)
-	th[i] = new boost::thread(boost::bind(&pRRT::threadSolve, this, i, m_rng.uniformInt(1, 10000000), endTime, &sol));
+	th[i] = new boost::thread(boost::bind(&pRRT::threadSolve, this, i, m_rng.uniformInt(1, 10000000), &svca[i], endTime, &sol));
     for (unsigned int i = 0 ; i < m_threadCount ; ++i)
     {
 	th[i]->join();
@@ -239,7 +239,7 @@ namespace ompl
 		boost::mutex                     lock;
 	    };    
 	    
-	    void threadSolve(unsigned int tid, unsigned int seed, ros::WallTime &endTime, SolutionInfo *sol);
+	    void threadSolve(unsigned int tid, unsigned int seed, const base::StateValidityChecker *svc, ros::WallTime &endTime, SolutionInfo *sol);
 	    
 	    void freeMemory(void)
 	    {
@@ -257,8 +257,8 @@ namespace ompl
 	    void addMotion(TreeData &tree, Motion *motion);
 	    Motion* selectMotion(random_utils::RNG &rng, TreeData &tree);	
 	    void removeMotion(TreeData &tree, Motion *motion, std::map<Motion*, bool> &seen);
-	    bool isPathValid(TreeData &tree, Motion *motion);
-	    bool checkSolution(random_utils::RNG &rng, bool start, TreeData &tree, TreeData &otherTree, Motion *motion, std::vector<Motion*> &solution);
+	    bool isPathValid(const base::StateValidityChecker &svc, TreeData &tree, Motion *motion);
+	    bool checkSolution(random_utils::RNG &rng, const base::StateValidityChecker &svc, bool start, TreeData &tree, TreeData &otherTree, Motion *motion, std::vector<Motion*> &solution);
 	    
 
 	    base::SpaceInformation::StateSamplingCoreArray m_sCoreArray;
@@ -38,7 +38,7 @@
 #include <boost/thread.hpp>
 #include <ros/console.h>
 
-void ompl::kinematic::pSBL::threadSolve(unsigned int tid, unsigned int seed, ros::WallTime &endTime, SolutionInfo *sol)
+void ompl::kinematic::pSBL::threadSolve(unsigned int tid, unsigned int seed, const base::StateValidityChecker *svc, ros::WallTime &endTime, SolutionInfo *sol)
 {   
     random_utils::RNG rng(seed);
     
@@ -106,7 +106,7 @@ void ompl::kinematic::pSBL::threadSolve(unsigned int tid, unsigned int seed, ros
 	
 	addMotion(tree, motion);
 
-	if (checkSolution(rng, !startTree, tree, otherTree, motion, solution))
+	if (checkSolution(rng, *svc, !startTree, tree, otherTree, motion, solution))
 	{
 	    sol->lock.lock();
 	    if (!sol->found)
@@ -198,9 +198,12 @@ bool ompl::kinematic::pSBL::solve(double solveTime)
     sol.found = false;
     m_loopCounter = 0;
     
+    /* each thread checks motions with its own validity checker */
+    base::SpaceInformation::StateValidityCheckerArray svca(m_si, m_threadCount);
+    
     std::vector<boost::thread*> th(m_threadCount);
     for (unsigned int i = 0 ; i < m_threadCount ; ++i)
-	th[i] = new boost::thread(boost::bind(&pSBL::threadSolve, this, i, m_rng.uniformInt(1, 10000000), endTime, &sol));
+	th[i] = new boost::thread(boost::bind(&pSBL::threadSolve, this, i, m_rng.uniformInt(1, 10000000), &svca[i], endTime, &sol));
     for (unsigned int i = 0 ; i < m_threadCount ; ++i)
     {
 	th[i]->join();
@@ -213,7 +216,7 @@ bool ompl::kinematic::pSBL::solve(double solveTime)
     return goal->isAchieved();
 }
 
-bool ompl::kinematic::pSBL::checkSolution(random_utils::RNG &rng, bool start, TreeData &tree, TreeData &otherTree, Motion *motion, std::vector<Motion*> &solution)
+bool ompl::kinematic::pSBL::checkSolution(random_utils::RNG &rng, const base::StateValidityChecker &svc, bool start, TreeData &tree, TreeData &otherTree, Motion *motion, std::vector<Motion*> &solution)
 {
     Grid<MotionSet>::Coord coord;
     m_projectionEvaluator->computeCoordinates(motion->state, coord);
@@ -238,7 +241,7 @@ bool ompl::kinematic::pSBL::checkSolution(random_utils::RNG &rng, bool start, Tr
 
 	addMotion(tree, connect);
 	
-	if (isPathValid(tree, connect) && isPathValid(otherTree, connectOther))
+	if (isPathValid(svc, tree, connect) && isPathValid(svc, otherTree, connectOther))
 	{
 	    /* extract the motions and put them in solution vector */
 	    
@@ -272,7 +275,7 @@ bool ompl::kinematic::pSBL::checkSolution(random_utils::RNG &rng, bool start, Tr
     return false;
 }
 
-bool ompl::kinematic::pSBL::isPathValid(TreeData &tree, Motion *motion)
+bool ompl::kinematic::pSBL::isPathValid(const base::StateValidityChecker &svc, TreeData &tree, Motion *motion)
 {
     std::vector<Motion*>       mpath;
     SpaceInformationKinematic *si = static_cast<SpaceInformationKinematic*>(m_si);
@@ -292,7 +295,7 @@ bool ompl::kinematic::pSBL::isPathValid(TreeData &tree, Motion *motion)
 	mpath[i]->lock.lock();
 	if (!mpath[i]->valid)
 	{
-	    if (si->checkMotionSubdivision(mpath[i]->parent->state, mpath[i]->state))
+	    if (si->checkMotionSubdivision(mpath[i]->parent->state, mpath[i]->state, svc))
 		mpath[i]->valid = true;
 	    else
 	    {
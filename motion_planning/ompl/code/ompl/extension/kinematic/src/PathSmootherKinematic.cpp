@@ -37,7 +37,31 @@
 #include "ompl/extension/kinematic/PathSmootherKinematic.h"
 #include <cstdlib>
 
+void ompl::kinematic::PathSmootherKinematic::clear(void)
+{
+    if (m_svca)
+    {
+	delete m_svca;
+	m_svca = NULL;
+    }
+}
+
+ompl::base::SpaceInformation::StateValidityCheckerArray& ompl::kinematic::PathSmootherKinematic::getStateValidityCheckers(void)
+{
+    if (!m_svca)
+	m_svca = new base::SpaceInformation::StateValidityCheckerArray(m_si, m_threadCount);
+    return *m_svca;
+}
+
 void ompl::kinematic::PathSmootherKinematic::smoothVertices(PathKinematic *path)
+{
+    if (!path || path->states.size() < 3)
+	return;    
+    
+    smoothVertices(path, getStateValidityCheckers());
+}
+
+void ompl::kinematic::PathSmootherKinematic::smoothVertices(PathKinematic *path, base::SpaceInformation::StateValidityCheckerArray &svca)
 {
     if (!path || path->states.size() < 3)
 	return;    
@@ -66,7 +90,7 @@ void ompl::kinematic::PathSmootherKinematic::smoothVertices(PathKinematic *path)
 	if (p1 > p2)
 	    std::swap(p1, p2);
 	
-	if (m_si->checkMotionSubdivision(path->states[p1], path->states[p2]))
+	if (m_si->checkMotionParallel(path->states[p1], path->states[p2], svca))
 	{
 	    for (int i = p1 + 1 ; i < p2 ; ++i)
 		delete path->states[i];
@@ -78,13 +102,23 @@ void ompl::kinematic::PathSmootherKinematic::smoothVertices(PathKinematic *path)
 
 void ompl::kinematic::PathSmootherKinematic::smoothMax(PathKinematic *path)
 {
-    smoothVertices(path);
+    /* the same checkers (and worker threads) are used for all the steps */
+    base::SpaceInformation::StateValidityCheckerArray &svca = getStateValidityCheckers();
+    smoothVertices(path, svca);
     m_si->interpolatePath(path, 3.0);
-    smoothVertices(path);
-    removeRedundantCommands(path);    
+    smoothVertices(path, svca);
+    removeRedundantCommands(path, svca);    
+}
+
+void ompl::kinematic::PathSmootherKinematic::removeRedundantCommands(PathKinematic *path)
+{
+    if (!path || path->states.size() < 3)
+	return;
+    
+    removeRedundantCommands(path, getStateValidityCheckers());
 }
 
-void ompl::kinematic::PathSmootherKinematic::removeRedundantCommands(PathKinematic *path) const
+void ompl::kinematic::PathSmootherKinematic::removeRedundantCommands(PathKinematic *path, base::SpaceInformation::StateValidityCheckerArray &svca) const
 {
     if (!path || path->states.size() < 3)
 	return;
@@ -112,11 +146,7 @@ void ompl::kinematic::PathSmootherKinematic::removeRedundantCommands(PathKinemat
 	
 	if (diff)
 	{
-	    bool change_back = false;	
-	    for (int j = 0 ; change_back && j < last ; ++j)
-		if (!m_si->checkMotionSubdivision(path->states[j], path->states[j + 1]))
-		    change_back = true;
-	    if (change_back)
+	    if (!m_si->checkPath(path, svca))
 	    {
 		for (int j = 1 ; j < last ; ++j)
 		    path->states[j]->values[i] = backup[j];
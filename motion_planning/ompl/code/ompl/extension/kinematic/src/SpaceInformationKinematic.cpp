@@ -46,10 +46,11 @@ void ompl::kinematic::SpaceInformationKinematic::setup(void)
     SpaceInformation::setup();
 }
 
-bool ompl::kinematic::SpaceInformationKinematic::checkMotionSubdivision(const base::State *s1, const base::State *s2) const
+bool ompl::kinematic::SpaceInformationKinematic::checkMotionSubdivision(const base::State *s1, const base::State *s2,
+									const base::StateValidityChecker &svc) const
 {
     /* assume motion starts in a valid configuration so s1 is valid */
-    if (!isValid(s2))
+    if (!svc(s2))
 	return false;
     
     std::valarray<double> step;
@@ -73,7 +74,7 @@ bool ompl::kinematic::SpaceInformationKinematic::checkMotionSubdivision(const ba
 	for (unsigned int j = 0 ; j < m_stateDimension ; ++j)
 	    test.values[j] = s1->values[j] + (double)mid * step[j];
 	
-	if (!isValid(&test))
+	if (!svc(&test))
 	    return false;
 	
 	pos.pop();
@@ -87,11 +88,11 @@ bool ompl::kinematic::SpaceInformationKinematic::checkMotionSubdivision(const ba
     return true;
 }
 
-bool ompl::kinematic::SpaceInformationKinematic::checkMotionIncremental(const base::State *s1, const base::State *s2,
+bool ompl::kinematic::SpaceInformationKinematic::checkMotionIncremental(const base::State *s1, const base::State *s2, const base::StateValidityChecker &svc,
 									base::State *lastValidState, double *lastValidTime) const
 {   
     /* assume motion starts in a valid configuration so s1 is valid */
-    if (!isValid(s2))
+    if (!svc(s2))
 	return false;
     
     std::valarray<double> step;
@@ -105,7 +106,7 @@ bool ompl::kinematic::SpaceInformationKinematic::checkMotionIncremental(const ba
 	double factor = (double)j;
 	for (unsigned int k = 0 ; k < m_stateDimension ; ++k)
 	    test.values[k] = s1->values[k] + factor * step[k];
-	if (!isValid(&test))
+	if (!svc(&test))
 	{
 	    if (lastValidState)
 	    {
@@ -140,6 +141,79 @@ bool ompl::kinematic::SpaceInformationKinematic::checkPath(const PathKinematic *
     return result;
 }
 
+bool ompl::kinematic::SpaceInformationKinematic::checkPath(const PathKinematic *path, StateValidityCheckerArray &svca) const
+{
+    if (path == NULL)
+	return false;
+    if (path->states.empty())
+	return true;
+    if (!svca[0](path->states[0]))
+	return false;
+    
+    /* gather the states of all segments, so they are checked in one parallel pass */
+    std::vector<base::State*> interpolated;
+    std::vector<base::State*> states;
+    const int last = path->states.size() - 1;
+    for (int j = 0 ; j < last ; ++j)
+    {
+	states.push_back(path->states[j + 1]);
+	const unsigned int first = interpolated.size();
+	getSubdivisionStates(path->states[j], path->states[j + 1], interpolated);
+	states.insert(states.end(), interpolated.begin() + first, interpolated.end());
+    }
+    
+    bool result = svca.checkStates(states);
+    
+    for (unsigned int i = 0 ; i < interpolated.size() ; ++i)
+	delete interpolated[i];
+    
+    return result;
+}
+
+bool ompl::kinematic::SpaceInformationKinematic::checkMotionParallel(const base::State *s1, const base::State *s2,
+								     StateValidityCheckerArray &svca) const
+{
+    /* assume motion starts in a valid configuration so s1 is valid */
+    if (!svca[0](s2))
+	return false;
+    
+    std::vector<base::State*> states;
+    getSubdivisionStates(s1, s2, states);
+    bool result = svca.checkStates(states);
+    for (unsigned int i = 0 ; i < states.size() ; ++i)
+	delete states[i];
+    
+    return result;
+}
+
+void ompl::kinematic::SpaceInformationKinematic::getSubdivisionStates(const base::State *s1, const base::State *s2,
+								      std::vector<base::State*> &states) const
+{
+    std::valarray<double> step;
+    int nd = findDifferenceStep(s1, s2, 1.0, step);
+    
+    std::queue< std::pair<int, int> > pos;
+    if (nd >= 2)
+	pos.push(std::make_pair(1, nd - 1));
+    
+    while (!pos.empty())
+    {
+	std::pair<int, int> x = pos.front();
+	pos.pop();
+	
+	int mid = (x.first + x.second) / 2;
+	base::State *state = new base::State(m_stateDimension);
+	for (unsigned int j = 0 ; j < m_stateDimension ; ++j)
+	    state->values[j] = s1->values[j] + (double)mid * step[j];
+	states.push_back(state);
+	
+	if (x.first < mid)
+	    pos.push(std::make_pair(x.first, mid - 1));
+	if (x.second > mid)
+	    pos.push(std::make_pair(mid + 1, x.second));
+    }
+}
+
 void ompl::kinematic::SpaceInformationKinematic::interpolatePath(PathKinematic *path, double factor) const
 {
     std::vector<base::State*> newStates;
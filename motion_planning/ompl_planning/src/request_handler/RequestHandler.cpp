@@ -192,9 +192,7 @@ void ompl_planning::RequestHandler::configure(const planning_models::KinematicSt
     ompl::base::State *start = new ompl::base::State(dim);
     
     /* set the pose of the whole robot */
-    ompl_ros::EnvironmentDescription *ed = psetup->ompl_model->getEnvironmentDescription();
-    ed->kmodel->computeTransforms(startState->getParams());
-    ed->collisionSpace->updateRobotModel();
+    psetup->ompl_model->setRobotState(startState->getParams());
     
     /* extract the components needed for the start state of the desired group */
     startState->copyParamsGroup(start->values, psetup->ompl_model->group);
@@ -263,8 +261,12 @@ bool ompl_planning::RequestHandler::computePlan(ModelMap &models, const planning
     
     ROS_INFO("Selected motion planner: '%s', with priority %d", req.planner_id.c_str(), psetup->priority);
     
+    /* the kinematic model is only read while planning (forward
+       kinematics go to the transforms of each environment
+       description), so only the environment model is locked; this
+       also keeps bodies from being attached to the robot while we
+       plan */
     m->planningMonitor->getEnvironmentModel()->lock();
-    m->planningMonitor->getKinematicModel()->lock();
 
     // configure the planner
     configure(start, req, psetup);
@@ -277,7 +279,6 @@ bool ompl_planning::RequestHandler::computePlan(ModelMap &models, const planning
     callPlanner(psetup, req.times, req.allowed_time, sol);
     
     m->planningMonitor->getEnvironmentModel()->unlock();
-    m->planningMonitor->getKinematicModel()->unlock();
 
     psetup->ompl_model->si->clearGoal();
     psetup->ompl_model->si->clearStartStates();
@@ -442,6 +443,10 @@ bool ompl_planning::RequestHandler::callPlanner(PlannerSetup *psetup, int times,
 	    psetup->mp->clear();	    
 	}
 	
+	/* the smoother's validity checkers hold a copy of this request's environment */
+	if (psetup->smoother)
+	    psetup->smoother->clear();
+	
 	ROS_DEBUG("Total planning time: %g; Average planning time: %g", totalTime, (totalTime / (double)times));
     }
     return result;
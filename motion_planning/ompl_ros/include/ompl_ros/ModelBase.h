@@ -39,8 +39,10 @@
 
 #include <planning_environment/monitors/planning_monitor.h>
 #include <planning_environment/util/kinematic_state_constraint_evaluator.h>
+#include <planning_models/kinematic_transforms.h>
 #include <ompl/base/SpaceInformation.h>
 #include <string>
+#include <vector>
 #include <map>
 
 namespace ompl_ros
@@ -57,6 +59,11 @@ namespace ompl_ros
 	/** \brief The group instance */
 	planning_models::KinematicModel::JointGroup                 *group;
 	const planning_environment::KinematicConstraintEvaluatorSet *constraintEvaluator;	
+
+	/** \brief Forward kinematics for this description. Planning
+	    only updates these transforms, so the kinematic model
+	    (which may be shared with other threads) is only read. */
+	planning_models::KinematicTransforms                        *transforms;
     };
     
     /** \brief The basic definition of a model (a group defined by the planning environment) we are planning for */
@@ -74,6 +81,21 @@ namespace ompl_ros
 	/** \brief Clear the created environment descriptions */
 	void clearEnvironmentDescriptions(void) const;
 	
+	/** \brief Create an environment description that is not
+	    associated to any thread: the collision space and the
+	    constraints are cloned. Free it with freeEnvironmentDescription() */
+	EnvironmentDescription* createEnvironmentDescription(void) const;
+	
+	/** \brief Free an environment description made by createEnvironmentDescription() */
+	void freeEnvironmentDescription(EnvironmentDescription *ed) const;
+
+	/** \brief Set the state of the whole robot. The transforms of
+	    the environment descriptions that exist (and of the ones
+	    created later) are computed for this state, so links
+	    outside the planning group are where this state puts
+	    them. */
+	void setRobotState(const double *params);
+	
 	/** \brief An instance of a planning monitor that knows about the planning groups */
 	planning_environment::PlanningMonitor                      *planningMonitor;
 
@@ -85,10 +107,18 @@ namespace ompl_ros
 	
 	/** \brief The group instance */
 	planning_models::KinematicModel::JointGroup                *group;
+
+	/** \brief The state of the whole robot, as set by setRobotState() */
+	std::vector<double>                                         robotState;
 	
 	/** \brief The instance of the space information maintained for this group. si->setup() will need to be called after configure() */
 	ompl::base::SpaceInformation                               *si;
 	std::map<std::string, ompl::base::StateDistanceEvaluator*>  sde;        // list of available distance evaluators
+
+    protected:
+	
+	/** \brief Allocate the transforms of an environment description, computed for robotState */
+	planning_models::KinematicTransforms* createTransforms(const planning_models::KinematicModel *kmodel) const;
     };
     
 } // ompl_ros
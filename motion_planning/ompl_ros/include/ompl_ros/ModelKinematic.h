@@ -58,6 +58,9 @@ namespace ompl_ros
 	}
 	
 	virtual bool configure(void);
+	
+	/** \brief Allocate a validity checker with its own copy of the collision space; used by parallel planners */
+	ompl::base::StateValidityChecker* allocStateValidityChecker(void);
     };
 
 } // ompl_ros
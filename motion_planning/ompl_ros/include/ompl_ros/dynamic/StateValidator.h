@@ -74,7 +74,7 @@ namespace ompl_ros
     protected:
 	
 	bool check(const ompl::base::State *s, collision_space::EnvironmentModel *em, planning_models::KinematicModel::JointGroup *jg,
-		   const planning_environment::KinematicConstraintEvaluatorSet *kce) const;
+		   const planning_environment::KinematicConstraintEvaluatorSet *kce, planning_models::KinematicTransforms *kt) const;
 	
 	ModelBase                  *model_;
 	ROSSpaceInformationDynamic *dsi_;
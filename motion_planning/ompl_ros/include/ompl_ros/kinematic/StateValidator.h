@@ -54,10 +54,23 @@ namespace ompl_ros
         ROSStateValidityPredicateKinematic(ROSSpaceInformationKinematic *si, ModelBase *model) : ompl::base::StateValidityChecker()
 	{
 	    model_ = model;
+	    ed_ = NULL;
+	}
+	
+	/** \brief Construct a checker that uses its own environment
+	    description (made by ModelBase::createEnvironmentDescription())
+	    instead of looking up the one of the calling thread. The
+	    description is freed when the checker is destroyed. */
+        ROSStateValidityPredicateKinematic(ROSSpaceInformationKinematic *si, ModelBase *model, EnvironmentDescription *ed) : ompl::base::StateValidityChecker()
+	{
+	    model_ = model;
+	    ed_ = ed;
 	}
 	
 	virtual ~ROSStateValidityPredicateKinematic(void)
 	{
+	    if (ed_)
+		model_->freeEnvironmentDescription(ed_);
 	}
 	
 	virtual bool operator()(const ompl::base::State *s) const;
@@ -74,9 +87,10 @@ namespace ompl_ros
     protected:
 	
 	bool check(const ompl::base::State *s, collision_space::EnvironmentModel *em, planning_models::KinematicModel::JointGroup *jg,
-		   const planning_environment::KinematicConstraintEvaluatorSet *kce) const;
+		   const planning_environment::KinematicConstraintEvaluatorSet *kce, planning_models::KinematicTransforms *kt) const;
 	
-	ModelBase *model_;
+	ModelBase              *model_;
+	EnvironmentDescription *ed_;
     };
     
 } // ompl_ros
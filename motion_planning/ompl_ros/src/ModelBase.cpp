@@ -64,6 +64,27 @@ ompl_ros::ModelBase::~ModelBase(void)
 	delete si;
 }
 
+planning_models::KinematicTransforms* ompl_ros::ModelBase::createTransforms(const planning_models::KinematicModel *kmodel) const
+{
+    planning_models::KinematicTransforms *kt = new planning_models::KinematicTransforms(kmodel);
+    if (!robotState.empty())
+	kt->computeTransforms(&robotState[0]);
+    return kt;
+}
+
+void ompl_ros::ModelBase::setRobotState(const double *params)
+{
+    robotState.assign(params, params + planningMonitor->getKinematicModel()->getDimension());
+    
+    lockENVS.lock();
+    for (std::map<boost::thread::id, EnvironmentDescription*>::iterator it = ENVS.begin() ; it != ENVS.end() ; ++it)
+    {
+	it->second->transforms->setRootTransform(it->second->kmodel->getRootTransform());
+	it->second->transforms->computeTransforms(params);
+    }
+    lockENVS.unlock();
+}
+
 ompl_ros::EnvironmentDescription* ompl_ros::ModelBase::getEnvironmentDescription(void) const
 {
     boost::thread::id id = boost::this_thread::get_id();
@@ -80,18 +101,12 @@ ompl_ros::EnvironmentDescription* ompl_ros::ModelBase::getEnvironmentDescription
 	    result->kmodel = result->collisionSpace->getRobotModel().get();
 	    result->constraintEvaluator = &constraintEvaluator;
 	    result->group = group;
+	    result->transforms = createTransforms(result->kmodel);
 	}
 	else
 	{
 	    ROS_DEBUG("Cloning collision environment (%d total)", (int)ENVS.size() + 1);
-	    result = new EnvironmentDescription();
-	    result->collisionSpace = planningMonitor->getEnvironmentModel()->clone();
-	    result->kmodel = result->collisionSpace->getRobotModel().get();
-	    result->group = result->kmodel->getGroup(groupName);
-	    planning_environment::KinematicConstraintEvaluatorSet *kce = new planning_environment::KinematicConstraintEvaluatorSet();
-	    kce->add(result->kmodel, constraintEvaluator.getPoseConstraints());
-	    kce->add(result->kmodel, constraintEvaluator.getJointConstraints());
-	    result->constraintEvaluator = kce;
+	    result = createEnvironmentDescription();
 	}
 	ENVS[id] = result;
     }
@@ -101,18 +116,36 @@ ompl_ros::EnvironmentDescription* ompl_ros::ModelBase::getEnvironmentDescription
     return result;
 }
 
+ompl_ros::EnvironmentDescription* ompl_ros::ModelBase::createEnvironmentDescription(void) const
+{
+    EnvironmentDescription *result = new EnvironmentDescription();
+    result->collisionSpace = planningMonitor->getEnvironmentModel()->clone();
+    result->kmodel = result->collisionSpace->getRobotModel().get();
+    result->group = result->kmodel->getGroup(groupName);
+    planning_environment::KinematicConstraintEvaluatorSet *kce = new planning_environment::KinematicConstraintEvaluatorSet();
+    kce->add(result->kmodel, constraintEvaluator.getPoseConstraints());
+    kce->add(result->kmodel, constraintEvaluator.getJointConstraints());
+    result->constraintEvaluator = kce;
+    result->transforms = createTransforms(result->kmodel);
+    return result;
+}
+
+void ompl_ros::ModelBase::freeEnvironmentDescription(EnvironmentDescription *ed) const
+{
+    if (ed->collisionSpace != planningMonitor->getEnvironmentModel())
+    {
+	delete ed->collisionSpace;
+	delete ed->constraintEvaluator;
+    }
+    delete ed->transforms;
+    delete ed;
+}
+
 void ompl_ros::ModelBase::clearEnvironmentDescriptions(void) const
 {    
     lockENVS.lock();    
     for (std::map<boost::thread::id, EnvironmentDescription*>::iterator it = ENVS.begin() ; it != ENVS.end() ; ++it)
-    {
-	if (it->second->collisionSpace != planningMonitor->getEnvironmentModel())
-	{
-	    delete it->second->collisionSpace;
-	    delete it->second->constraintEvaluator;
-	}
-	delete it->second;
-    }
+	freeEnvironmentDescription(it->second);
     ENVS.clear();
     lockENVS.unlock();
 }
@@ -35,6 +35,7 @@
 /** \author Ioan Sucan */
 
 #include "ompl_ros/ModelKinematic.h"
+#include <boost/bind.hpp>
 
 bool ompl_ros::ModelKinematic::configure(void)
 {
@@ -44,6 +45,7 @@ bool ompl_ros::ModelKinematic::configure(void)
     ROSSpaceInformationKinematic *ros_si = new ROSSpaceInformationKinematic(this);
     ROSStateValidityPredicateKinematic *svc = new ROSStateValidityPredicateKinematic(ros_si, this);
     ros_si->setStateValidityChecker(svc);
+    ros_si->setStateValidityCheckerAllocator(boost::bind(&ModelKinematic::allocStateValidityChecker, this));
     si = ros_si;
     
     sde["L2Square"] = new ompl::base::L2SquareStateDistanceEvaluator(si);
@@ -52,3 +54,8 @@ bool ompl_ros::ModelKinematic::configure(void)
     
     return true;
 }
+
+ompl::base::StateValidityChecker* ompl_ros::ModelKinematic::allocStateValidityChecker(void)
+{
+    return new ROSStateValidityPredicateKinematic(dynamic_cast<ROSSpaceInformationKinematic*>(si), this, createEnvironmentDescription());
+}
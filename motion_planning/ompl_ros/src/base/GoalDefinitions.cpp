@@ -170,7 +170,7 @@ void ompl_ros::GoalToPosition::print(std::ostream &out) const
 double ompl_ros::GoalToPosition::evaluateGoalAux(const ompl::base::State *state, std::vector<bool> *decision) const
 {
     EnvironmentDescription *ed = model_->getEnvironmentDescription();
-    ed->group->computeTransforms(state->values);
+    ed->transforms->computeTransformsGroup(state->values, ed->group);
     
     if (decision)
 	decision->resize(pce_.size());
@@ -178,8 +178,7 @@ double ompl_ros::GoalToPosition::evaluateGoalAux(const ompl::base::State *state,
     for (unsigned int i = 0 ; i < pce_.size() ; ++i)
     {
 	double dPos, dAng;
-	pce_[i]->use(ed->kmodel);
-	pce_[i]->evaluate(&dPos, &dAng);
+	pce_[i]->evaluate(*ed->transforms, &dPos, &dAng);
 	if (decision)
 	    (*decision)[i] = pce_[i]->decide(dPos, dAng);
 	distance += dPos + pce_[i]->getConstraintMessage().orientation_importance * dAng;
@@ -53,8 +53,8 @@ unsigned int ompl_ros::LinkPositionProjectionEvaluator::getDimension(void) const
 void ompl_ros::LinkPositionProjectionEvaluator::operator()(const ompl::base::State *state, double *projection) const
 {  
     EnvironmentDescription *ed = model_->getEnvironmentDescription();
-    ed->group->computeTransforms(state->values);
-    const btVector3 &origin = ed->kmodel->getLink(linkName_)->globalTrans.getOrigin();
+    ed->transforms->computeTransformsGroup(state->values, ed->group);
+    const btVector3 &origin = ed->transforms->getLinkTransform(linkName_)->getOrigin();
     projection[0] = origin.x();
     projection[1] = origin.y();
     projection[2] = origin.z();
@@ -42,7 +42,7 @@ bool ompl_ros::ROSStateValidityPredicateDynamic::operator()(const ompl::base::St
 	return false;
 
     EnvironmentDescription *ed = model_->getEnvironmentDescription();
-    return check(s, ed->collisionSpace, ed->group, ed->constraintEvaluator);
+    return check(s, ed->collisionSpace, ed->group, ed->constraintEvaluator, ed->transforms);
 }
 
 void ompl_ros::ROSStateValidityPredicateDynamic::setConstraints(const motion_planning_msgs::KinematicConstraints &kc)
@@ -63,14 +63,14 @@ void ompl_ros::ROSStateValidityPredicateDynamic::printSettings(std::ostream &out
 }
 
 bool ompl_ros::ROSStateValidityPredicateDynamic::check(const ompl::base::State *s, collision_space::EnvironmentModel *em, planning_models::KinematicModel::JointGroup *jg,
-						       const planning_environment::KinematicConstraintEvaluatorSet *kce) const
+						       const planning_environment::KinematicConstraintEvaluatorSet *kce, planning_models::KinematicTransforms *kt) const
 {
-    jg->computeTransforms(s->values);
+    kt->computeTransformsGroup(s->values, jg);
     
-    bool valid = kce->decide(s->values, jg);
+    bool valid = kce->decide(s->values, jg, *kt);
     if (valid)
     {
-	em->updateRobotModel();
+	em->updateRobotModel(*kt);
 	valid = !em->isCollision();
     }
     
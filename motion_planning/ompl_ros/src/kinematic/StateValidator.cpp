@@ -38,8 +38,8 @@
 
 bool ompl_ros::ROSStateValidityPredicateKinematic::operator()(const ompl::base::State *s) const
 {
-    EnvironmentDescription *ed = model_->getEnvironmentDescription();
-    return check(s, ed->collisionSpace, ed->group, ed->constraintEvaluator);
+    EnvironmentDescription *ed = ed_ ? ed_ : model_->getEnvironmentDescription();
+    return check(s, ed->collisionSpace, ed->group, ed->constraintEvaluator, ed->transforms);
 }
 
 void ompl_ros::ROSStateValidityPredicateKinematic::setConstraints(const motion_planning_msgs::KinematicConstraints &kc)
@@ -60,14 +60,14 @@ void ompl_ros::ROSStateValidityPredicateKinematic::printSettings(std::ostream &o
 }
 
 bool ompl_ros::ROSStateValidityPredicateKinematic::check(const ompl::base::State *s, collision_space::EnvironmentModel *em, planning_models::KinematicModel::JointGroup *jg,
-							 const planning_environment::KinematicConstraintEvaluatorSet *kce) const
+							 const planning_environment::KinematicConstraintEvaluatorSet *kce, planning_models::KinematicTransforms *kt) const
 {
-    jg->computeTransforms(s->values);
+    kt->computeTransformsGroup(s->values, jg);
     
-    bool valid = kce->decide(s->values, jg);
+    bool valid = kce->decide(s->values, jg, *kt);
     if (valid)
     {
-	em->updateRobotModel();
+	em->updateRobotModel(*kt);
 	valid = !em->isCollision();
     }
     
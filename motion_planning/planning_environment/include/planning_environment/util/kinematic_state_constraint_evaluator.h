@@ -38,6 +38,7 @@
 #define PLANNING_ENVIRONMENT_UTIL_KINEMATIC_STATE_CONSTRAINT_EVALUATOR_
 
 #include <planning_models/kinematic_model.h>
+#include <planning_models/kinematic_transforms.h>
 #include <motion_planning_msgs/KinematicConstraints.h>
 #include <iostream>
 #include <vector>
@@ -72,6 +73,15 @@ namespace planning_environment
 	/** \brief Decide whether the constraint is satisfied. The kinematic model is assumed to be at the state we want to decide. */
 	virtual bool decide(const double *params) const;
 
+	/** \brief Decide whether the constraint is satisfied. The
+	    transforms are assumed to be computed for the state we want
+	    to decide; the kinematic model is only read. */
+	virtual bool decide(const double *params, const planning_models::KinematicModel::JointGroup *group,
+			    const planning_models::KinematicTransforms &transforms) const
+	{
+	    return decide(params, group);
+	}
+
 	/** \brief Print the constraint data */
 	virtual void print(std::ostream &out = std::cout) const
 	{
@@ -142,8 +152,18 @@ namespace planning_environment
 	/** \brief Decide whether the constraint is satisfied. The kinematic model is assumed to be at the state we want to decide. */
 	virtual bool decide(const double *params, const planning_models::KinematicModel::JointGroup *group) const;
 
+	/** \brief Decide whether the constraint is satisfied. The transforms are assumed to be computed for the state we want to decide. */
+	virtual bool decide(const double *params, const planning_models::KinematicModel::JointGroup *group,
+			    const planning_models::KinematicTransforms &transforms) const;
+
 	/** \brief Evaluate the distances to the position and to the orientation are given. */
 	void evaluate(double *distPos, double *distAng) const;
+
+	/** \brief Evaluate the distances to the position and to the
+	    orientation, using the link pose in the given
+	    transforms. These may be computed for a clone of the model
+	    the constraint was set up with. */
+	void evaluate(const planning_models::KinematicTransforms &transforms, double *distPos, double *distAng) const;
 	
 	/** \brief Decide whether the constraint is satisfied. The distances to the position and to the orientation are given. */
 	bool decide(double dPos, double dAng) const;
@@ -156,6 +176,9 @@ namespace planning_environment
 	
     protected:
 	
+	/** \brief Evaluate the distances for a given pose of the constrained link (NULL if there is no constraint) */
+	void evaluate(const btTransform *linkPose, double *distPos, double *distAng) const;
+	
 	motion_planning_msgs::PoseConstraint         m_pc;
 	double                                       m_x, m_y, m_z;
 	double                                       m_roll, m_pitch, m_yaw;
@@ -195,6 +218,10 @@ namespace planning_environment
 	/** \brief Decide whether the set of constraints is satisfied  */
 	bool decide(const double *params) const;
 
+	/** \brief Decide whether the set of constraints is satisfied, using the given transforms instead of the ones stored in the model */
+	bool decide(const double *params, const planning_models::KinematicModel::JointGroup *group,
+		    const planning_models::KinematicTransforms &transforms) const;
+
 	/** \brief Print the constraint data */
 	void print(std::ostream &out = std::cout) const;
 	
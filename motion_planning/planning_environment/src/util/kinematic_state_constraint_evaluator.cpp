@@ -160,9 +160,28 @@ bool planning_environment::PoseConstraintEvaluator::decide(const double*, const
     return decide(dPos, dAng);
 }
 
+bool planning_environment::PoseConstraintEvaluator::decide(const double*, const planning_models::KinematicModel::JointGroup*,
+							   const planning_models::KinematicTransforms &transforms) const
+{
+    double dPos, dAng;
+    evaluate(transforms, &dPos, &dAng);
+    
+    return decide(dPos, dAng);
+}
+
 void planning_environment::PoseConstraintEvaluator::evaluate(double *distPos, double *distAng) const
 {
-    if (m_link)
+    evaluate(m_link ? &m_link->globalTrans : NULL, distPos, distAng);
+}
+
+void planning_environment::PoseConstraintEvaluator::evaluate(const planning_models::KinematicTransforms &transforms, double *distPos, double *distAng) const
+{
+    evaluate(m_link ? &transforms.getLinkTransform(m_link) : NULL, distPos, distAng);
+}
+
+void planning_environment::PoseConstraintEvaluator::evaluate(const btTransform *linkPose, double *distPos, double *distAng) const
+{
+    if (linkPose)
     {	
 	if (distPos)
 	{
@@ -170,7 +189,7 @@ void planning_environment::PoseConstraintEvaluator::evaluate(double *distPos, do
 	    
 	    if (m_pc.type & (motion_planning_msgs::PoseConstraint::POSITION_X | motion_planning_msgs::PoseConstraint::POSITION_Y | motion_planning_msgs::PoseConstraint::POSITION_Z))
 	    {
-		const btVector3 &bodyPos = m_link->globalTrans.getOrigin();
+		const btVector3 &bodyPos = linkPose->getOrigin();
 		if (m_pc.type & motion_planning_msgs::PoseConstraint::POSITION_X)
 		{
 		    double dx = bodyPos.getX() - m_x;
@@ -201,7 +220,7 @@ void planning_environment::PoseConstraintEvaluator::evaluate(double *distPos, do
 	    if (m_pc.type & (motion_planning_msgs::PoseConstraint::ORIENTATION_R | motion_planning_msgs::PoseConstraint::ORIENTATION_P | motion_planning_msgs::PoseConstraint::ORIENTATION_Y))
 	    {
 		btScalar yaw, pitch, roll;
-		m_link->globalTrans.getBasis().getEulerYPR(yaw, pitch, roll);
+		linkPose->getBasis().getEulerYPR(yaw, pitch, roll);
 
 		if (m_pc.type & motion_planning_msgs::PoseConstraint::ORIENTATION_R)
 		{
@@ -343,6 +362,15 @@ bool planning_environment::KinematicConstraintEvaluatorSet::decide(const double
     return decide(params, NULL);
 }
 
+bool planning_environment::KinematicConstraintEvaluatorSet::decide(const double *params, const planning_models::KinematicModel::JointGroup *group,
+								   const planning_models::KinematicTransforms &transforms) const
+{
+    for (unsigned int i = 0 ; i < m_kce.size() ; ++i)
+	if (!m_kce[i]->decide(params, group, transforms))
+	    return false;
+    return true;
+}
+
 void planning_environment::KinematicConstraintEvaluatorSet::use(const planning_models::KinematicModel *kmodel)
 {
     for (unsigned int i = 0 ; i < m_kce.size() ; ++i)
@@ -53,8 +53,14 @@
 namespace planning_models
 {
  
-    /** \brief Definition of a kinematic model. This class is not thread
-	safe, however multiple instances can be created */
+    /** \brief Definition of a kinematic model. Once constructed, the
+	description of the model (joints, links, groups, bounds) is not
+	modified, so it can be shared by multiple threads. The
+	transforms stored in the model by computeTransforms() are
+	however shared state, so this part of the class is not thread
+	safe. Threads that need forward kinematics concurrently should
+	each use their own planning_models::KinematicTransforms
+	instance instead. */
     class KinematicModel
     {
     public:	
@@ -91,6 +97,9 @@ namespace planning_models
 
 	    /** \brief The index where this joint starts readin params in the global state vector */
 	    unsigned int      stateIndex;
+
+	    /** \brief The index of this joint in the list of joints of the model */
+	    unsigned int      index;
 	    
 	    /** \brief the links that this joint connects */	    
 	    Link             *before;
@@ -100,7 +109,10 @@ namespace planning_models
 	    btTransform       varTrans;
 
 	    /** \brief Update the value of varTrans using the information from params */
-	    virtual void updateVariableTransform(const double *params) = 0;
+	    void updateVariableTransform(const double *params);
+	    
+	    /** \brief Compute the variable transform of the joint for the given params, without modifying the joint */
+	    virtual void computeVariableTransform(const double *params, btTransform &transf) const = 0;
 
 	};
 
@@ -113,8 +125,8 @@ namespace planning_models
 	    {
 	    }
 	    
-	    /** \brief Update the value of varTrans using the information from params */
-	    virtual void updateVariableTransform(const double *params);
+	    /** \brief Compute the variable transform of the joint for the given params, without modifying the joint */
+	    virtual void computeVariableTransform(const double *params, btTransform &transf) const;
 	};
 
 	/** \brief A planar joint */
@@ -127,8 +139,8 @@ namespace planning_models
 	        usedParams = 3; // (x, y, theta)
 	    }
 	    
-	    /** \brief Update the value of varTrans using the information from params */
-	    virtual void updateVariableTransform(const double *params);
+	    /** \brief Compute the variable transform of the joint for the given params, without modifying the joint */
+	    virtual void computeVariableTransform(const double *params, btTransform &transf) const;
 	};
 
 	/** \brief A floating joint */
@@ -141,8 +153,8 @@ namespace planning_models
 	        usedParams = 7; // vector: (x, y, z)  quaternion: (x, y, z, w)
 	    }
 
-	    /** \brief Update the value of varTrans using the information from params */
-	    virtual void updateVariableTransform(const double *params);
+	    /** \brief Compute the variable transform of the joint for the given params, without modifying the joint */
+	    virtual void computeVariableTransform(const double *params, btTransform &transf) const;
 	};
 
 	/** \brief A prismatic joint */
@@ -159,8 +171,8 @@ namespace planning_models
 	    double    lowLimit;
 	    double    hiLimit;
 	    
-	    /** \brief Update the value of varTrans using the information from params */
-	    virtual void updateVariableTransform(const double *params);
+	    /** \brief Compute the variable transform of the joint for the given params, without modifying the joint */
+	    virtual void computeVariableTransform(const double *params, btTransform &transf) const;
 	    
 	};
 	
@@ -180,8 +192,8 @@ namespace planning_models
 	    double    hiLimit;
 	    bool      continuous;
 
-	    /** \brief Update the value of varTrans using the information from params */
-	    virtual void updateVariableTransform(const double *params);
+	    /** \brief Compute the variable transform of the joint for the given params, without modifying the joint */
+	    virtual void computeVariableTransform(const double *params, btTransform &transf) const;
 
 	};
 	
@@ -202,6 +214,9 @@ namespace planning_models
 	    /** \brief Joint that connects this link to the parent link */
 	    Joint                     *before;
 	    
+	    /** \brief The index of this link in the order links are updated by computeTransforms() */
+	    unsigned int               index;
+	    
 	    /** \brief List of descending joints (each connects to a child link) */
 	    std::vector<Joint*>        after;
 	    
@@ -376,6 +391,15 @@ namespace planning_models
 	    appear in the robot state. */
 	void getJointNames(std::vector<std::string> &joints) const;
 	
+	/** \brief Get the array of links, in the order they are updated by computeTransforms(). Parent links always come before their children. */
+	void getLinksInUpdateOrder(std::vector<const Link*> &links) const;
+	
+	/** \brief Get the number of links in the model */
+	unsigned int getLinkCount(void) const;
+
+	/** \brief Get the number of joints in the model */
+	unsigned int getJointCount(void) const;
+	
 	/** \brief Perform forward kinematics for the entire robot */
 	void computeTransforms(const double *params);
 	
@@ -405,7 +429,9 @@ namespace planning_models
 	/** \brief Return a list of names of joints that are floating */
 	const std::vector<std::string> &getFloatingJoints(void) const;
 	
-	/** \brief Provide interface to a lock. Use carefully! */
+	/** \brief Provide interface to a lock. Use carefully! This is
+	    only needed when using the transforms stored in the model;
+	    planning_models::KinematicTransforms does not require it. */
 	void lock(void);
 	
 	/** \brief Provide interface to a lock. Use carefully! */
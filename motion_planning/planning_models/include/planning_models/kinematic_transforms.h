@@ -0,0 +1,127 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/** \author Ioan Sucan */
+
+#ifndef PLANNING_MODELS_KINEMATIC_TRANSFORMS_
+#define PLANNING_MODELS_KINEMATIC_TRANSFORMS_
+
+#include "planning_models/kinematic_model.h"
+
+/** \brief Main namespace */
+namespace planning_models
+{
+    
+    /** \brief Storage for the transforms computed by forward
+	kinematics on a kinematic model. The model itself is only read,
+	so any number of instances of this class (for instance, one per
+	planning thread) can compute forward kinematics on the same
+	model at the same time, without locking it. */
+    class KinematicTransforms
+    {
+    public:
+	KinematicTransforms(const KinematicModel *model);
+	KinematicTransforms(const KinematicTransforms &kt);
+	
+	~KinematicTransforms(void);
+	
+	KinematicTransforms &operator=(const KinematicTransforms &rhs);
+	
+	/** \brief Get the model these transforms are computed for */
+	const KinematicModel* getOwner(void) const;
+	
+	/** \brief Get the global transform applied to the entire tree of links */
+	const btTransform& getRootTransform(void) const;
+	
+	/** \brief Set the global transform applied to the entire tree of links. This does not modify the model. */
+	void setRootTransform(const btTransform &transform);
+	
+	/** \brief Perform forward kinematics for the entire robot */
+	void computeTransforms(const double *params);
+	
+	/** \brief Perform forward kinematics starting at the roots
+	    of a group, using the params of the group. Only the
+	    links in the subtree of the group are updated; the
+	    transforms of other links are kept from previous calls. */
+	void computeTransformsGroup(const double *params, const KinematicModel::JointGroup *group);
+
+	/** \brief Perform forward kinematics starting at the roots of a group */
+	void computeTransformsGroup(const double *params, const std::string &group);
+	
+	/** \brief Get the variable transform of a joint */
+	const btTransform& getJointTransform(const KinematicModel::Joint *joint) const;
+	
+	/** \brief Get the global transform of a link (includes the collision geometry offset) */
+	const btTransform& getLinkTransform(const KinematicModel::Link *link) const;
+	
+	/** \brief Get the global transform of a link, by name. Returns NULL if the link does not exist. */
+	const btTransform* getLinkTransform(const std::string &link) const;
+	
+	/** \brief Get the global transform a link forwards to its children */
+	const btTransform& getLinkTransformFwd(const KinematicModel::Link *link) const;
+
+	/** \brief Get the number of attached bodies for which transforms are available for a link */
+	unsigned int getAttachedBodyCount(const KinematicModel::Link *link) const;
+	
+	/** \brief Get the global transform of the index-th body attached to a link */
+	const btTransform& getAttachedBodyTransform(const KinematicModel::Link *link, unsigned int index) const;
+	
+    private:
+	
+	/** \brief Update the transforms of a link and its attached bodies, assuming the parent link is up to date */
+	void computeLinkTransform(const KinematicModel::Link *link);
+	
+	const KinematicModel                    *owner_;
+	
+	/** \brief The links of the model, in the order they are updated */
+	std::vector<const KinematicModel::Link*> links_;
+	
+	/** \brief The joints of the model, in the order they appear in the state vector */
+	std::vector<const KinematicModel::Joint*> joints_;
+	
+	btTransform                              rootTransform_;
+	
+	/** \brief Transforms indexed by KinematicModel::Joint::index */
+	std::vector<btTransform>                 varTrans_;
+	
+	/** \brief Transforms indexed by KinematicModel::Link::index */
+	std::vector<btTransform>                 globalTransFwd_;
+	std::vector<btTransform>                 globalTrans_;
+	std::vector< std::vector<btTransform> >  attachedBodyTrans_;
+    };
+    
+}
+
+#endif
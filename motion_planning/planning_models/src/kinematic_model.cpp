@@ -185,6 +185,7 @@ void planning_models::KinematicModel::buildConvenientDatastructures(void)
 	{
 	    Link *link = links.front();
 	    links.pop();
+	    link->index = updatedLinks_.size();
 	    updatedLinks_.push_back(link);
 	    for (unsigned int i = 0 ; i < link->after.size() ; ++i)
 		links.push(link->after[i]->after);
@@ -223,6 +224,7 @@ planning_models::KinematicModel::Joint* planning_models::KinematicModel::buildRe
 {
     Joint *joint = constructJoint(link->parent_joint.get(), stateBounds_);
     joint->stateIndex = dimension_;
+    joint->index = jointList_.size();
     jointMap_[joint->name] = joint;
     jointList_.push_back(joint);
     jointIndex_.push_back(dimension_);
@@ -560,10 +562,29 @@ void planning_models::KinematicModel::getJointNames(std::vector<std::string> &jo
 	joints.push_back(jointList_[i]->name);
 }
 
+void planning_models::KinematicModel::getLinksInUpdateOrder(std::vector<const Link*> &links) const
+{
+    links.clear();
+    links.reserve(updatedLinks_.size());
+    for (unsigned int i = 0 ; i < updatedLinks_.size() ; ++i)
+	links.push_back(updatedLinks_[i]);
+}
+
+unsigned int planning_models::KinematicModel::getLinkCount(void) const
+{
+    return updatedLinks_.size();
+}
+
+unsigned int planning_models::KinematicModel::getJointCount(void) const
+{
+    return jointList_.size();
+}
+
 planning_models::KinematicModel::Joint* planning_models::KinematicModel::copyRecursive(Link *parent, const Link *link)
 {
     Joint *joint = copyJoint(link->before);
     joint->stateIndex = dimension_;
+    joint->index = jointList_.size();
     jointMap_[joint->name] = joint;
     jointList_.push_back(joint);
     jointIndex_.push_back(dimension_);
@@ -736,7 +757,7 @@ void planning_models::KinematicModel::printTransforms(std::ostream &out) const
 
 /* ------------------------ Joint ------------------------ */
 
-planning_models::KinematicModel::Joint::Joint(KinematicModel *model) : owner(model), usedParams(0), stateIndex(0), before(NULL), after(NULL)
+planning_models::KinematicModel::Joint::Joint(KinematicModel *model) : owner(model), usedParams(0), stateIndex(0), index(0), before(NULL), after(NULL)
 {
     varTrans.setIdentity();
 }
@@ -747,37 +768,44 @@ planning_models::KinematicModel::Joint::~Joint(void)
 	delete after;
 }
 
-void planning_models::KinematicModel::FixedJoint::updateVariableTransform(const double *params)
+void planning_models::KinematicModel::Joint::updateVariableTransform(const double *params)
 {
-    // the joint remains identity
+    computeVariableTransform(params, varTrans);
 }
 
+void planning_models::KinematicModel::FixedJoint::computeVariableTransform(const double *params, btTransform &transf) const
+{
+    // the joint remains identity
+    transf.setIdentity();
+}
 
-void planning_models::KinematicModel::PlanarJoint::updateVariableTransform(const double *params)
+void planning_models::KinematicModel::PlanarJoint::computeVariableTransform(const double *params, btTransform &transf) const
 {
-    varTrans.setOrigin(btVector3(params[0], params[1], 0.0));
-    varTrans.setRotation(btQuaternion(btVector3(0.0, 0.0, 1.0), params[2]));
+    transf.setOrigin(btVector3(params[0], params[1], 0.0));
+    transf.setRotation(btQuaternion(btVector3(0.0, 0.0, 1.0), params[2]));
 }
 
-void planning_models::KinematicModel::FloatingJoint::updateVariableTransform(const double *params)
+void planning_models::KinematicModel::FloatingJoint::computeVariableTransform(const double *params, btTransform &transf) const
 {
-    varTrans.setOrigin(btVector3(params[0], params[1], params[2]));
-    varTrans.setRotation(btQuaternion(params[3], params[4], params[5], params[6]));
+    transf.setOrigin(btVector3(params[0], params[1], params[2]));
+    transf.setRotation(btQuaternion(params[3], params[4], params[5], params[6]));
 }
 
-void planning_models::KinematicModel::PrismaticJoint::updateVariableTransform(const double *params)
+void planning_models::KinematicModel::PrismaticJoint::computeVariableTransform(const double *params, btTransform &transf) const
 {
-    varTrans.setOrigin(axis * params[0]);
+    transf.getBasis().setIdentity();
+    transf.setOrigin(axis * params[0]);
 }
 
-void planning_models::KinematicModel::RevoluteJoint::updateVariableTransform(const double *params)
+void planning_models::KinematicModel::RevoluteJoint::computeVariableTransform(const double *params, btTransform &transf) const
 {
-    varTrans.setRotation(btQuaternion(axis, params[0]));
+    transf.setOrigin(btVector3(0.0, 0.0, 0.0));
+    transf.setRotation(btQuaternion(axis, params[0]));
 }
 
 /* ------------------------ Link ------------------------ */
 
-planning_models::KinematicModel::Link::Link(KinematicModel *model) : owner(model), before(NULL), shape(NULL)
+planning_models::KinematicModel::Link::Link(KinematicModel *model) : owner(model), before(NULL), index(0), shape(NULL)
 {
     constTrans.setIdentity();
     constGeomTrans.setIdentity();
@@ -0,0 +1,177 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/** \author Ioan Sucan */
+
+#include <planning_models/kinematic_transforms.h>
+#include <ros/console.h>
+
+planning_models::KinematicTransforms::KinematicTransforms(const KinematicModel *model) : owner_(model)
+{
+    owner_->getLinksInUpdateOrder(links_);
+    owner_->getJoints(joints_);
+    rootTransform_ = owner_->getRootTransform();
+    
+    btTransform identity;
+    identity.setIdentity();
+    varTrans_.resize(joints_.size(), identity);
+    globalTransFwd_.resize(links_.size(), identity);
+    globalTrans_.resize(links_.size(), identity);
+    attachedBodyTrans_.resize(links_.size());
+}
+
+planning_models::KinematicTransforms::KinematicTransforms(const KinematicTransforms &kt) : 
+    owner_(kt.owner_), links_(kt.links_), joints_(kt.joints_), rootTransform_(kt.rootTransform_),
+    varTrans_(kt.varTrans_), globalTransFwd_(kt.globalTransFwd_), globalTrans_(kt.globalTrans_),
+    attachedBodyTrans_(kt.attachedBodyTrans_)
+{
+}
+
+planning_models::KinematicTransforms::~KinematicTransforms(void)
+{
+}
+
+planning_models::KinematicTransforms& planning_models::KinematicTransforms::operator=(const KinematicTransforms &rhs)
+{
+    if (this != &rhs)
+    {
+	owner_ = rhs.owner_;
+	links_ = rhs.links_;
+	joints_ = rhs.joints_;
+	rootTransform_ = rhs.rootTransform_;
+	varTrans_ = rhs.varTrans_;
+	globalTransFwd_ = rhs.globalTransFwd_;
+	globalTrans_ = rhs.globalTrans_;
+	attachedBodyTrans_ = rhs.attachedBodyTrans_;
+    }
+    return *this;
+}
+
+const planning_models::KinematicModel* planning_models::KinematicTransforms::getOwner(void) const
+{
+    return owner_;
+}
+
+const btTransform& planning_models::KinematicTransforms::getRootTransform(void) const
+{
+    return rootTransform_;
+}
+
+void planning_models::KinematicTransforms::setRootTransform(const btTransform &transform)
+{
+    rootTransform_ = transform;
+}
+
+void planning_models::KinematicTransforms::computeLinkTransform(const KinematicModel::Link *link)
+{
+    const unsigned int li = link->index;
+    const KinematicModel::Joint *joint = link->before;
+    
+    btTransform &fwd = globalTransFwd_[li];
+    fwd.mult(joint->before ? globalTransFwd_[joint->before->index] : rootTransform_, link->constTrans);
+    fwd *= varTrans_[joint->index];
+    globalTrans_[li].mult(fwd, link->constGeomTrans);
+    
+    // bodies may have been attached to the model since we last looked at this link
+    const unsigned int nab = link->attachedBodies.size();
+    std::vector<btTransform> &abt = attachedBodyTrans_[li];
+    if (abt.size() != nab)
+	abt.resize(nab);
+    for (unsigned int i = 0 ; i < nab ; ++i)
+	abt[i].mult(globalTrans_[li], link->attachedBodies[i]->attachTrans);
+}
+
+void planning_models::KinematicTransforms::computeTransforms(const double *params)
+{
+    const unsigned int js = joints_.size();
+    for (unsigned int i = 0  ; i < js ; ++i)
+	joints_[i]->computeVariableTransform(params + joints_[i]->stateIndex, varTrans_[i]);
+    
+    const unsigned int ls = links_.size();
+    for (unsigned int i = 0 ; i < ls ; ++i)
+	computeLinkTransform(links_[i]);
+}
+
+void planning_models::KinematicTransforms::computeTransformsGroup(const double *params, const KinematicModel::JointGroup *group)
+{
+    const unsigned int js = group->joints.size();
+    for (unsigned int i = 0  ; i < js ; ++i)
+    {
+	const KinematicModel::Joint *joint = group->joints[i];
+	joint->computeVariableTransform(params + group->jointIndex[i], varTrans_[joint->index]);
+    }
+    
+    const unsigned int ls = group->updatedLinks.size();
+    for (unsigned int i = 0 ; i < ls ; ++i)
+	computeLinkTransform(group->updatedLinks[i]);
+}
+
+void planning_models::KinematicTransforms::computeTransformsGroup(const double *params, const std::string &group)
+{
+    const KinematicModel::JointGroup *g = owner_->getGroup(group);
+    if (g)
+	computeTransformsGroup(params, g);
+}
+
+const btTransform& planning_models::KinematicTransforms::getJointTransform(const KinematicModel::Joint *joint) const
+{
+    return varTrans_[joint->index];
+}
+
+const btTransform& planning_models::KinematicTransforms::getLinkTransform(const KinematicModel::Link *link) const
+{
+    return globalTrans_[link->index];
+}
+
+const btTransform* planning_models::KinematicTransforms::getLinkTransform(const std::string &link) const
+{
+    const KinematicModel::Link *l = owner_->getLink(link);
+    return l ? &globalTrans_[l->index] : NULL;
+}
+
+const btTransform& planning_models::KinematicTransforms::getLinkTransformFwd(const KinematicModel::Link *link) const
+{
+    return globalTransFwd_[link->index];
+}
+
+unsigned int planning_models::KinematicTransforms::getAttachedBodyCount(const KinematicModel::Link *link) const
+{
+    return attachedBodyTrans_[link->index].size();
+}
+
+const btTransform& planning_models::KinematicTransforms::getAttachedBodyTransform(const KinematicModel::Link *link, unsigned int index) const
+{
+    return attachedBodyTrans_[link->index][index];
+}
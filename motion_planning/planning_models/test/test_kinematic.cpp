@@ -36,8 +36,11 @@
 
 #include <planning_models/kinematic_model.h>
 #include <planning_models/kinematic_state.h>
+#include <planning_models/kinematic_transforms.h>
+#include <boost/thread.hpp>
 #include <gtest/gtest.h>
 #include <sstream>
+#include <cmath>
 #include <ctype.h>
 
 static bool sameStringIgnoringWS(const std::string &s1, const std::string &s2)
@@ -390,10 +393,103 @@ TEST(FK, OneRobot)
     planning_models::KinematicState sp_copy = *sp;
     EXPECT_TRUE(sp_copy == *sp);
     
+    // transforms computed outside the model match the ones stored in the model
+    planning_models::KinematicTransforms kt(model);
+    kt.computeTransforms(param);
+    std::vector<const planning_models::KinematicModel::Link*> links;
+    model->getLinks(links);
+    EXPECT_EQ((unsigned int)4, links.size());
+    for (unsigned int i = 0 ; i < links.size() ; ++i)
+    {
+	const btTransform &t = kt.getLinkTransform(links[i]);
+	EXPECT_NEAR(links[i]->globalTrans.getOrigin().x(), t.getOrigin().x(), 1e-5);
+	EXPECT_NEAR(links[i]->globalTrans.getOrigin().y(), t.getOrigin().y(), 1e-5);
+	EXPECT_NEAR(links[i]->globalTrans.getOrigin().z(), t.getOrigin().z(), 1e-5);
+	EXPECT_NEAR(links[i]->globalTrans.getRotation().x(), t.getRotation().x(), 1e-5);
+	EXPECT_NEAR(links[i]->globalTrans.getRotation().y(), t.getRotation().y(), 1e-5);
+	EXPECT_NEAR(links[i]->globalTrans.getRotation().z(), t.getRotation().z(), 1e-5);
+	EXPECT_NEAR(links[i]->globalTrans.getRotation().w(), t.getRotation().w(), 1e-5);
+    }
+    
+    // computing transforms for a group updates only the instance it is called on
+    double param2[5] = { 0, 0, 0, 0, 0 };
+    planning_models::KinematicTransforms kt2(kt);
+    kt2.computeTransformsGroup(param2, "base");
+    EXPECT_NEAR(0.0, kt2.getLinkTransform("link_a")->getOrigin().x(), 1e-5);
+    EXPECT_NEAR(1.0, kt.getLinkTransform("link_a")->getOrigin().x(), 1e-5);
+    EXPECT_NEAR(1.0, model->getLink("link_a")->globalTrans.getOrigin().x(), 1e-5);
+    EXPECT_TRUE(kt2.getLinkTransform("no_such_link") == NULL);
+    
     delete sp;
     delete model;
 }
 
+static void computeTransformsRepeatedly(const planning_models::KinematicModel *model, double value, bool *ok)
+{
+    planning_models::KinematicTransforms kt(model);
+    std::vector<double> params(model->getDimension(), value);
+    *ok = true;
+    for (unsigned int i = 0 ; i < 10000 ; ++i)
+    {
+	kt.computeTransforms(&params[0]);
+	if (fabs(kt.getLinkTransform(model->getLink("link_a")).getOrigin().x() - value) > 1e-9)
+	    *ok = false;
+    }
+}
+
+TEST(FK, ConcurrentTransforms)
+{
+    static const std::string MODEL3 = 
+	"<?xml version=\"1.0\" ?>" 
+	"<robot name=\"two_links\">"
+	"<joint name=\"base_joint\" type=\"planar\">"
+	"  <parent link=\"world\"/>"
+	"  <child link=\"base_link\"/>"
+	"  <origin rpy=\"0 0 0\" xyz=\"0 0 0\"/>"
+	"</joint>"
+	"<link name=\"base_link\">"
+	"  <collision>"
+	"    <origin rpy=\"0 0 0\" xyz=\"0 0 0\"/>"
+	"    <geometry>"
+	"      <box size=\"1 2 1\" />"
+	"    </geometry>"
+	"  </collision>"
+	"</link>"
+	"<joint name=\"joint_a\" type=\"continuous\">"
+	"   <axis xyz=\"0 0 1\"/>"
+	"   <parent link=\"base_link\"/>"
+	"   <child link=\"link_a\"/>"
+	"   <origin rpy=\"0 0 0\" xyz=\"0 0 0\"/>"
+	"</joint>"
+	"<link name=\"link_a\">"
+	"  <collision>"
+	"    <origin rpy=\"0 0 0\" xyz=\"0 0 0\"/>"
+	"    <geometry>"
+	"      <box size=\"1 2 1\" />"
+	"    </geometry>"
+	"  </collision>"
+	"</link>"
+	"</robot>";
+    
+    urdf::Model urdfModel;
+    urdfModel.initString(MODEL3);
+    std::map < std::string, std::vector<std::string> > groups;
+    const planning_models::KinematicModel *model = new planning_models::KinematicModel(urdfModel, groups);
+    
+    // each thread has its own transforms; the model is shared and never locked
+    const unsigned int nt = 4;
+    bool ok[nt];
+    boost::thread_group threads;
+    for (unsigned int i = 0 ; i < nt ; ++i)
+	threads.create_thread(boost::bind(&computeTransformsRepeatedly, model, 0.1 * (i + 1), &ok[i]));
+    threads.join_all();
+    
+    for (unsigned int i = 0 ; i < nt ; ++i)
+	EXPECT_TRUE(ok[i]);
+    
+    delete model;
+}
+
 
 int main(int argc, char **argv)
 {
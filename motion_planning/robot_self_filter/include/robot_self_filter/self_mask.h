@@ -78,6 +78,20 @@ namespace robot_self_filter
 	    }
 	};
 	
+	struct SortByHitScore
+	{
+	    SortByHitScore(const std::vector<double> &score) : score_(score)
+	    {
+	    }
+	    
+	    bool operator()(unsigned int b1, unsigned int b2) const
+	    {
+		return score_[b1] > score_[b2];
+	    }
+	    
+	    const std::vector<double> &score_;
+	};
+	
     public:
 	
 	/** \brief Construct the filter */
@@ -160,9 +174,30 @@ namespace robot_self_filter
 	/** \brief Configure the filter. */
 	bool configure(const std::vector<std::string> &links, double scale, double padd);
 	
-	/** \brief Compute bounding spheres for the checked robot links. */
+	/** \brief Compute bounding spheres for the checked robot links, as well as a sphere and an axis aligned box that bound the entire robot. */
 	void computeBoundingSpheres(void);
 	
+	/** \brief Check if a point is inside the volume that bounds all the checked robot links */
+	bool insideRobotBound(const btVector3 &pt) const
+	{
+	    return pt.x() >= aabbMin_.x() && pt.x() <= aabbMax_.x() &&
+		pt.y() >= aabbMin_.y() && pt.y() <= aabbMax_.y() &&
+		pt.z() >= aabbMin_.z() && pt.z() <= aabbMax_.z() &&
+		bound_.center.distance2(pt) < boundRadius2_;
+	}
+	
+	/** \brief Find the index of a body (scaled or unscaled) that contains the point. Bodies are
+	    tested in order of their recent hit frequency and only if their bounding sphere contains the point.
+	    Returns -1 if no body contains the point. */
+	int findContainingBody(const btVector3 &pt, bool unscaled) const;
+	
+	/** \brief Find the index of a (scaled) body that the ray starting at pt and going along dir intersects.
+	    Returns -1 if no body is intersected. */
+	int findIntersectedBody(const btVector3 &pt, const btVector3 &dir, std::vector<btVector3> *intersections) const;
+	
+	/** \brief Update the order in which bodies are tested, given the number of points each body accounted for in the last frame */
+	void updateBodyOrder(const std::vector<unsigned int> &hits);
+	
 	/** \brief Perform the actual mask computation. */
 	void maskAuxContainment(const sensor_msgs::PointCloud& data_in, std::vector<int> &mask);
 
@@ -179,6 +214,16 @@ namespace robot_self_filter
 	std::vector<double>                 bspheresRadius2_;
 	std::vector<bodies::BoundingSphere> bspheres_;
 	
+	/** \brief The bounding sphere and axis aligned bounding box of all the bodies, in the assumed frame */
+	bodies::BoundingSphere              bound_;
+	double                              boundRadius2_;
+	btVector3                           aabbMin_;
+	btVector3                           aabbMax_;
+	
+	/** \brief The order in which bodies are tested; bodies that recently contained the most points come first */
+	std::vector<unsigned int>           order_;
+	std::vector<double>                 hitScore_;
+	
     };
     
 }
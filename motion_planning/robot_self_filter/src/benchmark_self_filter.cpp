@@ -0,0 +1,162 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/** \author Ioan Sucan */
+
+/** Run the self mask on recorded clouds (e.g., tilting laser data played back
+    from a bag) and report how many points per second are processed.  Uses the
+    same parameters as the self_filter node; the cloud is read from 'cloud_in'. */
+
+#include <ros/ros.h>
+#include "robot_self_filter/self_mask.h"
+#include <tf/message_filter.h>
+#include <message_filters/subscriber.h>
+#include <sstream>
+
+class BenchmarkSelfFilter
+{
+public:
+
+    BenchmarkSelfFilter(void)
+    {
+	nh_.param<std::string>("~sensor_frame", sensor_frame_, std::string());
+	nh_.param<double>("~min_sensor_dist", min_sensor_dist_, 0.01);
+	nh_.param<int>("~report_every", report_every_, 50);
+	
+	std::vector<std::string> links;	
+	std::string link_names;
+	nh_.param<std::string>("~self_see_links", link_names, std::string());
+	std::stringstream ss(link_names);
+	while (ss.good() && !ss.eof())
+	{
+	    std::string link;
+	    ss >> link;
+	    links.push_back(link);
+	}
+	double padd;
+	nh_.param<double>("~self_see_padd", padd, 0.0);
+	double scale;
+	nh_.param<double>("~self_see_scale", scale, 1.0);
+	
+	sf_ = new robot_self_filter::SelfMask(tf_, links, scale, padd);
+	
+	std::vector<std::string> frames;
+	sf_->getLinkNames(frames);
+	if (!sensor_frame_.empty())
+	    frames.push_back(sensor_frame_);
+	
+	clouds_ = 0;
+	points_ = 0;
+	inside_ = 0;
+	shadow_ = 0;
+	seconds_ = 0.0;
+	
+	// keep all clouds; we want to measure the mask, not drop data
+	sub_ = new message_filters::Subscriber<sensor_msgs::PointCloud>(nh_, "cloud_in", 100);	
+	mn_ = new tf::MessageFilter<sensor_msgs::PointCloud>(*sub_, tf_, "", 100);
+	mn_->setTargetFrames(frames);
+	mn_->registerCallback(boost::bind(&BenchmarkSelfFilter::cloudCallback, this, _1));
+    }
+    
+    ~BenchmarkSelfFilter(void)
+    {
+	report();
+	delete mn_;
+	delete sub_;
+	delete sf_;
+    }
+    
+private:
+    
+    void cloudCallback(const sensor_msgs::PointCloudConstPtr &cloud)
+    {
+	std::vector<int> mask;
+	ros::WallTime tm = ros::WallTime::now();
+	
+	if (sensor_frame_.empty())
+	    sf_->maskContainment(*cloud, mask);
+	else
+	    sf_->maskIntersection(*cloud, sensor_frame_, min_sensor_dist_, mask);
+	
+	seconds_ += (ros::WallTime::now() - tm).toSec();
+	points_ += cloud->points.size();
+	clouds_++;
+	
+	for (unsigned int i = 0 ; i < mask.size() ; ++i)
+	    if (mask[i] == robot_self_filter::INSIDE)
+		inside_++;
+	    else
+		if (mask[i] == robot_self_filter::SHADOW)
+		    shadow_++;
+	
+	if (report_every_ > 0 && clouds_ % report_every_ == 0)
+	    report();
+    }
+    
+    void report(void)
+    {
+	if (clouds_ == 0 || seconds_ <= 0.0)
+	    return;
+	ROS_INFO("Self mask: %u clouds, %llu points (%llu inside, %llu shadow) in %f seconds: %f points per second, %f ms per cloud",
+		 clouds_, points_, inside_, shadow_, seconds_, (double)points_ / seconds_, 1000.0 * seconds_ / (double)clouds_);
+    }
+    
+    tf::TransformListener                                 tf_;
+    robot_self_filter::SelfMask                          *sf_;
+    tf::MessageFilter<sensor_msgs::PointCloud>           *mn_;
+    message_filters::Subscriber<sensor_msgs::PointCloud> *sub_;
+    
+    std::string                                           sensor_frame_;
+    ros::NodeHandle                                       nh_;
+    double                                                min_sensor_dist_;
+    int                                                   report_every_;
+    
+    unsigned int                                          clouds_;
+    unsigned long long                                    points_;
+    unsigned long long                                    inside_;
+    unsigned long long                                    shadow_;
+    double                                                seconds_;
+};
+
+    
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "benchmark_self_filter");
+
+    BenchmarkSelfFilter b;
+    ros::spin();
+    
+    return 0;
+}
@@ -208,6 +208,15 @@ bool robot_self_filter::SelfMask::configure(const std::vector<std::string> &link
     
     bspheres_.resize(bodies_.size());
     bspheresRadius2_.resize(bodies_.size());
+    
+    // initially, the test order is the volume order
+    order_.resize(bodies_.size());
+    hitScore_.resize(bodies_.size());
+    for (unsigned int i = 0 ; i < bodies_.size() ; ++i)
+    {
+	order_[i] = i;
+	hitScore_[i] = 0.0;
+    }
 
     for (unsigned int i = 0 ; i < bodies_.size() ; ++i)
 	ROS_DEBUG("Self mask includes link %s with volume %f", bodies_[i].name.c_str(), bodies_[i].volume);
@@ -267,11 +276,71 @@ void robot_self_filter::SelfMask::maskIntersection(const sensor_msgs::PointCloud
 void robot_self_filter::SelfMask::computeBoundingSpheres(void)
 {
     const unsigned int bs = bodies_.size();
+    std::vector<bodies::BoundingSphere> pair(2);
     for (unsigned int i = 0 ; i < bs ; ++i)
     {
-	bodies_[i].body->computeBoundingSphere(bspheres_[i]);
+	// the sphere has to bound both the scaled and the unscaled body, since both are tested against it
+	bodies_[i].body->computeBoundingSphere(pair[0]);
+	bodies_[i].unscaledBody->computeBoundingSphere(pair[1]);
+	bodies::mergeBoundingSpheres(pair, bspheres_[i]);
 	bspheresRadius2_[i] = bspheres_[i].radius * bspheres_[i].radius;
     }
+    
+    // compute a sphere and a box that bound the entire robot
+    bodies::mergeBoundingSpheres(bspheres_, bound_);
+    boundRadius2_ = bound_.radius * bound_.radius;
+    
+    if (bs > 0)
+    {
+	btVector3 r(bspheres_[0].radius, bspheres_[0].radius, bspheres_[0].radius);
+	aabbMin_ = bspheres_[0].center - r;
+	aabbMax_ = bspheres_[0].center + r;
+	for (unsigned int i = 1 ; i < bs ; ++i)
+	{
+	    r.setValue(bspheres_[i].radius, bspheres_[i].radius, bspheres_[i].radius);
+	    aabbMin_.setMin(bspheres_[i].center - r);
+	    aabbMax_.setMax(bspheres_[i].center + r);
+	}
+    }
+}
+
+void robot_self_filter::SelfMask::updateBodyOrder(const std::vector<unsigned int> &hits)
+{
+    // older frames count less, so the order follows the robot as it moves
+    const unsigned int bs = bodies_.size();
+    for (unsigned int i = 0 ; i < bs ; ++i)
+	hitScore_[i] = hitScore_[i] * 0.5 + hits[i];
+    
+    // stable sort keeps the volume order for bodies with equal scores
+    for (unsigned int i = 0 ; i < bs ; ++i)
+	order_[i] = i;
+    std::stable_sort(order_.begin(), order_.end(), SortByHitScore(hitScore_));
+}
+
+int robot_self_filter::SelfMask::findContainingBody(const btVector3 &pt, bool unscaled) const
+{
+    const unsigned int bs = order_.size();
+    for (unsigned int k = 0 ; k < bs ; ++k)
+    {
+	const unsigned int j = order_[k];
+	if (bspheres_[j].center.distance2(pt) >= bspheresRadius2_[j])
+	    continue;
+	if ((unscaled ? bodies_[j].unscaledBody : bodies_[j].body)->containsPoint(pt))
+	    return j;
+    }
+    return -1;
+}
+
+int robot_self_filter::SelfMask::findIntersectedBody(const btVector3 &pt, const btVector3 &dir, std::vector<btVector3> *intersections) const
+{
+    const unsigned int bs = order_.size();
+    for (unsigned int k = 0 ; k < bs ; ++k)
+    {
+	const unsigned int j = order_[k];
+	if (bodies_[j].body->intersectsRay(pt, dir, intersections, 1))
+	    return j;
+    }
+    return -1;
 }
 
 void robot_self_filter::SelfMask::assumeFrame(const roslib::Header& header, const btVector3 &sensor_pos, double min_sensor_dist)
@@ -332,99 +401,131 @@ void robot_self_filter::SelfMask::maskAuxContainment(const sensor_msgs::PointClo
 {
     const unsigned int bs = bodies_.size();
     const unsigned int np = data_in.points.size();
-    
-    // compute a sphere that bounds the entire robot
-    bodies::BoundingSphere bound;
-    bodies::mergeBoundingSpheres(bspheres_, bound);	  
-    btScalar radiusSquared = bound.radius * bound.radius;
+    std::vector<unsigned int> hits(bs, 0);
     
     // we now decide which points we keep
-#pragma omp parallel for schedule(dynamic) 
-    for (int i = 0 ; i < (int)np ; ++i)
+#pragma omp parallel
     {
-	btVector3 pt = btVector3(data_in.points[i].x, data_in.points[i].y, data_in.points[i].z);
-	int out = OUTSIDE;
-	if (bound.center.distance2(pt) < radiusSquared)
-	    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-		if (bodies_[j].body->containsPoint(pt))
+	std::vector<unsigned int> localHits(bs, 0);
+	
+#pragma omp for schedule(dynamic, 512)
+	for (int i = 0 ; i < (int)np ; ++i)
+	{
+	    btVector3 pt = btVector3(data_in.points[i].x, data_in.points[i].y, data_in.points[i].z);
+	    int out = OUTSIDE;
+	    if (insideRobotBound(pt))
+	    {
+		int b = findContainingBody(pt, false);
+		if (b >= 0)
+		{
+		    localHits[b]++;
 		    out = INSIDE;
+		}
+	    }
+	    
+	    mask[i] = out;
+	}
 	
-	mask[i] = out;
+#pragma omp critical
+	for (unsigned int j = 0 ; j < bs ; ++j)
+	    hits[j] += localHits[j];
     }
+    
+    updateBodyOrder(hits);
 }
 
 void robot_self_filter::SelfMask::maskAuxIntersection(const sensor_msgs::PointCloud& data_in, std::vector<int> &mask, const boost::function<void(const btVector3&)> &callback)
 {
     const unsigned int bs = bodies_.size();
     const unsigned int np = data_in.points.size();
-    
-    // compute a sphere that bounds the entire robot
-    bodies::BoundingSphere bound;
-    bodies::mergeBoundingSpheres(bspheres_, bound);	  
-    btScalar radiusSquared = bound.radius * bound.radius;
+    std::vector<unsigned int> hits(bs, 0);
     
     // we now decide which points we keep
-#pragma omp parallel for schedule(dynamic) 
-    for (int i = 0 ; i < (int)np ; ++i)
+#pragma omp parallel
     {
-	btVector3 pt = btVector3(data_in.points[i].x, data_in.points[i].y, data_in.points[i].z);
-	int out = OUTSIDE;
-
-	// we first check is the point is in the unscaled body. 
-	// if it is, the point is definitely inside
-	if (bound.center.distance2(pt) < radiusSquared)
-	    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-		if (bodies_[j].unscaledBody->containsPoint(pt))
-		    out = INSIDE;
-
-	// if the point is not inside the unscaled body,
-	if (out == OUTSIDE)
+	std::vector<unsigned int> localHits(bs, 0);
+	std::vector<btVector3> intersections;
+	
+#pragma omp for schedule(dynamic, 512)
+	for (int i = 0 ; i < (int)np ; ++i)
 	{
-	    // we check it the point is a shadow point 
-	    btVector3 dir(sensor_pos_ - pt);
-	    btScalar  lng = dir.length();
-	    if (lng < min_sensor_dist_)
-		out = INSIDE;
-	    else
-	    {		
-		dir /= lng;
-		if (callback)
+	    btVector3 pt = btVector3(data_in.points[i].x, data_in.points[i].y, data_in.points[i].z);
+	    int out = OUTSIDE;
+	    const bool inBound = insideRobotBound(pt);
+	    
+	    // we first check is the point is in the unscaled body. 
+	    // if it is, the point is definitely inside
+	    if (inBound)
+	    {
+		int b = findContainingBody(pt, true);
+		if (b >= 0)
 		{
-		    std::vector<btVector3> intersections;
-		    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-			if (bodies_[j].body->intersectsRay(pt, dir, &intersections, 1))
+		    localHits[b]++;
+		    out = INSIDE;
+		}
+	    }
+	    
+	    // if the point is not inside the unscaled body,
+	    if (out == OUTSIDE)
+	    {
+		// we check it the point is a shadow point 
+		btVector3 dir(sensor_pos_ - pt);
+		btScalar  lng = dir.length();
+		if (lng < min_sensor_dist_)
+		    out = INSIDE;
+		else
+		{		
+		    dir /= lng;
+		    if (callback)
+		    {
+			intersections.clear();
+			int b = findIntersectedBody(pt, dir, &intersections);
+			if (b >= 0)
 			{
 			    callback(intersections[0]);
+			    localHits[b]++;
 			    out = SHADOW;
 			}
-		}
-		else
-		{
-		    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-			if (bodies_[j].body->intersectsRay(pt, dir))
+		    }
+		    else
+		    {
+			int b = findIntersectedBody(pt, dir, NULL);
+			if (b >= 0)
+			{
+			    localHits[b]++;
 			    out = SHADOW;
-		}
-		
-		// if it is not a shadow point, we check if it is inside the scaled body
-		if (out == OUTSIDE && bound.center.distance2(pt) < radiusSquared)
-		    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-			if (bodies_[j].body->containsPoint(pt))
+			}
+		    }
+		    
+		    // if it is not a shadow point, we check if it is inside the scaled body
+		    if (out == OUTSIDE && inBound)
+		    {
+			int b = findContainingBody(pt, false);
+			if (b >= 0)
+			{
+			    localHits[b]++;
 			    out = INSIDE;
+			}
+		    }
+		}
 	    }
+	    
+	    mask[i] = out;
 	}
 	
-	mask[i] = out;
+#pragma omp critical
+	for (unsigned int j = 0 ; j < bs ; ++j)
+	    hits[j] += localHits[j];
     }
+    
+    updateBodyOrder(hits);
 }
 
 int robot_self_filter::SelfMask::getMaskContainment(const btVector3 &pt) const
 {
-    const unsigned int bs = bodies_.size();
-    int out = OUTSIDE;
-    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-	if (bodies_[j].body->containsPoint(pt))
-	    out = INSIDE;
-    return out;
+    if (insideRobotBound(pt) && findContainingBody(pt, false) >= 0)
+	return INSIDE;
+    return OUTSIDE;
 }
 
 int robot_self_filter::SelfMask::getMaskContainment(double x, double y, double z) const
@@ -434,14 +535,13 @@ int robot_self_filter::SelfMask::getMaskContainment(double x, double y, double z
 
 int robot_self_filter::SelfMask::getMaskIntersection(const btVector3 &pt, const boost::function<void(const btVector3&)> &callback) const
 {  
-    const unsigned int bs = bodies_.size();
-
+    const bool inBound = insideRobotBound(pt);
+    
     // we first check is the point is in the unscaled body. 
     // if it is, the point is definitely inside
     int out = OUTSIDE;
-    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-	if (bodies_[j].unscaledBody->containsPoint(pt))
-	    out = INSIDE;
+    if (inBound && findContainingBody(pt, true) >= 0)
+	out = INSIDE;
     
     if (out == OUTSIDE)
     {
@@ -458,24 +558,21 @@ int robot_self_filter::SelfMask::getMaskIntersection(const btVector3 &pt, const
 	    if (callback)
 	    {
 		std::vector<btVector3> intersections;
-		for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-		    if (bodies_[j].body->intersectsRay(pt, dir, &intersections, 1))
-		    {
-			callback(intersections[0]);
-			out = SHADOW;
-		    }
+		if (findIntersectedBody(pt, dir, &intersections) >= 0)
+		{
+		    callback(intersections[0]);
+		    out = SHADOW;
+		}
 	    }
 	    else
 	    {
-		for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-		    if (bodies_[j].body->intersectsRay(pt, dir))
-			out = SHADOW;
+		if (findIntersectedBody(pt, dir, NULL) >= 0)
+		    out = SHADOW;
 	    }
 	    
 	    // if it is not a shadow point, we check if it is inside the scaled body
-	    for (unsigned int j = 0 ; out == OUTSIDE && j < bs ; ++j)
-		if (bodies_[j].body->containsPoint(pt))
-		    out = INSIDE;
+	    if (out == OUTSIDE && inBound && findContainingBody(pt, false) >= 0)
+		out = INSIDE;
 	}
     }
     return out;
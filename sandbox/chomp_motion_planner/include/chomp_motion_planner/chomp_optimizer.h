@@ -122,9 +122,6 @@ private:
   // temporary variables for all functions:
   Eigen::VectorXd smoothness_derivative_;
   KDL::JntArray kdl_joint_array_;
-  Eigen::MatrixXd jacobian_;
-  Eigen::MatrixXd jacobian_pseudo_inverse_;
-  Eigen::MatrixXd jacobian_jacobian_tranpose_;
   Eigen::VectorXd random_state_;
   Eigen::VectorXd joint_state_velocities_;
 
@@ -152,7 +149,8 @@ private:
   void getRandomMomentum();
   void updateMomentum();
   void updatePositionFromMomentum();
-  void calculatePseudoInverse();
+  void calculatePseudoInverse(const Eigen::MatrixXd& jacobian, Eigen::MatrixXd& jacobian_jacobian_tranpose,
+      Eigen::MatrixXd& jacobian_pseudo_inverse) const;
 
 };
 
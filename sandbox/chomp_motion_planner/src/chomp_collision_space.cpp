@@ -58,11 +58,14 @@ void ChompCollisionSpace::collisionMapCallback(const mapping_msgs::CollisionMapC
   if (mutex_.try_lock())
   {
     ros::WallTime start = ros::WallTime::now();
-    distance_field_->reset();
-    ROS_INFO("Reset prop distance_field in %f sec", (ros::WallTime::now() - start).toSec());
-    start = ros::WallTime::now();
-    distance_field_->addPointsToField(cuboid_points_);
-    distance_field_->addCollisionMapToField(*collision_map);
+    std::vector<btVector3> points(cuboid_points_);
+    points.reserve(cuboid_points_.size() + collision_map->boxes.size());
+    for (size_t i=0; i<collision_map->boxes.size(); ++i)
+      points.push_back(btVector3(collision_map->boxes[i].center.x,
+                                 collision_map->boxes[i].center.y,
+                                 collision_map->boxes[i].center.z));
+    // only the voxels that changed since the last map are added or removed:
+    distance_field_->updatePointsInField(points);
     mutex_.unlock();
     ROS_INFO("Updated prop distance_field in %f sec", (ros::WallTime::now() - start).toSec());
 
@@ -115,9 +115,6 @@ void ChompOptimizer::initialize()
   collision_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   final_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   smoothness_derivative_ = Eigen::VectorXd::Zero(num_vars_all_);
-  jacobian_ = Eigen::MatrixXd::Zero(3, num_joints_);
-  jacobian_pseudo_inverse_ = Eigen::MatrixXd::Zero(num_joints_, 3);
-  jacobian_jacobian_tranpose_ = Eigen::MatrixXd::Zero(3, 3);
   random_state_ = Eigen::VectorXd::Zero(num_joints_);
   joint_state_velocities_ = Eigen::VectorXd::Zero(num_joints_);
 
@@ -279,61 +276,71 @@ void ChompOptimizer::calculateSmoothnessIncrements()
 
 void ChompOptimizer::calculateCollisionIncrements()
 {
-  double potential;
-  double vel_mag_sq;
-  double vel_mag;
-  Vector3d potential_gradient;
-  Vector3d normalized_velocity;
-  Matrix3d orthogonal_projector;
-  Vector3d curvature_vector;
-  Vector3d cartesian_gradient;
-
   collision_increments_.setZero(num_vars_free_, num_joints_);
-  for (int i=free_vars_start_; i<=free_vars_end_; i++)
+
+  // every trajectory point only writes its own row of the increments, so the points are split between threads
+  #pragma omp parallel
   {
-    for (int j=0; j<num_collision_points_; j++)
+    double potential;
+    double vel_mag_sq;
+    double vel_mag;
+    Vector3d potential_gradient;
+    Vector3d normalized_velocity;
+    Matrix3d orthogonal_projector;
+    Vector3d curvature_vector;
+    Vector3d cartesian_gradient;
+    Eigen::MatrixXd jacobian = Eigen::MatrixXd::Zero(3, num_joints_);
+    Eigen::MatrixXd jacobian_pseudo_inverse = Eigen::MatrixXd::Zero(num_joints_, 3);
+    Eigen::MatrixXd jacobian_jacobian_tranpose = Eigen::MatrixXd::Zero(3, 3);
+
+    #pragma omp for schedule(static)
+    for (int i=free_vars_start_; i<=free_vars_end_; i++)
     {
-      potential = collision_point_potential_[i][j];
-      if (potential <= 1e-10)
-        continue;
+      for (int j=0; j<num_collision_points_; j++)
+      {
+        potential = collision_point_potential_[i][j];
+        if (potential <= 1e-10)
+          continue;
 
-      potential_gradient = collision_point_potential_gradient_[i][j];
+        potential_gradient = collision_point_potential_gradient_[i][j];
 
-      vel_mag = collision_point_vel_mag_[i][j];
-      vel_mag_sq = vel_mag*vel_mag;
+        vel_mag = collision_point_vel_mag_[i][j];
+        vel_mag_sq = vel_mag*vel_mag;
 
-      // all math from the CHOMP paper:
+        // all math from the CHOMP paper:
 
-      normalized_velocity = collision_point_vel_eigen_[i][j] / vel_mag;
-      orthogonal_projector = Matrix3d::Identity() - (normalized_velocity * normalized_velocity.transpose());
-      curvature_vector = (orthogonal_projector * collision_point_acc_eigen_[i][j]) / vel_mag_sq;
-      cartesian_gradient = vel_mag*(orthogonal_projector*potential_gradient - potential*curvature_vector);
+        normalized_velocity = collision_point_vel_eigen_[i][j] / vel_mag;
+        orthogonal_projector = Matrix3d::Identity() - (normalized_velocity * normalized_velocity.transpose());
+        curvature_vector = (orthogonal_projector * collision_point_acc_eigen_[i][j]) / vel_mag_sq;
+        cartesian_gradient = vel_mag*(orthogonal_projector*potential_gradient - potential*curvature_vector);
 
-      // pass it through the jacobian transpose to get the increments
-      planning_group_->collision_points_[j].getJacobian(joint_pos_eigen_[i], joint_axis_eigen_[i],
-          collision_point_pos_eigen_[i][j], jacobian_, group_joint_to_kdl_joint_index_);
-      if (parameters_->getUsePseudoInverse())
-      {
-        calculatePseudoInverse();
-        collision_increments_.row(i-free_vars_start_).transpose() -=
-            jacobian_pseudo_inverse_ * cartesian_gradient;
-      }
-      else
-      {
-        collision_increments_.row(i-free_vars_start_).transpose() -=
-            jacobian_.transpose() * cartesian_gradient;
+        // pass it through the jacobian transpose to get the increments
+        planning_group_->collision_points_[j].getJacobian(joint_pos_eigen_[i], joint_axis_eigen_[i],
+            collision_point_pos_eigen_[i][j], jacobian, group_joint_to_kdl_joint_index_);
+        if (parameters_->getUsePseudoInverse())
+        {
+          calculatePseudoInverse(jacobian, jacobian_jacobian_tranpose, jacobian_pseudo_inverse);
+          collision_increments_.row(i-free_vars_start_).transpose() -=
+              jacobian_pseudo_inverse * cartesian_gradient;
+        }
+        else
+        {
+          collision_increments_.row(i-free_vars_start_).transpose() -=
+              jacobian.transpose() * cartesian_gradient;
+        }
+        if (point_is_in_collision_[i][j])
+          break;
       }
-      if (point_is_in_collision_[i][j])
-        break;
     }
   }
   //cout << collision_increments_ << endl;
 }
 
-void ChompOptimizer::calculatePseudoInverse()
+void ChompOptimizer::calculatePseudoInverse(const Eigen::MatrixXd& jacobian, Eigen::MatrixXd& jacobian_jacobian_tranpose,
+    Eigen::MatrixXd& jacobian_pseudo_inverse) const
 {
-  jacobian_jacobian_tranpose_ = jacobian_*jacobian_.transpose() + Eigen::MatrixXd::Identity(3,3)*parameters_->getPseudoInverseRidgeFactor();
-  jacobian_pseudo_inverse_ = jacobian_.transpose() * jacobian_jacobian_tranpose_.inverse();
+  jacobian_jacobian_tranpose = jacobian*jacobian.transpose() + Eigen::MatrixXd::Identity(3,3)*parameters_->getPseudoInverseRidgeFactor();
+  jacobian_pseudo_inverse = jacobian.transpose() * jacobian_jacobian_tranpose.inverse();
 }
 
 void ChompOptimizer::calculateTotalIncrements()
@@ -498,49 +505,66 @@ void ChompOptimizer::performForwardKinematics()
 
   is_collision_free_ = true;
 
-  // for each point in the trajectory
-  for (int i=start; i<=end; ++i)
+  // JntToCartFull() records the segment evaluation order inside the solver, so it has to run serially.
+  // JntToCartPartial() only reads the solver (and the fixed segment frames computed in the first
+  // iteration), so every trajectory point can be handled by a different thread.
+  if (iteration_==0)
   {
-    int full_traj_index = group_trajectory_.getFullTrajectoryIndex(i);
-    full_trajectory_->getTrajectoryPointKDL(full_traj_index, kdl_joint_array_);
-
-    if (iteration_==0)
+    for (int i=start; i<=end; ++i)
     {
+      int full_traj_index = group_trajectory_.getFullTrajectoryIndex(i);
+      full_trajectory_->getTrajectoryPointKDL(full_traj_index, kdl_joint_array_);
       planning_group_->fk_solver_->JntToCartFull(kdl_joint_array_, joint_pos_[i], joint_axis_[i], segment_frames_[i]);
     }
-    else
-    {
-      planning_group_->fk_solver_->JntToCartPartial(kdl_joint_array_, joint_pos_[i], joint_axis_[i], segment_frames_[i]);
-    }
-    //robot_model_->getForwardKinematicsSolver()->JntToCart(kdl_joint_array_, joint_pos_[i], joint_axis_[i], segment_frames_[i]);
+  }
 
-    state_is_in_collision_[i] = false;
+  #pragma omp parallel
+  {
+    // each thread needs its own joint array:
+    KDL::JntArray kdl_joint_array(kdl_joint_array_.rows());
 
-    // calculate the position of every collision point:
-    for (int j=0; j<num_collision_points_; j++)
+    // for each point in the trajectory
+    #pragma omp for schedule(static)
+    for (int i=start; i<=end; ++i)
     {
-      planning_group_->collision_points_[j].getTransformedPosition(segment_frames_[i], collision_point_pos_[i][j]);
-      //int segment_number = planning_group_->collision_points_[j].getSegmentNumber();
-      //collision_point_pos_[i][j] = segment_frames_[i][segment_number] * planning_group_->collision_points_[j].getPosition();
+      if (iteration_!=0)
+      {
+        int full_traj_index = group_trajectory_.getFullTrajectoryIndex(i);
+        full_trajectory_->getTrajectoryPointKDL(full_traj_index, kdl_joint_array);
+        planning_group_->fk_solver_->JntToCartPartial(kdl_joint_array, joint_pos_[i], joint_axis_[i], segment_frames_[i]);
+      }
 
-      bool colliding = collision_space_->getCollisionPointPotentialGradient(planning_group_->collision_points_[j],
-          collision_point_pos_eigen_[i][j],
-          collision_point_potential_[i][j],
-          collision_point_potential_gradient_[i][j]);
+      state_is_in_collision_[i] = false;
 
-      point_is_in_collision_[i][j] = colliding;
+      // calculate the position of every collision point:
+      for (int j=0; j<num_collision_points_; j++)
+      {
+        planning_group_->collision_points_[j].getTransformedPosition(segment_frames_[i], collision_point_pos_[i][j]);
+
+        bool colliding = collision_space_->getCollisionPointPotentialGradient(planning_group_->collision_points_[j],
+            collision_point_pos_eigen_[i][j],
+            collision_point_potential_[i][j],
+            collision_point_potential_gradient_[i][j]);
 
-      if (colliding)
-        state_is_in_collision_[i] = true;
+        point_is_in_collision_[i][j] = colliding;
+
+        if (colliding)
+          state_is_in_collision_[i] = true;
+      }
     }
+  }
 
+  for (int i=start; i<=end; ++i)
+  {
     if (state_is_in_collision_[i])
     {
       is_collision_free_ = false;
+      break;
     }
   }
 
   // now, get the vel and acc for each collision point (using finite differencing)
+  #pragma omp parallel for schedule(static)
   for (int i=free_vars_start_; i<=free_vars_end_; i++)
   {
     for (int j=0; j<num_collision_points_; j++)
@@ -49,16 +49,17 @@ namespace distance_field
 
 /**
  * \brief Structure that holds voxel information for the DistanceField.
+ *
+ * Only the squared distance and the index of the closest obstacle cell are stored (8 bytes per voxel);
+ * the location of a voxel is implied by its position in the grid.
  */
 struct PropDistanceFieldVoxel
 {
   PropDistanceFieldVoxel();
   PropDistanceFieldVoxel(int distance_sq);
 
-  int distance_square_;         /**< Squared distance from the closest obstacle */
-  int location_[3];             /**< Grid location of this voxel */
-  int closest_point_[3];        /**< Closes obstacle from this voxel */
-  int update_direction_;        /**< Direction from which this voxel was updated */
+  int distance_square_;         /**< Squared distance from the closest obstacle (in cells) */
+  int closest_point_;           /**< Index of the closest obstacle cell in the grid, or UNINITIALIZED */
 
   static const int UNINITIALIZED=-1;
 };
@@ -70,6 +71,10 @@ struct PropDistanceFieldVoxel
  * the closest obstacle in each voxel. Also available is the location of the closest point,
  * and the gradient of the field at a point. Expansion of obstacles is performed upto a given
  * radius.
+ *
+ * Obstacle points can be added and removed incrementally: removing points only clears the
+ * voxels whose closest obstacle was removed, and re-propagates into them from the voxels
+ * around that region.
  */
 class PropagationDistanceField: public DistanceField<PropDistanceFieldVoxel>
 {
@@ -86,20 +91,41 @@ public:
   /**
    * \brief Add (and expand) a set of points to the distance field.
    */
-  virtual void addPointsToField(const std::vector<btVector3> points);
+  virtual void addPointsToField(const std::vector<btVector3>& points);
+
+  /**
+   * \brief Remove a set of obstacle points from the distance field, and update the distances
+   * of the voxels that were closest to them.
+   */
+  void removePointsFromField(const std::vector<btVector3>& points);
+
+  /**
+   * \brief Make the given points the complete set of obstacles. Only the difference to the
+   * current set of obstacles is added or removed, so this is much cheaper than reset()
+   * followed by addPointsToField() when consecutive sensor updates are similar.
+   */
+  void updatePointsInField(const std::vector<btVector3>& points);
 
   /**
    * \brief Resets the distance field to the max_distance.
    */
   virtual void reset();
 
+  /**
+   * \brief Gets the grid location of the obstacle closest to the given cell.
+   *
+   * Returns false if there is no obstacle within max_distance of the cell.
+   */
+  bool getClosestObstacleCell(int x, int y, int z, int& closest_x, int& closest_y, int& closest_z) const;
+
   /**
    * \brief Gets the distance to the closest obstacle and the gradient of the field at a location.
    */
   double getDistanceGradient(double x, double y, double z, double& gradient_x, double& gradient_y, double& gradient_z) const;
 
 private:
-  std::vector<std::vector<PropDistanceFieldVoxel*> > bucket_queue_;
+  std::vector<std::vector<int> > bucket_queue_;     /**< Cell indices to process, bucketed by squared distance */
+  std::vector<int> obstacle_cells_;                 /**< Sorted indices of the cells that are obstacles */
   double max_distance_;
   int max_distance_sq_;
   double inv_twice_resolution_;
@@ -119,15 +145,22 @@ private:
   int getDirectionNumber(int dx, int dy, int dz) const;
   void initNeighborhoods();
   static int eucDistSq(int* point1, int* point2);
+  static int sign(int x);
+
+  void indexToCell(int index, int* cell) const;
+  void pointsToCells(const std::vector<btVector3>& points, std::vector<int>& cells) const;
+  void addObstacleCells(const std::vector<int>& cells);
+  void removeObstacleCells(const std::vector<int>& cells);
+  void updateNeighbor(const int* closest_point, int nx, int ny, int nz);
+  void processQueue();
 };
 
 ////////////////////////// inline functions follow ////////////////////////////////////////
 
 inline PropDistanceFieldVoxel::PropDistanceFieldVoxel(int distance_sq):
-  distance_square_(distance_sq)
+  distance_square_(distance_sq),
+  closest_point_(PropDistanceFieldVoxel::UNINITIALIZED)
 {
-    for (int i=0; i<3; i++)
-      closest_point_[i] = PropDistanceFieldVoxel::UNINITIALIZED;
 }
 
 inline PropDistanceFieldVoxel::PropDistanceFieldVoxel()
@@ -139,6 +172,27 @@ inline double PropagationDistanceField::getDistance(const PropDistanceFieldVoxel
   return sqrt_table_[object.distance_square_];
 }
 
+inline void PropagationDistanceField::indexToCell(int index, int* cell) const
+{
+  cell[DIM_X] = index / stride1_;
+  index -= cell[DIM_X]*stride1_;
+  cell[DIM_Y] = index / stride2_;
+  cell[DIM_Z] = index - cell[DIM_Y]*stride2_;
+}
+
+inline bool PropagationDistanceField::getClosestObstacleCell(int x, int y, int z, int& closest_x, int& closest_y, int& closest_z) const
+{
+  const PropDistanceFieldVoxel& voxel = getCell(x,y,z);
+  if (voxel.closest_point_ == PropDistanceFieldVoxel::UNINITIALIZED)
+    return false;
+  int cell[3];
+  indexToCell(voxel.closest_point_, cell);
+  closest_x = cell[DIM_X];
+  closest_y = cell[DIM_Y];
+  closest_z = cell[DIM_Z];
+  return true;
+}
+
 inline double PropagationDistanceField::getDistanceGradient(double x, double y, double z, double& gradient_x, double& gradient_y, double& gradient_z) const
 {
   int gx, gy, gz;
@@ -36,6 +36,8 @@
 
 #include <distance_field/propagation_distance_field.h>
 #include <visualization_msgs/Marker.h>
+#include <algorithm>
+#include <iterator>
 
 namespace distance_field
 {
@@ -46,7 +48,7 @@ PropagationDistanceField::~PropagationDistanceField()
 
 PropagationDistanceField::PropagationDistanceField(double size_x, double size_y, double size_z, double resolution,
     double origin_x, double origin_y, double origin_z, double max_distance):
-      DistanceField<PropDistanceFieldVoxel>(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, PropDistanceFieldVoxel(max_distance))
+      DistanceField<PropDistanceFieldVoxel>(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, PropDistanceFieldVoxel())
 {
   max_distance_ = max_distance;
   int max_dist_int = int(max_distance_/resolution);
@@ -54,10 +56,16 @@ PropagationDistanceField::PropagationDistanceField(double size_x, double size_y,
   inv_twice_resolution_ = 1.0/(2.0*resolution);
   initNeighborhoods();
 
+  // out-of-bounds cells are reported as being at max_distance:
+  default_object_ = PropDistanceFieldVoxel(max_distance_sq_);
+
   // create a sqrt table:
   sqrt_table_.resize(max_distance_sq_+1);
   for (int i=0; i<=max_distance_sq_; ++i)
     sqrt_table_[i] = sqrt(double(i))*resolution;
+
+  bucket_queue_.resize(max_distance_sq_+1);
+  reset();
 }
 
 int PropagationDistanceField::eucDistSq(int* point1, int* point2)
@@ -68,107 +76,215 @@ int PropagationDistanceField::eucDistSq(int* point1, int* point2)
   return dx*dx + dy*dy + dz*dz;
 }
 
-void PropagationDistanceField::addPointsToField(const std::vector<btVector3> points)
+void PropagationDistanceField::pointsToCells(const std::vector<btVector3>& points, std::vector<int>& cells) const
 {
-  // initialize the bucket queue
-  bucket_queue_.resize(max_distance_sq_+1);
-
-  bucket_queue_[0].reserve(points.size());
-  // first mark all the points as distance=0, and add them to the queue
-  int x, y, z, nx, ny, nz;
-  int loc[3];
-  int initial_update_direction = getDirectionNumber(0,0,0);
+  int x, y, z;
+  cells.clear();
+  cells.reserve(points.size());
   for (unsigned int i=0; i<points.size(); ++i)
   {
     bool valid = worldToGrid(points[i].x(), points[i].y(), points[i].z(), x, y, z);
     if (!valid)
       continue;
-    PropDistanceFieldVoxel& voxel = getCell(x,y,z);
+    cells.push_back(ref(x,y,z));
+  }
+  std::sort(cells.begin(), cells.end());
+  cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+}
+
+void PropagationDistanceField::addPointsToField(const std::vector<btVector3>& points)
+{
+  std::vector<int> cells;
+  pointsToCells(points, cells);
+  addObstacleCells(cells);
+}
+
+void PropagationDistanceField::removePointsFromField(const std::vector<btVector3>& points)
+{
+  std::vector<int> cells;
+  pointsToCells(points, cells);
+  removeObstacleCells(cells);
+}
+
+void PropagationDistanceField::updatePointsInField(const std::vector<btVector3>& points)
+{
+  std::vector<int> cells;
+  pointsToCells(points, cells);
+
+  std::vector<int> old_cells;
+  std::set_difference(obstacle_cells_.begin(), obstacle_cells_.end(), cells.begin(), cells.end(),
+      std::back_inserter(old_cells));
+  std::vector<int> new_cells;
+  std::set_difference(cells.begin(), cells.end(), obstacle_cells_.begin(), obstacle_cells_.end(),
+      std::back_inserter(new_cells));
+
+  removeObstacleCells(old_cells);
+  addObstacleCells(new_cells);
+}
+
+void PropagationDistanceField::addObstacleCells(const std::vector<int>& cells)
+{
+  // first mark all the points as distance=0, and add them to the queue
+  bucket_queue_[0].reserve(cells.size());
+  std::vector<int> new_cells;
+  new_cells.reserve(cells.size());
+  for (unsigned int i=0; i<cells.size(); ++i)
+  {
+    PropDistanceFieldVoxel& voxel = data_[cells[i]];
+    if (voxel.distance_square_ == 0)
+      continue;
     voxel.distance_square_ = 0;
-    voxel.closest_point_[DIM_X] = x;
-    voxel.closest_point_[DIM_Y] = y;
-    voxel.closest_point_[DIM_Z] = z;
-    voxel.location_[DIM_X] = x;
-    voxel.location_[DIM_Y] = y;
-    voxel.location_[DIM_Z] = z;
-    voxel.update_direction_ = initial_update_direction;
-    bucket_queue_[0].push_back(&voxel);
+    voxel.closest_point_ = cells[i];
+    bucket_queue_[0].push_back(cells[i]);
+    new_cells.push_back(cells[i]);
+  }
+
+  std::vector<int> merged;
+  merged.reserve(obstacle_cells_.size() + new_cells.size());
+  std::merge(obstacle_cells_.begin(), obstacle_cells_.end(), new_cells.begin(), new_cells.end(),
+      std::back_inserter(merged));
+  obstacle_cells_.swap(merged);
+
+  processQueue();
+}
+
+void PropagationDistanceField::removeObstacleCells(const std::vector<int>& cells)
+{
+  if (cells.empty())
+    return;
+
+  // clear the obstacle cells themselves:
+  std::vector<int> stack;
+  for (unsigned int i=0; i<cells.size(); ++i)
+  {
+    PropDistanceFieldVoxel& voxel = data_[cells[i]];
+    if (voxel.distance_square_ != 0)
+      continue;
+    voxel = PropDistanceFieldVoxel(max_distance_sq_);
+    stack.push_back(cells[i]);
+  }
+
+  std::vector<int> remaining;
+  remaining.reserve(obstacle_cells_.size());
+  std::set_difference(obstacle_cells_.begin(), obstacle_cells_.end(), cells.begin(), cells.end(),
+      std::back_inserter(remaining));
+  obstacle_cells_.swap(remaining);
+
+  // flood outwards, clearing every voxel whose closest obstacle is no longer an obstacle. Voxels
+  // bordering the cleared region that still have a valid obstacle are the seeds for re-propagation.
+  std::vector<int> seeds;
+  const std::vector<std::vector<int> >& all_neighbors = neighborhoods_[0][getDirectionNumber(0,0,0)];
+  int loc[3];
+  while (!stack.empty())
+  {
+    int index = stack.back();
+    stack.pop_back();
+    indexToCell(index, loc);
+
+    for (unsigned int n=0; n<all_neighbors.size(); n++)
+    {
+      int nx = loc[DIM_X] + all_neighbors[n][DIM_X];
+      int ny = loc[DIM_Y] + all_neighbors[n][DIM_Y];
+      int nz = loc[DIM_Z] + all_neighbors[n][DIM_Z];
+      if (!isCellValid(nx,ny,nz))
+        continue;
+      int neighbor_index = ref(nx,ny,nz);
+      PropDistanceFieldVoxel& neighbor = data_[neighbor_index];
+      if (neighbor.closest_point_ == PropDistanceFieldVoxel::UNINITIALIZED)
+        continue;
+      if (data_[neighbor.closest_point_].distance_square_ != 0)
+      {
+        neighbor = PropDistanceFieldVoxel(max_distance_sq_);
+        stack.push_back(neighbor_index);
+      }
+      else
+      {
+        seeds.push_back(neighbor_index);
+      }
+    }
+  }
+
+  // the seeds were reached from arbitrary directions, so expand them into all of their neighbors:
+  int closest[3];
+  for (unsigned int i=0; i<seeds.size(); ++i)
+  {
+    const PropDistanceFieldVoxel& voxel = data_[seeds[i]];
+    if (voxel.closest_point_ == PropDistanceFieldVoxel::UNINITIALIZED)
+      continue;
+    indexToCell(seeds[i], loc);
+    indexToCell(voxel.closest_point_, closest);
+    for (unsigned int n=0; n<all_neighbors.size(); n++)
+      updateNeighbor(closest, loc[DIM_X] + all_neighbors[n][DIM_X],
+          loc[DIM_Y] + all_neighbors[n][DIM_Y], loc[DIM_Z] + all_neighbors[n][DIM_Z]);
   }
 
-  // now process the queue:
+  processQueue();
+}
+
+void PropagationDistanceField::updateNeighbor(const int* closest_point, int nx, int ny, int nz)
+{
+  if (!isCellValid(nx,ny,nz))
+    return;
+
+  // calculate the neighbor's new distance based on my closest filled voxel:
+  int dx = nx - closest_point[DIM_X];
+  int dy = ny - closest_point[DIM_Y];
+  int dz = nz - closest_point[DIM_Z];
+  int new_distance_sq = dx*dx + dy*dy + dz*dz;
+  if (new_distance_sq > max_distance_sq_)
+    return;
+
+  int neighbor_index = ref(nx,ny,nz);
+  PropDistanceFieldVoxel& neighbor = data_[neighbor_index];
+  if (new_distance_sq < neighbor.distance_square_)
+  {
+    // update the neighboring voxel and put it in the queue:
+    neighbor.distance_square_ = new_distance_sq;
+    neighbor.closest_point_ = ref(closest_point[DIM_X], closest_point[DIM_Y], closest_point[DIM_Z]);
+    bucket_queue_[new_distance_sq].push_back(neighbor_index);
+  }
+}
+
+void PropagationDistanceField::processQueue()
+{
+  int loc[3];
+  int closest[3];
   for (unsigned int i=0; i<bucket_queue_.size(); ++i)
   {
-    std::vector<PropDistanceFieldVoxel*>::iterator list_it = bucket_queue_[i].begin();
-    while(list_it!=bucket_queue_[i].end())
+    // bucket_queue_[i] can grow while it is processed (a diagonal step can keep the distance the same)
+    for (unsigned int q=0; q<bucket_queue_[i].size(); ++q)
     {
-      PropDistanceFieldVoxel* vptr = *list_it;
+      int index = bucket_queue_[i][q];
+      const PropDistanceFieldVoxel& voxel = data_[index];
+
+      // skip the entry if the voxel was improved after it was queued:
+      if (voxel.distance_square_ != int(i))
+        continue;
 
-      x = vptr->location_[DIM_X];
-      y = vptr->location_[DIM_Y];
-      z = vptr->location_[DIM_Z];
+      indexToCell(index, loc);
+      indexToCell(voxel.closest_point_, closest);
 
-      // select the neighborhood list based on the update direction:
-      std::vector<std::vector<int> >* neighborhood;
+      // select the neighborhood list based on the direction from the closest obstacle, which is
+      // the direction this voxel was reached from:
       int D = i;
       if (D>1)
         D=1;
-      // avoid a possible segfault situation:
-      if (vptr->update_direction_<0 || vptr->update_direction_>26)
-      {
-   //     ROS_WARN("Invalid update direction detected: %d", vptr->update_direction_);
-        ++list_it;
-        continue;
-      }
-
-      neighborhood = &neighborhoods_[D][vptr->update_direction_];
+      int direction = getDirectionNumber(sign(loc[DIM_X] - closest[DIM_X]),
+          sign(loc[DIM_Y] - closest[DIM_Y]), sign(loc[DIM_Z] - closest[DIM_Z]));
+      const std::vector<std::vector<int> >& neighborhood = neighborhoods_[D][direction];
 
-      for (unsigned int n=0; n<neighborhood->size(); n++)
-      {
-        int dx = (*neighborhood)[n][DIM_X];
-        int dy = (*neighborhood)[n][DIM_Y];
-        int dz = (*neighborhood)[n][DIM_Z];
-        nx = x + dx;
-        ny = y + dy;
-        nz = z + dz;
-        if (!isCellValid(nx,ny,nz))
-          continue;
-
-        // the real update code:
-        // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &getCell(nx, ny, nz);
-        loc[DIM_X] = nx;
-        loc[DIM_Y] = ny;
-        loc[DIM_Z] = nz;
-        int new_distance_sq = eucDistSq(vptr->closest_point_, loc);
-        if (new_distance_sq > max_distance_sq_)
-          continue;
-        if (new_distance_sq < neighbor->distance_square_)
-        {
-          // update the neighboring voxel
-          neighbor->distance_square_ = new_distance_sq;
-          neighbor->closest_point_[DIM_X] = vptr->closest_point_[DIM_X];
-          neighbor->closest_point_[DIM_Y] = vptr->closest_point_[DIM_Y];
-          neighbor->closest_point_[DIM_Z] = vptr->closest_point_[DIM_Z];
-          neighbor->location_[DIM_X] = loc[DIM_X];
-          neighbor->location_[DIM_Y] = loc[DIM_Y];
-          neighbor->location_[DIM_Z] = loc[DIM_Z];
-          neighbor->update_direction_ = getDirectionNumber(dx, dy, dz);
-
-          // and put it in the queue:
-          bucket_queue_[new_distance_sq].push_back(neighbor);
-        }
-      }
-
-      ++list_it;
+      for (unsigned int n=0; n<neighborhood.size(); n++)
+        updateNeighbor(closest, loc[DIM_X] + neighborhood[n][DIM_X],
+            loc[DIM_Y] + neighborhood[n][DIM_Y], loc[DIM_Z] + neighborhood[n][DIM_Z]);
     }
     bucket_queue_[i].clear();
   }
-
 }
 
 void PropagationDistanceField::reset()
 {
   VoxelGrid<PropDistanceFieldVoxel>::reset(PropDistanceFieldVoxel(max_distance_sq_));
+  obstacle_cells_.clear();
 }
 
 void PropagationDistanceField::initNeighborhoods()
@@ -235,6 +351,11 @@ void PropagationDistanceField::initNeighborhoods()
 
 }
 
+int PropagationDistanceField::sign(int x)
+{
+  return (x>0) - (x<0);
+}
+
 int PropagationDistanceField::getDirectionNumber(int dx, int dy, int dz) const
 {
   return (dx+1)*9 + (dy+1)*3 + dz+1;
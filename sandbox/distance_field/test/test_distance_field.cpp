@@ -38,7 +38,9 @@
 
 #include <distance_field/voxel_grid.h>
 #include <distance_field/distance_field.h>
+#include <distance_field/propagation_distance_field.h>
 #include <ros/ros.h>
+#include <cstdlib>
 
 using namespace distance_field;
 
@@ -51,3 +53,67 @@ using namespace distance_field;
   df.addPointsToField(points);
 }
 */
+
+static const double width = 0.4;
+static const double height = 0.3;
+static const double depth = 0.2;
+static const double resolution = 0.02;
+static const double max_dist = 0.1;
+
+static void randomPoints(int num, std::vector<btVector3>& points)
+{
+  for (int i=0; i<num; i++)
+  {
+    points.push_back(btVector3(width*(rand()/(RAND_MAX+1.0)),
+                               height*(rand()/(RAND_MAX+1.0)),
+                               depth*(rand()/(RAND_MAX+1.0))));
+  }
+}
+
+static void expectSameDistances(const PropagationDistanceField& df, const PropagationDistanceField& ref)
+{
+  int num_x = ref.getNumCells(PropagationDistanceField::DIM_X);
+  int num_y = ref.getNumCells(PropagationDistanceField::DIM_Y);
+  int num_z = ref.getNumCells(PropagationDistanceField::DIM_Z);
+
+  for (int x=0; x<num_x; x++)
+    for (int y=0; y<num_y; y++)
+      for (int z=0; z<num_z; z++)
+      {
+        EXPECT_EQ(ref.getDistanceFromCell(x,y,z), df.getDistanceFromCell(x,y,z))
+          << "cell " << x << " " << y << " " << z;
+      }
+}
+
+TEST(TestPropagationDistanceField, TestIncrementalUpdates)
+{
+  srand(2009);
+  PropagationDistanceField df(width, height, depth, resolution, 0.0, 0.0, 0.0, max_dist);
+
+  std::vector<btVector3> first;
+  randomPoints(40, first);
+  df.addPointsToField(first);
+
+  std::vector<btVector3> second;
+  randomPoints(40, second);
+  df.addPointsToField(second);
+
+  // remove half of the first batch, the other half stays
+  std::vector<btVector3> removed(first.begin(), first.begin()+20);
+  df.removePointsFromField(removed);
+
+  // replace the complete set with part of what is left plus new points
+  std::vector<btVector3> final_points(first.begin()+20, first.end());
+  final_points.insert(final_points.end(), second.begin(), second.begin()+25);
+  randomPoints(30, final_points);
+  df.updatePointsInField(final_points);
+
+  PropagationDistanceField ref(width, height, depth, resolution, 0.0, 0.0, 0.0, max_dist);
+  ref.addPointsToField(final_points);
+  expectSameDistances(df, ref);
+
+  // removing everything leaves the same field as one that never had obstacles
+  df.removePointsFromField(final_points);
+  ref.reset();
+  expectSameDistances(df, ref);
+}
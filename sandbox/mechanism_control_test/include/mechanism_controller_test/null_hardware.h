@@ -17,8 +17,15 @@ public:
    */
   ~NullHardware();
 
-  void update();
+  /*!
+   * \brief Simulates the actuators for dt seconds: each one is a unit inertia
+   * with some damping, driven by its commanded effort
+   */
+  void update(double dt);
 
+  /*!
+   * \brief Creates an actuator for every actuator named by the transmissions
+   */
   void initXml(TiXmlElement *config);
 
   pr2_mechanism::HardwareInterface *hw_;
@@ -0,0 +1,30 @@
+#ifndef REALTIME_TRACKER_H
+#define REALTIME_TRACKER_H
+
+/*!
+ * \brief Counts the heap allocations and blocking mutex locks made by a
+ * thread while tracking is on.
+ *
+ * Linking realtime_tracker.cpp into an executable interposes malloc, calloc,
+ * realloc and pthread_mutex_lock for the whole process (operator new and
+ * boost::mutex go through them), so the counts include calls made inside
+ * shared libraries and plugins. Calls from threads that are not tracking are
+ * passed straight through.
+ */
+class RealtimeTracker
+{
+public:
+  /// Starts counting on the calling thread, from zero
+  static void start();
+
+  /// Stops counting on the calling thread. The counts are kept until the next start()
+  static void stop();
+
+  /// Heap allocations made by the calling thread since start()
+  static unsigned long allocations();
+
+  /// Blocking mutex locks made by the calling thread since start()
+  static unsigned long locks();
+};
+
+#endif
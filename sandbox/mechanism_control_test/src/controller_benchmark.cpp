@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2009, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs controllers in a realtime loop against simulated hardware and reports
+ * how long their update() takes, and whether they allocate memory or block on
+ * a mutex while doing it.
+ *
+ * The controllers are spawned the way mechanism control spawns them: each
+ * name on the command line must have its "type" and configuration on the
+ * parameter server. They are started, then updated for the given number of
+ * cycles at the given rate. For each controller the latency percentiles of
+ * update() are printed, along with the number of heap allocations and
+ * blocking locks made in starting() and update(). Any controller that made
+ * one is flagged, and the exit status is then 1.
+ *
+ * Usage: controller_benchmark -x <file|param> [-n cycles] [-r rate] controller...
+ */
+
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <ros/ros.h>
+#include <boost/thread/thread.hpp>
+#include <tinyxml/tinyxml.h>
+#include <pluginlib/class_loader.h>
+#include <pr2_controller_interface/controller.h>
+#include <pr2_mechanism_control/controller_spec.h>
+#include <pr2_mechanism_control/scheduler.h>
+#include <mechanism_controller_test/null_hardware.h>
+#include <mechanism_controller_test/realtime_tracker.h>
+
+
+static struct
+{
+  char *program_;
+  char *xml_;
+  int cycles_;
+  double rate_;
+} g_options;
+
+static const int NSEC_PER_SEC = 1e+9;
+
+void Usage(std::string msg = "")
+{
+  fprintf(stderr, "Usage: %s [options] controller...\n", g_options.program_);
+  fprintf(stderr, "  Available options\n");
+  fprintf(stderr, "    -x, --xml <file|param>      Load the robot description from this file or parameter name\n");
+  fprintf(stderr, "    -n, --cycles <n>            Number of control cycles to run (default 10000)\n");
+  fprintf(stderr, "    -r, --rate <hz>             Control loop rate (default 1000)\n");
+  fprintf(stderr, "    -h, --help                  Print this message and exit\n");
+  if (msg != "")
+  {
+    fprintf(stderr, "Error: %s\n", msg.c_str());
+    exit(-1);
+  }
+  else
+  {
+    exit(0);
+  }
+}
+
+static inline double now()
+{
+  struct timespec n;
+  clock_gettime(CLOCK_MONOTONIC, &n);
+  return double(n.tv_nsec) / NSEC_PER_SEC + n.tv_sec;
+}
+
+void spinThread()
+{
+  ros::spin();
+}
+
+
+/// Gives the controllers access to each other, as mechanism control does
+class BenchmarkProvider : public controller::ControllerProvider
+{
+public:
+  std::vector<ControllerSpec> controllers_;
+
+  controller::Controller* getControllerByName(const std::string& name)
+  {
+    for (size_t i = 0; i < controllers_.size(); ++i)
+    {
+      if (controllers_[i].name == name)
+        return controllers_[i].c.get();
+    }
+    return NULL;
+  }
+};
+
+
+/// Update times and realtime violations of one controller, or of the whole cycle
+struct Measurements
+{
+  std::string name;
+  std::vector<double> times;
+  unsigned long allocations, locks;
+
+  Measurements(const std::string &n, int cycles) : name(n), allocations(0), locks(0)
+  {
+    times.reserve(cycles);
+  }
+
+  void track()
+  {
+    allocations += RealtimeTracker::allocations();
+    locks += RealtimeTracker::locks();
+  }
+
+  double percentile(double p) const
+  {
+    size_t i = std::min(times.size() - 1, size_t(p * times.size()));
+    return times[i];
+  }
+
+  bool print()
+  {
+    std::sort(times.begin(), times.end());
+    bool violated = allocations > 0 || locks > 0;
+    printf("%-32s %8.1f %8.1f %8.1f %8.1f %8.1f %8lu %8lu%s\n", name.c_str(),
+           percentile(0.5) * 1e+6, percentile(0.9) * 1e+6, percentile(0.99) * 1e+6,
+           percentile(0.999) * 1e+6, times.back() * 1e+6, allocations, locks,
+           violated ? "  NOT REALTIME SAFE" : "");
+    return !violated;
+  }
+};
+
+
+int benchmark(const std::vector<std::string> &names)
+{
+  ros::NodeHandle node;
+
+  // Load robot description
+  TiXmlDocument xml;
+  struct stat st;
+  if (0 == stat(g_options.xml_, &st))
+  {
+    xml.LoadFile(g_options.xml_);
+  }
+  else
+  {
+    ROS_INFO("Xml file not found, reading from parameter server\n");
+    std::string result;
+    if (node.getParam(g_options.xml_, result))
+      xml.Parse(result.c_str());
+    else
+    {
+      ROS_FATAL("Could not load the xml from parameter server: %s\n", g_options.xml_);
+      return -1;
+    }
+  }
+  TiXmlElement *root_element = xml.RootElement();
+  TiXmlElement *root = xml.FirstChildElement("robot");
+  if (!root || !root_element)
+  {
+    ROS_FATAL("Could not parse the xml from %s\n", g_options.xml_);
+    return -1;
+  }
+
+  // Simulated hardware, with the actuators the transmissions ask for
+  NullHardware hw;
+  hw.initXml(root);
+  hw.hw_->current_time_ = ros::Time::now();
+  pr2_mechanism::Robot model(hw.hw_);
+  if (!model.initXml(root))
+  {
+    ROS_FATAL("Could not initialize the robot model from %s\n", g_options.xml_);
+    return -1;
+  }
+  pr2_mechanism::RobotState state(&model);
+  state.propagateState();
+
+  // Spawn the controllers
+  pluginlib::ClassLoader<controller::Controller> controller_loader("pr2_controller_interface", "controller::Controller");
+  BenchmarkProvider provider;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    ros::NodeHandle c_node(node, names[i]);
+    std::string type;
+    if (!c_node.getParam("type", type))
+    {
+      ROS_FATAL("Could not spawn controller '%s' because the type was not specified", names[i].c_str());
+      return -1;
+    }
+
+    controller::Controller *c = NULL;
+    try {
+      c = controller_loader.createClassInstance(type, true);
+    }
+    catch (const std::runtime_error &ex)
+    {
+      ROS_ERROR("Could not load class %s: %s", type.c_str(), ex.what());
+    }
+    if (c == NULL)
+    {
+      ROS_FATAL("Could not spawn controller '%s' because controller type '%s' does not exist",
+                names[i].c_str(), type.c_str());
+      return -1;
+    }
+
+    if (!c->initRequest(&provider, &state, c_node))
+    {
+      delete c;
+      ROS_FATAL("Initializing controller '%s' failed", names[i].c_str());
+      return -1;
+    }
+
+    provider.controllers_.resize(provider.controllers_.size() + 1);
+    provider.controllers_.back().name = names[i];
+    provider.controllers_.back().c.reset(c);
+  }
+
+  std::vector<size_t> schedule;
+  if (!scheduleControllers(provider.controllers_, schedule))
+  {
+    ROS_FATAL("Scheduling the controllers failed");
+    return -1;
+  }
+  std::vector<ControllerSpec> &controllers = provider.controllers_;
+
+  // All the memory the loop needs, allocated up front
+  std::vector<Measurements> measurements;
+  for (size_t i = 0; i < controllers.size(); ++i)
+    measurements.push_back(Measurements(controllers[schedule[i]].name, g_options.cycles_));
+  Measurements cycle("(whole cycle)", g_options.cycles_);
+  Measurements jitter("(wakeup jitter)", g_options.cycles_);
+
+  // Starts up a thread to handle ROS calls
+  boost::thread t(spinThread);
+  t.detach();
+
+  // Set to realtime scheduler for this thread
+  struct sched_param thread_param;
+  int policy = SCHED_FIFO;
+  thread_param.sched_priority = sched_get_priority_max(policy);
+  if (pthread_setschedparam(pthread_self(), policy, &thread_param) != 0)
+    ROS_WARN("Could not switch to the realtime scheduler; expect more jitter");
+
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    RealtimeTracker::start();
+    bool started = controllers[schedule[i]].c->startRequest();
+    RealtimeTracker::stop();
+    measurements[i].track();
+    if (!started)
+      ROS_WARN("Controller '%s' failed to start", measurements[i].name.c_str());
+  }
+
+  struct timespec tick;
+  clock_gettime(CLOCK_MONOTONIC, &tick);
+  int period = NSEC_PER_SEC / g_options.rate_;
+  double dt = 1.0 / g_options.rate_;
+
+  for (int n = 0; n < g_options.cycles_ && ros::ok(); ++n)
+  {
+    hw.update(dt);
+    hw.hw_->current_time_ = ros::Time::now();
+
+    double start = now();
+    state.propagateState();
+    state.zeroCommands();
+
+    // Update all controllers in scheduling order
+    for (size_t i = 0; i < controllers.size(); ++i)
+    {
+      double start = now();
+      RealtimeTracker::start();
+      controllers[schedule[i]].c->updateRequest();
+      RealtimeTracker::stop();
+      measurements[i].times.push_back(now() - start);
+      measurements[i].track();
+    }
+
+    state.enforceSafety();
+    state.propagateEffort();
+    cycle.times.push_back(now() - start);
+
+    tick.tv_nsec += period;
+    while (tick.tv_nsec >= NSEC_PER_SEC)
+    {
+      tick.tv_nsec -= NSEC_PER_SEC;
+      tick.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tick, NULL);
+    jitter.times.push_back(now() - (tick.tv_sec + double(tick.tv_nsec) / NSEC_PER_SEC));
+  }
+
+  for (size_t i = 0; i < controllers.size(); ++i)
+    controllers[schedule[i]].c->stopRequest();
+
+  if (cycle.times.empty())
+    return -1;
+
+  printf("%d cycles at %.0f Hz, times in us\n", int(cycle.times.size()), g_options.rate_);
+  printf("%-32s %8s %8s %8s %8s %8s %8s %8s\n", "controller", "50%", "90%", "99%", "99.9%", "max", "allocs", "locks");
+  bool safe = true;
+  for (size_t i = 0; i < measurements.size(); ++i)
+    safe = measurements[i].print() && safe;
+  cycle.print();
+  jitter.print();
+
+  return safe ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+  // Keep the kernel from swapping us out
+  mlockall(MCL_CURRENT | MCL_FUTURE);
+
+  ros::init(argc, argv, "controller_benchmark");
+
+  // Parse options
+  g_options.program_ = argv[0];
+  g_options.cycles_ = 10000;
+  g_options.rate_ = 1000.0;
+  while (1)
+  {
+    static struct option long_options[] = {
+      {"help", no_argument, 0, 'h'},
+      {"xml", required_argument, 0, 'x'},
+      {"cycles", required_argument, 0, 'n'},
+      {"rate", required_argument, 0, 'r'},
+      {0, 0, 0, 0}
+    };
+    int option_index = 0;
+    int c = getopt_long(argc, argv, "hx:n:r:", long_options, &option_index);
+    if (c == -1) break;
+    switch (c)
+    {
+      case 'h':
+        Usage();
+        break;
+      case 'x':
+        g_options.xml_ = optarg;
+        break;
+      case 'n':
+        g_options.cycles_ = atoi(optarg);
+        break;
+      case 'r':
+        g_options.rate_ = atof(optarg);
+        break;
+    }
+  }
+
+  if (!g_options.xml_)
+    Usage("You must specify a robot description XML file");
+  if (g_options.cycles_ <= 0 || g_options.rate_ <= 0)
+    Usage("The number of cycles and the rate must be positive");
+  if (optind == argc)
+    Usage("You must name at least one controller");
+
+  std::vector<std::string> names(argv + optind, argv + argc);
+  int result = benchmark(names);
+
+  ros::shutdown();
+  return result;
+}
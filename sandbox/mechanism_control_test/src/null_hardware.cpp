@@ -1,11 +1,50 @@
 #include <mechanism_controller_test/null_hardware.h>
 
+static const double DAMPING = 10.0;
+
 NullHardware::NullHardware(){
   hw_ = new pr2_mechanism::HardwareInterface(0);
 }
 
 NullHardware::~NullHardware(){
+  delete hw_;
+}
+
+void NullHardware::update(double dt){
+  for (size_t i = 0; i < hw_->actuators_.size(); ++i)
+  {
+    pr2_mechanism::ActuatorState &state = hw_->actuators_[i]->state_;
+    const pr2_mechanism::ActuatorCommand &command = hw_->actuators_[i]->command_;
+
+    state.is_enabled_ = command.enable_;
+    state.last_requested_effort_ = command.effort_;
+    state.last_commanded_effort_ = command.effort_;
+    state.last_measured_effort_ = command.effort_;
+
+    // Semi-implicit, so stiff controllers don't blow the simulation up
+    state.velocity_ = (state.velocity_ + command.effort_ * dt) / (1.0 + DAMPING * dt);
+    state.encoder_velocity_ = state.velocity_;
+    state.position_ += state.velocity_ * dt;
+    state.timestamp_ += dt;
+  }
 }
 
 void NullHardware::initXml(TiXmlElement *config){
+  for (TiXmlElement *t = config->FirstChildElement("transmission"); t;
+       t = t->NextSiblingElement("transmission"))
+  {
+    for (TiXmlElement *a = t->FirstChildElement("actuator"); a;
+         a = a->NextSiblingElement("actuator"))
+    {
+      const char *name = a->Attribute("name");
+      if (!name)
+        continue;
+
+      bool exists = false;
+      for (size_t i = 0; i < hw_->actuators_.size() && !exists; ++i)
+        exists = hw_->actuators_[i]->name_ == name;
+      if (!exists)
+        hw_->actuators_.push_back(new pr2_mechanism::Actuator(name));
+    }
+  }
 }
@@ -0,0 +1,84 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <mechanism_controller_test/realtime_tracker.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// glibc's own allocator entry points, which malloc and friends forward to
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static __thread bool g_tracking = false;
+static __thread unsigned long g_allocations = 0;
+static __thread unsigned long g_locks = 0;
+
+typedef int (*MutexLockFunction)(pthread_mutex_t *);
+static MutexLockFunction g_mutex_lock = NULL;
+
+// Looked up before main, while there is only one thread, so that
+// pthread_mutex_lock never has to call dlsym itself
+static void __attribute__((constructor)) findMutexLock()
+{
+  g_mutex_lock = (MutexLockFunction)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+  if (!g_mutex_lock)
+  {
+    fprintf(stderr, "RealtimeTracker: could not find pthread_mutex_lock: %s\n", dlerror());
+    abort();
+  }
+}
+
+extern "C" void *malloc(size_t size)
+{
+  if (g_tracking)
+    ++g_allocations;
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+  if (g_tracking)
+    ++g_allocations;
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+  if (g_tracking)
+    ++g_allocations;
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex)
+{
+  if (g_tracking)
+    ++g_locks;
+  if (!g_mutex_lock)
+    findMutexLock();
+  return g_mutex_lock(mutex);
+}
+
+void RealtimeTracker::start()
+{
+  g_allocations = 0;
+  g_locks = 0;
+  g_tracking = true;
+}
+
+void RealtimeTracker::stop()
+{
+  g_tracking = false;
+}
+
+unsigned long RealtimeTracker::allocations()
+{
+  return g_allocations;
+}
+
+unsigned long RealtimeTracker::locks()
+{
+  return g_locks;
+}
@@ -335,10 +335,10 @@ double TemplateModel::fitPointCloud(const sensor_msgs::PointCloud& cloud, const
 		int x, y, z;
 		double val;
 		if (distance_voxel_grid_->worldToGrid(wx,wy,wz,x,y,z)) {
-			distance_field::PropDistanceFieldVoxel& voxel = distance_voxel_grid_->getCell(x,y,z);
+			int closest_x = x, closest_y = y, closest_z = z;
+			distance_voxel_grid_->getClosestObstacleCell(x,y,z,closest_x,closest_y,closest_z);
 			double cx, cy, cz;
-			distance_voxel_grid_->gridToWorld(voxel.closest_point_[0],voxel.closest_point_[1],voxel.closest_point_[2],
-						cx,cy,cz);
+			distance_voxel_grid_->gridToWorld(closest_x,closest_y,closest_z,cx,cy,cz);
 			val = distance_voxel_grid_->getDistanceFromCell(x,y,z);
 			vector.x += (cx-wx);
 			vector.y += (cy-wy);
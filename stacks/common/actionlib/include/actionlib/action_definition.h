@@ -55,6 +55,13 @@ namespace actionlib {
   \
   typedef boost::shared_ptr<const ActionFeedback> ActionFeedbackConstPtr; \
   typedef boost::shared_ptr<const Feedback> FeedbackConstPtr;
+
+  /**
+   * The header.frame_id of a GoalStatusArray that only carries the goals
+   * whose status changed since the last one. Goals missing from such an
+   * array are not lost.
+   */
+  static const char* const INCREMENTAL_STATUS_FRAME = "incremental";
 };
 #endif
 
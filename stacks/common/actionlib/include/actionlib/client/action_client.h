@@ -210,7 +210,9 @@ private:
     manager_.registerSendGoalFunc(boost::bind(&ActionClientT::sendGoalFunc, this, _1));
     manager_.registerCancelFunc(boost::bind(&ActionClientT::sendCancelFunc, this, _1));
 
-    status_sub_   = queue_subscribe("status",   1, &ActionClientT::statusCb,   this, queue);
+    //a server publishing incremental status sends only the goals that
+    //changed in each array, so none of them can be dropped for a newer one
+    status_sub_   = queue_subscribe("status",  50, &ActionClientT::statusCb,   this, queue);
     feedback_sub_ = queue_subscribe("feedback", 1, &ActionClientT::feedbackCb, this, queue);
     result_sub_   = queue_subscribe("result",   1, &ActionClientT::resultCb,   this, queue);
   }
@@ -159,6 +159,10 @@ void CommStateMachine<ActionSpec>::updateStatus(GoalHandleT& gh, const actionlib
     latest_goal_status_ = *goal_status;
   else
   {
+    // Incremental status only carries the goals that changed, so our goal not being in it means nothing
+    if (status_array->header.frame_id == INCREMENTAL_STATUS_FRAME)
+      return;
+
     if (state_ != CommState::WAITING_FOR_GOAL_ACK &&
         state_ != CommState::WAITING_FOR_RESULT &&
         state_ != CommState::DONE)
@@ -50,7 +50,11 @@
 #include <actionlib/server/handle_tracker_deleter.h>
 #include <actionlib/server/server_goal_handle.h>
 
+#include <boost/unordered_map.hpp>
+
 #include <list>
+#include <deque>
+#include <set>
 
 namespace actionlib {
   /**
@@ -144,7 +148,14 @@ namespace actionlib {
       void goalCallback(const boost::shared_ptr<const ActionGoal>& goal);
 
       /**
-       * @brief  Publish status for all goals on a timer event
+       * @brief  Request cancellation of a goal in the status list on behalf of the client
+       * @param it The goal to cancel
+       */
+      void cancelGoal(typename std::list<StatusTracker<ActionSpec> >::iterator it);
+
+      /**
+       * @brief  Publish status for all goals on a timer event, or only the
+       * goals that changed if status is published incrementally
        */
       void publishStatus(const ros::TimerEvent& e);
 
@@ -153,6 +164,31 @@ namespace actionlib {
        */
       void publishStatus();
 
+      /**
+       * @brief  Add a goal to the status list and the goal index
+       * @param tracker The StatusTracker for the goal
+       * @return An iterator to the goal in the status list
+       */
+      typename std::list<StatusTracker<ActionSpec> >::iterator addGoal(const StatusTracker<ActionSpec>& tracker);
+
+      /**
+       * @brief  Mark a goal as having no GoalHandles left, so that it is removed
+       * from the status list status_list_timeout from now
+       * @param it The goal that has no GoalHandles left
+       */
+      void expireGoal(typename std::list<StatusTracker<ActionSpec> >::iterator it);
+
+      /**
+       * @brief  Remove goals whose time in the status list without a GoalHandle has run out
+       */
+      void removeExpiredGoals();
+
+      /**
+       * @brief  Record that the status of a goal has changed, for incremental status publishing
+       * @param status The new status of the goal
+       */
+      void statusChanged(const actionlib_msgs::GoalStatus& status);
+
       ros::NodeHandle node_;
 
       ros::Subscriber goal_sub_, cancel_sub_;
@@ -164,12 +200,28 @@ namespace actionlib {
 
       std::list<StatusTracker<ActionSpec> > status_list_;
 
+      //the goals in status_list_ by goal id
+      boost::unordered_map<std::string, typename std::list<StatusTracker<ActionSpec> >::iterator> goal_index_;
+
+      //goals with no GoalHandles left, in the order their handles went away,
+      //with the handle_destruction_time_ they were queued with
+      std::deque<std::pair<ros::Time, std::string> > expiry_queue_;
+
+      //ids of the goals whose status changed since status was last published
+      std::set<std::string> changed_goals_;
+
       boost::function<void (GoalHandle)> goal_callback_;
       boost::function<void (GoalHandle)> cancel_callback_;
 
       ros::Time last_cancel_;
       ros::Duration status_list_timeout_;
 
+      //if set, only goals whose status changed are published, with the full
+      //status list every status_snapshot_period_
+      bool incremental_status_;
+      ros::Duration status_snapshot_period_;
+      ros::Time last_snapshot_;
+
       //we need to allow access to our private fields to our helper classes
       friend class ServerGoalHandle<ActionSpec>;
       friend class HandleTrackerDeleter<ActionSpec>;
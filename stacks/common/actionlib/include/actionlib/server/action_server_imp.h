@@ -47,7 +47,7 @@ namespace actionlib {
       boost::function<void (GoalHandle)> goal_cb,
       boost::function<void (GoalHandle)> cancel_cb,
       bool auto_start)
-    : node_(n, name), goal_callback_(goal_cb), cancel_callback_(cancel_cb), started_(auto_start) {
+    : node_(n, name), goal_callback_(goal_cb), cancel_callback_(cancel_cb), incremental_status_(false), started_(auto_start) {
 
       //if we're to autostart... then we'll initialize things
       if(started_){ 
@@ -58,7 +58,12 @@ namespace actionlib {
 
   template <class ActionSpec>
   void ActionServer<ActionSpec>::initialize(){
-      status_pub_ = node_.advertise<actionlib_msgs::GoalStatusArray>("status", 1);
+      //clients must understand incremental status, so it is off by default
+      node_.param("incremental_status", incremental_status_, false);
+
+      //incremental arrays only carry the goals that changed, so a burst of
+      //transitions must not overwrite each other in the publisher queue
+      status_pub_ = node_.advertise<actionlib_msgs::GoalStatusArray>("status", incremental_status_ ? 50 : 1);
       result_pub_ = node_.advertise<ActionResult>("result", 1);
       feedback_pub_ = node_.advertise<ActionFeedback>("feedback", 1);
 
@@ -69,12 +74,15 @@ namespace actionlib {
           boost::bind(&ActionServer::cancelCallback, this, _1));
 
       //read the frequency with which to publish status from the parameter server
-      double status_frequency, status_list_timeout;
+      double status_frequency, status_list_timeout, status_snapshot_period;
       node_.param("status_frequency", status_frequency, 5.0);
       node_.param("status_list_timeout", status_list_timeout, 5.0);
 
       status_list_timeout_ = ros::Duration(status_list_timeout);
 
+      node_.param("status_snapshot_period", status_snapshot_period, 1.0);
+      status_snapshot_period_ = ros::Duration(status_snapshot_period);
+
       status_timer_ = node_.createTimer(ros::Duration(1.0 / status_frequency),
           boost::bind(&ActionServer::publishStatus, this, _1));
   }
@@ -97,6 +105,9 @@ namespace actionlib {
     ar->status = status;
     ar->result = result;
     result_pub_.publish(ar);
+
+    //a result goes with a change to a terminal status
+    statusChanged(status);
   }
 
   template <class ActionSpec>
@@ -120,48 +131,38 @@ namespace actionlib {
     //we need to handle a cancel for the user
     ROS_DEBUG("The action server has received a new cancel request");
     bool goal_id_found = false;
-    for(typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.begin(); it != status_list_.end(); ++it){
-      //check if the goal id is zero or if it is equal to the goal id of
-      //the iterator or if the time of the iterator warrants a cancel
-      if(
-          (goal_id->id == "" && goal_id->stamp == ros::Time()) //id and stamp 0 --> cancel everything
-          || goal_id->id == (*it).status_.goal_id.id //ids match... cancel that goal
-          || (goal_id->stamp != ros::Time() && (*it).status_.goal_id.stamp <= goal_id->stamp) //stamp != 0 --> cancel everything before stamp
-        ){
-        //we need to check if we need to store this cancel request for later
-        if(goal_id->id == (*it).status_.goal_id.id)
-          goal_id_found = true;
-
-        //attempt to get the handle_tracker for the list item if it exists
-        boost::shared_ptr<void> handle_tracker = (*it).handle_tracker_.lock();
-
-        if((*it).handle_tracker_.expired()){
-          //if the handle tracker is expired, then we need to create a new one
-          HandleTrackerDeleter<ActionSpec> d(this, it);
-          handle_tracker = boost::shared_ptr<void>((void *)NULL, d);
-          (*it).handle_tracker_ = handle_tracker;
-
-          //we also need to reset the time that the status is supposed to be removed from the list
-          (*it).handle_destruction_time_ = ros::Time();
-        }
-
-        //set the status of the goal to PREEMPTING or RECALLING as approriate
-        //and check if the request should be passed on to the user
-        GoalHandle gh(it, this, handle_tracker);
-        if(gh.setCancelRequested()){
-          //call the user's cancel callback on the relevant goal
-          cancel_callback_(gh);
+    if(goal_id->id != "" && goal_id->stamp == ros::Time()){
+      //a cancel for a single goal, which we can look up by its id
+      typename boost::unordered_map<std::string, typename std::list<StatusTracker<ActionSpec> >::iterator>::iterator index_it = goal_index_.find(goal_id->id);
+      if(index_it != goal_index_.end()){
+        goal_id_found = true;
+        cancelGoal(index_it->second);
+      }
+    }
+    else{
+      for(typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.begin(); it != status_list_.end(); ++it){
+        //check if the goal id is zero or if it is equal to the goal id of
+        //the iterator or if the time of the iterator warrants a cancel
+        if(
+            (goal_id->id == "" && goal_id->stamp == ros::Time()) //id and stamp 0 --> cancel everything
+            || goal_id->id == (*it).status_.goal_id.id //ids match... cancel that goal
+            || (goal_id->stamp != ros::Time() && (*it).status_.goal_id.stamp <= goal_id->stamp) //stamp != 0 --> cancel everything before stamp
+          ){
+          //we need to check if we need to store this cancel request for later
+          if(goal_id->id == (*it).status_.goal_id.id)
+            goal_id_found = true;
+
+          cancelGoal(it);
         }
       }
-
     }
 
     //if the requested goal_id was not found, and it is non-zero, then we need to store the cancel request
     if(goal_id->id != "" && !goal_id_found){
-      typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.insert(status_list_.end(),
+      typename std::list<StatusTracker<ActionSpec> >::iterator it = addGoal(
           StatusTracker<ActionSpec> (*goal_id, actionlib_msgs::GoalStatus::RECALLING));
       //start the timer for how long the status will live in the list without a goal handle to it
-      (*it).handle_destruction_time_ = ros::Time::now();
+      expireGoal(it);
     }
 
     //make sure to set last_cancel_ based on the stamp associated with this cancel request
@@ -169,6 +170,30 @@ namespace actionlib {
       last_cancel_ = goal_id->stamp;
   }
 
+  template <class ActionSpec>
+  void ActionServer<ActionSpec>::cancelGoal(typename std::list<StatusTracker<ActionSpec> >::iterator it){
+    //attempt to get the handle_tracker for the list item if it exists
+    boost::shared_ptr<void> handle_tracker = (*it).handle_tracker_.lock();
+
+    if((*it).handle_tracker_.expired()){
+      //if the handle tracker is expired, then we need to create a new one
+      HandleTrackerDeleter<ActionSpec> d(this, it);
+      handle_tracker = boost::shared_ptr<void>((void *)NULL, d);
+      (*it).handle_tracker_ = handle_tracker;
+
+      //we also need to reset the time that the status is supposed to be removed from the list
+      (*it).handle_destruction_time_ = ros::Time();
+    }
+
+    //set the status of the goal to PREEMPTING or RECALLING as approriate
+    //and check if the request should be passed on to the user
+    GoalHandle gh(it, this, handle_tracker);
+    if(gh.setCancelRequested()){
+      //call the user's cancel callback on the relevant goal
+      cancel_callback_(gh);
+    }
+  }
+
   template <class ActionSpec>
   void ActionServer<ActionSpec>::goalCallback(const boost::shared_ptr<const ActionGoal>& goal){
     boost::recursive_mutex::scoped_lock lock(lock_);
@@ -180,22 +205,22 @@ namespace actionlib {
     ROS_DEBUG("The action server has received a new goal request");
 
     //we need to check if this goal already lives in the status list
-    for(typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.begin(); it != status_list_.end(); ++it){
-      if(goal->goal_id.id == (*it).status_.goal_id.id){
-
-        //if this is a request for a goal that has no active handles left,
-        //we'll bump how long it stays in the list
-        if((*it).handle_tracker_.expired()){
-          (*it).handle_destruction_time_ = ros::Time::now();
-        }
-
-        //make sure not to call any user callbacks or add duplicate status onto the list
-        return;
+    typename boost::unordered_map<std::string, typename std::list<StatusTracker<ActionSpec> >::iterator>::iterator index_it = goal_index_.find(goal->goal_id.id);
+    if(index_it != goal_index_.end()){
+      typename std::list<StatusTracker<ActionSpec> >::iterator it = index_it->second;
+
+      //if this is a request for a goal that has no active handles left,
+      //we'll bump how long it stays in the list
+      if((*it).handle_tracker_.expired()){
+        expireGoal(it);
       }
+
+      //make sure not to call any user callbacks or add duplicate status onto the list
+      return;
     }
 
     //if the goal is not in our list, we need to create a StatusTracker associated with this goal and push it on
-    typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.insert(status_list_.end(), StatusTracker<ActionSpec> (goal));
+    typename std::list<StatusTracker<ActionSpec> >::iterator it = addGoal(StatusTracker<ActionSpec> (goal));
 
     //we need to create a handle tracker for the incoming goal and update the StatusTracker
     HandleTrackerDeleter<ActionSpec> d(this, it);
@@ -214,6 +239,43 @@ namespace actionlib {
     }
   }
 
+  template <class ActionSpec>
+  typename std::list<StatusTracker<ActionSpec> >::iterator ActionServer<ActionSpec>::addGoal(const StatusTracker<ActionSpec>& tracker){
+    typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.insert(status_list_.end(), tracker);
+    goal_index_[(*it).status_.goal_id.id] = it;
+    statusChanged((*it).status_);
+    return it;
+  }
+
+  template <class ActionSpec>
+  void ActionServer<ActionSpec>::expireGoal(typename std::list<StatusTracker<ActionSpec> >::iterator it){
+    (*it).handle_destruction_time_ = ros::Time::now();
+    expiry_queue_.push_back(std::make_pair((*it).handle_destruction_time_, (*it).status_.goal_id.id));
+  }
+
+  template <class ActionSpec>
+  void ActionServer<ActionSpec>::removeExpiredGoals(){
+    ros::Time now = ros::Time::now();
+    while(!expiry_queue_.empty() && expiry_queue_.front().first + status_list_timeout_ < now){
+      typename boost::unordered_map<std::string, typename std::list<StatusTracker<ActionSpec> >::iterator>::iterator index_it = goal_index_.find(expiry_queue_.front().second);
+
+      //the goal may have been removed already, or have been given a new
+      //handle or a later destruction time since it was queued
+      if(index_it != goal_index_.end()
+          && (*index_it->second).handle_destruction_time_ == expiry_queue_.front().first){
+        status_list_.erase(index_it->second);
+        goal_index_.erase(index_it);
+      }
+      expiry_queue_.pop_front();
+    }
+  }
+
+  template <class ActionSpec>
+  void ActionServer<ActionSpec>::statusChanged(const actionlib_msgs::GoalStatus& status){
+    if(incremental_status_)
+      changed_goals_.insert(status.goal_id.id);
+  }
+
   template <class ActionSpec>
   void ActionServer<ActionSpec>::start(){
     initialize();
@@ -238,22 +300,34 @@ namespace actionlib {
     //build a status array
     actionlib_msgs::GoalStatusArray status_array;
 
-    status_array.set_status_list_size(status_list_.size());
-
-    unsigned int i = 0;
-    for(typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.begin(); it != status_list_.end();){
-      status_array.status_list[i] = (*it).status_;
+    //when publishing incrementally, the whole status list is still sent every
+    //status_snapshot_period_, so that clients that miss an update catch up
+    if(incremental_status_ && ros::Time::now() < last_snapshot_ + status_snapshot_period_){
+      //only the goals that changed since the last time status was published
+      status_array.header.frame_id = INCREMENTAL_STATUS_FRAME;
+      status_array.status_list.reserve(changed_goals_.size());
+      for(std::set<std::string>::iterator id = changed_goals_.begin(); id != changed_goals_.end(); ++id){
+        typename boost::unordered_map<std::string, typename std::list<StatusTracker<ActionSpec> >::iterator>::iterator index_it = goal_index_.find(*id);
+        if(index_it != goal_index_.end())
+          status_array.status_list.push_back((*index_it->second).status_);
+      }
+    }
+    else{
+      status_array.set_status_list_size(status_list_.size());
 
-      //check if the item is due for deletion from the status list
-      if((*it).handle_destruction_time_ != ros::Time()
-          && (*it).handle_destruction_time_ + status_list_timeout_ < ros::Time::now()){
-        it = status_list_.erase(it);
+      unsigned int i = 0;
+      for(typename std::list<StatusTracker<ActionSpec> >::iterator it = status_list_.begin(); it != status_list_.end(); ++it){
+        status_array.status_list[i] = (*it).status_;
+        ++i;
       }
-      else
-        ++it;
 
-      ++i;
+      if(incremental_status_)
+        last_snapshot_ = ros::Time::now();
     }
+    changed_goals_.clear();
+
+    //check if any items are due for deletion from the status list
+    removeExpiredGoals();
 
     status_pub_.publish(status_array);
   }
@@ -47,7 +47,7 @@ namespace actionlib {
     if(as_){
       //make sure to lock while we erase status for this goal from the list
       as_->lock_.lock();
-      (*status_it_).handle_destruction_time_ = ros::Time::now();
+      as_->expireGoal(status_it_);
       //as_->status_list_.erase(status_it_);
       as_->lock_.unlock();
     }
@@ -49,11 +49,13 @@ namespace actionlib {
       //if we were pending before, then we'll go active
       if(status == actionlib_msgs::GoalStatus::PENDING){
         (*status_it_).status_.status = actionlib_msgs::GoalStatus::ACTIVE;
+        as_->statusChanged((*status_it_).status_);
         as_->publishStatus();
       }
       //if we were recalling before, now we'll go to preempting
       else if(status == actionlib_msgs::GoalStatus::RECALLING){
         (*status_it_).status_.status = actionlib_msgs::GoalStatus::PREEMPTING;
+        as_->statusChanged((*status_it_).status_);
         as_->publishStatus();
       }
       else
@@ -208,12 +210,14 @@ namespace actionlib {
       unsigned int status = (*status_it_).status_.status;
       if(status == actionlib_msgs::GoalStatus::PENDING){
         (*status_it_).status_.status = actionlib_msgs::GoalStatus::RECALLING;
+        as_->statusChanged((*status_it_).status_);
         as_->publishStatus();
         return true;
       }
 
       if(status == actionlib_msgs::GoalStatus::ACTIVE){
         (*status_it_).status_.status = actionlib_msgs::GoalStatus::PREEMPTING;
+        as_->statusChanged((*status_it_).status_);
         as_->publishStatus();
         return true;
       }
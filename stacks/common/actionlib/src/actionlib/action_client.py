@@ -92,6 +92,10 @@ GoalStatus.to_string = classmethod(get_name_of_constant)
 CommState.to_string = classmethod(get_name_of_constant)
 TerminalState.to_string = classmethod(get_name_of_constant)
 
+## The header.frame_id of a GoalStatusArray that only carries the goals
+## whose status changed since the last one.
+INCREMENTAL_STATUS_FRAME = 'incremental'
+
 def _find_status_by_goal_id(status_array, id):
     for s in status_array.status_list:
         if s.goal_id.id == id:
@@ -288,6 +292,9 @@ class CommStateMachine:
 
             # You mean you haven't heard of me?
             if not status:
+                # Incremental status only carries the goals that changed
+                if status_array.header.frame_id == INCREMENTAL_STATUS_FRAME:
+                    return
                 if self.state not in [CommState.WAITING_FOR_GOAL_ACK,
                                       CommState.WAITING_FOR_RESULT,
                                       CommState.DONE]:
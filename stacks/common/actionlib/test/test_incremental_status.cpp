@@ -0,0 +1,232 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+*********************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <actionlib/server/action_server.h>
+#include <actionlib/client/action_client.h>
+#include <actionlib/TestAction.h>
+#include <boost/thread.hpp>
+#include <map>
+#include <set>
+
+// The launch file turns on ~incremental_status for the test_action server,
+// with a snapshot period long enough that every array after the first one
+// is incremental
+
+typedef actionlib::ActionServer<actionlib::TestAction> Server;
+typedef actionlib::ActionClient<actionlib::TestAction> Client;
+
+static const unsigned int NUM_GOALS = 20;
+
+class TestServer
+{
+public:
+  TestServer(ros::NodeHandle& n)
+    : server_(n, "test_action", boost::bind(&TestServer::goalCb, this, _1),
+              boost::bind(&TestServer::cancelCb, this, _1))
+  {
+    status_sub_ = n.subscribe("test_action/status", 100, &TestServer::statusCb, this);
+  }
+
+  void goalCb(Server::GoalHandle gh)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    goals_.push_back(gh);
+  }
+
+  void cancelCb(Server::GoalHandle gh)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    canceled_.push_back(gh.getGoalID().id);
+    gh.setCanceled();
+  }
+
+  void statusCb(const actionlib_msgs::GoalStatusArrayConstPtr& status_array)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (status_array->header.frame_id != actionlib::INCREMENTAL_STATUS_FRAME)
+      return;
+    for (unsigned int i = 0; i < status_array->status_list.size(); ++i)
+      seen_[status_array->status_list[i].goal_id.id].insert(status_array->status_list[i].status);
+  }
+
+  unsigned int numGoals()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return goals_.size();
+  }
+
+  // whether an incremental array carried this status for the goal
+  bool seen(const std::string& id, uint8_t status)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return seen_[id].count(status) > 0;
+  }
+
+  Server server_;
+  ros::Subscriber status_sub_;
+  boost::mutex mutex_;
+  std::vector<Server::GoalHandle> goals_;
+  std::vector<std::string> canceled_;
+  std::map<std::string, std::set<uint8_t> > seen_;
+};
+
+// Wait for every handle to reach the given comm state
+static bool waitForCommState(std::vector<Client::GoalHandle>& handles, actionlib::CommState::StateEnum state)
+{
+  ros::Time timeout = ros::Time::now() + ros::Duration(10.0);
+  while (ros::ok() && ros::Time::now() < timeout) {
+    unsigned int i = 0;
+    while (i < handles.size() && handles[i].getCommState() == state)
+      ++i;
+    if (i == handles.size())
+      return true;
+    ros::Duration(0.01).sleep();
+  }
+  return false;
+}
+
+TEST(ActionServer, IncrementalStatus)
+{
+  ros::NodeHandle n;
+  TestServer ts(n);
+  Client ac(n, "test_action");
+  ASSERT_TRUE(ac.waitForActionServerToStart(ros::Duration(10.0)));
+
+  // goals go out one at a time, the client's goal publisher only queues one
+  std::vector<Client::GoalHandle> handles;
+  for (unsigned int i = 0; i < NUM_GOALS; ++i) {
+    actionlib::TestGoal goal;
+    goal.goal = i;
+    handles.push_back(ac.sendGoal(goal));
+    ros::Time timeout = ros::Time::now() + ros::Duration(10.0);
+    while (ts.numGoals() <= i && ros::Time::now() < timeout)
+      ros::Duration(0.01).sleep();
+    ASSERT_EQ(i + 1, ts.numGoals());
+  }
+
+  // accepting them all at once publishes a burst of incremental arrays, each
+  // with a single goal in it, none of which the client may miss
+  for (unsigned int i = 0; i < NUM_GOALS; ++i)
+    ts.goals_[i].setAccepted();
+  ASSERT_TRUE(waitForCommState(handles, actionlib::CommState::ACTIVE));
+  for (unsigned int i = 0; i < NUM_GOALS; ++i)
+    EXPECT_TRUE(ts.seen(ts.goals_[i].getGoalID().id, actionlib_msgs::GoalStatus::ACTIVE));
+
+  // a cancel for a single goal id is looked up in the goal index, and only
+  // reaches that goal
+  handles[3].cancel();
+  ros::Time timeout = ros::Time::now() + ros::Duration(10.0);
+  while (handles[3].getCommState() != actionlib::CommState::DONE && ros::Time::now() < timeout)
+    ros::Duration(0.01).sleep();
+  ASSERT_EQ(actionlib::CommState::DONE, handles[3].getCommState().state_);
+  EXPECT_EQ(actionlib::TerminalState::PREEMPTED, handles[3].getTerminalState().state_);
+  {
+    boost::mutex::scoped_lock lock(ts.mutex_);
+    ASSERT_EQ(1u, ts.canceled_.size());
+    EXPECT_EQ(ts.goals_[3].getGoalID().id, ts.canceled_[0]);
+  }
+
+  // terminal states only go out with the next status publish
+  timeout = ros::Time::now() + ros::Duration(10.0);
+  while (!ts.seen(ts.goals_[3].getGoalID().id, actionlib_msgs::GoalStatus::PREEMPTED) && ros::Time::now() < timeout)
+    ros::Duration(0.01).sleep();
+  EXPECT_TRUE(ts.seen(ts.goals_[3].getGoalID().id, actionlib_msgs::GoalStatus::PREEMPTED));
+
+  std::vector<Client::GoalHandle> rest;
+  for (unsigned int i = 0; i < NUM_GOALS; ++i) {
+    if (i == 3)
+      continue;
+    EXPECT_EQ(actionlib::CommState::ACTIVE, handles[i].getCommState().state_);
+    ts.goals_[i].setSucceeded();
+    rest.push_back(handles[i]);
+  }
+  ASSERT_TRUE(waitForCommState(rest, actionlib::CommState::DONE));
+  for (unsigned int i = 0; i < rest.size(); ++i)
+    EXPECT_EQ(actionlib::TerminalState::SUCCEEDED, rest[i].getTerminalState().state_);
+}
+
+// A cancel that arrives before its goal is kept in the goal index, and the
+// goal is recalled without reaching the goal callback
+TEST(ActionServer, CancelBeforeGoal)
+{
+  ros::NodeHandle n;
+  TestServer ts(n);
+  ros::Publisher goal_pub = n.advertise<actionlib::TestActionGoal>("test_action/goal", 1);
+  ros::Publisher cancel_pub = n.advertise<actionlib_msgs::GoalID>("test_action/cancel", 1);
+  ros::Time timeout = ros::Time::now() + ros::Duration(10.0);
+  while ((goal_pub.getNumSubscribers() == 0 || cancel_pub.getNumSubscribers() == 0) && ros::Time::now() < timeout)
+    ros::Duration(0.01).sleep();
+  ASSERT_GT(goal_pub.getNumSubscribers(), 0u);
+  ASSERT_GT(cancel_pub.getNumSubscribers(), 0u);
+
+  actionlib_msgs::GoalID cancel;
+  cancel.id = "early";
+  cancel_pub.publish(cancel);
+
+  // goal and cancel come in on separate topics, give the cancel a head start
+  timeout = ros::Time::now() + ros::Duration(10.0);
+  while (!ts.seen("early", actionlib_msgs::GoalStatus::RECALLING) && ros::Time::now() < timeout)
+    ros::Duration(0.01).sleep();
+  ASSERT_TRUE(ts.seen("early", actionlib_msgs::GoalStatus::RECALLING));
+
+  actionlib::TestActionGoal goal;
+  goal.goal_id.id = "early";
+  goal_pub.publish(goal);
+  ros::Duration(0.5).sleep();
+  EXPECT_EQ(0u, ts.numGoals());
+}
+
+static void spinThread()
+{
+  ros::spin();
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_incremental_status");
+  ros::NodeHandle n;
+  boost::thread spin_thread(&spinThread);
+
+  int result = RUN_ALL_TESTS();
+
+  ros::shutdown();
+  spin_thread.join();
+  return result;
+}
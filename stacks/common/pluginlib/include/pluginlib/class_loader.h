@@ -32,6 +32,7 @@
 #include "ros/console.h"
 
 #include "pluginlib/class_desc.h"
+#include "pluginlib/plugin_index.h"
 
 #include "Poco/ClassLoader.h"
 #include "ros/package.h"
@@ -46,102 +46,23 @@ namespace pluginlib {
   template <class T>
   ClassLoader<T>::ClassLoader(std::string package, std::string base_class, std::string attrib_name) : base_class_(base_class)
   {
-    //Pull possible files from manifests of packages which depend on this package and export class
-    std::vector<std::string> paths;
-    ros::package::getPlugins(package, attrib_name, paths);
+    //The classes declared in manifests of packages which depend on this package and export class
+    PluginIndex index(package, attrib_name);
+    const std::vector<ClassDesc>& classes = index.getClasses();
 
-    //The poco factory for base class T
-    for (std::vector<std::string>::iterator it = paths.begin(); it != paths.end(); ++it)
+    for (std::vector<ClassDesc>::const_iterator it = classes.begin(); it != classes.end(); ++it)
     {
-      TiXmlDocument document;
-      document.LoadFile(*it);
-      TiXmlElement * config = document.RootElement();
-      if (config == NULL)
-      {
-        ROS_ERROR("XML Document \"%s\" had no Root Element.  This likely means the XML is malformed or missing.", it->c_str());
-        return;
-      }
-      if (config->ValueStr() != "library" &&
-          config->ValueStr() != "class_libraries")
-      {
-        ROS_ERROR("The XML given to add must have either \"library\" or \
-            \"class_libraries\" as the root tag");
-        return ;
+      //make sure that this class is of the right type before registering it
+      if(it->base_class_ == base_class){
+        // register class here
+        classes_available_.insert(std::pair<std::string, ClassDesc>(it->lookup_name_, *it));
+        ROS_DEBUG("MATCHED Base type for class with name: %s type: %s base_class_type: %s Expecting base_class_type %s", 
+                  it->lookup_name_.c_str(), it->derived_class_.c_str(), it->base_class_.c_str(), base_class.c_str());
       }
-      //Step into the filter list if necessary
-      if (config->ValueStr() == "class_libraries")
+      else
       {
-        config = config->FirstChildElement("library");
-      }
-
-      TiXmlElement* library = config;
-      while ( library != NULL)
-      {
-        std::string library_path = library->Attribute("path");
-        if (library_path.size() == 0)
-        {
-          ROS_ERROR("Failed to find Path Attirbute in library element in %s", it->c_str());
-          continue;
-        }
-
-        std::string package_name;
-
-        fs::path p(*it);
-        fs::path parent = p.parent_path();
-        // figure out the package this class is part of
-        while (true)
-        {
-          if (fs::exists(parent / "manifest.xml"))
-          {
-            std::string package = parent.filename();
-            std::string package_path = ros::package::getPath(package);
-            if (it->find(package_path) == 0)
-            {
-              package_name = package;
-              break;
-            }
-          }
-
-          parent = parent.parent_path();
-
-          if (parent.string().empty())
-          {
-            ROS_ERROR("Could not find package name for class %s", it->c_str());
-            break;
-          }
-        }
-        fs::path full_library_path(parent / library_path);
-
-        TiXmlElement* class_element = library->FirstChildElement("class");
-        while (class_element)
-        {
-          std::string base_class_type = class_element->Attribute("base_class_type");
-          std::string lookup_name = class_element->Attribute("name");
-          std::string derived_class = class_element->Attribute("type");
-
-          
-          
-          //make sure that this class is of the right type before registering it
-          if(base_class_type == base_class){
-
-            // register class here
-            TiXmlElement* description = class_element->FirstChildElement("description");
-            std::string description_str = description ? description->GetText() : "";
-
-            classes_available_.insert(std::pair<std::string, ClassDesc>(lookup_name, ClassDesc(lookup_name, derived_class, base_class_type, package_name, description_str, full_library_path.string())));
-            ROS_DEBUG("MATCHED Base type for class with name: %s type: %s base_class_type: %s Expecting base_class_type %s", 
-                      lookup_name.c_str(), derived_class.c_str(), base_class_type.c_str(), base_class.c_str());
-          }
-          else
-          {
-            ROS_DEBUG("UNMATCHED Base type for class with name: %s type: %s base_class_type: %s Expecting base_class_type %s", 
-                      lookup_name.c_str(), derived_class.c_str(), base_class_type.c_str(), base_class.c_str());
-            
-          }
-          //step to next class_element
-          class_element = class_element->NextSiblingElement( "class" );
-        }
-        library = library->NextSiblingElement( "library" );
+        ROS_DEBUG("UNMATCHED Base type for class with name: %s type: %s base_class_type: %s Expecting base_class_type %s", 
+                  it->lookup_name_.c_str(), it->derived_class_.c_str(), it->base_class_.c_str(), base_class.c_str());
       }
     }
   }
@@ -0,0 +1,121 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+*********************************************************************/
+#ifndef PLUGINLIB_PLUGIN_INDEX_H_
+#define PLUGINLIB_PLUGIN_INDEX_H_
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include "pluginlib/class_desc.h"
+
+namespace pluginlib {
+  /**
+   * @class PluginIndex
+   * @brief The classes declared in the plugin description files that packages
+   * export for a given package and attribute
+   *
+   * Finding the description files means a rospack crawl, and each of them is
+   * parsed and the package it belongs to looked up. The result is kept in
+   * memory and in an index file under $ROS_HOME/plugin_index (~/.ros by
+   * default), which is shared by all processes. The index is rebuilt when
+   * ROS_ROOT or ROS_PACKAGE_PATH change, when any description file or the
+   * manifest of its package is modified, or once it is older than
+   * ROS_CACHE_TIMEOUT seconds (60 by default, as for rospack). A timeout of
+   * 0 disables the index.
+   */
+  class PluginIndex
+  {
+    public:
+      /**
+       * @brief  Loads the index for a package and attribute, building it if necessary
+       * @param package The package containing the base class
+       * @param attrib_name The attribute to search for in manifest.xml files
+       */
+      PluginIndex(const std::string& package, const std::string& attrib_name);
+
+      /**
+       * @brief  Returns the classes declared by all of the description files, whatever their base class
+       */
+      const std::vector<ClassDesc>& getClasses() const { return classes_; }
+
+      /**
+       * @brief  Returns true if the classes came from an existing index rather than a crawl
+       */
+      bool isCached() const { return cached_; }
+
+    private:
+      /**
+       * @brief  A plugin description file, with what is needed to tell whether it changed
+       */
+      struct DescriptionFile
+      {
+        std::string path_;
+        std::time_t mtime_;
+        std::string manifest_path_; ///< The manifest of the package the file belongs to, empty if not found
+        std::time_t manifest_mtime_;
+        std::vector<ClassDesc> classes_;
+      };
+
+      /**
+       * @brief  Finds and parses all of the description files
+       */
+      void build(const std::string& package, const std::string& attrib_name);
+
+      /**
+       * @brief  Parses a description file
+       * @param file The file to parse, with its path set
+       * @return True if the file could be parsed
+       */
+      bool parseFile(DescriptionFile& file);
+
+      /**
+       * @brief  Returns true if the index is younger than timeout seconds, was built
+       * for the current ROS_ROOT and ROS_PACKAGE_PATH, and none of the description
+       * files or their manifests changed since
+       */
+      bool isCurrent(double timeout) const;
+
+      bool read(const std::string& index_path);
+      void write(const std::string& index_path) const;
+
+      std::string root_, package_path_; ///< ROS_ROOT and ROS_PACKAGE_PATH the index was built with
+      std::time_t created_;
+      std::vector<DescriptionFile> files_;
+      std::vector<ClassDesc> classes_;
+      bool cached_;
+  };
+};
+#endif
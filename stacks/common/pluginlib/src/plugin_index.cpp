@@ -0,0 +1,368 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+*********************************************************************/
+#include "pluginlib/plugin_index.h"
+#include "ros/console.h"
+#include "ros/package.h"
+#include "tinyxml/tinyxml.h"
+#include "boost/filesystem.hpp"
+#include "boost/thread/mutex.hpp"
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+
+namespace fs = boost::filesystem;
+
+namespace pluginlib {
+  namespace {
+    //indices already loaded by this process, by package and attribute
+    boost::mutex indices_mutex;
+    std::map<std::string, PluginIndex> indices;
+
+    std::string getEnv(const char* name)
+    {
+      const char* value = getenv(name);
+      return value ? value : "";
+    }
+
+    double getCacheTimeout()
+    {
+      std::string timeout = getEnv("ROS_CACHE_TIMEOUT");
+      return timeout.empty() ? 60.0 : atof(timeout.c_str());
+    }
+
+    fs::path getIndexDirectory()
+    {
+      std::string ros_home = getEnv("ROS_HOME");
+      if (ros_home.empty())
+        ros_home = getEnv("HOME") + "/.ros";
+      return fs::path(ros_home) / "plugin_index";
+    }
+
+    std::time_t getModificationTime(const std::string& path)
+    {
+      try
+      {
+        return fs::last_write_time(fs::path(path));
+      }
+      catch (fs::filesystem_error &ex)
+      {
+        return 0;
+      }
+    }
+
+    std::string getAttribute(TiXmlElement* element, const char* name)
+    {
+      const char* value = element->Attribute(name);
+      return value ? value : "";
+    }
+
+    //strings are written as their length, a colon, and the characters, so
+    //that descriptions can hold any text
+    void writeString(std::ostream& out, const std::string& str)
+    {
+      out << str.size() << ':' << str << '\n';
+    }
+
+    bool readString(std::istream& in, std::string& str)
+    {
+      size_t size;
+      char colon;
+      if (!(in >> size) || !in.get(colon) || colon != ':')
+        return false;
+      str.resize(size);
+      if (size > 0 && !in.read(&str[0], size))
+        return false;
+      return true;
+    }
+  }
+
+  PluginIndex::PluginIndex(const std::string& package, const std::string& attrib_name) : created_(0), cached_(false)
+  {
+    double timeout = getCacheTimeout();
+    if (timeout <= 0)
+    {
+      build(package, attrib_name);
+      return;
+    }
+
+    std::string key = package + "." + attrib_name;
+    {
+      boost::mutex::scoped_lock lock(indices_mutex);
+      std::map<std::string, PluginIndex>::iterator it = indices.find(key);
+      if (it != indices.end() && it->second.isCurrent(timeout))
+      {
+        *this = it->second;
+        cached_ = true;
+        return;
+      }
+    }
+
+    fs::path index_path = getIndexDirectory() / key;
+    if (read(index_path.string()) && isCurrent(timeout))
+    {
+      ROS_DEBUG("Using the plugin index in %s", index_path.string().c_str());
+      cached_ = true;
+    }
+    else
+    {
+      build(package, attrib_name);
+      write(index_path.string());
+    }
+
+    boost::mutex::scoped_lock lock(indices_mutex);
+    std::map<std::string, PluginIndex>::iterator it = indices.find(key);
+    if (it != indices.end())
+      it->second = *this;
+    else
+      indices.insert(std::make_pair(key, *this));
+  }
+
+  void PluginIndex::build(const std::string& package, const std::string& attrib_name)
+  {
+    root_ = getEnv("ROS_ROOT");
+    package_path_ = getEnv("ROS_PACKAGE_PATH");
+    created_ = std::time(NULL);
+    files_.clear();
+    classes_.clear();
+
+    //Pull possible files from manifests of packages which depend on this package and export class
+    std::vector<std::string> paths;
+    ros::package::getPlugins(package, attrib_name, paths);
+
+    for (std::vector<std::string>::iterator it = paths.begin(); it != paths.end(); ++it)
+    {
+      //files that can't be parsed are kept too, so that the index is rebuilt once they are fixed
+      DescriptionFile file;
+      file.path_ = *it;
+      parseFile(file);
+      files_.push_back(file);
+      classes_.insert(classes_.end(), file.classes_.begin(), file.classes_.end());
+    }
+  }
+
+  bool PluginIndex::parseFile(DescriptionFile& file)
+  {
+    file.mtime_ = getModificationTime(file.path_);
+    file.manifest_mtime_ = 0;
+
+    TiXmlDocument document;
+    document.LoadFile(file.path_);
+    TiXmlElement * config = document.RootElement();
+    if (config == NULL)
+    {
+      ROS_ERROR("XML Document \"%s\" had no Root Element.  This likely means the XML is malformed or missing.", file.path_.c_str());
+      return false;
+    }
+    if (config->ValueStr() != "library" &&
+        config->ValueStr() != "class_libraries")
+    {
+      ROS_ERROR("The XML given to add must have either \"library\" or \
+          \"class_libraries\" as the root tag");
+      return false;
+    }
+    //Step into the filter list if necessary
+    if (config->ValueStr() == "class_libraries")
+    {
+      config = config->FirstChildElement("library");
+    }
+
+    std::string package_name;
+
+    fs::path p(file.path_);
+    fs::path parent = p.parent_path();
+    // figure out the package this class is part of
+    while (true)
+    {
+      if (fs::exists(parent / "manifest.xml"))
+      {
+        std::string package = parent.filename();
+        std::string package_path = ros::package::getPath(package);
+        if (file.path_.find(package_path) == 0)
+        {
+          package_name = package;
+          file.manifest_path_ = (parent / "manifest.xml").string();
+          file.manifest_mtime_ = getModificationTime(file.manifest_path_);
+          break;
+        }
+      }
+
+      parent = parent.parent_path();
+
+      if (parent.string().empty())
+      {
+        ROS_ERROR("Could not find package name for class %s", file.path_.c_str());
+        break;
+      }
+    }
+
+    TiXmlElement* library = config;
+    for (; library != NULL; library = library->NextSiblingElement( "library" ))
+    {
+      std::string library_path = getAttribute(library, "path");
+      if (library_path.size() == 0)
+      {
+        ROS_ERROR("Failed to find Path Attirbute in library element in %s", file.path_.c_str());
+        continue;
+      }
+
+      fs::path full_library_path(parent / library_path);
+
+      TiXmlElement* class_element = library->FirstChildElement("class");
+      while (class_element)
+      {
+        std::string base_class_type = getAttribute(class_element, "base_class_type");
+        std::string lookup_name = getAttribute(class_element, "name");
+        std::string derived_class = getAttribute(class_element, "type");
+
+        TiXmlElement* description = class_element->FirstChildElement("description");
+        std::string description_str = description && description->GetText() ? description->GetText() : "";
+
+        file.classes_.push_back(ClassDesc(lookup_name, derived_class, base_class_type, package_name, description_str, full_library_path.string()));
+
+        //step to next class_element
+        class_element = class_element->NextSiblingElement( "class" );
+      }
+    }
+    return true;
+  }
+
+  bool PluginIndex::isCurrent(double timeout) const
+  {
+    if (std::difftime(std::time(NULL), created_) >= timeout)
+      return false;
+    if (root_ != getEnv("ROS_ROOT") || package_path_ != getEnv("ROS_PACKAGE_PATH"))
+      return false;
+
+    for (std::vector<DescriptionFile>::const_iterator it = files_.begin(); it != files_.end(); ++it)
+    {
+      if (getModificationTime(it->path_) != it->mtime_)
+        return false;
+      if (!it->manifest_path_.empty() && getModificationTime(it->manifest_path_) != it->manifest_mtime_)
+        return false;
+    }
+    return true;
+  }
+
+  bool PluginIndex::read(const std::string& index_path)
+  {
+    std::ifstream in(index_path.c_str(), std::ios::binary);
+    if (!in)
+      return false;
+
+    std::string format;
+    size_t num_files;
+    if (!readString(in, format) || format != "pluginlib_index 1"
+        || !readString(in, root_) || !readString(in, package_path_)
+        || !(in >> created_ >> num_files))
+      return false;
+
+    files_.clear();
+    classes_.clear();
+    for (size_t i = 0; i < num_files; ++i)
+    {
+      DescriptionFile file;
+      size_t num_classes;
+      if (!readString(in, file.path_) || !(in >> file.mtime_)
+          || !readString(in, file.manifest_path_) || !(in >> file.manifest_mtime_ >> num_classes))
+        return false;
+
+      for (size_t j = 0; j < num_classes; ++j)
+      {
+        std::string lookup_name, derived_class, base_class, package, description, library_path;
+        if (!readString(in, lookup_name) || !readString(in, derived_class) || !readString(in, base_class)
+            || !readString(in, package) || !readString(in, description) || !readString(in, library_path))
+          return false;
+        file.classes_.push_back(ClassDesc(lookup_name, derived_class, base_class, package, description, library_path));
+      }
+      files_.push_back(file);
+      classes_.insert(classes_.end(), file.classes_.begin(), file.classes_.end());
+    }
+    return true;
+  }
+
+  void PluginIndex::write(const std::string& index_path) const
+  {
+    //write to a file of our own and move it into place, so that other
+    //processes never read a partial index
+    std::stringstream tmp_path;
+    tmp_path << index_path << "." << getpid();
+    try
+    {
+      fs::create_directories(fs::path(index_path).parent_path());
+    }
+    catch (fs::filesystem_error &ex)
+    {
+      ROS_DEBUG("Couldn't create a directory for the plugin index %s", index_path.c_str());
+      return;
+    }
+
+    {
+      std::ofstream out(tmp_path.str().c_str(), std::ios::binary);
+      writeString(out, "pluginlib_index 1");
+      writeString(out, root_);
+      writeString(out, package_path_);
+      out << created_ << ' ' << files_.size() << '\n';
+      for (std::vector<DescriptionFile>::const_iterator it = files_.begin(); it != files_.end(); ++it)
+      {
+        writeString(out, it->path_);
+        out << it->mtime_ << '\n';
+        writeString(out, it->manifest_path_);
+        out << it->manifest_mtime_ << ' ' << it->classes_.size() << '\n';
+        for (std::vector<ClassDesc>::const_iterator c = it->classes_.begin(); c != it->classes_.end(); ++c)
+        {
+          writeString(out, c->lookup_name_);
+          writeString(out, c->derived_class_);
+          writeString(out, c->base_class_);
+          writeString(out, c->package_);
+          writeString(out, c->description_);
+          writeString(out, c->library_path_);
+        }
+      }
+      if (!out)
+      {
+        ROS_DEBUG("Couldn't write the plugin index %s", tmp_path.str().c_str());
+        unlink(tmp_path.str().c_str());
+        return;
+      }
+    }
+
+    if (rename(tmp_path.str().c_str(), index_path.c_str()) != 0)
+      unlink(tmp_path.str().c_str());
+  }
+};
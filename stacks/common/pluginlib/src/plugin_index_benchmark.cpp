@@ -0,0 +1,72 @@
+#include "pluginlib/plugin_index.h"
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Time taken to find the plugins a ClassLoader would see: with a rospack
+// crawl and parse of every description file, with the plugin index from
+// disk, and with the index another ClassLoader in the process has loaded.
+// Run it twice to time the index on disk, as the first run may build it.
+// Usage: plugin_index_benchmark <package> <base class> [attribute] [repeats]
+
+static double wallTime()
+{
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static size_t countClasses(const pluginlib::PluginIndex& index, const std::string& base_class)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < index.getClasses().size(); ++i)
+    if (index.getClasses()[i].base_class_ == base_class)
+      ++count;
+  return count;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s <package> <base class> [attribute] [repeats]\n", argv[0]);
+    return 1;
+  }
+  std::string package = argv[1], base_class = argv[2];
+  std::string attrib_name = argc > 3 ? argv[3] : "plugin";
+  int repeats = argc > 4 ? atoi(argv[4]) : 5;
+
+  const char* timeout = getenv("ROS_CACHE_TIMEOUT");
+  std::string cache_timeout = timeout ? timeout : "60";
+
+  setenv("ROS_CACHE_TIMEOUT", "0", 1);
+  double start = wallTime();
+  size_t crawled = 0;
+  for (int r = 0; r < repeats; ++r)
+    crawled = countClasses(pluginlib::PluginIndex(package, attrib_name), base_class);
+  double crawl_ms = (wallTime() - start) * 1000.0 / repeats;
+
+  setenv("ROS_CACHE_TIMEOUT", cache_timeout.c_str(), 1);
+  start = wallTime();
+  pluginlib::PluginIndex first(package, attrib_name);
+  double first_ms = (wallTime() - start) * 1000.0;
+
+  start = wallTime();
+  size_t indexed = 0;
+  for (int r = 0; r < repeats; ++r)
+    indexed = countClasses(pluginlib::PluginIndex(package, attrib_name), base_class);
+  double again_ms = (wallTime() - start) * 1000.0 / repeats;
+
+  printf("%u classes of %s\n", (unsigned)crawled, base_class.c_str());
+  printf("%-28s %10.2f ms\n", "crawl", crawl_ms);
+  printf("%-28s %10.2f ms\n", first.isCached() ? "index on disk" : "crawl and write index", first_ms);
+  printf("%-28s %10.2f ms\n", "index in process", again_ms);
+
+  if (countClasses(first, base_class) != crawled || indexed != crawled)
+  {
+    printf("The index doesn't match the crawl\n");
+    return 1;
+  }
+  return 0;
+}
@@ -138,6 +138,18 @@ private:
   std::map<std::string, diagnostic_item::DiagnosticItem*> msgs_;
   std::string prefix_; /**< Prepended to all status names of aggregator. */
 
+  /*!
+   *\brief Indices of the analyzers that match each status name seen so far
+   */
+  std::map<std::string, std::vector<unsigned int> > routes_;
+
+  /*!
+   *\brief Returns the indices of the analyzers that match name, asking them the first time
+   */
+  const std::vector<unsigned int> &getRoute(const std::string &name);
+
+  ros::WallDuration callback_time_; /**< Time spent in diagCallback since the last publishData */
+
   void clearMessages(); /**< Clears msgs_ map of (name, DiagnosticItems). */
 };
 
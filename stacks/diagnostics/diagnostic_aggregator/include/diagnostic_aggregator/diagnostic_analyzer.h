@@ -99,6 +99,15 @@ public:
     return my_vec;
   }
 
+  /*!
+   *\brief Returns true if the analyzer wants the status with this name.
+   *
+   * The aggregator asks once for every new status name and remembers the
+   * answer, so it must not change. analyze() is only given the items that
+   * matched. The default matches every name.
+   */
+  virtual bool match(const std::string &name) { return true; }
+
   /*!
    *\brief Returns full prefix of analyzer. (ex: '/Robot/Sensors')
    */
@@ -45,6 +45,7 @@
 #include "diagnostic_msgs/KeyValue.h"
 #include "diagnostic_aggregator/diagnostic_analyzer.h"
 #include "diagnostic_aggregator/diagnostic_item.h"
+#include "diagnostic_aggregator/name_matcher.h"
 #include "XmlRpcValue.h"
 
 namespace diagnostic_analyzer {
@@ -111,6 +112,13 @@ public:
    */
   std::vector<diagnostic_msgs::DiagnosticStatus*> analyze(std::map<std::string, diagnostic_item::DiagnosticItem*> msgs);
 
+  /*!
+   *\brief Returns true if the name is expected, or matches the name, startswith or contains lists
+   *
+   * The "Other" analyzer matches every name.
+   */
+  bool match(const std::string &name);
+
   /*!
    *\brief Returns full prefix (ex: "/Robot/Power System")
    */
@@ -132,6 +140,8 @@ private:
   std::vector<std::string> contains_;
   std::vector<std::string> name_;
 
+  NameMatcher matcher_; /**< All of the above, compiled */
+
   /*!
    *\brief Stores items by name
    */
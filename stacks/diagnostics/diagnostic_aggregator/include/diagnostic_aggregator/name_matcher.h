@@ -0,0 +1,102 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef NAME_MATCHER_H
+#define NAME_MATCHER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace diagnostic_analyzer {
+
+/*!
+ *\brief NameMatcher matches status names against a set of rules in one pass
+ *
+ * Rules are whole names, prefixes and substrings, as given to the
+ * GenericAnalyzer by its "expected", "name", "startswith" and "contains"
+ * parameters. They are compiled into one trie: whole names and prefixes are
+ * found by following the name down from the root, substrings by running it
+ * through the trie as an Aho-Corasick automaton. Matching takes time in the
+ * length of the name, whatever the number of rules.
+ */
+class NameMatcher
+{
+public:
+  NameMatcher();
+
+  /*!
+   *\brief Matches names equal to name
+   */
+  void addName(const std::string &name);
+
+  /*!
+   *\brief Matches names that start with prefix
+   */
+  void addPrefix(const std::string &prefix);
+
+  /*!
+   *\brief Matches names that contain substring
+   */
+  void addSubstring(const std::string &substring);
+
+  /*!
+   *\brief Returns true if name matches any of the rules
+   */
+  bool match(const std::string &name);
+
+private:
+  struct Node
+  {
+    std::map<char, int> next;
+    int fail;
+    bool name, prefix, substring; /**< substring is also set if the node's failure chain ends a substring */
+    Node() : fail(0), name(false), prefix(false), substring(false) {}
+  };
+
+  std::vector<Node> nodes_; /**< nodes_[0] is the root */
+  bool has_substrings_;
+  bool compiled_; /**< False until the failure links for the current rules are built */
+
+  int addPath(const std::string &s);
+
+  /*!
+   *\brief Builds the failure links, breadth first
+   */
+  void compile();
+};
+
+}
+
+#endif //NAME_MATCHER_H
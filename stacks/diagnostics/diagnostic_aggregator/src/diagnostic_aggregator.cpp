@@ -35,6 +35,7 @@
 // Author: Kevin Watts
 
 #include <diagnostic_aggregator/diagnostic_aggregator.h>
+#include <sstream>
 
 using namespace std;
 using namespace diagnostic_aggregator;
@@ -114,15 +115,34 @@ void DiagnosticAggregator::init()
 
 void DiagnosticAggregator::diagCallback(const diagnostic_msgs::DiagnosticArray::ConstPtr& diag_msg)
 {
+  ros::WallTime start = ros::WallTime::now();
+
   map<string, diagnostic_item::DiagnosticItem*>::iterator it;
   for (unsigned int i = 0; i < diag_msg->status.size(); ++i)
   {
-    it = msgs_.find(diag_msg->status[i].name);
-    if (it == msgs_.end())
-      msgs_[diag_msg->status[i].name] = new diagnostic_item::DiagnosticItem(&diag_msg->status[i]);
+    it = msgs_.lower_bound(diag_msg->status[i].name);
+    if (it == msgs_.end() || it->first != diag_msg->status[i].name)
+      msgs_.insert(it, make_pair(diag_msg->status[i].name, new diagnostic_item::DiagnosticItem(&diag_msg->status[i])));
     else
-      msgs_[diag_msg->status[i].name]->update(&diag_msg->status[i]);
+      it->second->update(&diag_msg->status[i]);
+  }
+
+  callback_time_ += ros::WallTime::now() - start;
+}
+
+const vector<unsigned int> &DiagnosticAggregator::getRoute(const string &name)
+{
+  map<string, vector<unsigned int> >::iterator it = routes_.lower_bound(name);
+  if (it != routes_.end() && it->first == name)
+    return it->second;
+
+  it = routes_.insert(it, make_pair(name, vector<unsigned int>()));
+  for (unsigned int j = 0; j < analyzers_.size(); ++j)
+  {
+    if (analyzers_[j]->match(name))
+      it->second.push_back(j);
   }
+  return it->second;
 }
 
 
@@ -141,6 +161,8 @@ void DiagnosticAggregator::clearMessages()
 
 void DiagnosticAggregator::publishData()
 {
+  ros::WallTime start = ros::WallTime::now();
+
   diagnostic_msgs::DiagnosticArray array;
 
   diagnostic_msgs::DiagnosticStatus header_status;
@@ -148,13 +170,24 @@ void DiagnosticAggregator::publishData()
   header_status.level = 0;
   header_status.message = "OK";
 
+  // Give each analyzer only the items it matches. msgs_ is sorted, so
+  // each item goes at the end of the analyzer's map.
+  vector<map<string, diagnostic_item::DiagnosticItem*> > routed(analyzers_.size());
+  map<string, diagnostic_item::DiagnosticItem*>::iterator it;
+  for (it = msgs_.begin(); it != msgs_.end(); ++it)
+  {
+    const vector<unsigned int> &route = getRoute(it->first);
+    for (unsigned int k = 0; k < route.size(); ++k)
+      routed[route[k]].insert(routed[route[k]].end(), *it);
+  }
+
   // Call analyzers on data
   for (unsigned int j = 0; j < analyzers_.size(); ++j)
   {
     string prefix = analyzers_[j]->getPrefix();
     string nice_name = analyzers_[j]->getName();
 
-    vector<diagnostic_msgs::DiagnosticStatus*> processed = analyzers_[j]->analyze(msgs_);
+    vector<diagnostic_msgs::DiagnosticStatus*> processed = analyzers_[j]->analyze(routed[j]);
 
     // Look through processed data for header, append it to header_status
     // Ex: Look for /Robot/Power and append (Power, OK) to header
@@ -186,11 +219,27 @@ void DiagnosticAggregator::publishData()
     header_status.message = "Error";
 
 
+  // Time taken to take in and analyze this cycle's data
+  ros::WallDuration processing_time = callback_time_ + (ros::WallTime::now() - start);
+  diagnostic_msgs::KeyValue kv;
+  kv.key = "Status Items";
+  stringstream items;
+  items << msgs_.size();
+  kv.value = items.str();
+  header_status.values.push_back(kv);
+  kv.key = "Processing Time (ms)";
+  stringstream time;
+  time << processing_time.toSec() * 1000.0;
+  kv.value = time.str();
+  header_status.values.push_back(kv);
+  ROS_DEBUG("Aggregated %d status items in %.3f ms", (int)msgs_.size(), processing_time.toSec() * 1000.0);
+
   array.status.push_back(header_status);
 
   agg_pub_.publish(array);
 
   clearMessages();
+  callback_time_ = ros::WallDuration();
 }
   
 
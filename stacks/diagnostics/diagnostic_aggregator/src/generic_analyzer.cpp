@@ -67,6 +67,7 @@ bool GenericAnalyzer::init(string first_prefix, const ros::NodeHandle &n)
     {
       string starts = startswith[i];
       startswith_.push_back(starts);
+      matcher_.addPrefix(starts);
     }
   }
 
@@ -77,6 +78,7 @@ bool GenericAnalyzer::init(string first_prefix, const ros::NodeHandle &n)
     {
       string name = name_val[i];
       name_.push_back(name);
+      matcher_.addName(name);
     }
   }
 
@@ -87,6 +89,7 @@ bool GenericAnalyzer::init(string first_prefix, const ros::NodeHandle &n)
     {
       string contain_str = contains[i];
       contains_.push_back(contain_str);
+      matcher_.addSubstring(contain_str);
     }
   }
 
@@ -97,6 +100,7 @@ bool GenericAnalyzer::init(string first_prefix, const ros::NodeHandle &n)
     {
       string expected_str = expected[i];
       expected_.push_back(expected_str);
+      matcher_.addName(expected_str);
       
       // Make sure we're looking for this item
       diagnostic_msgs::DiagnosticStatus *status = new diagnostic_msgs::DiagnosticStatus();
@@ -216,8 +220,15 @@ vector<diagnostic_msgs::DiagnosticStatus*> GenericAnalyzer::toAnalyzeOther(map<s
   return to_analyze;
 }
 
+bool GenericAnalyzer::match(const string &name)
+{
+  if (other_)
+    return true;
+
+  return matcher_.match(name);
+}
+
 // Returns vector of msgs to analyze
-///\todo optimize with dictionaries or something
 vector<diagnostic_msgs::DiagnosticStatus*> GenericAnalyzer::toAnalyze(map<string, diagnostic_item::DiagnosticItem*> msgs)
 {
   vector<diagnostic_msgs::DiagnosticStatus*> to_analyze;
@@ -226,63 +237,10 @@ vector<diagnostic_msgs::DiagnosticStatus*> GenericAnalyzer::toAnalyze(map<string
 
   for (it = msgs.begin(); it != msgs.end(); ++it)
   {
-    // Look for all startswith, etc
-    diagnostic_item::DiagnosticItem *item = it->second;
-    
-    string name = item->getName();
-
-    bool analyzed = false;
-
     // Check expected, name, startswith, contains
-    // If we're going to analyze it, don't check remainder
-    for (unsigned int i = 0; i < expected_.size(); ++i)
-    {
-      if (name == expected_[i])
-      {
-        to_analyze.push_back(item->toStatusMsg());
-        analyzed = true;
-        break;
-      }
-    }
-    if (analyzed)
-      continue;
-
-    for (unsigned int i = 0; i < name_.size(); ++i)
-    {
-      if (name == name_[i])
-      {
-        to_analyze.push_back(item->toStatusMsg());
-        analyzed = true;
-        break;
-      }
-    }
-    if (analyzed)
-      continue;
-
-    for (unsigned int i = 0; i < startswith_.size(); ++i)
-    {
-      if (name.find(startswith_[i]) == 0)
-      {
-        to_analyze.push_back(item->toStatusMsg());
-        analyzed = true;
-        break;
-      }
-    }
-    if (analyzed)
-      continue;
- 
-    for (unsigned int i = 0; i < contains_.size(); ++i)
-    {
-      if (name.find(contains_[i]) != string::npos)
-      {
-        to_analyze.push_back(item->toStatusMsg());
-        analyzed = true;
-        break;
-      }
-    }
+    if (match(it->first))
+      to_analyze.push_back(it->second->toStatusMsg());
   }
 
   return to_analyze;
 }
-
-
@@ -0,0 +1,153 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "diagnostic_aggregator/name_matcher.h"
+#include <queue>
+
+using namespace diagnostic_analyzer;
+using namespace std;
+
+NameMatcher::NameMatcher() : nodes_(1), has_substrings_(false), compiled_(true) { }
+
+int NameMatcher::addPath(const string &s)
+{
+  int node = 0;
+  for (unsigned int i = 0; i < s.size(); ++i)
+  {
+    map<char, int>::iterator it = nodes_[node].next.find(s[i]);
+    if (it != nodes_[node].next.end())
+    {
+      node = it->second;
+      continue;
+    }
+
+    nodes_.push_back(Node());
+    nodes_[node].next[s[i]] = nodes_.size() - 1;
+    node = nodes_.size() - 1;
+  }
+  compiled_ = false;
+  return node;
+}
+
+void NameMatcher::addName(const string &name)
+{
+  nodes_[addPath(name)].name = true;
+}
+
+void NameMatcher::addPrefix(const string &prefix)
+{
+  nodes_[addPath(prefix)].prefix = true;
+}
+
+void NameMatcher::addSubstring(const string &substring)
+{
+  nodes_[addPath(substring)].substring = true;
+  has_substrings_ = true;
+}
+
+void NameMatcher::compile()
+{
+  queue<int> to_visit;
+  map<char, int>::iterator it;
+  for (it = nodes_[0].next.begin(); it != nodes_[0].next.end(); ++it)
+  {
+    nodes_[it->second].fail = 0;
+    to_visit.push(it->second);
+  }
+
+  while (!to_visit.empty())
+  {
+    int node = to_visit.front();
+    to_visit.pop();
+
+    for (it = nodes_[node].next.begin(); it != nodes_[node].next.end(); ++it)
+    {
+      // Longest proper suffix of the child's path that is also in the trie
+      int fail = nodes_[node].fail;
+      map<char, int>::iterator edge;
+      while ((edge = nodes_[fail].next.find(it->first)) == nodes_[fail].next.end() && fail != 0)
+        fail = nodes_[fail].fail;
+      if (edge != nodes_[fail].next.end() && edge->second != it->second)
+        fail = edge->second;
+
+      Node &child = nodes_[it->second];
+      child.fail = fail;
+      child.substring = child.substring || nodes_[fail].substring;
+      to_visit.push(it->second);
+    }
+  }
+
+  compiled_ = true;
+}
+
+bool NameMatcher::match(const string &name)
+{
+  if (!compiled_)
+    compile();
+
+  // Whole names and prefixes, straight down from the root
+  int node = 0;
+  unsigned int i = 0;
+  for (; i < name.size(); ++i)
+  {
+    if (nodes_[node].prefix)
+      return true;
+    map<char, int>::const_iterator it = nodes_[node].next.find(name[i]);
+    if (it == nodes_[node].next.end())
+      break;
+    node = it->second;
+  }
+  if (i == name.size() && (nodes_[node].name || nodes_[node].prefix))
+    return true;
+
+  if (!has_substrings_)
+    return false;
+
+  // Substrings anywhere in the name
+  node = 0;
+  if (nodes_[0].substring)
+    return true;
+  for (i = 0; i < name.size(); ++i)
+  {
+    map<char, int>::const_iterator it;
+    while ((it = nodes_[node].next.find(name[i])) == nodes_[node].next.end() && node != 0)
+      node = nodes_[node].fail;
+    if (it != nodes_[node].next.end())
+      node = it->second;
+    if (nodes_[node].substring)
+      return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,163 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include "diagnostic_aggregator/name_matcher.h"
+
+using namespace diagnostic_analyzer;
+
+TEST(NameMatcher, Name)
+{
+  NameMatcher m;
+  m.addName("Motor Controller");
+  EXPECT_TRUE(m.match("Motor Controller"));
+  EXPECT_FALSE(m.match("Motor"));
+  EXPECT_FALSE(m.match("Motor Controllers"));
+  EXPECT_FALSE(m.match("My Motor Controller"));
+  EXPECT_FALSE(m.match(""));
+}
+
+TEST(NameMatcher, Prefix)
+{
+  NameMatcher m;
+  m.addPrefix("EtherCAT");
+  m.addPrefix("EtherCAT Device");
+  EXPECT_TRUE(m.match("EtherCAT"));
+  EXPECT_TRUE(m.match("EtherCAT Master"));
+  EXPECT_TRUE(m.match("EtherCAT Device (fl_caster)"));
+  EXPECT_FALSE(m.match("Ether"));
+  EXPECT_FALSE(m.match("The EtherCAT Master"));
+}
+
+TEST(NameMatcher, Substring)
+{
+  NameMatcher m;
+  m.addSubstring("laser");
+  EXPECT_TRUE(m.match("laser"));
+  EXPECT_TRUE(m.match("base_laser"));
+  EXPECT_TRUE(m.match("laser_tilt"));
+  EXPECT_TRUE(m.match("tilt laser driver"));
+  EXPECT_TRUE(m.match("lalaser"));
+  EXPECT_FALSE(m.match("lase"));
+  EXPECT_FALSE(m.match("Laser"));
+}
+
+TEST(NameMatcher, EmptyRules)
+{
+  NameMatcher none;
+  EXPECT_FALSE(none.match(""));
+  EXPECT_FALSE(none.match("anything"));
+
+  // an empty prefix or substring matches every name, an empty name only
+  // the empty name
+  NameMatcher name;
+  name.addName("");
+  EXPECT_TRUE(name.match(""));
+  EXPECT_FALSE(name.match("a"));
+
+  NameMatcher prefix;
+  prefix.addPrefix("");
+  EXPECT_TRUE(prefix.match(""));
+  EXPECT_TRUE(prefix.match("a"));
+
+  NameMatcher substring;
+  substring.addSubstring("");
+  EXPECT_TRUE(substring.match(""));
+  EXPECT_TRUE(substring.match("a"));
+}
+
+// Substrings that are suffixes or parts of each other are found through the
+// failure links
+TEST(NameMatcher, OverlappingSubstrings)
+{
+  NameMatcher m;
+  m.addSubstring("abcd");
+  m.addSubstring("bc");
+  m.addSubstring("cde");
+  EXPECT_TRUE(m.match("xbcx"));
+  EXPECT_TRUE(m.match("abcx"));
+  EXPECT_TRUE(m.match("abcde"));
+  EXPECT_TRUE(m.match("abccde"));
+  EXPECT_FALSE(m.match("abdce"));
+  EXPECT_FALSE(m.match("acd"));
+
+  NameMatcher n;
+  n.addSubstring("aab");
+  n.addSubstring("ab");
+  EXPECT_TRUE(n.match("aaab"));
+  EXPECT_TRUE(n.match("xab"));
+  EXPECT_FALSE(n.match("aaa"));
+
+  NameMatcher p;
+  p.addSubstring("she");
+  p.addSubstring("hers");
+  EXPECT_TRUE(p.match("ushers"));
+  EXPECT_TRUE(p.match("usher"));
+  EXPECT_FALSE(p.match("her s he"));
+  EXPECT_FALSE(p.match("hes"));
+}
+
+// Rules of different kinds share trie nodes without matching for each other
+TEST(NameMatcher, MixedRules)
+{
+  NameMatcher m;
+  m.addName("Joint");
+  m.addPrefix("Joint ");
+  m.addSubstring("calibration");
+  EXPECT_TRUE(m.match("Joint"));
+  EXPECT_TRUE(m.match("Joint r_elbow"));
+  EXPECT_FALSE(m.match("Jointed"));
+  EXPECT_FALSE(m.match("Joi"));
+  EXPECT_TRUE(m.match("Jointed calibration"));
+  EXPECT_FALSE(m.match("calibratio"));
+}
+
+// Rules added after matching are compiled into the automaton
+TEST(NameMatcher, AddAfterMatch)
+{
+  NameMatcher m;
+  m.addSubstring("abc");
+  EXPECT_FALSE(m.match("xbcx"));
+  m.addSubstring("bc");
+  EXPECT_TRUE(m.match("xbcx"));
+  m.addName("xyz");
+  EXPECT_TRUE(m.match("xyz"));
+  EXPECT_FALSE(m.match("xy"));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
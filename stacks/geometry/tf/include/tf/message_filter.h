@@ -39,6 +39,8 @@
 
 #include <string>
 #include <list>
+#include <map>
+#include <algorithm>
 #include <vector>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
@@ -153,14 +155,15 @@ public:
   ~MessageFilter()
   {
     message_connection_.disconnect();
-    tf_.removeTransformsChangedListener(tf_connection_);
+    tf_.removeTransformUpdatedListener(tf_connection_);
 
     clear();
 
-    TF_MESSAGEFILTER_DEBUG("Successful Transforms: %llu, Failed Transforms: %llu, Discarded due to age: %llu, Transform messages received: %llu, Messages received: %llu, Total dropped: %llu",
+    TF_MESSAGEFILTER_DEBUG("Successful Transforms: %llu, Failed Transforms: %llu, Discarded due to age: %llu, Transform messages received: %llu, Messages received: %llu, Total dropped: %llu, Tests avoided: %llu",
                            (long long unsigned int)successful_transform_count_, (long long unsigned int)failed_transform_count_, 
                            (long long unsigned int)failed_out_the_back_count_, (long long unsigned int)transform_message_count_, 
-                           (long long unsigned int)incoming_message_count_, (long long unsigned int)dropped_message_count_);
+                           (long long unsigned int)incoming_message_count_, (long long unsigned int)dropped_message_count_,
+                           (long long unsigned int)avoided_test_count_);
 
   }
 
@@ -183,6 +186,7 @@ public:
     boost::mutex::scoped_lock string_lock(target_frames_string_mutex_);
 
     target_frames_ = target_frames;
+    retestAll();
 
     std::stringstream ss;
     for (std::vector<std::string>::const_iterator it = target_frames_.begin(); it != target_frames_.end(); ++it)
@@ -205,7 +209,9 @@ public:
    */
   void setTolerance(const ros::Duration& tolerance)
   {
+    boost::mutex::scoped_lock lock(messages_mutex_);
     time_tolerance_ = tolerance;
+    retestAll();
   }
 
   /**
@@ -221,30 +227,51 @@ public:
     message_count_ = 0;
   }
 
+  /**
+   * \brief Get the number of times a queued message was not retested because none of the new transforms could make it ready
+   */
+  uint64_t getAvoidedTestCount()
+  {
+    boost::mutex::scoped_lock lock(messages_mutex_);
+    return avoided_test_count_;
+  }
+
   /**
    * \brief Manually add a message into this filter.
    * \note If the message is immediately transformable, this will immediately call through to its output callback
    */
   void add(const MConstPtr& message)
   {
-    if (testMessage(message))
+    uint64_t transform_count = transformMessageCount();
+
+    MessageInfo info;
+    info.message = message;
+    if (testMessage(info))
     {
       return;
     }
 
     boost::mutex::scoped_lock lock(messages_mutex_);
 
+    // Transforms which arrived during the test may already have been handled by the timer
+    if (transformMessageCount() != transform_count)
+    {
+      info.any_update = true;
+      new_transforms_ = true;
+    }
+
     // If this message is about to push us past our queue size, erase the oldest message
     if (queue_size_ != 0 && message_count_ + 1 > queue_size_)
     {
       ++dropped_message_count_;
-      TF_MESSAGEFILTER_DEBUG("Removed oldest message because buffer is full, count now %d (frame_id=%s, stamp=%f)", message_count_, messages_.front()->header.frame_id.c_str(), messages_.front()->header.stamp.toSec());
+      TF_MESSAGEFILTER_DEBUG("Removed oldest message because buffer is full, count now %d (frame_id=%s, stamp=%f)", message_count_, messages_.front().message->header.frame_id.c_str(), messages_.front().message->header.stamp.toSec());
       messages_.pop_front();
       --message_count_;
     }
 
     // Add the message to our list
-    messages_.push_back(message);
+    messages_.push_back(MessageInfo());
+    messages_.back().swap(info);
     ++message_count_;
 
     TF_MESSAGEFILTER_DEBUG("Added message in frame %s at time %.3f, count now %d", message->header.frame_id.c_str(), message->header.stamp.toSec(), message_count_);
@@ -264,17 +291,110 @@ private:
     transform_message_count_ = 0;
     incoming_message_count_ = 0;
     dropped_message_count_ = 0;
+    avoided_test_count_ = 0;
     time_tolerance_ = ros::Duration(0.0);
 
-    tf_connection_ = tf_.addTransformsChangedListener(boost::bind(&MessageFilter::transformsChanged, this));
+    tf_connection_ = tf_.addTransformUpdatedListener(boost::bind(&MessageFilter::transformUpdated, this, _1, _2));
 
     max_rate_timer_ = nh_.createWallTimer(ros::WallDuration(max_rate_.toSec()), &MessageFilter::maxRateTimerCallback, this);
   }
 
-  typedef std::list<MConstPtr> L_Message;
+  /**
+   * \brief A queued message, and the new transform data it is waiting for
+   *
+   * The message is only retested once one of its blocking frames gets data at or after the
+   * corresponding stamp.  If tf can't tell which frames block it (e.g. they aren't connected
+   * yet), it is retested on any new data.
+   */
+  struct MessageInfo
+  {
+    MessageInfo() : any_update(true) {}
+
+    void swap(MessageInfo& other)
+    {
+      message.swap(other.message);
+      std::swap(any_update, other.any_update);
+      blocking_frames.swap(other.blocking_frames);
+      blocking_stamps.swap(other.blocking_stamps);
+    }
+
+    MConstPtr message;
+    bool any_update;
+    std::vector<std::string> blocking_frames;
+    std::vector<ros::Time> blocking_stamps;
+  };
+
+  typedef std::list<MessageInfo> L_Message;
+  typedef std::map<std::string, ros::Time> M_FrameStamp;
+
+  /**
+   * \brief Find what a message which isn't ready yet is waiting for
+   */
+  void findBlockingFrames(MessageInfo& info)
+  {
+    const MConstPtr& message = info.message;
+    info.any_update = false;
+    info.blocking_frames.clear();
+    info.blocking_stamps.clear();
+    for (std::vector<std::string>::iterator target_it = target_frames_.begin(); !info.any_update && target_it != target_frames_.end(); ++target_it)
+    {
+      info.any_update = !tf_.getBlockingFrames(*target_it, message->header.frame_id, message->header.stamp, info.blocking_frames, info.blocking_stamps);
+      if (time_tolerance_ != ros::Duration(0.0))
+      {
+        info.any_update = info.any_update || !tf_.getBlockingFrames(*target_it, message->header.frame_id, message->header.stamp + time_tolerance_, info.blocking_frames, info.blocking_stamps);
+      }
+    }
+
+    // Not ready, but nothing specific to wait for
+    if (info.blocking_frames.empty())
+    {
+      info.any_update = true;
+    }
+  }
+
+  /**
+   * \brief Whether any of the updates may have made a message ready
+   */
+  bool isWoken(const MessageInfo& info, const M_FrameStamp& updates, const ros::Time& latest_update_stamp)
+  {
+    if (info.any_update)
+    {
+      return true;
+    }
+
+    // Messages which fall out of the back of the cache are dropped on their next test
+    if (info.message->header.stamp + tf_.getCacheLength() < latest_update_stamp)
+    {
+      return true;
+    }
+
+    for (unsigned int i = 0; i < info.blocking_frames.size(); ++i)
+    {
+      M_FrameStamp::const_iterator update = updates.find(info.blocking_frames[i]);
+      if (update != updates.end() && update->second >= info.blocking_stamps[i])
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * \brief Test all queued messages on the next update, e.g. after the target frames changed
+   */
+  void retestAll()
+  {
+    for (typename L_Message::iterator it = messages_.begin(); it != messages_.end(); ++it)
+    {
+      it->any_update = true;
+    }
+  }
 
-  bool testMessage(const MConstPtr& message)
+  bool testMessage(MessageInfo& info)
   {
+    const MConstPtr& message = info.message;
+
     //Throw out messages which are too old
     //! \todo combine getLatestCommonTime call with the canTransform call
     for (std::vector<std::string>::iterator target_it = target_frames_.begin(); target_it != target_frames_.end(); ++target_it)
@@ -327,12 +447,13 @@ private:
     else
     {
       ++failed_transform_count_;
+      findBlockingFrames(info);
     }
 
     return ready;
   }
 
-  void testMessages()
+  void testMessages(const M_FrameStamp& updates, const ros::Time& latest_update_stamp)
   {
     if (!messages_.empty() && getTargetFramesString() == " ")
     {
@@ -344,9 +465,12 @@ private:
     typename L_Message::iterator it = messages_.begin();
     for (; it != messages_.end(); ++i)
     {
-      MConstPtr& message = *it;
-
-      if (testMessage(message))
+      if (!isWoken(*it, updates, latest_update_stamp))
+      {
+        ++avoided_test_count_;
+        ++it;
+      }
+      else if (testMessage(*it))
       {
         --message_count_;
         it = messages_.erase(it);
@@ -363,8 +487,15 @@ private:
     boost::mutex::scoped_lock list_lock(messages_mutex_);
     if (new_transforms_)
     {
-      testMessages();
-      new_transforms_ = false;
+      M_FrameStamp updates;
+      ros::Time latest_update_stamp;
+      {
+        boost::mutex::scoped_lock updates_lock(updates_mutex_);
+        updates.swap(updates_);
+        latest_update_stamp = latest_update_stamp_;
+        new_transforms_ = false;
+      }
+      testMessages(updates, latest_update_stamp);
     }
 
     checkFailures();
@@ -378,8 +509,32 @@ private:
     add(msg);
   }
 
-  void transformsChanged()
+  uint64_t transformMessageCount()
+  {
+    boost::mutex::scoped_lock lock(updates_mutex_);
+    return transform_message_count_;
+  }
+
+  void transformUpdated(const std::string& frame_id, const ros::Time& stamp)
   {
+    boost::mutex::scoped_lock lock(updates_mutex_);
+
+    // Keep the latest stamp per frame since the last test
+    M_FrameStamp::iterator update = updates_.find(frame_id);
+    if (update == updates_.end())
+    {
+      updates_.insert(std::make_pair(frame_id, stamp));
+    }
+    else if (update->second < stamp)
+    {
+      update->second = stamp;
+    }
+
+    if (latest_update_stamp_ < stamp)
+    {
+      latest_update_stamp_ = stamp;
+    }
+
     new_transforms_ = true;
 
     ++transform_message_count_;
@@ -428,6 +583,9 @@ private:
 
   bool new_messages_; ///< Used to skip waiting on new_data_ if new messages have come in while calling back
   volatile bool new_transforms_; ///< Used to skip waiting on new_data_ if new transforms have come in while calling back or transforming data
+  M_FrameStamp updates_; ///< The frames which got new transforms since the last test, with the latest stamp of each
+  ros::Time latest_update_stamp_; ///< The latest stamp of any new transform
+  boost::mutex updates_mutex_; ///< The mutex used for locking updates_
 
   uint64_t successful_transform_count_;
   uint64_t failed_transform_count_;
@@ -435,6 +593,7 @@ private:
   uint64_t transform_message_count_;
   uint64_t incoming_message_count_;
   uint64_t dropped_message_count_;
+  uint64_t avoided_test_count_; ///< Queued messages not retested because none of the new transforms could make them ready
 
   ros::Time last_out_the_back_stamp_;
   std::string last_out_the_back_frame_;
@@ -159,6 +159,15 @@ public:
    * zero if fails to cross */
   int getLatestCommonTime(const std::string& source, const std::string& dest, ros::Time& time, std::string * error_string) const;
 
+  /**@brief Find the frames whose data keeps a transform from being available
+   * For each transform in the chain between target_frame and source_frame which can't be
+   * interpolated or extrapolated to time, adds its frame id to frames, and to stamps the time
+   * new data for that frame has to reach (zero if any new data for it may help).
+   * Returns false if the chain can't be determined, e.g. if the frames aren't connected,
+   * in which case any new transform may make the transform available */
+  bool getBlockingFrames(const std::string& target_frame, const std::string& source_frame, const ros::Time& time,
+                         std::vector<std::string>& frames, std::vector<ros::Time>& stamps) const;
+
 
   /** \brief Transform a Stamped Quaternion into the target frame */
   void transformQuaternion(const std::string& target_frame, const Stamped<tf::Quaternion>& stamped_in, Stamped<tf::Quaternion>& stamped_out) const;
@@ -245,6 +254,17 @@ public:
   boost::signals::connection addTransformsChangedListener(boost::function<void(void)> callback);
   void removeTransformsChangedListener(boost::signals::connection c);
 
+  /**
+   * \brief Add a callback that happens when a new transform has arrived, with the (remapped)
+   * frame id and the stamp of the new transform
+   *
+   * \param callback The callback, of the form void func(const std::string& frame_id, const ros::Time& stamp);
+   * \return A boost::signals::connection object that can be used to remove this
+   * listener
+   */
+  boost::signals::connection addTransformUpdatedListener(boost::function<void(const std::string&, const ros::Time&)> callback);
+  void removeTransformUpdatedListener(boost::signals::connection c);
+
   /** 
    * \brief Get the tf_prefix this is running with
    */
@@ -297,6 +317,9 @@ protected:
   typedef boost::signal<void(void)> TransformsChangedSignal;
   /// Signal which is fired whenever new transform data has arrived, from the thread the data arrived in
   TransformsChangedSignal transforms_changed_;
+  typedef boost::signal<void(const std::string&, const ros::Time&)> TransformUpdatedSignal;
+  /// Signal which is fired along with transforms_changed_, with the frame id and stamp of the new data
+  TransformUpdatedSignal transform_updated_;
   boost::mutex transforms_changed_mutex_;
 
   //Whether it is safe to use waitForTransform.  This is basically stating that tf is multithreaded.  
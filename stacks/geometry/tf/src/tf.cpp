@@ -173,6 +173,7 @@ bool Transformer::setTransform(const Stamped<btTransform>& transform, const std:
   {
     boost::mutex::scoped_lock lock(transforms_changed_mutex_);
     transforms_changed_();
+    transform_updated_(mapped_transform.frame_id_, mapped_transform.stamp_);
   }
 
   return true;
@@ -684,6 +685,50 @@ int Transformer::lookupLists(unsigned int target_frame, ros::Time time, unsigned
   }
 
 
+// Adds the transforms of list which are too far from time, by the same rules as test_extrapolation
+static void addBlockingFrames(const std::vector<TransformStorage>& list, const ros::Time& time, const ros::Duration& max_extrapolation_distance,
+                              std::vector<std::string>& frames, std::vector<ros::Time>& stamps)
+{
+  for (unsigned int i = 0; i < list.size(); i++)
+  {
+    const TransformStorage& transform = list[i];
+    ros::Time stamp; // zero: any new data
+    if ((transform.mode_ == ONE_VALUE || transform.mode_ == EXTRAPOLATE_FORWARD) && time - transform.stamp_ > max_extrapolation_distance)
+      stamp = time - max_extrapolation_distance;
+    else if ((transform.mode_ == ONE_VALUE || transform.mode_ == EXTRAPOLATE_BACK) && transform.stamp_ - time > max_extrapolation_distance)
+      stamp = ros::Time();
+    else
+      continue;
+    frames.push_back(transform.frame_id_);
+    stamps.push_back(stamp);
+  }
+}
+
+bool Transformer::getBlockingFrames(const std::string& target_frame, const std::string& source_frame, const ros::Time& time,
+                                    std::vector<std::string>& frames, std::vector<ros::Time>& stamps) const
+{
+  std::string mapped_target_frame = remap(tf_prefix_, target_frame);
+  std::string mapped_source_frame = remap(tf_prefix_, source_frame);
+
+  if (time == ros::Time()) // the latest common time moves with any new data
+    return false;
+
+  TransformLists t_list;
+  try
+  {
+    if (lookupLists(lookupFrameNumber(mapped_target_frame), time, lookupFrameNumber(mapped_source_frame), t_list, NULL) != NO_ERROR)
+      return false;
+  }
+  catch (tf::LookupException &ex)
+  {
+    return false;
+  }
+
+  addBlockingFrames(t_list.inverseTransforms, time, max_extrapolation_distance_, frames, stamps);
+  addBlockingFrames(t_list.forwardTransforms, time, max_extrapolation_distance_, frames, stamps);
+  return true;
+}
+
 bool Transformer::test_extrapolation(const ros::Time& target_time, const TransformLists& lists, std::string * error_string) const
 {
   bool retval = false;
@@ -1115,6 +1160,18 @@ void Transformer::removeTransformsChangedListener(boost::signals::connection c)
   c.disconnect();
 }
 
+boost::signals::connection Transformer::addTransformUpdatedListener(boost::function<void(const std::string&, const ros::Time&)> callback)
+{
+  boost::mutex::scoped_lock lock(transforms_changed_mutex_);
+  return transform_updated_.connect(callback);
+}
+
+void Transformer::removeTransformUpdatedListener(boost::signals::connection c)
+{
+  boost::mutex::scoped_lock lock(transforms_changed_mutex_);
+  c.disconnect();
+}
+
 /*
 void Transformer::transformTransform(const std::string& target_frame,
                                   const geometry_msgs::TransformStamped& msg_in,
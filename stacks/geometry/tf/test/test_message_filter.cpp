@@ -260,6 +260,61 @@ TEST(MessageFilter, tolerance)
 	EXPECT_EQ(1, n.count_); // Latest message is off the end of the offset
 }
 
+TEST(MessageFilter, waitsOnBlockingFrame)
+{
+  tf::TransformListener tf_client;
+  Notification n(1);
+  MessageFilter<geometry_msgs::PointStamped> filter(tf_client, "frame1", 1);
+  filter.registerCallback(boost::bind(&Notification::notify, &n, _1));
+
+  // frame1 -> frame2 can be interpolated, frame3 -> frame2 is behind
+	ros::Time stamp = ros::Time::now();
+  tf::Stamped<tf::Transform> transform(btTransform(btQuaternion(0,0,0), btVector3(1,2,3)), stamp, "frame1", "frame2");
+  tf_client.setTransform(transform);
+  transform.stamp_ = stamp + ros::Duration(1.0);
+  tf_client.setTransform(transform);
+  tf::Stamped<tf::Transform> behind(btTransform(btQuaternion(0,0,0), btVector3(1,2,3)), stamp, "frame3", "frame2");
+  tf_client.setTransform(behind);
+
+  geometry_msgs::PointStampedPtr msg(new geometry_msgs::PointStamped);
+  msg->header.stamp = stamp + ros::Duration(0.5);
+  msg->header.frame_id = "frame3";
+  filter.add(msg);
+
+	EXPECT_EQ(0, n.count_);
+
+  // More data for the frame which isn't blocking doesn't help, so the
+  // message isn't retested
+  uint64_t avoided = filter.getAvoidedTestCount();
+  transform.stamp_ = stamp + ros::Duration(2.0);
+  tf_client.setTransform(transform);
+
+	ros::WallDuration(0.1).sleep();
+	ros::spinOnce();
+
+	EXPECT_EQ(0, n.count_);
+  EXPECT_GT(filter.getAvoidedTestCount(), avoided);
+
+  // Data for the blocking frame that isn't recent enough doesn't either
+  avoided = filter.getAvoidedTestCount();
+  behind.stamp_ = stamp + ros::Duration(0.2);
+  tf_client.setTransform(behind);
+
+	ros::WallDuration(0.1).sleep();
+	ros::spinOnce();
+
+	EXPECT_EQ(0, n.count_);
+  EXPECT_GT(filter.getAvoidedTestCount(), avoided);
+
+  behind.stamp_ = stamp + ros::Duration(1.0);
+  tf_client.setTransform(behind);
+
+	ros::WallDuration(0.1).sleep();
+	ros::spinOnce();
+
+	EXPECT_EQ(1, n.count_);
+}
+
 // TODO: re-enable once ROS 0.7.3 is out and the Timer issues have been fixed
 #if 0
 TEST(MessageFilter, maxRate)
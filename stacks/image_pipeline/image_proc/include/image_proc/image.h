@@ -62,6 +62,8 @@
 
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/CameraInfo.h>
+
+#include "image_proc/rectify.h"
 //#include <sensor_msgs/fill_image.h>
 
 // alignment on allocation
@@ -222,6 +224,13 @@ namespace cam
     void doBayerColorRGB();	// does Bayer => color and mono
     void doBayerMono();		// does Bayer => mono
 
+    // fused color conversion and rectification
+    // the raw image is converted in bands just ahead of the rectification
+    //   tiles that read it, while the rows are still in cache
+    // only the selected rectified outputs are produced; the mono image,
+    //   and the color image if rectColor is set, come along with them
+    bool doBayerRectify(bool rect, bool rectColor);
+
 
   protected:
     // rectification arrays from OpenCV
@@ -230,22 +239,24 @@ namespace cam
     CvMat *rR;
     CvMat *rKp;
 
-    CvMat* rMapxy;		// rectification table, integer format
-    CvMat* rMapa;
-    CvMat* mx,* my;
-    IplImage* srcIm;		// temps for rectification
-    IplImage* dstIm;
+    RectifyMap rMap;		// rectification table, fixed point
 
   private:
     // various color converters
+    // these process Bayer rows [row0,row1), so they can be run in bands
     void convertBayerGRBGColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
-				  int width, int height, color_conversion_t colorAlg);
+				  int width, int height, color_conversion_t colorAlg,
+				  int row0, int row1);
     void convertBayerBGGRColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
-				  int width, int height, color_conversion_t colorAlg);
+				  int width, int height, color_conversion_t colorAlg,
+				  int row0, int row1);
     void convertBayerGRBGMono(uint8_t *src, uint8_t *dstm,
-                              int width, int height, color_conversion_t colorAlg);
+                              int width, int height, color_conversion_t colorAlg,
+                              int row0, int row1);
     void convertBayerBGGRMono(uint8_t *src, uint8_t *dstm,
-                              int width, int height, color_conversion_t colorAlg);
+                              int width, int height, color_conversion_t colorAlg,
+                              int row0, int row1);
+    void convertBayerRows(bool color, int row0, int row1);
   };
 
 }
@@ -0,0 +1,100 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef RECTIFY_H
+#define RECTIFY_H
+
+#include <stdint.h>
+
+namespace cam
+{
+  //
+  // Bilinear rectification table
+  //
+  // The table is built once from the floating-point maps produced by
+  //   cvInitUndistortRectifyMap, and stored as separate arrays (source
+  //   offsets, top-row weights, bottom-row weights) in the order the
+  //   remap functions visit the output image: tiles of TILE_H rows by
+  //   TILE_W columns, so the source pixels for a tile stay in cache.
+  //
+  // Weights are fixed point with WEIGHT_BITS fractional bits, stored as
+  //   (upper left, upper right) and (lower left, lower right) pairs so
+  //   that the SSE2 version can use one pmaddwd per row.
+  // Output pixels that map outside the source image are set to 0.
+  //
+
+  class RectifyMap
+  {
+  public:
+    RectifyMap();
+    ~RectifyMap();
+
+    static const int TILE_W = 64;	// must be a multiple of 8
+    static const int TILE_H = 8;
+    static const int WEIGHT_BITS = 14;
+
+    // builds the table from per-pixel source coordinates
+    void init(const float *mapx, const float *mapy, int width, int height);
+    void release();
+    bool isInitialized() const { return offset != NULL; }
+
+    // rectify a mono image, or an RGB image with 3 bytes per pixel
+    // src and dest are width x height, and must not overlap
+    void remapMono(const uint8_t *src, uint8_t *dest) const;
+    void remapRGB(const uint8_t *src, uint8_t *dest) const;
+
+    // the output is processed in bands of TILE_H rows; a band only reads
+    //   source rows below bandSourceEnd(band), which never decreases,
+    //   so the source can be produced band by band ahead of the remap
+    int numBands() const { return (height+TILE_H-1)/TILE_H; }
+    int bandSourceEnd(int band) const { return bandEnd[band]; }
+
+    // rectify output bands [band0,band1) only
+    void remapMono(const uint8_t *src, uint8_t *dest, int band0, int band1) const;
+    void remapRGB(const uint8_t *src, uint8_t *dest, int band0, int band1) const;
+
+  private:
+    int width, height;
+    int *bandEnd;		// one past the last source row read, per band
+    int32_t *offset;		// source pixel index of the upper left neighbor
+    int16_t *wtop;		// upper left, upper right weight pairs
+    int16_t *wbot;		// lower left, lower right weight pairs
+
+    // owns its tables, no copies
+    RectifyMap(const RectifyMap &);
+    RectifyMap &operator=(const RectifyMap &);
+  };
+}
+
+#endif	// RECTIFY_H
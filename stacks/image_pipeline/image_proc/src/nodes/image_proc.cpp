@@ -102,22 +102,21 @@ public:
   {
     cam_bridge::RawToCamData(*raw_image, *cam_info, cam::IMAGE_RAW, &img_data_);
 
-    // @todo: only do processing if topics have subscribers
+    // only produce the outputs that have subscribers
     // @todo: parameter for bayer interpolation to use
-    if (do_colorize_ &&
-	(pub_color_.getNumSubscribers() > 0 ||
-	 pub_rect_color_.getNumSubscribers() > 0))
+    bool rect = do_rectify_ && pub_rect_.getNumSubscribers() > 0;
+    bool rect_color = do_rectify_ && do_colorize_ && pub_rect_color_.getNumSubscribers() > 0;
+
+    // color conversion and rectification in one pass
+    if (rect || rect_color)
+      img_data_.doBayerRectify(rect, rect_color);
+
+    if (do_colorize_ && pub_color_.getNumSubscribers() > 0)
       {
 	//img_data_.colorConvertType = COLOR_CONVERSION_EDGE;
-	img_data_.doBayerColorRGB();
-	//img_data_.doBayerMono();
+	img_data_.doBayerColorRGB(); // no-op if already converted
       }
 
-    if (do_rectify_ && 
-	(pub_rect_.getNumSubscribers() > 0 ||
-	 pub_rect_color_.getNumSubscribers() > 0))
-      img_data_.doRectify();
-
     // Publish images
     img_.header.stamp = raw_image->header.stamp;
     img_.header.frame_id = raw_image->header.frame_id;
@@ -78,25 +78,17 @@ ImageData::ImageData()
   // rectification mapping
   hasRectification = false;
   initRect = false;
-  rMapxy = NULL;
-  rMapa = NULL;
 
   // calibration matrices
   rD = cvCreateMat(5,1,CV_64F);
   rK = cvCreateMat(3,3,CV_64F);
   rR = cvCreateMat(3,3,CV_64F);
   rKp = cvCreateMat(3,3,CV_64F);
-
-  // temp images, these will be changed when used
-  srcIm = cvCreateImageHeader(cvSize(640,480), IPL_DEPTH_8U, 1);
-  dstIm = cvCreateImageHeader(cvSize(640,480), IPL_DEPTH_8U, 1);
 }
 
 ImageData::~ImageData()
 {
   releaseBuffers();
-  cvReleaseImageHeader(&srcIm);
-  cvReleaseImageHeader(&dstIm);
 }
 
 // storage
@@ -127,12 +119,7 @@ ImageData::releaseBuffers()
   imRectColorSize = 0;
 
   initRect = false;
-  if (rMapxy)
-    cvReleaseMat(&rMapxy);
-  if (rMapa)
-    cvReleaseMat(&rMapa);
-  rMapxy = NULL;
-  rMapa = NULL;
+  rMap.release();
 }
 
 
@@ -148,7 +135,7 @@ ImageData::initRectify(bool force)
   if (!hasRectification || imWidth == 0 || imHeight == 0)
     return false;
 
-  if (initRect && !force && rMapxy != NULL && rMapa != NULL)
+  if (initRect && !force && rMap.isInitialized())
     return true;		// already done
 
   // set values of cal matrices
@@ -169,12 +156,12 @@ ImageData::initRectify(bool force)
     CV_MAT_ELEM(*rD, double, i, 0) = D[i];
 
   // Set up rectification mapping
-  rMapxy = cvCreateMat(imHeight, imWidth, CV_16SC2);
-  rMapa  = cvCreateMat(imHeight, imWidth, CV_16UC1);//CV_16SC1);
-  mx = cvCreateMat(imHeight, imWidth, CV_32FC1);
-  my = cvCreateMat(imHeight, imWidth, CV_32FC1);
+  CvMat *mx = cvCreateMat(imHeight, imWidth, CV_32FC1);
+  CvMat *my = cvCreateMat(imHeight, imWidth, CV_32FC1);
   cvInitUndistortRectifyMap(rK,rD,rR,rKp,mx,my);
-  cvConvertMaps(mx,my,rMapxy,rMapa);
+  rMap.init(mx->data.fl, my->data.fl, imWidth, imHeight);
+  cvReleaseMat(&mx);
+  cvReleaseMat(&my);
 
   initRect = true;
   return true;
@@ -209,8 +196,6 @@ ImageData::doRectify()
 
   initRectify();		// ok to call multiple times
 
-  CvSize size = cvSize(imWidth,imHeight);
-
   // rectify grayscale image
   if (imType != COLOR_CODING_NONE)
     {
@@ -222,15 +207,8 @@ ImageData::doRectify()
 	  imRect = (uint8_t *)MEMALIGN(imSize);
 	}
 
-      // set up images
       imRectType = imType;
-      cvInitImageHeader(srcIm, size, IPL_DEPTH_8U, 1);
-      cvInitImageHeader(dstIm, size, IPL_DEPTH_8U, 1);
-      cvSetData(srcIm, im, imWidth);
-      cvSetData(dstIm, imRect, imWidth);
-
-      cvRemap(srcIm,dstIm,rMapxy,rMapa);
-      //cvRemap(srcIm,dstIm,mx,my);
+      rMap.remapMono(im, imRect);
     }
 
   // rectify color image
@@ -245,15 +223,92 @@ ImageData::doRectify()
 	  imRectColor = (uint8_t *)MEMALIGN(imRectColorSize);
 	}
 
-      // set up images
       imRectColorType = imColorType;
-      cvInitImageHeader(srcIm, size, IPL_DEPTH_8U, 3);
-      cvInitImageHeader(dstIm, size, IPL_DEPTH_8U, 3);
-      cvSetData(srcIm, imColor, imWidth*3);
-      cvSetData(dstIm, imRectColor, imWidth*3);
+      rMap.remapRGB(imColor, imRectColor);
+    }
+  return true;
+}
+
+
+// fused color conversion and rectification
+// each band of rectified rows is produced right after the Bayer rows it
+//   reads, so the converted rows are picked up from cache rather than
+//   from a second pass over the whole image
+
+bool
+ImageData::doBayerRectify(bool rect, bool rectColor)
+{
+  if (!rect && !rectColor)
+    return true;
+
+  bool bayer = (imRawType == COLOR_CODING_BAYER8_GRBG ||
+		imRawType == COLOR_CODING_BAYER8_BGGR);
+
+  // nothing to fuse: not Bayer, already converted, or no rectification
+  if (!bayer || imType != COLOR_CODING_NONE || imColorType != COLOR_CODING_NONE ||
+      !initRectify())
+    {
+      if (rectColor)
+	doBayerColorRGB();
+      return doRectify();
+    }
+
+  // check allocation
+  size_t size = imWidth*imHeight;
+  if (imSize < size)
+    {
+      MEMFREE(im);
+      im = (uint8_t *)MEMALIGN(size);
+      imSize = size;
+    }
+  if (rectColor && imColorSize < size*3)
+    {
+      MEMFREE(imColor);
+      imColor = (uint8_t *)MEMALIGN(size*3);
+      imColorSize = size*3;
+    }
+  if (rect && imRectSize < size)
+    {
+      MEMFREE(imRect);
+      imRect = (uint8_t *)MEMALIGN(size);
+      imRectSize = size;
+    }
+  if (rectColor && imRectColorSize < size*3)
+    {
+      MEMFREE(imRectColor);
+      imRectColor = (uint8_t *)MEMALIGN(size*3);
+      imRectColorSize = size*3;
+    }
+
+  int done = 0;			// Bayer rows converted so far
+  for (int band=0; band<rMap.numBands(); band++)
+    {
+      // the converters complete a row when the next pair is done
+      int need = (rMap.bandSourceEnd(band) + 2) & ~1;
+      if (need > imHeight)
+	need = imHeight;
+      if (need > done)
+	{
+	  convertBayerRows(rectColor, done, need);
+	  done = need;
+	}
+      if (rect)
+	rMap.remapMono(im, imRect, band, band+1);
+      if (rectColor)
+	rMap.remapRGB(imColor, imRectColor, band, band+1);
+    }
 
-      cvRemap(srcIm,dstIm,rMapxy,rMapa);
-      //cvRemap(srcIm,dstIm,mx,my);
+  // rows below the rectified area, so the full images are valid too
+  if (done < imHeight)
+    convertBayerRows(rectColor, done, imHeight);
+
+  imType = COLOR_CODING_MONO8;
+  if (rect)
+    imRectType = COLOR_CODING_MONO8;
+  if (rectColor)
+    {
+      imColorType = COLOR_CODING_RGB8;
+      imRectColorType = COLOR_CODING_RGB8;
     }
   return true;
 }
@@ -1339,10 +1394,10 @@ ImageData::doBayerColorRGB()
       imType = COLOR_CODING_MONO8;
       return;
     case COLOR_CODING_BAYER8_GRBG:
-      convertBayerGRBGColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType);
+      convertBayerGRBGColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType, 0, imHeight);
       break;
     case COLOR_CODING_BAYER8_BGGR:
-      convertBayerBGGRColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType);
+      convertBayerBGGRColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType, 0, imHeight);
       break;
       
     default:
@@ -1381,10 +1436,10 @@ ImageData::doBayerMono()
       memcpy(im, imRaw, size);
       break;
     case COLOR_CODING_BAYER8_GRBG:
-      convertBayerGRBGMono(imRaw, im, imWidth, imHeight, colorConvertType);
+      convertBayerGRBGMono(imRaw, im, imWidth, imHeight, colorConvertType, 0, imHeight);
       break;
     case COLOR_CODING_BAYER8_BGGR:
-      convertBayerBGGRMono(imRaw, im, imWidth, imHeight, colorConvertType);
+      convertBayerBGGRMono(imRaw, im, imWidth, imHeight, colorConvertType, 0, imHeight);
       break;
       
     default:
@@ -1395,28 +1450,57 @@ ImageData::doBayerMono()
 }
 
 
+// converts Bayer rows [row0,row1) of the raw image to mono, and to color
+//   if requested; used by the fused color/rectification stage
+
+void
+ImageData::convertBayerRows(bool color, int row0, int row1)
+{
+  switch (imRawType) {
+    case COLOR_CODING_BAYER8_GRBG:
+      if (color)
+	convertBayerGRBGColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType, row0, row1);
+      else
+	convertBayerGRBGMono(imRaw, im, imWidth, imHeight, colorConvertType, row0, row1);
+      break;
+    case COLOR_CODING_BAYER8_BGGR:
+      if (color)
+	convertBayerBGGRColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType, row0, row1);
+      else
+	convertBayerBGGRMono(imRaw, im, imWidth, imHeight, colorConvertType, row0, row1);
+      break;
+    default:
+      break;
+  }
+}
+
+
 // real funtion to do the job
 // converts to RGB
+// rows [row0,row1) of the Bayer image are processed, row0 even; calls on
+//   consecutive ranges give the same result as one call on the whole
+//   image, with rows below row1-1 complete
 
 void
 ImageData::convertBayerGRBGColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
-				    int width, int height, color_conversion_t colorAlg)
+				    int width, int height, color_conversion_t colorAlg,
+				    int row0, int row1)
 {
   uint8_t *s;
   int i, j;
   int ll = width;
   int ll2 = width*2;
 
-  s = src;
+  s = src + row0*ll;
   int pp2 = width*3*2;          // previous 2 color lines
   int pp = width*3;             // previous color line
-  uint8_t *cd = dstc;		// color
-  uint8_t *md = dstm;		// monochrome
+  uint8_t *cd = dstc + row0*pp;	// color
+  uint8_t *md = dstm + row0*ll;	// monochrome
 
   // simple, but has "zipper" artifacts
   if (colorAlg == COLOR_CONVERSION_BILINEAR)
     {
-      for (i=0; i<height; i+=2)
+      for (i=row0; i<row1; i+=2)
 	{
 	  // red line (GRGR...)
 	  for (j=0; j<width; j+=2, cd+=6, md+=2)
@@ -1472,7 +1556,7 @@ ImageData::convertBayerGRBGColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
       cd += pp2;
       s += ll2;
 
-      for (i=0; i<height-4; i+=2)
+      for (i=row0; i<row1 && i<height-4; i+=2)
 	{
 	  // GR line
 	  // do first two pixels
@@ -1581,23 +1665,24 @@ ImageData::convertBayerGRBGColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
 
 void
 ImageData::convertBayerBGGRColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
-				    int width, int height, color_conversion_t colorAlg)
+				    int width, int height, color_conversion_t colorAlg,
+				    int row0, int row1)
 {
   uint8_t *s;
   int i, j;
   int ll = width;
   int ll2 = width*2;
 
-  s = src;
+  s = src + row0*ll;
   int pp2 = width*3*2;          // previous 2 color lines
   int pp = width*3;             // previous color line
-  uint8_t *cd = dstc;		// color
-  uint8_t *md = dstm;		// monochrome
+  uint8_t *cd = dstc + row0*pp;	// color
+  uint8_t *md = dstm + row0*ll;	// monochrome
 
   // simple, but has "zipper" artifacts
   if (colorAlg == COLOR_CONVERSION_BILINEAR)
     {
-      for (i=0; i<height; i+=2)
+      for (i=row0; i<row1; i+=2)
 	{
           // blue line (BGBG...)
 	  *(cd+2) = *s;		// blue pixel
@@ -1653,7 +1738,7 @@ ImageData::convertBayerBGGRColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
       cd += pp2;
       s += ll2;
 
-      for (i=0; i<height-4; i+=2)
+      for (i=row0; i<row1 && i<height-4; i+=2)
 	{
           // BG line
 	  // do first two pixels
@@ -1763,23 +1848,25 @@ ImageData::convertBayerBGGRColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
 
 // real function to do the job
 // converts to monochrome
+// rows [row0,row1) as for the RGB converters
 
 void
 ImageData::convertBayerGRBGMono(uint8_t *src, uint8_t *dstm,
-				int width, int height, color_conversion_t colorAlg)
+				int width, int height, color_conversion_t colorAlg,
+				int row0, int row1)
 {
   uint8_t *s;
   int i, j;
   int ll = width;
   int ll2 = width*2;
 
-  s = src;
-  uint8_t *md = dstm;		// monochrome
+  s = src + row0*ll;
+  uint8_t *md = dstm + row0*ll;	// monochrome
 
   // simple, but has "zipper" artifacts
   if (colorAlg == COLOR_CONVERSION_BILINEAR)
     {
-      for (i=0; i<height; i+=2)
+      for (i=row0; i<row1; i+=2)
 	{
 	  // red line (GRGR...)
 	  for (j=0; j<width; j+=2, md+=2)
@@ -1813,7 +1900,7 @@ ImageData::convertBayerGRBGMono(uint8_t *src, uint8_t *dstm,
       // do first two lines
       s += ll2;
 
-      for (i=0; i<height-4; i+=2)
+      for (i=row0; i<row1 && i<height-4; i+=2)
 	{
 	  // GR line
 	  // do first two pixels
@@ -1878,20 +1965,21 @@ ImageData::convertBayerGRBGMono(uint8_t *src, uint8_t *dstm,
 
 void
 ImageData::convertBayerBGGRMono(uint8_t *src, uint8_t *dstm,
-				int width, int height, color_conversion_t colorAlg)
+				int width, int height, color_conversion_t colorAlg,
+				int row0, int row1)
 {
   uint8_t *s;
   int i, j;
   int ll = width;
   int ll2 = width*2;
 
-  s = src;
-  uint8_t *md = dstm;		// monochrome
+  s = src + row0*ll;
+  uint8_t *md = dstm + row0*ll;	// monochrome
 
   // simple, but has "zipper" artifacts
   if (colorAlg == COLOR_CONVERSION_BILINEAR)
     {
-      for (i=0; i<height; i+=2)
+      for (i=row0; i<row1; i+=2)
 	{
           // blue line (BGBG...)
 	  for (j=0; j<width-2; j+=2, md+=2)
@@ -1925,7 +2013,7 @@ ImageData::convertBayerBGGRMono(uint8_t *src, uint8_t *dstm,
       // do first two lines
       s += ll2;
 
-      for (i=0; i<height-4; i+=2)
+      for (i=row0; i<row1 && i<height-4; i+=2)
 	{
           // BG line
 	  // do first two pixels
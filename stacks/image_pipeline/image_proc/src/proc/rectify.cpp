@@ -0,0 +1,284 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+//
+// rectify.cpp
+// fixed-point bilinear rectification
+//
+
+#include "image_proc/image.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace cam;
+
+// fractional bits of the x and y interpolation steps; their product
+//   gives the WEIGHT_BITS of the table
+#define INTERP_BITS 7
+
+RectifyMap::RectifyMap()
+{
+  width = height = 0;
+  offset = NULL;
+  wtop = NULL;
+  wbot = NULL;
+  bandEnd = NULL;
+}
+
+RectifyMap::~RectifyMap()
+{
+  release();
+}
+
+void
+RectifyMap::release()
+{
+  MEMFREE(offset);
+  MEMFREE(wtop);
+  MEMFREE(wbot);
+  MEMFREE(bandEnd);
+  offset = NULL;
+  wtop = NULL;
+  wbot = NULL;
+  bandEnd = NULL;
+}
+
+
+//
+// quantize a source coordinate into the left/upper pixel and the
+//   interpolation step towards the next one, returns false if the
+//   pixel can't be interpolated inside the image
+//
+
+static bool
+quantize(float v, int size, int *i, int *f)
+{
+  const int one = 1 << INTERP_BITS;
+  if (!(v >= 0.0f && v <= (float)(size-1)))
+    return false;
+  int q = (int)(v*one + 0.5f);
+  *i = q >> INTERP_BITS;
+  *f = q & (one-1);
+  if (*i >= size-1)		// on the last pixel, interpolate from the one before
+    {
+      *i = size-2;
+      *f = one;
+    }
+  return true;
+}
+
+void
+RectifyMap::init(const float *mapx, const float *mapy, int w, int h)
+{
+  const int one = 1 << INTERP_BITS;
+
+  release();
+  width = w;
+  height = h;
+  offset = (int32_t *)MEMALIGN(w*h*sizeof(int32_t));
+  wtop = (int16_t *)MEMALIGN(2*w*h*sizeof(int16_t));
+  wbot = (int16_t *)MEMALIGN(2*w*h*sizeof(int16_t));
+  bandEnd = (int *)MEMALIGN(numBands()*sizeof(int));
+
+  // fill in tile order, the same order the remap functions use
+  int k = 0;
+  int rowEnd = h < 2 ? h : 2;	// unmapped pixels read the first two rows
+  for (int ty=0; ty<h; ty+=TILE_H)
+    {
+      int th = h-ty < TILE_H ? h-ty : TILE_H;
+      for (int tx=0; tx<w; tx+=TILE_W)
+	{
+	  int tw = w-tx < TILE_W ? w-tx : TILE_W;
+	  for (int y=ty; y<ty+th; y++)
+	    for (int x=tx; x<tx+tw; x++, k++)
+	      {
+		int ix, iy, fx, fy;
+		if (w < 2 || h < 2 ||
+		    !quantize(mapx[y*w+x], w, &ix, &fx) ||
+		    !quantize(mapy[y*w+x], h, &iy, &fy))
+		  {
+		    offset[k] = 0;
+		    wtop[2*k] = wtop[2*k+1] = 0;
+		    wbot[2*k] = wbot[2*k+1] = 0;
+		    continue;
+		  }
+		offset[k] = iy*w + ix;
+		wtop[2*k]   = (one-fx)*(one-fy);
+		wtop[2*k+1] = fx*(one-fy);
+		wbot[2*k]   = (one-fx)*fy;
+		wbot[2*k+1] = fx*fy;
+		if (iy+2 > rowEnd)
+		  rowEnd = iy+2;
+	      }
+	}
+      bandEnd[ty/TILE_H] = rowEnd;
+    }
+}
+
+
+//
+// remap functions
+// the SSE2 mono version does 8 output pixels at a time: the two neighbors
+//   in each source row are gathered as 16-bit pairs, unpacked to words,
+//   and multiplied with the weight pairs by pmaddwd
+// RGB stays scalar, the gather for three channels costs more than the
+//   multiplies it saves
+//
+
+#define ROUND (1 << (RectifyMap::WEIGHT_BITS-1))
+
+static inline int
+interp(const uint8_t *p, int stride, const int16_t *wt, const int16_t *wb)
+{
+  int v = p[0]*wt[0] + p[1]*wt[1] + p[stride]*wb[0] + p[stride+1]*wb[1];
+  return (v + ROUND) >> RectifyMap::WEIGHT_BITS;
+}
+
+#ifdef __SSE2__
+static inline __m128i
+interp8(__m128i top, __m128i bot, const int16_t *wt, const int16_t *wb)
+{
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi32(ROUND);
+  __m128i lo, hi;
+
+  // pixels 0-3
+  lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(top,zeros), _mm_loadu_si128((__m128i *)wt)),
+		     _mm_madd_epi16(_mm_unpacklo_epi8(bot,zeros), _mm_loadu_si128((__m128i *)wb)));
+  // pixels 4-7
+  hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(top,zeros), _mm_loadu_si128((__m128i *)(wt+8))),
+		     _mm_madd_epi16(_mm_unpackhi_epi8(bot,zeros), _mm_loadu_si128((__m128i *)(wb+8))));
+  lo = _mm_srai_epi32(_mm_add_epi32(lo,round), RectifyMap::WEIGHT_BITS);
+  hi = _mm_srai_epi32(_mm_add_epi32(hi,round), RectifyMap::WEIGHT_BITS);
+  lo = _mm_packs_epi32(lo,hi);
+  return _mm_packus_epi16(lo,lo); // 8 bytes in the low half
+}
+
+// gather neighbor pairs for 8 mono pixels; a pair is one unaligned
+//   16-bit load, inserted with pinsrw
+#define LOADPAIR(p) (*(const uint16_t *)(p))
+
+static inline void
+gather8(const uint8_t *src, const int32_t *off, int stride, __m128i *top, __m128i *bot)
+{
+  __m128i t = _mm_cvtsi32_si128(LOADPAIR(src+off[0]));
+  __m128i b = _mm_cvtsi32_si128(LOADPAIR(src+off[0]+stride));
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[1]), 1);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[1]+stride), 1);
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[2]), 2);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[2]+stride), 2);
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[3]), 3);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[3]+stride), 3);
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[4]), 4);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[4]+stride), 4);
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[5]), 5);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[5]+stride), 5);
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[6]), 6);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[6]+stride), 6);
+  t = _mm_insert_epi16(t, LOADPAIR(src+off[7]), 7);
+  b = _mm_insert_epi16(b, LOADPAIR(src+off[7]+stride), 7);
+  *top = t;
+  *bot = b;
+}
+#endif
+
+void
+RectifyMap::remapMono(const uint8_t *src, uint8_t *dest) const
+{
+  remapMono(src, dest, 0, numBands());
+}
+
+void
+RectifyMap::remapMono(const uint8_t *src, uint8_t *dest, int band0, int band1) const
+{
+  const int w = width;
+  const int yend = band1*TILE_H < height ? band1*TILE_H : height;
+  int k = band0*TILE_H*w;	// all bands but the last are full
+  for (int ty=band0*TILE_H; ty<yend; ty+=TILE_H)
+    for (int tx=0; tx<w; tx+=TILE_W)
+      {
+	int th = height-ty < TILE_H ? height-ty : TILE_H;
+	int tw = w-tx < TILE_W ? w-tx : TILE_W;
+	for (int y=ty; y<ty+th; y++)
+	  {
+	    uint8_t *d = dest + y*w + tx;
+	    int i = 0;
+#ifdef __SSE2__
+	    for (; i+8<=tw; i+=8, k+=8, d+=8)
+	      {
+		__m128i top, bot;
+		gather8(src, offset+k, w, &top, &bot);
+		_mm_storel_epi64((__m128i *)d, interp8(top, bot, wtop+2*k, wbot+2*k));
+	      }
+#endif
+	    for (; i<tw; i++, k++, d++)
+	      *d = interp(src + offset[k], w, wtop+2*k, wbot+2*k);
+	  }
+      }
+}
+
+void
+RectifyMap::remapRGB(const uint8_t *src, uint8_t *dest) const
+{
+  remapRGB(src, dest, 0, numBands());
+}
+
+void
+RectifyMap::remapRGB(const uint8_t *src, uint8_t *dest, int band0, int band1) const
+{
+  const int w = width;
+  const int yend = band1*TILE_H < height ? band1*TILE_H : height;
+  int k = band0*TILE_H*w;	// all bands but the last are full
+  for (int ty=band0*TILE_H; ty<yend; ty+=TILE_H)
+    for (int tx=0; tx<w; tx+=TILE_W)
+      {
+	int th = height-ty < TILE_H ? height-ty : TILE_H;
+	int tw = w-tx < TILE_W ? w-tx : TILE_W;
+	for (int y=ty; y<ty+th; y++)
+	  {
+	    uint8_t *d = dest + (y*w + tx)*3;
+	    for (int i=0; i<tw; i++, k++, d+=3)
+	      {
+		// weights are shared by the three channels
+		const uint8_t *p = src + offset[k]*3;
+		const int ul = wtop[2*k], ur = wtop[2*k+1];
+		const int ll = wbot[2*k], lr = wbot[2*k+1];
+		for (int c=0; c<3; c++, p++)
+		  d[c] = (p[0]*ul + p[3]*ur + p[3*w]*ll + p[3*w+3]*lr + ROUND) >> WEIGHT_BITS;
+	      }
+	  }
+      }
+}
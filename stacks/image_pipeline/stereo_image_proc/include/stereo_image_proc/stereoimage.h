@@ -37,6 +37,7 @@
 
 #include "image_proc/image.h"
 #include "stereo_image_proc/stereolib.h"
+#include <vector>
 
 // version of parameter files
 #define OST_MAJORVERSION 5
@@ -44,6 +45,8 @@
 
 namespace cam
 {
+  class BandWorkers;		// threads for multi-threaded disparity
+
   // stereo data structure
 
   class StereoData
@@ -144,6 +147,12 @@ namespace cam
     bool setCorrSize(int size);
     bool setUniqueCheck(bool val);
 
+    // multi-threaded disparity
+    // the normal algorithm is split into overlapping horizontal bands,
+    //   output is identical to the single-threaded version
+    int numThreads;		// number of threads for disparity, 1 is single-threaded
+    bool setNumThreads(int n);
+
     // buffers for stereo
     uint8_t *buf, *flim, *frim;
     int maxxim, maxyim, maxdlen, maxcorr; // for changing buffer sizes
@@ -153,6 +162,17 @@ namespace cam
     uint8_t *rbuf;
     uint32_t *lbuf, *wbuf;
 
+    // per-band buffers for multi-threaded disparity
+    std::vector<uint8_t *> bandBuf;
+    std::vector<int16_t *> bandDisp;
+    int bandBufSize, bandDispSize;
+    void releaseBandBuffers();
+    BandWorkers *bandWorkers;	// started on first use, kept between frames
+
+    // prefilter and disparity for NORMAL_ALGORITHM using numThreads threads
+    void doStereoBands(uint8_t *lim, uint8_t *rim, int ftzero, int corr, int dlen,
+		       int tthresh, int uthresh);
+
   };
 
 
@@ -138,6 +138,9 @@ public:
     int num_disp;
     if (nh_.getParam("~num_disp", num_disp))
       stdata_->setNumDisp(num_disp);
+    int num_threads;
+    if (nh_.getParam("~num_threads", num_threads))
+      stdata_->setNumThreads(num_threads);
 
 
     // resolve names, advertise and subscribe
@@ -144,6 +144,10 @@ public:
     if (getParam("~num_disp", num_disp))
       stdata_->setNumDisp(num_disp);
 
+    int num_threads;
+    if (getParam("~num_threads", num_threads))
+      stdata_->setNumThreads(num_threads);
+
     subscribe("raw_stereo", raw_stereo_, &StereoProc::rawCb, 1);
   }
 
@@ -42,9 +42,105 @@
 
 #include <sstream>
 #include <iostream>
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
 
 #define PRINTF(a...) printf(a)
 
+namespace cam
+{
+  // persistent worker threads
+  // on each run(), worker i runs job i, and the calling thread runs the
+  //   last job; run() returns when all the jobs are done
+  class BandWorkers
+  {
+  public:
+    BandWorkers(int n);		// n worker threads
+    ~BandWorkers();
+    int size() const { return nworkers; }
+    void run(const std::vector<boost::function<void ()> > &jobs); // at most size()+1 jobs
+
+  private:
+    void loop(int index);
+
+    int nworkers;
+    boost::thread_group threads;
+    boost::mutex lock;
+    boost::condition workAvailable, workDone;
+    const std::vector<boost::function<void ()> > *jobs;
+    int njobs;			// jobs for the workers in this round
+    int pending;		// worker jobs not done yet
+    unsigned int round;		// incremented on each run()
+    bool stop;
+  };
+
+  BandWorkers::BandWorkers(int n)
+    : nworkers(n), jobs(NULL), njobs(0), pending(0), round(0), stop(false)
+  {
+    for (int i=0; i<n; i++)
+      threads.create_thread(boost::bind(&BandWorkers::loop, this, i));
+  }
+
+  BandWorkers::~BandWorkers()
+  {
+    {
+      boost::mutex::scoped_lock l(lock);
+      stop = true;
+    }
+    workAvailable.notify_all();
+    threads.join_all();
+  }
+
+  void
+  BandWorkers::run(const std::vector<boost::function<void ()> > &j)
+  {
+    int n = j.size() - 1;
+    {
+      boost::mutex::scoped_lock l(lock);
+      jobs = &j;
+      njobs = n;
+      pending = n;
+      round++;
+    }
+    workAvailable.notify_all();
+
+    j[n]();			// last job on this thread
+
+    boost::mutex::scoped_lock l(lock);
+    while (pending > 0)
+      workDone.wait(l);
+  }
+
+  void
+  BandWorkers::loop(int index)
+  {
+    unsigned int seen = 0;
+    while (true)
+      {
+	const boost::function<void ()> *job;
+	{
+	  boost::mutex::scoped_lock l(lock);
+	  while (!stop && round == seen)
+	    workAvailable.wait(l);
+	  if (stop)
+	    return;
+	  seen = round;
+	  if (index >= njobs)
+	    continue;		// nothing for this thread this round
+	  job = &(*jobs)[index];
+	}
+
+	(*job)();
+
+	boost::mutex::scoped_lock l(lock);
+	if (--pending == 0)
+	  workDone.notify_one();
+      }
+  }
+}
+
 using namespace cam;
 
 // stereo class fns
@@ -64,6 +160,9 @@ StereoData::StereoData()
   rbuf = NULL;
   lbuf = NULL;
   maxyim = maxxim = maxdlen = maxcorr = 0;
+  numThreads = 1;
+  bandBufSize = bandDispSize = 0;
+  bandWorkers = NULL;
 
   // nominal values
   imWidth = 640;
@@ -106,6 +205,8 @@ StereoData::~StereoData()
   MEMFREE(buf);
   MEMFREE(flim);
   MEMFREE(frim);
+  delete bandWorkers;
+  releaseBandBuffers();
 }
 
 bool
@@ -170,6 +271,16 @@ StereoData::setCorrSize(int val)
 }
 
 
+bool
+StereoData::setNumThreads(int val)
+{
+  if (val < 1) val = 1;
+  if (val > 16) val = 16;
+  numThreads = val;
+  return true;
+}
+
+
 bool
 StereoData::setRangeMax(double val)
 {
@@ -319,20 +430,38 @@ StereoData::doDisparity(stereo_algorithm_t alg)
 
   // allocate buffers
   // TODO: make these consistent with current values
+  // do_stereo_d_fast clears up to 8 rows past the end of its output
   if (!imDisp)
-    imDisp = (int16_t *)MEMALIGN(xim*yim*2);
+    imDisp = (int16_t *)MEMALIGN(xim*(yim+8)*2);
 
   if (!buf || yim*dlen*(corr+5) > maxyim*maxdlen*(maxcorr+5))
     buf  = (uint8_t *)MEMALIGN(yim*2*dlen*(corr+5)); // local storage for the algorithm
+  // the prefilter doesn't write the first rows of the feature images,
+  //   which do_stereo reads, so they start out cleared
   if (!flim || xim*yim > maxxim*maxyim)
-    flim = (uint8_t *)MEMALIGN(xim*yim); // feature image
+    {
+      flim = (uint8_t *)MEMALIGN(xim*yim); // feature image
+      memset(flim, 0, xim*yim);
+    }
   if (!frim || xim*yim > maxxim*maxyim)
-    frim = (uint8_t *)MEMALIGN(xim*yim); // feature image
+    {
+      frim = (uint8_t *)MEMALIGN(xim*yim); // feature image
+      memset(frim, 0, xim*yim);
+    }
   if (xim > maxxim) maxxim = xim;
   if (yim > maxyim) maxyim = yim;
   if (dlen > maxdlen) maxdlen = dlen;
   if (corr > maxcorr) maxcorr = corr;
 
+  // multi-threaded version of the normal algorithm
+  if (alg == NORMAL_ALGORITHM && numThreads > 1)
+    {
+      doStereoBands(lim, rim, ftzero, corr, dlen, tthresh, uthresh);
+      hasDisparity = true;
+      doSpeckle();		// on the whole image, so regions can cross band seams
+      return true;
+    }
+
   // prefilter
   do_prefilter(lim, flim, xim, yim, ftzero, buf);
   do_prefilter(rim, frim, xim, yim, ftzero, buf);
@@ -382,6 +511,137 @@ StereoData::doDisparity(stereo_algorithm_t alg)
 
 
 
+//
+// multi-threaded stereo
+// each band of output rows is computed by do_stereo on the rows it owns
+//   plus a margin above and below, covering the correlation and prefilter
+//   windows and the 8-row blocks do_stereo_d_fast extracts disparities in.
+// results go into a separate buffer per band, and only the owned rows
+//   are copied to imDisp, so the output is identical to a single call
+// the threads are started once and wait for work between frames,
+//   see BandWorkers
+//
+
+namespace
+{
+  struct PrefilterTask
+  {
+    uint8_t *im, *ftim, *buf;
+    int xim, yim, ftzero;
+    void operator()() const
+    {
+      do_prefilter(im, ftim, xim, yim, ftzero, buf);
+    }
+  };
+
+  struct StereoBandTask
+  {
+    uint8_t *flim, *frim, *buf;
+    int16_t *disp, *bdisp;
+    int xim, ftzero, corr, dlen, tthresh, uthresh;
+    int top, bottom;		// rows processed
+    int first, last;		// rows owned by this band
+    void operator()() const
+    {
+      int yim = bottom - top;
+      memset(bdisp, 0, xim*yim*sizeof(int16_t));
+      do_stereo(flim + top*xim, frim + top*xim, bdisp, NULL, xim, yim,
+		ftzero, corr, corr, dlen, tthresh, uthresh, buf);
+      memcpy(disp + first*xim, bdisp + (first-top)*xim, (last-first)*xim*sizeof(int16_t));
+    }
+  };
+}
+
+void
+StereoData::releaseBandBuffers()
+{
+  for (size_t i=0; i<bandBuf.size(); i++)
+    {
+      MEMFREE(bandBuf[i]);
+      MEMFREE(bandDisp[i]);
+    }
+  bandBuf.clear();
+  bandDisp.clear();
+  bandBufSize = bandDispSize = 0;
+}
+
+void
+StereoData::doStereoBands(uint8_t *lim, uint8_t *rim, int ftzero, int corr, int dlen,
+			  int tthresh, int uthresh)
+{
+  int xim = imWidth;
+  int yim = imHeight;
+
+  // rows needed above and below a band for its output to be exact
+  int margin = (corr + YKERN)/2 + 8;
+
+  // don't make the bands much smaller than their margins
+  int nbands = numThreads;
+  if (nbands > yim/(2*margin))
+    nbands = yim/(2*margin);
+  if (nbands < 1)
+    nbands = 1;
+
+  // band buffers, sized for the largest band
+  // do_stereo_d_fast can write up to 8 rows past the end of its output
+  int maxrows = (yim + nbands - 1)/nbands + 2*margin;
+  int bsize = maxrows*2*dlen*(corr+5);
+  int dsize = (maxrows+8)*xim*sizeof(int16_t);
+  if ((int)bandBuf.size() < nbands || bsize > bandBufSize || dsize > bandDispSize)
+    {
+      releaseBandBuffers();
+      bandBufSize = bsize;
+      bandDispSize = dsize;
+      for (int i=0; i<nbands; i++)
+	{
+	  bandBuf.push_back((uint8_t *)MEMALIGN(bandBufSize));
+	  bandDisp.push_back((int16_t *)MEMALIGN(bandDispSize));
+	}
+    }
+
+  // worker threads, at least one for the prefilter
+  int nworkers = nbands > 2 ? nbands-1 : 1;
+  if (!bandWorkers || bandWorkers->size() < nworkers)
+    {
+      delete bandWorkers;
+      bandWorkers = new BandWorkers(nworkers);
+    }
+
+  // prefilter, left and right in parallel
+  std::vector<boost::function<void ()> > jobs(2);
+  PrefilterTask lpre = { lim, flim, bandBuf[0], xim, yim, ftzero };
+  PrefilterTask rpre = { rim, frim, buf, xim, yim, ftzero };
+  jobs[0] = lpre;
+  jobs[1] = rpre;
+  bandWorkers->run(jobs);
+
+  // disparity bands; rows not owned by any band stay zero, as in do_stereo
+  memset(imDisp, 0, xim*yim*sizeof(int16_t));
+  jobs.resize(nbands);
+  for (int i=0; i<nbands; i++)
+    {
+      StereoBandTask task;
+      task.flim = flim;
+      task.frim = frim;
+      task.buf = bandBuf[i];
+      task.disp = imDisp;
+      task.bdisp = bandDisp[i];
+      task.xim = xim;
+      task.ftzero = ftzero;
+      task.corr = corr;
+      task.dlen = dlen;
+      task.tthresh = tthresh;
+      task.uthresh = uthresh;
+      task.first = (i*yim)/nbands;
+      task.last = ((i+1)*yim)/nbands;
+      task.top = i == 0 ? 0 : task.first - margin;
+      task.bottom = i == nbands-1 ? yim : task.last + margin;
+      jobs[i] = task;
+    }
+  bandWorkers->run(jobs);	// last band on this thread
+}
+
+
 //
 // apply speckle filter
 // useful for STOC processing, where it's not done on-camera
@@ -1081,696 +1341,3 @@ StereoData::createParams(bool store)
 
   return str;
 }
-
-
-
-//
-// color processing
-// two algorithms: linear interpolation, and edge-tracking interpolation
-//
-
-// convert from Bayer to RGB (3 bytes)
-
-#define AVG(a,b) (((int)(a) + (int)(b))>>1)
-
-void
-ImageData::doBayerColorRGB()
-{
-  if (imRawType == COLOR_CODING_NONE)
-  {
-    return;		// nothing to colorize
-  }
-
-  if (imColorType != COLOR_CODING_NONE)
-  {
-    return;		// already done
-  }
-
-  // check allocation
-  size_t size = imWidth*imHeight;
-  if (imSize < size)
-    {
-      MEMFREE(im);
-      im = (uint8_t *)MEMALIGN(size);
-      imSize = size;
-    }
-  if (imColorSize < size*3)
-    {
-      MEMFREE(imColor);
-      imColor = (uint8_t *)MEMALIGN(size*3);
-      imColorSize = size*3;
-    }
-  switch (imRawType) {
-    case COLOR_CODING_MONO8:
-      memcpy(im, imRaw, size);
-      imType = COLOR_CODING_MONO8;
-      return;
-    case COLOR_CODING_BAYER8_GRBG:
-      convertBayerGRBGColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType);
-      break;
-    case COLOR_CODING_BAYER8_BGGR:
-      convertBayerBGGRColorRGB(imRaw, imColor, im, imWidth, imHeight, colorConvertType);
-      break;
-      
-    default:
-      PRINTF("Unsupported color coding %i", imRawType);
-      return;
-  }
-  imType = COLOR_CODING_MONO8;
-  imColorType = COLOR_CODING_RGB8;
-}
-
-
-void
-ImageData::doBayerMono()
-{
-
-  if (imRawType == COLOR_CODING_NONE)
-  {
-    return;		// nothing to colorize
-  }
-
-  if (imType != COLOR_CODING_NONE)
-  {
-    return;		// already done
-  }
-
-  // check allocation
-  size_t size = imWidth*imHeight;
-  if (imSize < size)
-    {
-      MEMFREE(im);
-      im = (uint8_t *)MEMALIGN(size);
-      imSize = size;
-    }
-  switch (imRawType) {
-    case COLOR_CODING_MONO8:
-      memcpy(im, imRaw, size);
-      break;
-    case COLOR_CODING_BAYER8_GRBG:
-      convertBayerGRBGMono(imRaw, im, imWidth, imHeight, colorConvertType);
-      break;
-    case COLOR_CODING_BAYER8_BGGR:
-      convertBayerBGGRMono(imRaw, im, imWidth, imHeight, colorConvertType);
-      break;
-      
-    default:
-      PRINTF("Unsupported color coding %i", imRawType);
-      return;
-  }
-  imType = COLOR_CODING_MONO8;
-}
-
-
-// real funtion to do the job
-// converts to RGB
-
-void
-ImageData::convertBayerGRBGColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
-				    int width, int height, color_conversion_t colorAlg)
-{
-  uint8_t *s;
-  int i, j;
-  int ll = width;
-  int ll2 = width*2;
-
-  s = src;
-  int pp2 = width*3*2;          // previous 2 color lines
-  int pp = width*3;             // previous color line
-  uint8_t *cd = dstc;		// color
-  uint8_t *md = dstm;		// monochrome
-
-  // simple, but has "zipper" artifacts
-  if (colorAlg == COLOR_CONVERSION_BILINEAR)
-    {
-      for (i=0; i<height; i+=2)
-	{
-	  // red line (GRGR...)
-	  for (j=0; j<width; j+=2, cd+=6, md+=2)
-	    {
-	      *md = *(cd+1) = *s++;	// green pixel
-	      *(cd+3+0) = *s++;	// red pixel
-	      *(cd+0) = AVG(*(cd+3+0), *(cd-3+0)); // interpolated red pixel
-	      if (i > 1)
-		{
-		  *(cd-pp+0) = AVG(*(cd-pp2+0), *(cd+0)); // interpolated red pixel
-		  *(cd-pp+3+0) = AVG(*(cd-pp2+3+0), *(cd+3+0)); // interpolated red pixel
-		  *(md-ll) = *(cd-pp+1) = ((int)*(cd+1) + (int)*(cd-pp-3+1) + (int)*(cd-pp+3+1) + (int)*(cd-pp2+1)) >> 2;
-		}
-	    }
-
-	  // blue line (BGBG...)
-	  *(cd+2) = *s;		// blue pixel
-	  for (j=0; j<width-2; j+=2, cd+=6, md+=2)
-	    {
-	      s++;
-	      *(md+1) = *(cd+3+1) = *s++; // green pixel
-	      *(cd+6+2) = *s;
-	      *(cd+3+2) = AVG(*(cd+2), *(cd+6+2)); // interpolated blue pixel
-	      if (i > 1)
-		{
-		  *(cd-pp+2) = AVG(*(cd-pp2+2), *(cd+2)); // interpolated blue pixel
-		  *(cd-pp+3+2) = AVG(*(cd-pp2+3+2), *(cd+3+2)); // interpolated blue pixel
-		  *(md-ll+1) = *(cd-pp+3+1) = ((int)*(cd+3+1) + (int)*(cd-pp+1) + (int)*(cd-pp+6+1) + (int)*(cd-pp2+3+1)) >> 2;
-		}
-	    }
-	  // last pixels
-	  s++;
-	  *(md+1) = *(cd+3+1) = *s++;      // green pixel
-	  *(cd+3+2) = *(cd+2);	// interpolated blue pixel
-	  if (i > 1)
-	    {
-	      *(cd-pp+2) = AVG(*(cd-pp2+2), *(cd+2)); // interpolated blue pixel
-	      *(cd-pp+3+2) = AVG(*(cd-pp2+3+2), *(cd+3+2)); // interpolated blue pixel
-	    }
-	  cd +=6;
-	  md +=2;
-	}
-    }
-
-  // EDGE color algorithm, better but slower
-  else
-    {
-      int a,b,c,d;
-      int dc, dv, dh;
-      int ww;
-
-      // do first two lines
-      cd += pp2;
-      s += ll2;
-
-      for (i=0; i<height-4; i+=2)
-	{
-	  // GR line
-	  // do first two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, cd+=6, md+=2)
-	    {
-	      // green pixels
-	      *md = *(cd+1) = *s++;
-	      dc = 2*(int)*(s);
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dv > dh) // vert is stronger, use horz
-		*(md+1) = *(cd+3+1) = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*(md+1) = *(cd+3+1) = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      // color pixels
-	      *(cd+3+0) = *s;	// red pixel
-
-	      a = (int)*(s) - (int)*(cd+3+1);
-	      b = (int)*(s-2) - (int)*(cd-3+1);
-	      c = (int)*(s-ll2) - (int)*(cd-pp2+3+1);
-	      d = (int)*(s-ll2-2) - (int)*(cd-pp2-3+1);
-
-	      ww = 2*(int)*(cd+1) + (a + b);
-	      if (ww < 0) ww = 0;
-	      *(cd+0) = ww>>1;	// interpolated red pixel
-
-	      ww = 2*(int)*(cd-pp+3+1) + (a + c);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+3+0) = ww>>1; // interpolated red pixel
-
-	      ww = 4*(int)*(cd-pp+1) + (a + b + c + d);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+0) = ww>>2; // interpolated red pixel
-
-	      s++;
-	    }
-	  // last two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-
-	  // BG line
-	  // do first two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, cd+=6, md+=2)
-	    {
-	      dc = 2*(int)*s;
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dh < dv) // vert is stronger, use horz
-		*md = *(cd+1) = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*md = *(cd+1) = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      *(md+1) = *(cd+3+1) = *(s+1); // green pixel
-
-	      // color pixels
-	      *(cd+3+2) = *s;	// blue pixel
-
-	      a = (int)*(s) - (int)*(cd+3+1);
-	      b = (int)*(s-2) - (int)*(cd-3+1);
-	      c = (int)*(s-ll2) - (int)*(cd-pp2+3+1);
-	      d = (int)*(s-ll2-2) - (int)*(cd-pp2-3+1);
-
-	      ww = 2*(int)*(cd+1) + (a + b);
-	      if (ww < 0) ww = 0;
-	      *(cd+2) = ww>>1;	// interpolated blue pixel
-
-	      ww = 2*(int)*(cd-pp+3+1) + (a + c);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+3+2) = ww>>1; // interpolated blue pixel
-
-	      ww = 4*(int)*(cd-pp+1) + (a + b + c + d);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+2) = ww>>2; // interpolated blue pixel
-
-	      s+=2;
-	    }
-	  // last two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-	}
-
-      // last two lines
-      for (j=0; j<width; j+=2)
-	{
-	}
-    }
-
-}
-
-void
-ImageData::convertBayerBGGRColorRGB(uint8_t *src, uint8_t *dstc, uint8_t *dstm,
-				    int width, int height, color_conversion_t colorAlg)
-{
-  uint8_t *s;
-  int i, j;
-  int ll = width;
-  int ll2 = width*2;
-
-  s = src;
-  int pp2 = width*3*2;          // previous 2 color lines
-  int pp = width*3;             // previous color line
-  uint8_t *cd = dstc;		// color
-  uint8_t *md = dstm;		// monochrome
-
-  // simple, but has "zipper" artifacts
-  if (colorAlg == COLOR_CONVERSION_BILINEAR)
-    {
-      for (i=0; i<height; i+=2)
-	{
-          // blue line (BGBG...)
-	  *(cd+2) = *s;		// blue pixel
-	  for (j=0; j<width-2; j+=2, cd+=6, md+=2)
-	    {
-	      s++;
-	      *(md+1) = *(cd+3+1) = *s++; // green pixel
-	      *(cd+6+2) = *s;
-	      *(cd+3+2) = AVG(*(cd+2), *(cd+6+2)); // interpolated blue pixel
-	      if (i > 1)
-		{
-		  *(cd-pp+2) = AVG(*(cd-pp2+2), *(cd+2)); // interpolated blue pixel
-		  *(cd-pp+3+2) = AVG(*(cd-pp2+3+2), *(cd+3+2)); // interpolated blue pixel
-		  *(md-ll+1) = *(cd-pp+3+1) = ((int)*(cd+3+1) + (int)*(cd-pp+1) + (int)*(cd-pp+6+1) + (int)*(cd-pp2+3+1)) >> 2;
-		}
-	    }
-	  // last pixels
-	  s++;
-	  *(md+1) = *(cd+3+1) = *s++;      // green pixel
-	  *(cd+3+2) = *(cd+2);	// interpolated blue pixel
-	  if (i > 1)
-	    {
-	      *(cd-pp+2) = AVG(*(cd-pp2+2), *(cd+2)); // interpolated blue pixel
-	      *(cd-pp+3+2) = AVG(*(cd-pp2+3+2), *(cd+3+2)); // interpolated blue pixel
-	    }
-	  cd +=6;
-	  md +=2;
-          
-	  // red line (GRGR...)
-	  for (j=0; j<width; j+=2, cd+=6, md+=2)
-	    {
-	      *md = *(cd+1) = *s++;	// green pixel
-	      *(cd+3+0) = *s++;	// red pixel
-	      *(cd+0) = AVG(*(cd+3+0), *(cd-3+0)); // interpolated red pixel
-	      if (i > 1)
-		{
-		  *(cd-pp+0) = AVG(*(cd-pp2+0), *(cd+0)); // interpolated red pixel
-		  *(cd-pp+3+0) = AVG(*(cd-pp2+3+0), *(cd+3+0)); // interpolated red pixel
-		  *(md-ll) = *(cd-pp+1) = ((int)*(cd+1) + (int)*(cd-pp-3+1) + (int)*(cd-pp+3+1) + (int)*(cd-pp2+1)) >> 2;
-		}
-	    }
-	}
-    }
-
-  // EDGE color algorithm, better but slower
-  else
-    {
-      int a,b,c,d;
-      int dc, dv, dh;
-      int ww;
-
-      // do first two lines
-      cd += pp2;
-      s += ll2;
-
-      for (i=0; i<height-4; i+=2)
-	{
-          // BG line
-	  // do first two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, cd+=6, md+=2)
-	    {
-	      dc = 2*(int)*s;
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dh < dv) // vert is stronger, use horz
-		*md = *(cd+1) = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*md = *(cd+1) = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      *(md+1) = *(cd+3+1) = *(s+1); // green pixel
-
-	      // color pixels
-	      *(cd+3+2) = *s;	// blue pixel
-
-	      a = (int)*(s) - (int)*(cd+3+1);
-	      b = (int)*(s-2) - (int)*(cd-3+1);
-	      c = (int)*(s-ll2) - (int)*(cd-pp2+3+1);
-	      d = (int)*(s-ll2-2) - (int)*(cd-pp2-3+1);
-
-	      ww = 2*(int)*(cd+1) + (a + b);
-	      if (ww < 0) ww = 0;
-	      *(cd+2) = ww>>1;	// interpolated blue pixel
-
-	      ww = 2*(int)*(cd-pp+3+1) + (a + c);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+3+2) = ww>>1; // interpolated blue pixel
-
-	      ww = 4*(int)*(cd-pp+1) + (a + b + c + d);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+2) = ww>>2; // interpolated blue pixel
-
-	      s+=2;
-	    }
-	  // last two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-          
-	  // GR line
-	  // do first two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, cd+=6, md+=2)
-	    {
-	      // green pixels
-	      *md = *(cd+1) = *s++;
-	      dc = 2*(int)*(s);
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dv > dh) // vert is stronger, use horz
-		*(md+1) = *(cd+3+1) = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*(md+1) = *(cd+3+1) = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      // color pixels
-	      *(cd+3+0) = *s;	// red pixel
-
-	      a = (int)*(s) - (int)*(cd+3+1);
-	      b = (int)*(s-2) - (int)*(cd-3+1);
-	      c = (int)*(s-ll2) - (int)*(cd-pp2+3+1);
-	      d = (int)*(s-ll2-2) - (int)*(cd-pp2-3+1);
-
-	      ww = 2*(int)*(cd+1) + (a + b);
-	      if (ww < 0) ww = 0;
-	      *(cd+0) = ww>>1;	// interpolated red pixel
-
-	      ww = 2*(int)*(cd-pp+3+1) + (a + c);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+3+0) = ww>>1; // interpolated red pixel
-
-	      ww = 4*(int)*(cd-pp+1) + (a + b + c + d);
-	      if (ww < 0) ww = 0;
-	      *(cd-pp+0) = ww>>2; // interpolated red pixel
-
-	      s++;
-	    }
-	  // last two pixels
-	  cd += 6;
-	  md += 2;
-	  s += 2;
-	}
-
-      // last two lines
-      for (j=0; j<width; j+=2)
-	{
-	}
-    }
-
-}
-
-
-// real function to do the job
-// converts to monochrome
-
-void
-ImageData::convertBayerGRBGMono(uint8_t *src, uint8_t *dstm,
-				int width, int height, color_conversion_t colorAlg)
-{
-  uint8_t *s;
-  int i, j;
-  int ll = width;
-  int ll2 = width*2;
-
-  s = src;
-  uint8_t *md = dstm;		// monochrome
-
-  // simple, but has "zipper" artifacts
-  if (colorAlg == COLOR_CONVERSION_BILINEAR)
-    {
-      for (i=0; i<height; i+=2)
-	{
-	  // red line (GRGR...)
-	  for (j=0; j<width; j+=2, md+=2)
-	    {
-	      *md = *s++;	// green pixel
-	      s++;	// red pixel
-	      if (i > 1)
-		*(md-ll) = ((int)*(md) + (int)*(md-ll-1) + (int)*(md-ll+1) + (int)*(md-ll2)) >> 2;
-	    }
-
-	  // blue line (BGBG...)
-	  for (j=0; j<width-2; j+=2, md+=2)
-	    {
-	      s++;
-	      *(md+1) = *s++; // green pixel
-	      if (i > 1)
-		*(md-ll+1) = ((int)*(md+1) + (int)*(md-ll) + (int)*(md-ll+2) + (int)*(md-ll2+1)) >> 2;
-	    }
-	  // last pixels
-	  s++;
-	  *(md+1) = *s++;	// green pixel
-	  md +=2;
-	}
-    }
-
-  // EDGE color algorithm, better but slower
-  else
-    {
-      int dc, dv, dh;
-
-      // do first two lines
-      s += ll2;
-
-      for (i=0; i<height-4; i+=2)
-	{
-	  // GR line
-	  // do first two pixels
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, md+=2)
-	    {
-	      // green pixels
-	      *md = *s++;
-	      dc = 2*(int)*(s);
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dv > dh) // vert is stronger, use horz
-		*(md+1) = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*(md+1) = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      s++;
-	    }
-	  // last two pixels
-	  md += 2;
-	  s += 2;
-
-	  // BG line
-	  // do first two pixels
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, md+=2)
-	    {
-	      dc = 2*(int)*s;
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dh < dv) // vert is stronger, use horz
-		*md = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*md = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      *(md+1) = *(s+1); // green pixel
-
-	      s+=2;
-	    }
-	  // last two pixels
-	  md += 2;
-	  s += 2;
-	}
-
-      // last two lines
-      for (j=0; j<width; j+=2)
-	{
-	}
-    }
-
-}
-
-void
-ImageData::convertBayerBGGRMono(uint8_t *src, uint8_t *dstm,
-				int width, int height, color_conversion_t colorAlg)
-{
-  uint8_t *s;
-  int i, j;
-  int ll = width;
-  int ll2 = width*2;
-
-  s = src;
-  uint8_t *md = dstm;		// monochrome
-
-  // simple, but has "zipper" artifacts
-  if (colorAlg == COLOR_CONVERSION_BILINEAR)
-    {
-      for (i=0; i<height; i+=2)
-	{
-          // blue line (BGBG...)
-	  for (j=0; j<width-2; j+=2, md+=2)
-	    {
-	      s++;
-	      *(md+1) = *s++; // green pixel
-	      if (i > 1)
-		*(md-ll+1) = ((int)*(md+1) + (int)*(md-ll) + (int)*(md-ll+2) + (int)*(md-ll2+1)) >> 2;
-	    }
-	  // last pixels
-	  s++;
-	  *(md+1) = *s++;	// green pixel
-	  md +=2;
-          
-	  // red line (GRGR...)
-	  for (j=0; j<width; j+=2, md+=2)
-	    {
-	      *md = *s++;	// green pixel
-	      s++;	// red pixel
-	      if (i > 1)
-		*(md-ll) = ((int)*(md) + (int)*(md-ll-1) + (int)*(md-ll+1) + (int)*(md-ll2)) >> 2;
-	    }
-	}
-    }
-
-  // EDGE color algorithm, better but slower
-  else
-    {
-      int dc, dv, dh;
-
-      // do first two lines
-      s += ll2;
-
-      for (i=0; i<height-4; i+=2)
-	{
-          // BG line
-	  // do first two pixels
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, md+=2)
-	    {
-	      dc = 2*(int)*s;
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dh < dv) // vert is stronger, use horz
-		*md = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*md = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      *(md+1) = *(s+1); // green pixel
-
-	      s+=2;
-	    }
-	  // last two pixels
-	  md += 2;
-	  s += 2;
-          
-	  // GR line
-	  // do first two pixels
-	  md += 2;
-	  s += 2;
-
-	  // do most of line
-	  for (j=0; j<width-4; j+=2, md+=2)
-	    {
-	      // green pixels
-	      *md = *s++;
-	      dc = 2*(int)*(s);
-	      dh = dc - (int)*(s-2) - (int)*(s+2);
-	      if (dh < 0) dh = -dh;
-	      dv = dc - (int)*(s-ll2) - (int)*(s+ll2);
-	      if (dv < 0) dv = -dv;
-	      if (dv > dh) // vert is stronger, use horz
-		*(md+1) = ((int)*(s-1) + (int)*(s+1))>>1;
-	      else	// horz is stronger, use vert
-		*(md+1) = ((int)*(s-ll) + (int)*(s+ll))>>1;
-
-	      s++;
-	    }
-	  // last two pixels
-	  md += 2;
-	  s += 2;
-	}
-
-      // last two lines
-      for (j=0; j<width; j+=2)
-	{
-	}
-    }
-
-}
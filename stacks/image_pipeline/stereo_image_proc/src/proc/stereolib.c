@@ -964,7 +964,7 @@ do_stereo_d_fast(uint8_t *lim, uint8_t *rim, // input feature images
 
   // set up buffers, first align to 16 bytes
   uintptr_t bufp = (uintptr_t)buf;
-  int16_t *intbuf, *textbuf, *accbuf, temp;
+  int16_t *intbuf, *textbuf, *accbuf, *tintbuf, temp;
   int8_t *corrbuf;
 
   if (bufp & 0xF)
@@ -1000,11 +1000,20 @@ do_stereo_d_fast(uint8_t *lim, uint8_t *rim, // input feature images
     bufp = (bufp+15) & ~(uintptr_t)0xF;
   corrbuf = (int8_t *)bufp;  
 
+  // integration buffer for the texture pass, separate from intbuf so the
+  // first ywin rows of intbuf stay zero for the correlation pass
+  tintbuf = (int16_t *)&corrbuf[dlen*yim*xwin];
+  bufp = (uintptr_t)tintbuf;
+  if (bufp & 0xF)
+    bufp = (bufp+15) & ~(uintptr_t)0xF;
+  tintbuf = (int16_t *)bufp;  
+
   // clear out buffers
   memclr_si128((__m128i *)intbuf, dlen*yim*sizeof(int16_t));
   memclr_si128((__m128i *)corrbuf, dlen*yim*xwin*sizeof(int8_t));
   memclr_si128((__m128i *)accbuf, dlen*yim*sizeof(int16_t));
-  memclr_si128((__m128i *)textbuf, yim*sizeof(int16_t));
+  memclr_si128((__m128i *)textbuf, (yim+8)*sizeof(int16_t)); // round up, memclr_si128 works in 8-word blocks
+  memclr_si128((__m128i *)tintbuf, (ywin+8)*sizeof(int16_t)); // only the first ywin-1 entries are read before being set
 
   // set up corrbuf pointers
   corrend = corrbuf + dlen*yim*xwin;
@@ -1121,11 +1130,10 @@ do_stereo_d_fast(uint8_t *lim, uint8_t *rim, // input feature images
 
       // average texture computation
       // use full corr window
-      memclr_si128((__m128i *)intbuf, yim*sizeof(int16_t));
       limpp = limp;
       limpp2 = limp2;
-      intp = intbuf+ywin-1;
-      intpp = intbuf;
+      intp = tintbuf+ywin-1;
+      intpp = tintbuf;
       accpp = textbuf;
       acc = 0;
 	  
@@ -1562,18 +1570,67 @@ do_rectify_mono(uint8_t *dest, uint8_t *src, int w, int h, inttab_t *rtab)
     }
 }
 
-// SSE version, TBD
+// SSE2 version, 8 pixels at a time
+// the two neighbors in each source row are gathered as 16-bit pairs with
+//   pinsrw, interleaved top/bottom so that each pixel lines up with its
+//   (a1,a2,b1,b2) coefficients in the table; one pmaddwd then gives
+//   the top and bottom sums of two pixels
 void 
 do_rectify_mono_fast(uint8_t *dest, uint8_t *src, int w, int h, inttab_t *rtab)
 {
   int i,j;
   uint8_t *p;
   int val;
+  __m128i g0, g1, t0, t1, t2, t3, c0, c1, s0, s1, s2, s3;
+  const __m128i zeros = _mm_setzero_si128();
+
+// top and bottom pair of table entry k into words 2n and 2n+1
+#define PAIRS(g,k,n) \
+  p = src + rtab[k].addr; \
+  g = _mm_insert_epi16(g, p[0] | (p[1] << 8), 2*n); \
+  g = _mm_insert_epi16(g, p[w] | (p[w+1] << 8), 2*n+1)
+
   // loop over rows
   for (i=0; i<h; i++)
     {
-      // loop over cols
-      for (j=0; j<w; j++, dest++, rtab++)
+      // loop over cols, 8 at a time
+      for (j=0; j+8<=w; j+=8, dest+=8, rtab+=8)
+	{
+	  g0 = g1 = zeros;
+	  PAIRS(g0,0,0); PAIRS(g0,1,1); PAIRS(g0,2,2); PAIRS(g0,3,3);
+	  PAIRS(g1,4,0); PAIRS(g1,5,1); PAIRS(g1,6,2); PAIRS(g1,7,3);
+
+	  // coefficients are the odd dwords of the table entries
+	  t0 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)rtab), _MM_SHUFFLE(3,1,3,1));
+	  t1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)(rtab+2)), _MM_SHUFFLE(3,1,3,1));
+	  t2 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)(rtab+4)), _MM_SHUFFLE(3,1,3,1));
+	  t3 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)(rtab+6)), _MM_SHUFFLE(3,1,3,1));
+	  c0 = _mm_unpacklo_epi64(t0, t1); // pixels 0-3
+	  c1 = _mm_unpacklo_epi64(t2, t3); // pixels 4-7
+
+	  // top and bottom sums, two pixels per register
+	  s0 = _mm_madd_epi16(_mm_unpacklo_epi8(g0,zeros), _mm_unpacklo_epi8(c0,zeros));
+	  s1 = _mm_madd_epi16(_mm_unpackhi_epi8(g0,zeros), _mm_unpackhi_epi8(c0,zeros));
+	  s2 = _mm_madd_epi16(_mm_unpacklo_epi8(g1,zeros), _mm_unpacklo_epi8(c1,zeros));
+	  s3 = _mm_madd_epi16(_mm_unpackhi_epi8(g1,zeros), _mm_unpackhi_epi8(c1,zeros));
+
+	  // (t0,b0,t1,b1) -> (t0,t1,b0,b1), then add tops and bottoms
+	  s0 = _mm_shuffle_epi32(s0, _MM_SHUFFLE(3,1,2,0));
+	  s1 = _mm_shuffle_epi32(s1, _MM_SHUFFLE(3,1,2,0));
+	  s2 = _mm_shuffle_epi32(s2, _MM_SHUFFLE(3,1,2,0));
+	  s3 = _mm_shuffle_epi32(s3, _MM_SHUFFLE(3,1,2,0));
+	  s0 = _mm_add_epi32(_mm_unpacklo_epi64(s0,s1), _mm_unpackhi_epi64(s0,s1));
+	  s2 = _mm_add_epi32(_mm_unpacklo_epi64(s2,s3), _mm_unpackhi_epi64(s2,s3));
+
+	  s0 = _mm_srli_epi32(s0, INTOFFSET); // get rid of fractional offset
+	  s2 = _mm_srli_epi32(s2, INTOFFSET);
+	  s0 = _mm_packs_epi32(s0, s2);
+	  s0 = _mm_packus_epi16(s0, s0);
+	  _mm_storel_epi64((__m128i *)dest, s0);
+	}
+
+      // rest of the row
+      for (; j<w; j++, dest++, rtab++)
 	{
 	  p = src + rtab->addr; // upper left pixel
 	  val = (*p)*rtab->a1 + (*(p+1))*rtab->a2 + (*(p+w))*rtab->b1 + (*(p+w+1))*rtab->b2;
@@ -1581,3 +1638,4 @@ do_rectify_mono_fast(uint8_t *dest, uint8_t *src, int w, int h, inttab_t *rtab)
 	}
     }
 }
+#undef PAIRS
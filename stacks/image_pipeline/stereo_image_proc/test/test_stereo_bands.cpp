@@ -0,0 +1,134 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+//
+// test_stereo_bands.cpp
+// multi-threaded disparity must give the same output as the
+//   single-threaded version
+//
+
+#include <gtest/gtest.h>
+#include "stereo_image_proc/stereoimage.h"
+
+using namespace cam;
+
+// textured left image, right image shifted by a disparity that
+//   changes across the image
+static void
+makeImages(int xim, int yim, uint8_t *left, uint8_t *right)
+{
+  srand(1);
+  for (int y=0; y<yim; y++)
+    for (int x=0; x<xim; x++)
+      left[y*xim+x] = (x*7 + y*13 + rand()%60 + ((x/20 + y/20)%2)*80) & 0xff;
+  for (int y=0; y<yim; y++)
+    for (int x=0; x<xim; x++)
+      {
+	int d = 10 + (y*40)/yim + (x > 300 && x < 400 ? 30 : 0);
+	right[y*xim+x] = x+d < xim ? left[y*xim+x+d] : 0;
+      }
+}
+
+// sets the images as already rectified
+static void
+setImages(StereoData &sd, int xim, int yim, const uint8_t *left, const uint8_t *right)
+{
+  sd.setSize(xim, yim);
+  ImageData *im[2] = { sd.imLeft, sd.imRight };
+  const uint8_t *src[2] = { left, right };
+  for (int i=0; i<2; i++)
+    {
+      if (!im[i]->imRect)
+	{
+	  // an extra row, the prefilter reads past the end of the image
+	  im[i]->imRectSize = xim*(yim+1);
+	  im[i]->imRect = (uint8_t *)MEMALIGN(im[i]->imRectSize);
+	  memset(im[i]->imRect, 0, im[i]->imRectSize);
+	}
+      memcpy(im[i]->imRect, src[i], xim*yim);
+      im[i]->imRectType = COLOR_CODING_MONO8;
+    }
+  sd.hasDisparity = false;
+}
+
+TEST(StereoBands, SameAsSingleThreaded)
+{
+  const int xim = 640;
+  const int heights[] = { 480, 471, 240 };
+  const int corrs[] = { 5, 11, 15, 23 };
+  const int ndisps[] = { 16, 32, 64, 128 };
+  const int threads[] = { 2, 3, 4, 7 };
+
+  uint8_t *left = (uint8_t *)malloc(xim*480);
+  uint8_t *right = (uint8_t *)malloc(xim*480);
+
+  for (int h=0; h<3; h++)
+    {
+      int yim = heights[h];
+      makeImages(xim, yim, left, right);
+      for (int c=0; c<4; c++)
+	for (int n=0; n<4; n++)
+	  {
+	    StereoData single;
+	    single.setCorrSize(corrs[c]);
+	    single.setNumDisp(ndisps[n]);
+	    setImages(single, xim, yim, left, right);
+	    ASSERT_TRUE(single.doDisparity());
+
+	    // the banded version twice, so leftover buffer contents would show
+	    StereoData banded;
+	    banded.setCorrSize(corrs[c]);
+	    banded.setNumDisp(ndisps[n]);
+	    for (int t=0; t<4; t++)
+	      for (int rep=0; rep<2; rep++)
+		{
+		  banded.setNumThreads(threads[t]);
+		  setImages(banded, xim, yim, left, right);
+		  ASSERT_TRUE(banded.doDisparity());
+		  EXPECT_EQ(0, memcmp(single.imDisp, banded.imDisp, xim*yim*sizeof(int16_t)))
+		    << "height " << yim << " corr " << corrs[c] << " disparities " << ndisps[n]
+		    << " threads " << threads[t];
+		}
+	  }
+    }
+
+  free(left);
+  free(right);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
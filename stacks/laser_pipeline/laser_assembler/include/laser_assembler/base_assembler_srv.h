@@ -40,11 +40,15 @@
 #include "sensor_msgs/PointCloud.h"
 
 #include <deque>
+#include <vector>
+#include <algorithm>
 
 // Service
 #include "laser_assembler/AssembleScans.h"
 
 #include "boost/thread.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/cstdint.hpp"
 #include "math.h"
 
 namespace laser_assembler
@@ -62,6 +66,10 @@ namespace laser_assembler
  *  - \b "~max_scans" (unsigned int) - The number of scans to store in the assembler's history, until they're thrown away
  *  - \b "~fixed_frame" (string) - The frame to which received data should immeadiately be transformed to
  *  - \b "~downsampling_factor" (int) - Specifies how often to sample from a scan. 1 preserves all the data. 3 keeps only 1/3 of the points.
+ *  - \b "~voxel_size" (double) - If positive, the assembled cloud is downsampled so that it contains at most one point per cubic
+ *                                 voxel of this edge length (in meters). 0 disables voxel downsampling (default).
+ *                                 Voxels reach 2^20 edge lengths out from the fixed frame's origin. Points beyond that share
+ *                                 the outermost voxels.
  *
  *  @section services ROS Service Calls
  *  - \b "~build_cloud" (AssembleScans.srv) - Accumulates scans between begin time and
@@ -112,10 +120,30 @@ private:
   //! \brief Service Callback function called whenever we need to build a cloud
   bool buildCloud(AssembleScans::Request& req, AssembleScans::Response& resp) ;
 
+  //! \brief Converted scans are immutable once they are in the history, so they can be shared with buildCloud without copying
+  typedef boost::shared_ptr<const sensor_msgs::PointCloud> CloudConstPtr ;
+
+  //! \brief Orders scans in the history by their timestamp
+  static bool stampLessThan(const CloudConstPtr& cloud, const ros::Time& stamp) ;
+  static bool cloudLessThan(const CloudConstPtr& a, const CloudConstPtr& b) ;
+
+  /** \brief Reduces cloud_in to at most one point per voxel of edge length voxel_size_
+   * The first point that falls into a voxel (in cloud order) is the one that is kept, along with all its channel values
+   */
+  void voxelDownsample(const sensor_msgs::PointCloud& cloud_in, sensor_msgs::PointCloud& cloud_out) const ;
+
+  /** \brief Voxel index, offset to [0, 2^21), of a coordinate in voxel units
+   * Coordinates more than 2^20 voxels from the origin are clamped to the outermost voxel on their side
+   */
+  static int64_t voxelIndex(double coord) ;
+
   tf::MessageNotifier<T>* scan_notifier_ ;
 
-  //! \brief Stores history of scans
-  std::deque<sensor_msgs::PointCloud> scan_hist_ ;
+  /** \brief Stores history of scans, sorted by timestamp
+   * The mutex only protects the ring itself. buildCloud copies out the pointers it needs and assembles the
+   * cloud without holding the lock, so large requests don't block incoming scans.
+   */
+  std::deque<CloudConstPtr> scan_hist_ ;
   boost::mutex scan_hist_mutex_ ;
 
   //! \brief The number points currently in the scan history
@@ -133,6 +161,9 @@ private:
   //! \brief Specify how much to downsample the data. A value of 1 preserves all the data. 3 would keep 1/3 of the data.
   unsigned int downsample_factor_ ;
 
+  //! \brief Edge length of the voxels used to downsample the assembled cloud. 0 disables voxel downsampling
+  double voxel_size_ ;
+
 } ;
 
 template <class T>
@@ -177,6 +208,15 @@ BaseAssemblerSrv<T>::BaseAssemblerSrv(const std::string& node_name) : node_(node
   downsample_factor_ = tmp_downsample_factor ;
   ROS_INFO("Downsample Factor: %u", downsample_factor_) ;
 
+  // ***** Set voxel_size *****
+  ros::Node::instance()->param("~voxel_size", voxel_size_, 0.0) ;
+  if (voxel_size_ < 0)
+  {
+    ROS_ERROR("Parameter voxel_size<0: %f", voxel_size_) ;
+    voxel_size_ = 0.0 ;
+  }
+  ROS_INFO("Voxel Size: %f", voxel_size_) ;
+
   // ***** Start Services *****
   ros::Node::instance()->advertiseService(ros::Node::instance()->getName()+"/build_cloud", &BaseAssemblerSrv<T>::buildCloud, this, 0) ;
 
@@ -220,12 +260,12 @@ void BaseAssemblerSrv<T>::scansCallback(const boost::shared_ptr<T>& scan_ptr)
 {
   const T scan = *scan_ptr ;
 
-  sensor_msgs::PointCloud cur_cloud ;
+  boost::shared_ptr<sensor_msgs::PointCloud> cur_cloud(new sensor_msgs::PointCloud) ;
 
   // Convert the scan data into a universally known datatype: PointCloud
   try
   {
-    ConvertToCloud(fixed_frame_, scan, cur_cloud) ;              // Convert scan into a point cloud
+    ConvertToCloud(fixed_frame_, scan, *cur_cloud) ;              // Convert scan into a point cloud
   }
   catch(tf::TransformException& ex)
   {
@@ -234,18 +274,34 @@ void BaseAssemblerSrv<T>::scansCallback(const boost::shared_ptr<T>& scan_ptr)
   }
 
   // Add the current scan (now of type PointCloud) into our history of scans
-  scan_hist_mutex_.lock() ;
+  boost::mutex::scoped_lock lock(scan_hist_mutex_) ;
   if (scan_hist_.size() == max_scans_)                           // Is our deque full?
   {
-    total_pts_ -= scan_hist_.front().get_points_size() ;            // We're removing an elem, so this reduces our total point count
+    total_pts_ -= scan_hist_.front()->get_points_size() ;        // We're removing an elem, so this reduces our total point count
     scan_hist_.pop_front() ;                                     // The front of the deque has the oldest elem, so we can get rid of it
   }
-  scan_hist_.push_back(cur_cloud) ;                              // Add the newest scan to the back of the deque
-  total_pts_ += cur_cloud.get_points_size() ;                       // Add the new scan to the running total of points
+
+  // Scans almost always arrive in order, but keep the history sorted in case the notifier releases them out of order
+  if (scan_hist_.empty() || !(cur_cloud->header.stamp < scan_hist_.back()->header.stamp))
+    scan_hist_.push_back(cur_cloud) ;                            // Add the newest scan to the back of the deque
+  else
+    scan_hist_.insert(std::upper_bound(scan_hist_.begin(), scan_hist_.end(), CloudConstPtr(cur_cloud), &BaseAssemblerSrv<T>::cloudLessThan),
+                      cur_cloud) ;
+  total_pts_ += cur_cloud->get_points_size() ;                   // Add the new scan to the running total of points
 
   //printf("Scans: %4u  Points: %10u\n", scan_hist_.size(), total_pts_) ;
+}
 
-  scan_hist_mutex_.unlock() ;
+template <class T>
+bool BaseAssemblerSrv<T>::stampLessThan(const CloudConstPtr& cloud, const ros::Time& stamp)
+{
+  return cloud->header.stamp < stamp ;
+}
+
+template <class T>
+bool BaseAssemblerSrv<T>::cloudLessThan(const CloudConstPtr& a, const CloudConstPtr& b)
+{
+  return a->header.stamp < b->header.stamp ;
 }
 
 template <class T>
@@ -253,29 +309,25 @@ bool BaseAssemblerSrv<T>::buildCloud(AssembleScans::Request& req, AssembleScans:
 {
   //printf("Starting Service Request\n") ;
 
-  scan_hist_mutex_.lock() ;
-  // Determine where in our history we actually are
-  unsigned int i = 0 ;
-
-  // Find the beginning of the request. Probably should be a search
-  while ( i < scan_hist_.size() &&                                                    // Don't go past end of deque
-          scan_hist_[i].header.stamp < req.begin )                                    // Keep stepping until we've exceeded the start time
-  {
-    i++ ;
-  }
-  unsigned int start_index = i ;
-
-  unsigned int req_pts = 0 ;                                                          // Keep a total of the points in the current request
-  // Find the end of the request
-  while ( i < scan_hist_.size() &&                                                    // Don't go past end of deque
-          scan_hist_[i].header.stamp < req.end )                                      // Don't go past the end-time of the request
+  // Grab references to the scans in the requested window. This is the only part of the request that needs the lock.
+  std::vector<CloudConstPtr> req_scans ;
+  unsigned int start_index, past_end_index, hist_size ;
   {
-    req_pts += (scan_hist_[i].get_points_size()+downsample_factor_-1)/downsample_factor_ ;
-    i += downsample_factor_ ;
+    boost::mutex::scoped_lock lock(scan_hist_mutex_) ;
+    typename std::deque<CloudConstPtr>::iterator begin_it, end_it ;
+    begin_it = std::lower_bound(scan_hist_.begin(), scan_hist_.end(), req.begin, &BaseAssemblerSrv<T>::stampLessThan) ;
+    end_it   = std::lower_bound(begin_it,           scan_hist_.end(), req.end,   &BaseAssemblerSrv<T>::stampLessThan) ;
+
+    start_index = begin_it - scan_hist_.begin() ;
+    past_end_index = end_it - scan_hist_.begin() ;
+    hist_size = scan_hist_.size() ;
+
+    req_scans.reserve((past_end_index - start_index + downsample_factor_ - 1)/downsample_factor_) ;
+    for (unsigned int i=start_index; i<past_end_index; i+=downsample_factor_)
+      req_scans.push_back(scan_hist_[i]) ;
   }
-  unsigned int past_end_index = i ;
 
-  if (start_index == past_end_index)
+  if (req_scans.size() == 0)
   {
     resp.cloud.header.frame_id = fixed_frame_ ;
     resp.cloud.header.stamp = req.end ;
@@ -284,38 +336,104 @@ bool BaseAssemblerSrv<T>::buildCloud(AssembleScans::Request& req, AssembleScans:
   }
   else
   {
+    sensor_msgs::PointCloud full_cloud ;
+    sensor_msgs::PointCloud& cloud = (voxel_size_ > 0.0) ? full_cloud : resp.cloud ;
+
+    unsigned int req_pts = 0 ;                                                          // Keep a total of the points in the current request
+    for (unsigned int i=0; i<req_scans.size(); i++)
+      req_pts += (req_scans[i]->get_points_size()+downsample_factor_-1)/downsample_factor_ ;
+
     // Note: We are assuming that channel information is consistent across multiple scans. If not, then bad things (segfaulting) will happen
     // Allocate space for the cloud
-    resp.cloud.set_points_size( req_pts ) ;
-    const unsigned int num_channels = scan_hist_[start_index].get_channels_size() ;
-    resp.cloud.set_channels_size(num_channels) ;
-    for (i = 0; i<num_channels; i++)
+    cloud.set_points_size( req_pts ) ;
+    const unsigned int num_channels = req_scans[0]->get_channels_size() ;
+    cloud.set_channels_size(num_channels) ;
+    for (unsigned int i = 0; i<num_channels; i++)
     {
-      resp.cloud.channels[i].name = scan_hist_[start_index].channels[i].name ;
-      resp.cloud.channels[i].set_values_size(req_pts) ;
+      cloud.channels[i].name = req_scans[0]->channels[i].name ;
+      cloud.channels[i].set_values_size(req_pts) ;
     }
-    //resp.cloud.header.stamp = req.end ;
-    resp.cloud.header.frame_id = fixed_frame_ ;
+    cloud.header.frame_id = fixed_frame_ ;
     unsigned int cloud_count = 0 ;
-    for (i=start_index; i<past_end_index; i+=downsample_factor_)
+    for (unsigned int i=0; i<req_scans.size(); i++)
     {
-      for(unsigned int j=0; j<scan_hist_[i].get_points_size(); j+=downsample_factor_)
+      const sensor_msgs::PointCloud& scan = *req_scans[i] ;
+      for(unsigned int j=0; j<scan.get_points_size(); j+=downsample_factor_)
       {
-        resp.cloud.points[cloud_count].x = scan_hist_[i].points[j].x ;
-        resp.cloud.points[cloud_count].y = scan_hist_[i].points[j].y ;
-        resp.cloud.points[cloud_count].z = scan_hist_[i].points[j].z ;
+        cloud.points[cloud_count] = scan.points[j] ;
         for (unsigned int k=0; k<num_channels; k++)
-          resp.cloud.channels[k].values[cloud_count] = scan_hist_[i].channels[k].values[j] ;
+          cloud.channels[k].values[cloud_count] = scan.channels[k].values[j] ;
 
         cloud_count++ ;
       }
-      resp.cloud.header.stamp = scan_hist_[i].header.stamp;
+      cloud.header.stamp = scan.header.stamp;
     }
+
+    if (voxel_size_ > 0.0)
+      voxelDownsample(full_cloud, resp.cloud) ;
   }
-  scan_hist_mutex_.unlock() ;
 
-  ROS_DEBUG("Point Cloud Results: Aggregated from index %u->%u. BufferSize: %u. Points in cloud: %u", start_index, past_end_index, scan_hist_.size(), resp.cloud.points.size()) ;
+  ROS_DEBUG("Point Cloud Results: Aggregated from index %u->%u. BufferSize: %u. Points in cloud: %u", start_index, past_end_index, hist_size, resp.cloud.points.size()) ;
   return true ;
 }
 
+template <class T>
+int64_t BaseAssemblerSrv<T>::voxelIndex(double coord)
+{
+  // 21 bits per axis cover voxels -2^20 to 2^20-1. Coordinates beyond that (or NaN) are clamped, rather than
+  // wrapping around onto voxels near the origin, so only points in the outermost voxels can be merged wrongly
+  const double offset = 1 << 20 ;
+  double v = floor(coord) ;
+  if (!(v > -offset))
+    v = -offset ;
+  else if (v > offset - 1)
+    v = offset - 1 ;
+  return (int64_t) (v + offset) ;
+}
+
+template <class T>
+void BaseAssemblerSrv<T>::voxelDownsample(const sensor_msgs::PointCloud& cloud_in, sensor_msgs::PointCloud& cloud_out) const
+{
+  // Pack the integer voxel coordinates into a single key (21 bits per axis), and sort (key, index) pairs.
+  // Sorting keeps this independent of any hashing. Pairs with equal keys are ordered by index, which keeps the
+  // first point of each voxel at the front.
+  const unsigned int num_pts = cloud_in.get_points_size() ;
+  const double inv_size = 1.0 / voxel_size_ ;
+
+  std::vector<std::pair<int64_t, unsigned int> > keys(num_pts) ;
+  for (unsigned int i=0; i<num_pts; i++)
+  {
+    const int64_t vx = voxelIndex(cloud_in.points[i].x * inv_size) ;
+    const int64_t vy = voxelIndex(cloud_in.points[i].y * inv_size) ;
+    const int64_t vz = voxelIndex(cloud_in.points[i].z * inv_size) ;
+    keys[i] = std::make_pair((vx << 42) | (vy << 21) | vz, i) ;
+  }
+  std::sort(keys.begin(), keys.end()) ;
+
+  std::vector<unsigned int> kept ;
+  kept.reserve(num_pts) ;
+  for (unsigned int i=0; i<num_pts; i++)
+  {
+    if (i == 0 || keys[i].first != keys[i-1].first)
+      kept.push_back(keys[i].second) ;
+  }
+  std::sort(kept.begin(), kept.end()) ;                          // Preserve the original scan ordering in the output
+
+  const unsigned int num_channels = cloud_in.get_channels_size() ;
+  cloud_out.header = cloud_in.header ;
+  cloud_out.set_points_size(kept.size()) ;
+  cloud_out.set_channels_size(num_channels) ;
+  for (unsigned int k=0; k<num_channels; k++)
+  {
+    cloud_out.channels[k].name = cloud_in.channels[k].name ;
+    cloud_out.channels[k].set_values_size(kept.size()) ;
+  }
+  for (unsigned int i=0; i<kept.size(); i++)
+  {
+    cloud_out.points[i] = cloud_in.points[kept[i]] ;
+    for (unsigned int k=0; k<num_channels; k++)
+      cloud_out.channels[k].values[i] = cloud_in.channels[k].values[kept[i]] ;
+  }
+}
+
 }
@@ -89,9 +89,21 @@ namespace trajectory
     {
         TCoeff() {}
 
+        TCoeff(int dimension){setDimension(dimension);}; /** Constructor with dimension specified */
+
+        static const int MAX_COEFF_SIZE = 5; /** number of coefficients stored for each dimension */
+
         /* 
            \brief Get the coefficient corresponding to a degree in the polynomial and a dimension index */ 
-        inline double get_coefficient(int degree, int dim_index); 
+        inline double get_coefficient(int degree, int dim_index) const {return coeff_[dim_index*MAX_COEFF_SIZE+degree];};
+
+        /*!
+          \brief Set the dimension of the coefficient structure. This resizes the internal vector to the right size
+        */
+        void setDimension(int dimension){
+          dimension_ = dimension;
+          coeff_.resize(dimension_*MAX_COEFF_SIZE);
+        }
 
         private: 
 
@@ -101,7 +113,13 @@ namespace trajectory
 
         double duration_; /** duration of this trajectory segment */
 
-        std::vector<std::vector<double> > coeff_; /** std::vector of coefficients */
+        std::vector<double> coeff_; /** coefficients of all the dimensions, MAX_COEFF_SIZE consecutive values per dimension */
+
+        /* 
+           \brief Pointer to the coefficients of a dimension index */ 
+        inline double* coefficients(int dim_index) {return &coeff_[dim_index*MAX_COEFF_SIZE];};
+
+        inline const double* coefficients(int dim_index) const {return &coeff_[dim_index*MAX_COEFF_SIZE];};
 
         friend class Trajectory;
     };
@@ -122,7 +140,8 @@ namespace trajectory
     void clear();
 
     /*!
-      \brief Add a point to the trajectory
+      \brief Add a point to the trajectory. The point is inserted in order of its timestamp and only the segments 
+      on either side of it are reparameterized; the points after it are shifted in time if those segments had to be stretched.
     */
     void addPoint(const TPoint);
 
@@ -212,7 +231,8 @@ namespace trajectory
     void setJointWraps(int index);
 
     /*! 
-       \brief finds the trajectory segment corresponding to a particular time 
+       \brief finds the trajectory segment corresponding to a particular time. The segment found by the previous call and the one 
+       after it are checked first, so sampling forward in time is constant time. Otherwise the timestamps are binary searched.
        \param input time (in seconds)
        \return segment index 
     */
@@ -235,6 +255,8 @@ namespace trajectory
     void init(int num_points, int dimension);
 
     int num_points_; /** number of points in the trajectory */
+
+    int last_segment_; /** segment index returned by the last call to findTrajectorySegment */
  
     int dimension_; /** dimension of the trajectory */
 
@@ -260,13 +282,31 @@ namespace trajectory
     */
     int parameterize();  
 
+    /*!
+      \brief calculate the coefficients for the trajectory segments between points start and end only.
+       If the time of point end changes, all the points after it are shifted by the same amount.
+      \param index of the first point
+      \param index of the last point
+    */
+    int parameterize(int start, int end);
+
+    /*!
+      \brief update the times of points start+1 to end from the segment durations and shift the points after end to match
+    */
+    void updateTimes(int start, int end);
+
+    /*!
+      \brief make room for at least num_points points in the trajectory
+    */
+    void reserve(int num_points);
+
     /*!
       \brief calculate the coefficients for interpolation between trajectory points using linear interpolation
        If autocalc_timing_ is true, timings for the trajectories are automatically calculated using max rate information. Thus,
        the time duration for any segment is the maximum of two times: the time duration specified by the user
        and the time duration dictated by the constraints. 
     */
-    int parameterizeLinear();
+    int parameterizeLinear(int start, int end);
 
     /*!
       \brief calculate the coefficients for interpolation between trajectory points using blended linear interpolation.
@@ -274,7 +314,7 @@ namespace trajectory
        the time duration for any segment is the maximum of two times: the time duration specified by the user
        and the time duration dictated by the constraints. 
     */
-    int parameterizeBlendedLinear();
+    int parameterizeBlendedLinear(int start, int end);
 
     /*!
       \brief calculate the coefficients for interpolation between trajectory points using cubic interpolation.
@@ -282,7 +322,7 @@ namespace trajectory
        the time duration for any segment is the maximum of two times: the time duration specified by the user
        and the time duration dictated by the constraints. 
     */
-    int parameterizeCubic();
+    int parameterizeCubic(int start, int end);
 
     /*!
       \brief calculate a minimum time trajectory using linear interpolation
@@ -32,16 +32,16 @@
 #include "trajectory/trajectory.h"
 #include <angles/angles.h>
 #include <cstdlib>
+#include <algorithm>
 
 #define MAX_ALLOWABLE_TIME 1.0e8
 #define EPS_TRAJECTORY 1.0e-8
 
 #define MAX_NUM_POINTS 1000
-#define MAX_COEFF_SIZE 5
 
 using namespace trajectory;
 
-Trajectory::Trajectory(int dimension): dimension_(dimension)
+Trajectory::Trajectory(int dimension): max_acc_set_(false), max_rate_set_(false), num_points_(0), last_segment_(0), dimension_(dimension)
 {
   interp_method_ = "linear";
   autocalc_timing_ = false;
@@ -64,9 +64,7 @@ void Trajectory::init(int num_points, int dimension)
 
   for(int i=0; i<num_points-1; i++)
   {
-    tc_[i].coeff_.resize(dimension);
-    for(int j=0; j < dimension; j++)
-      tc_[i].coeff_[j].resize(MAX_COEFF_SIZE);
+    tc_[i].setDimension(dimension);
   }
   for(int i=0; i < dimension; i++)
   {
@@ -82,6 +80,17 @@ void Trajectory::clear()
   max_limit_.resize(0);
   max_rate_.resize(0);
   max_acc_.resize(0);
+  num_points_ = 0;
+  last_segment_ = 0;
+}
+
+void Trajectory::reserve(int num_points)
+{
+  if((int) tp_.size() >= num_points)
+    return;
+
+  tp_.resize(num_points,TPoint(dimension_));
+  tc_.resize(num_points-1,TCoeff(dimension_));
 }
 
 int Trajectory::setTrajectory(const std::vector<TPoint>& tp)
@@ -100,6 +109,7 @@ int Trajectory::setTrajectory(const std::vector<TPoint>& tp)
 //  ROS_INFO("Initializing trajectory with %d points",tp.size());
 
   num_points_ = tp.size();
+  reserve(num_points_);
 
 //  tp_.resize(num_points_);
 
@@ -137,6 +147,7 @@ int Trajectory::setTrajectory(const std::vector<double> &p, int numPoints)
     return -1;
   }   
   autocalc_timing_ = true;//Enable autocalc timing by default since no time information given in trajectory
+  reserve(num_points_);
 //tp_.resize(num_points_);
 
   for(int i=0; i<num_points_;i++)
@@ -200,6 +211,7 @@ int Trajectory::setTrajectory(const std::vector<double> &p, const std::vector<do
     ROS_WARN("Input has only %d values, expecting %d values for a %d dimensional trajectory with %d number of points",p.size(), num_points_*dimension_, dimension_, num_points_);
     return -1;
   }   
+  reserve(num_points_);
 
   for(int i=0; i<num_points_;i++)
   {
@@ -232,6 +244,7 @@ int Trajectory::setTrajectory(const std::vector<double> &p, const std::vector<do
     ROS_WARN("Input has only %d values, expecting %d values for a %d dimensional trajectory with %d number of points",p.size(), num_points_*dimension_, dimension_, num_points_);
     return -1;
   }   
+  reserve(num_points_);
 
   for(int i=0; i<num_points_;i++)
   {
@@ -247,24 +260,53 @@ int Trajectory::setTrajectory(const std::vector<double> &p, const std::vector<do
   return 1;
 }
 
-void Trajectory::addPoint(const TPoint tp)
+static bool timeLess(const Trajectory::TPoint &tp, double time)
 {
-  double time = tp.time_;
+  return tp.time_ < time;
+}
 
-  int index = findTrajectorySegment(time);
-  std::vector<TPoint>::iterator it = tp_.begin() + index;
-  tp_.insert(it,tp);
+static bool lessTime(double time, const Trajectory::TPoint &tp)
+{
+  return time < tp.time_;
+}
+
+void Trajectory::addPoint(const TPoint tp)
+{
+  // Insert after all the points with the same or an earlier time
+  int index = std::upper_bound(tp_.begin(),tp_.begin()+num_points_,tp.time_,lessTime) - tp_.begin();
+
+  reserve(num_points_+1);
+  // Shift the later points and their segments up by one, in place
+  std::copy_backward(tp_.begin()+index,tp_.begin()+num_points_,tp_.begin()+num_points_+1);
+  if(index < num_points_-1)
+    std::copy_backward(tc_.begin()+index,tc_.begin()+num_points_-1,tc_.begin()+num_points_);
+  tp_[index] = tp;
   num_points_++;
-  parameterize();
+
+  // Only the segments ending and starting at the new point change
+  parameterize(std::max(index-1,0),std::min(index+1,num_points_-1));
 }
 
 int Trajectory::findTrajectorySegment(double time)
 {
-  int result = 0;
+  if(num_points_ < 2)
+    return 0;
 
-  while(time > tp_[result+1].time_)
-    result++;
+  int last = num_points_-2;
+  int result = std::min(last_segment_,last);
+
+  // The segment sampled last time, or the one after it
+  if(time <= tp_[result+1].time_ && (result == 0 || time > tp_[result].time_))
+    return result;
+  if(result < last && time > tp_[result+1].time_ && time <= tp_[result+2].time_)
+  {
+    last_segment_ = result+1;
+    return last_segment_;
+  }
 
+  // First segment whose end point is not before time
+  result = std::lower_bound(tp_.begin()+1,tp_.begin()+num_points_-1,time,timeLess) - tp_.begin() - 1;
+  last_segment_ = result;
   return result;
 }
 
@@ -306,11 +348,11 @@ int Trajectory::sample(TPoint &tp, double time)
   } 
   int segment_index = findTrajectorySegment(time);
 //  ROS_INFO("segment index : %d",segment_index);
-  if(interp_method_ == std::string("linear"))
+  if(interp_method_ == "linear")
     sampleLinear(tp,time,tc_[segment_index],tp_[segment_index].time_);
-  else if(interp_method_ == std::string("cubic"))
+  else if(interp_method_ == "cubic")
     sampleCubic(tp,time,tc_[segment_index],tp_[segment_index].time_);
-  else if(interp_method_ == std::string("blended_linear"))
+  else if(interp_method_ == "blended_linear")
     sampleBlendedLinear(tp,time,tc_[segment_index],tp_[segment_index].time_);
   else
     ROS_WARN("Unrecognized interp_method type: %s\n",interp_method_.c_str());
@@ -429,8 +471,8 @@ int Trajectory::minimizeSegmentTimesWithLinearInterpolation()
 //      temp[1] = (tp_[i].q_[j] - tp_[i-1].q_[j])/tc_[i-1].duration_;  
       temp[1] = jointDiff(tp_[i-1].q_[j],tp_[i].q_[j],j)/tc_[i-1].duration_;  
 
-      tc_[i-1].coeff_[j][0] = temp[0];
-      tc_[i-1].coeff_[j][1] = temp[1];
+      tc_[i-1].coefficients(j)[0] = temp[0];
+      tc_[i-1].coefficients(j)[1] = temp[1];
       tc_[i-1].degree_ = 1;
       tc_[i-1].dimension_ = dimension_;
 
@@ -479,10 +521,10 @@ int Trajectory::minimizeSegmentTimesWithCubicInterpolation()
       temp[2] = (3*diff-(2*tp_[i-1].qdot_[j]+tp_[i].qdot_[j])*tc_[i-1].duration_)/(tc_[i-1].duration_*tc_[i-1].duration_);
       temp[3] = (-2*diff+(tp_[i-1].qdot_[j]+tp_[i].qdot_[j])*tc_[i-1].duration_)/(pow(tc_[i-1].duration_,3));
 
-      tc_[i-1].coeff_[j][0] = temp[0];
-      tc_[i-1].coeff_[j][1] = temp[1];
-      tc_[i-1].coeff_[j][2] = temp[2];
-      tc_[i-1].coeff_[j][3] = temp[3];
+      tc_[i-1].coefficients(j)[0] = temp[0];
+      tc_[i-1].coefficients(j)[1] = temp[1];
+      tc_[i-1].coefficients(j)[2] = temp[2];
+      tc_[i-1].coefficients(j)[3] = temp[3];
       tc_[i-1].degree_ = 1;
       tc_[i-1].dimension_ = dimension_;
 
@@ -538,11 +580,11 @@ int Trajectory::minimizeSegmentTimesWithBlendedLinearInterpolation()
       temp[3] = tb;
       temp[4] = std::max(tc_[i-1].duration_-2*tb,0.0);
 
-      tc_[i-1].coeff_[j][0] = temp[0];
-      tc_[i-1].coeff_[j][1] = temp[1];
-      tc_[i-1].coeff_[j][2] = temp[2];
-      tc_[i-1].coeff_[j][3] = temp[3];
-      tc_[i-1].coeff_[j][4] = temp[4];
+      tc_[i-1].coefficients(j)[0] = temp[0];
+      tc_[i-1].coefficients(j)[1] = temp[1];
+      tc_[i-1].coefficients(j)[2] = temp[2];
+      tc_[i-1].coefficients(j)[3] = temp[3];
+      tc_[i-1].coefficients(j)[4] = temp[4];
       tc_[i-1].degree_ = 1;
       tc_[i-1].dimension_ = dimension_;
 //      tc.coeff_.push_back(temp);
@@ -575,9 +617,10 @@ void Trajectory::sampleLinear(TPoint &tp, double time, const TCoeff &tc, double
 //  ROS_INFO("Coeff internal size: %d", tc.coeff_[0].size());
   for(int i =0; i < dimension_; i++)
   {
+    const double *coeff = tc.coefficients(i);
 //    ROS_INFO("Coeffs: %f %f", tc.coeff_[i][0], tc.coeff_[i][1]);
-    tp.q_[i]    =  tc.coeff_[i][0] + segment_time * tc.coeff_[i][1];
-    tp.qdot_[i] =  tc.coeff_[i][1];
+    tp.q_[i]    =  coeff[0] + segment_time * coeff[1];
+    tp.qdot_[i] =  coeff[1];
 
     if(joint_wraps_[i])
       tp.q_[i] = angles::normalize_angle(tp.q_[i]);
@@ -593,27 +636,28 @@ void Trajectory::sampleBlendedLinear(TPoint &tp, double time, const TCoeff &tc,
   double segment_time = time - segment_start_time;
   for(int i =0; i < dimension_; i++)
   {
-    double taccend = tc.coeff_[i][3];
-    double tvelend = tc.coeff_[i][3] + tc.coeff_[i][4];
-    double tvel = tc.coeff_[i][4];
-    double acc = tc.coeff_[i][2]*2;
-    double v0 = tc.coeff_[i][1];
+    const double *coeff = tc.coefficients(i);
+    double taccend = coeff[3];
+    double tvelend = coeff[3] + coeff[4];
+    double tvel = coeff[4];
+    double acc = coeff[2]*2;
+    double v0 = coeff[1];
  
     if(segment_time <= taccend)
     {
-      tp.q_[i]    =  tc.coeff_[i][0] + segment_time * v0 + 0.5 * segment_time * segment_time * acc;
-      tp.qdot_[i] =  tc.coeff_[i][1] + segment_time * acc;
+      tp.q_[i]    =  coeff[0] + segment_time * v0 + 0.5 * segment_time * segment_time * acc;
+      tp.qdot_[i] =  coeff[1] + segment_time * acc;
     }
     else if(segment_time >= tvelend)
     {
       double dT = segment_time - tvelend;
-      tp.q_[i] = tc.coeff_[i][0] +  v0 * taccend + 0.5 * acc * taccend * taccend + acc * taccend * tvel + acc * taccend * dT - 0.5 * acc * dT * dT;
+      tp.q_[i] = coeff[0] +  v0 * taccend + 0.5 * acc * taccend * taccend + acc * taccend * tvel + acc * taccend * dT - 0.5 * acc * dT * dT;
       tp.qdot_[i] = acc*taccend - acc*dT;
     }
     else
     {
       double dT = segment_time - taccend;
-      tp.q_[i] = tc.coeff_[i][0] +  v0 * taccend + 0.5 * acc * taccend * taccend + acc * taccend * dT;
+      tp.q_[i] = coeff[0] +  v0 * taccend + 0.5 * acc * taccend * taccend + acc * taccend * dT;
       tp.qdot_[i] = acc * taccend;
     }
 
@@ -630,8 +674,9 @@ void Trajectory::sampleCubic(TPoint &tp, double time, const TCoeff &tc, double s
   double segment_time = time - segment_start_time;
   for(int i =0; i < dimension_; i++)
   {
-    tp.q_[i]    = tc.coeff_[i][0] + segment_time * tc.coeff_[i][1] + segment_time*segment_time*tc.coeff_[i][2] + segment_time*segment_time*segment_time*tc.coeff_[i][3];
-    tp.qdot_[i] = tc.coeff_[i][1] + 2*segment_time*tc.coeff_[i][2] + 3*segment_time*segment_time*tc.coeff_[i][3];
+    const double *coeff = tc.coefficients(i);
+    tp.q_[i]    = coeff[0] + segment_time * coeff[1] + segment_time*segment_time*coeff[2] + segment_time*segment_time*segment_time*coeff[3];
+    tp.qdot_[i] = coeff[1] + 2*segment_time*coeff[2] + 3*segment_time*segment_time*coeff[3];
 
     if(joint_wraps_[i])
       tp.q_[i] = angles::normalize_angle(tp.q_[i]);
@@ -814,14 +859,19 @@ void Trajectory::setInterpolationMethod(std::string interp_method)
 }
 
 int Trajectory::parameterize()
+{
+  return parameterize(0,num_points_-1);
+}
+
+int Trajectory::parameterize(int start, int end)
 {
   int error_code = -1;
-  if(interp_method_ == std::string("linear"))
-     error_code = parameterizeLinear();
-  else if(interp_method_ == std::string("cubic"))
-     error_code = parameterizeCubic();
-  else if(interp_method_ == std::string("blended_linear"))
-     error_code = parameterizeBlendedLinear();
+  if(interp_method_ == "linear")
+     error_code = parameterizeLinear(start,end);
+  else if(interp_method_ == "cubic")
+     error_code = parameterizeCubic(start,end);
+  else if(interp_method_ == "blended_linear")
+     error_code = parameterizeBlendedLinear(start,end);
   else
   {
     ROS_WARN("Unrecognized interp_method type: %s\n",interp_method_.c_str());
@@ -829,8 +879,26 @@ int Trajectory::parameterize()
   return error_code;
 }
 
+void Trajectory::updateTimes(int start, int end)
+{
+  if(end <= start)
+    return;
 
-int Trajectory::parameterizeLinear()
+  double end_time = tp_[end].time_;
+  for(int i=start+1; i <= end; i++)
+    tp_[i].time_ = tp_[i-1].time_ + tc_[i-1].duration_;
+
+  // The segments after end keep their durations
+  double shift = tp_[end].time_ - end_time;
+  if(shift != 0.0)
+  {
+    for(int i=end+1; i < num_points_; i++)
+      tp_[i].time_ += shift;
+  }
+}
+
+
+int Trajectory::parameterizeLinear(int start, int end)
 {
   double dT(0);
 
@@ -851,7 +919,7 @@ int Trajectory::parameterizeLinear()
       return -1;
     }
   }
-  for(int i=1; i < (int) num_points_ ; i++)
+  for(int i=start+1; i <= end; i++)
   {
 //    tc.coeff_.clear();
     dT = tp_[i].time_ - tp_[i-1].time_;
@@ -875,8 +943,8 @@ int Trajectory::parameterizeLinear()
 //         ROS_WARN("Zero duration between two trajectory points");
         }
 //      tc.coeff_.push_back(temp);
-      tc_[i-1].coeff_[j][0] = temp[0];
-      tc_[i-1].coeff_[j][1] = temp[1];
+      tc_[i-1].coefficients(j)[0] = temp[0];
+      tc_[i-1].coefficients(j)[1] = temp[1];
       tc_[i-1].degree_ = 1;
       tc_[i-1].dimension_ = dimension_;
     }
@@ -890,17 +958,13 @@ int Trajectory::parameterizeLinear()
   }
 */
   // Now modify all the times to bring them up to date
-  for(int i=1; i < (int) num_points_; i++)
-  {
-    tp_[i].time_ = tp_[i-1].time_ + tc_[i-1].duration_;
-//    ROS_INFO("Times: %d %f",i,tp_[i].time_);
-  }
+  updateTimes(start,end);
   return 1;
 }
 
 
 
-int Trajectory::parameterizeCubic()
+int Trajectory::parameterizeCubic(int start, int end)
 {
   double dT(0);
 
@@ -923,7 +987,7 @@ int Trajectory::parameterizeCubic()
     }
   }
 
-  for(int i=1; i < (int) num_points_ ; i++)
+  for(int i=start+1; i <= end; i++)
   {
 //    tc.coeff_.clear();
     dT = tp_[i].time_ - tp_[i-1].time_;
@@ -949,10 +1013,10 @@ int Trajectory::parameterizeCubic()
       if(std::isnan(temp[3]))
         temp[3] = 0.0;
 
-      tc_[i-1].coeff_[j][0] = temp[0];
-      tc_[i-1].coeff_[j][1] = temp[1];
-      tc_[i-1].coeff_[j][2] = temp[2];
-      tc_[i-1].coeff_[j][3] = temp[3];
+      tc_[i-1].coefficients(j)[0] = temp[0];
+      tc_[i-1].coefficients(j)[1] = temp[1];
+      tc_[i-1].coefficients(j)[2] = temp[2];
+      tc_[i-1].coefficients(j)[3] = temp[3];
       tc_[i-1].degree_ = 1;
       tc_[i-1].dimension_ = dimension_;
 
@@ -962,14 +1026,13 @@ int Trajectory::parameterizeCubic()
   }
 
   // Now modify all the times to bring them up to date
-  for(int i=1; i < (int) num_points_; i++)
-    tp_[i].time_ = tp_[i-1].time_ + tc_[i-1].duration_;
+  updateTimes(start,end);
 
   return 1;
 }
 
 
-int Trajectory::parameterizeBlendedLinear()
+int Trajectory::parameterizeBlendedLinear(int start, int end)
 {
    double dT(0.0),acc(0.0),tb(0.0);
 /*
@@ -991,7 +1054,7 @@ int Trajectory::parameterizeBlendedLinear()
     }
   }
 
-  for(int i=1; i < (int) num_points_ ; i++)
+  for(int i=start+1; i <= end; i++)
   {
 //    tc.coeff_.clear();
     dT = tp_[i].time_ - tp_[i-1].time_;
@@ -1021,11 +1084,11 @@ int Trajectory::parameterizeBlendedLinear()
       temp[3] = tb;
       temp[4] = std::max(tc_[i-1].duration_-2*tb,0.0);
 
-      tc_[i-1].coeff_[j][0] = temp[0];
-      tc_[i-1].coeff_[j][1] = temp[1];
-      tc_[i-1].coeff_[j][2] = temp[2];
-      tc_[i-1].coeff_[j][3] = temp[3];
-      tc_[i-1].coeff_[j][4] = temp[4];
+      tc_[i-1].coefficients(j)[0] = temp[0];
+      tc_[i-1].coefficients(j)[1] = temp[1];
+      tc_[i-1].coefficients(j)[2] = temp[2];
+      tc_[i-1].coefficients(j)[3] = temp[3];
+      tc_[i-1].coefficients(j)[4] = temp[4];
       tc_[i-1].degree_ = 1;
       tc_[i-1].dimension_ = dimension_;
 
@@ -1037,8 +1100,7 @@ int Trajectory::parameterizeBlendedLinear()
   }
 
   // Now modify all the times to bring them up to date
-  for(int i=1; i < (int) num_points_; i++)
-    tp_[i].time_ = tp_[i-1].time_ + tc_[i-1].duration_;
+  updateTimes(start,end);
 
   return 1;
 }
@@ -0,0 +1,88 @@
+#include "trajectory/trajectory.h"
+#include <time.h>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+// Sampling cost of a long trajectory, as seen by a controller sampling it at
+// 1 kHz: the mean and worst time of a sample() call for each interpolation
+// method, sampling forward in time and at random times. Also the cost of
+// appending points one at a time with addPoint().
+// Usage: ./benchmark_sample [points] [dimension]
+
+using namespace trajectory;
+
+static double wallTime()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+int main( int argc, char** argv )
+{
+  static const double DT = 0.001;
+  static const double SEGMENT_TIME = 0.1;
+  int num_points = argc > 1 ? atoi(argv[1]) : 500;
+  int dimension = argc > 2 ? atoi(argv[2]) : 7;
+
+  std::vector<double> p(num_points*dimension), pdot(num_points*dimension), time(num_points);
+  std::vector<double> max_rate(dimension, 10.0), max_acc(dimension, 100.0);
+  srand(0);
+  for (int i = 0; i < num_points; ++i) {
+    time[i] = i * SEGMENT_TIME;
+    for (int j = 0; j < dimension; ++j) {
+      p[i*dimension+j] = rand() / (double)RAND_MAX - 0.5;
+      pdot[i*dimension+j] = 0.0;
+    }
+  }
+
+  printf("%d points, %d dimensions, sampled every %g s\n", num_points, dimension, DT);
+  printf("%-16s %-8s %12s %12s\n", "method", "order", "mean us", "max us");
+
+  const char* methods[] = {"linear", "cubic", "blended_linear"};
+  for (int m = 0; m < 3; ++m) {
+    Trajectory traj(dimension);
+    traj.setMaxRates(max_rate);
+    traj.setMaxAcc(max_acc);
+    traj.setInterpolationMethod(methods[m]);
+    traj.setTrajectory(p, pdot, time, num_points);
+
+    Trajectory::TPoint tp(dimension);
+    double total_time = traj.getTotalTime();
+    int samples = (int)(total_time / DT);
+
+    for (int random = 0; random < 2; ++random) {
+      double mean = 0.0, worst = 0.0;
+      for (int k = 0; k < samples; ++k) {
+        double t = random ? total_time * rand() / RAND_MAX : k * DT;
+        double start = wallTime();
+        traj.sample(tp, t);
+        double elapsed = wallTime() - start;
+        mean += elapsed;
+        if (elapsed > worst)
+          worst = elapsed;
+      }
+      printf("%-16s %-8s %12.3f %12.3f\n", methods[m], random ? "random" : "forward",
+             mean / samples * 1e6, worst * 1e6);
+    }
+  }
+
+  Trajectory traj(dimension);
+  traj.setMaxRates(max_rate);
+  traj.setTrajectory(p, pdot, std::vector<double>(time.begin(), time.begin() + 2), 2);
+  Trajectory::TPoint tp(dimension);
+  double start = wallTime();
+  for (int i = 2; i < num_points; ++i) {
+    tp.time_ = time[i];
+    for (int j = 0; j < dimension; ++j) {
+      tp.q_[j] = p[i*dimension+j];
+      tp.qdot_[j] = 0.0;
+    }
+    traj.addPoint(tp);
+  }
+  printf("addPoint %-15s %12.3f us per point\n", "append", (wallTime() - start) / (num_points - 2) * 1e6);
+
+  return 0;
+}
@@ -217,6 +217,129 @@ TEST(Trajectory, samplingAfterInstantiationWithoutTimeCubic){
   t.sample(b,1.5);
 }
 
+TEST(Trajectory, addPoint){
+  Trajectory t(1);
+  Trajectory::TPoint b(1);
+  std::vector<double> a;
+  std::vector<double> c;
+
+  a.resize(3);
+  c.resize(3);
+
+  a[0] = 0;
+  a[1] = 1;
+  a[2] = 3;
+
+  c[0] = 0;
+  c[1] = 1;
+  c[2] = 3;
+
+  t.setTrajectory(a,c,3);
+
+  Trajectory::TPoint p(1);
+  p.q_[0] = 2;
+  p.time_ = 2;
+  t.addPoint(p);
+
+  p.q_[0] = 5;
+  p.time_ = 4;
+  t.addPoint(p);
+
+  EXPECT_EQ(t.getNumberPoints(),5);
+
+  std::vector<double> timestamps;
+  timestamps.resize(5);
+  t.getTimeStamps(timestamps);
+  for(int i=0; i < 5; i++)
+    EXPECT_EQ(timestamps[i],(double) i);
+
+  t.sample(b,2.5);
+  EXPECT_NEAR(b.q_[0],2.5,1e-9);
+  t.sample(b,3.5);
+  EXPECT_NEAR(b.q_[0],4.0,1e-9);
+  t.sample(b,0.5);
+  EXPECT_NEAR(b.q_[0],0.5,1e-9);
+}
+
+TEST(Trajectory, addPointMatchesSetTrajectory){
+  Trajectory t(2);
+  Trajectory u(2);
+  Trajectory::TPoint b(2);
+  Trajectory::TPoint e(2);
+  std::vector<Trajectory::TPoint> points;
+
+  std::vector<double> d;
+  d.resize(2);
+  d[0] = 1;
+  d[1] = 1;
+  t.setMaxRates(d);
+  u.setMaxRates(d);
+  t.autocalc_timing_ = true;
+  u.autocalc_timing_ = true;
+
+  double q[6][3] = {{0,0,0},{3,1,0.5},{3.5,-1,0.5},{6,0,1},{9,1,1.5},{10,3,1.5}};
+  for(int i=0; i < 6; i++)
+  {
+    Trajectory::TPoint p(2);
+    p.time_ = q[i][0];
+    p.q_[0] = q[i][1];
+    p.q_[1] = q[i][2];
+    p.qdot_[0] = p.qdot_[1] = 0.0;
+    points.push_back(p);
+  }
+
+  // The segments before the appended point and on either side of the
+  // inserted one have to be stretched, which shifts the points after them
+  std::vector<Trajectory::TPoint> first(points.begin(),points.begin()+5);
+  first.erase(first.begin()+2);
+  t.setTrajectory(first);
+  t.addPoint(points[5]);
+  t.addPoint(points[2]);
+
+  u.setTrajectory(points);
+
+  ASSERT_EQ(t.getNumberPoints(),6);
+  std::vector<double> timestamps, expected;
+  timestamps.resize(6);
+  expected.resize(6);
+  t.getTimeStamps(timestamps);
+  u.getTimeStamps(expected);
+  for(int i=0; i < 6; i++)
+    EXPECT_NEAR(timestamps[i],expected[i],1e-9);
+
+  for(double time = 0.0; time < u.getTotalTime(); time += 0.1)
+  {
+    t.sample(b,time);
+    u.sample(e,time);
+    EXPECT_NEAR(b.q_[0],e.q_[0],1e-9);
+    EXPECT_NEAR(b.q_[1],e.q_[1],1e-9);
+  }
+}
+
+TEST(Trajectory, findTrajectorySegment){
+  Trajectory t(1);
+  std::vector<double> a;
+  std::vector<double> c;
+
+  a.resize(5);
+  c.resize(5);
+  for(int i=0; i < 5; i++)
+  {
+    a[i] = i;
+    c[i] = i;
+  }
+  c[3] = 2; // zero duration segment
+  t.setTrajectory(a,c,5);
+
+  EXPECT_EQ(t.findTrajectorySegment(0.5),0);
+  EXPECT_EQ(t.findTrajectorySegment(1.5),1);
+  EXPECT_EQ(t.findTrajectorySegment(3.5),3);
+  EXPECT_EQ(t.findTrajectorySegment(2.0),1);
+  EXPECT_EQ(t.findTrajectorySegment(0.0),0);
+  EXPECT_EQ(t.findTrajectorySegment(1.0),0);
+  EXPECT_EQ(t.findTrajectorySegment(4.0),3);
+  EXPECT_EQ(t.findTrajectorySegment(2.5),3);
+}
 
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
@@ -1,8 +1,18 @@
 #include "trajectory/trajectory.h"
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <unistd.h>
 
 using namespace trajectory;
 
+// Exercises write() without leaving its output in the source tree
+static void writeAndRemove(Trajectory &t, const std::string &name)
+{
+  std::string filename = std::string(P_tmpdir) + "/" + name;
+  EXPECT_EQ(1, t.write(filename,0.01));
+  unlink(filename.c_str());
+}
+
 TEST(Trajectory, samplingAfterInstantiationWithoutTimeBlendedLinear){
   Trajectory t(2);
   Trajectory::TPoint b(2);
@@ -26,7 +36,7 @@ TEST(Trajectory, samplingAfterInstantiationWithoutTimeBlendedLinear){
 
   t.setTrajectory(a,4);
   t.sample(b,1.5);
-  t.write(std::string("junk.txt"),0.01);
+  writeAndRemove(t,"utestBlended_increasing.txt");
 
   a[2] = -1; 
   a[4] = -2;
@@ -34,7 +44,7 @@ TEST(Trajectory, samplingAfterInstantiationWithoutTimeBlendedLinear){
 
   t.setTrajectory(a,4);
   t.sample(b,1.5);
-  t.write(std::string("junk2.txt"),0.01);
+  writeAndRemove(t,"utestBlended_decreasing.txt");
 
 }
 
@@ -70,7 +80,7 @@ TEST(Trajectory, samplingWithZeroInput){
   t.setTrajectory(a,time,4);
   ROS_INFO("Setting trajectory done");
   t.sample(b,1.5);
-  t.write(std::string("junk_zero.txt"),0.01);
+  writeAndRemove(t,"utestBlended_zero.txt");
 
 }
 
@@ -1,8 +1,18 @@
 #include "trajectory/trajectory.h"
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <unistd.h>
 
 using namespace trajectory;
 
+// Exercises write() without leaving its output in the source tree
+static void writeAndRemove(Trajectory &t, const std::string &name)
+{
+  std::string filename = std::string(P_tmpdir) + "/" + name;
+  EXPECT_EQ(1, t.write(filename,0.01));
+  unlink(filename.c_str());
+}
+
 TEST(Trajectory, samplingAfterCubic){
   Trajectory t(2);
   Trajectory::TPoint b(2);
@@ -32,7 +42,7 @@ TEST(Trajectory, samplingAfterCubic){
 
   t.sample(b,1.5);
 
-  t.write(std::string("junk.txt"),0.01);
+  writeAndRemove(t,"utestCubic.txt");
 }
 
 
@@ -33,6 +33,8 @@
 #define REALTIME_TOOLS_RECORDER_H
 
 #include <string>
+#include <vector>
+#include <cstdio>
 #include <boost/thread/thread.hpp>
 
 #include "ros/node_handle.h"
@@ -45,8 +47,20 @@ namespace pr2_mechanism {
 /** \brief Recorder provides support for streaming data out of
  * realtime without overloading ROS.
  *
- * The data is packed into a pr2_mechanism_msgs/BufferedData message, and
- * published at 10Hz.
+ * Each control cycle, record() fills a frame holding the time from the
+ * robot and one value per channel. Channels that are not recorded in a
+ * cycle are NaN. A frame is complete once the next cycle starts. Complete
+ * frames go into a ring which the realtime thread never waits on. If the
+ * ring is full, frames are dropped and counted.
+ *
+ * A separate thread drains the ring. Either it packs 100 frames at a time
+ * into a pr2_mechanism_msgs/BufferedData message, or it writes every frame
+ * to a binary trace file, which scripts/tracedump.py reads.
+ *
+ * The trace file starts with "PR2TRACE", the format version, the number
+ * of channels, and each channel name as a length and characters (uint32).
+ * Each frame follows as the time's sec and nsec (uint32) and a float per
+ * channel, all in the byte order of the machine that wrote it.
  */
 class Recorder
 {
@@ -63,9 +77,13 @@ public:
   void channel(unsigned int index, const std::string &name);
 
   /**
-   * Spins up the publishing thread and begins sending out data.
+   * Spins up the writing thread and begins sending out data.
+   *
+   * \param topic The topic to publish BufferedData on
+   * \param trace_path If given, frames are written to this trace file instead of being published
    */
-  bool init(pr2_mechanism::RobotState *robot, const ros::NodeHandle &node, const std::string &topic = "trace");
+  bool init(pr2_mechanism::RobotState *robot, const ros::NodeHandle &node, const std::string &topic = "trace",
+            const std::string &trace_path = "");
 
   /**@brief Call record in realtime on each data value.  init() must have already been called.
    * \param index The channel index, corresponding to the index given to channel()
@@ -73,18 +91,37 @@ public:
    */
   void record(unsigned int index, float value);
 
+  /**@brief The number of frames dropped because the writing thread fell behind */
+  unsigned int dropped() const { return dropped_; }
+
+  static const unsigned int RING_FRAMES = 4096;
+  static const unsigned int FRAMES_PER_MESSAGE = 100;
+
 private:
   ros::NodeHandle node_;
   ros::Publisher pub_;
   pr2_mechanism::RobotState *robot_;
 
-  pr2_mechanism_msgs::BufferedData msg_[2];
-  int other(int i) { return i == 0 ? 1 : 0; }
-  int filling_;  // Index of msg_ which the RT process is currently filling with data
-  int publishing_;  // Index of msg_ which is being publishing (or waiting to be published)
+  std::vector<std::string> names_;
+  FILE *trace_;
+
+  // The ring of frames.  The realtime thread fills the frame at head_ and
+  // is the only one to move head_; the writing thread reads the frames from
+  // tail_ up to head_ and is the only one to move tail_.
+  std::vector<ros::Time> times_;
+  std::vector<float> values_;  // RING_FRAMES frames of names_.size() values
+  volatile unsigned int head_;
+  volatile unsigned int tail_;
+  bool filling_;  // True once the frame at head_ has been started
+  unsigned int dropped_;
+
+  pr2_mechanism_msgs::BufferedData msg_;
+  unsigned int msg_frames_;  // Frames in msg_ so far
+
+  void writeFrame(unsigned int frame);
 
   boost::thread thread_;
-  void publishingLoop();
+  void writingLoop();
   bool is_running_;
   bool keep_running_;
   void stop() { keep_running_ = false; }
@@ -0,0 +1,76 @@
+#! /usr/bin/env python
+# Copyright (c) 2009, Willow Garage, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the name of the Willow Garage, Inc. nor the names of its
+#       contributors may be used to endorse or promote products derived from
+#       this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+
+# Prints a trace file written by pr2_mechanism::Recorder as comma separated
+# values, one line per control cycle, starting with the time.
+#
+# Usage: tracedump.py <trace file>
+
+import struct
+import sys
+
+def read_trace(f):
+    if f.read(8) != b'PR2TRACE':
+        raise ValueError("Not a trace file")
+    version, num_channels = struct.unpack('=II', f.read(8))
+    if version != 1:
+        raise ValueError("Unknown trace version %d" % version)
+    names = []
+    for i in range(num_channels):
+        length, = struct.unpack('=I', f.read(4))
+        names.append(f.read(length).decode())
+
+    frame = struct.Struct('=II%df' % num_channels)
+    frames = []
+    while True:
+        data = f.read(frame.size)
+        if len(data) < frame.size:
+            break
+        values = frame.unpack(data)
+        frames.append((values[0] + values[1] * 1e-9, values[2:]))
+    return names, frames
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write("Usage: tracedump.py <trace file>\n")
+        sys.exit(1)
+
+    f = open(sys.argv[1], 'rb')
+    names, frames = read_trace(f)
+    f.close()
+
+    for i in range(len(names)):
+        sys.stdout.write("# %2d: %s\n" % ((i+1), names[i]))
+    for t, values in frames:
+        sys.stdout.write("%.6f" % t)
+        for v in values:
+            sys.stdout.write(", %f" % v)
+        sys.stdout.write("\n")
+
+if __name__ == '__main__': main()
@@ -30,16 +30,21 @@
 // Author: Stuart Glaser
 
 #include "pr2_mechanism_control/recorder.h"
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
 
 namespace pr2_mechanism {
 
-Recorder::Recorder() : robot_(NULL), is_running_(false) {}
+Recorder::Recorder()
+  : robot_(NULL), trace_(NULL), head_(0), tail_(0), filling_(false), dropped_(0), msg_frames_(0),
+    is_running_(false), keep_running_(false)
+{}
 
 Recorder::~Recorder()
 {
   stop();
-  while (is_running_)
-    usleep(10000);
+  thread_.join();
   pub_.shutdown();
 }
 
@@ -49,31 +54,58 @@ void Recorder::channel(unsigned int index, const std::string &name)
     ROS_FATAL("Cannot call channel after init");
     return;
   }
-  if (msg_[0].channels.size() <= index)
-    msg_[0].channels.resize(index + 1);
-  msg_[0].channels[index].name = name;
+  if (names_.size() <= index)
+    names_.resize(index + 1);
+  names_[index] = name;
 }
 
-bool Recorder::init(pr2_mechanism::RobotState *robot, const ros::NodeHandle &node, const std::string &topic)
+bool Recorder::init(pr2_mechanism::RobotState *robot, const ros::NodeHandle &node, const std::string &topic,
+                    const std::string &trace_path)
 {
-  robot_ = robot;
+  node_ = node;
 
-  msg_[1].channels.resize(msg_[0].channels.size());
-  for (size_t i = 0; i < msg_[0].channels.size(); ++i)
+  if (!trace_path.empty())
   {
-    msg_[1].channels[i].name = msg_[0].channels[i].name;
-    msg_[0].channels[i].values.resize(100);
-    msg_[1].channels[i].values.resize(100);
+    trace_ = fopen(trace_path.c_str(), "wb");
+    if (!trace_)
+    {
+      ROS_ERROR("Could not open trace file %s", trace_path.c_str());
+      return false;
+    }
+
+    uint32_t version = 1, num_channels = names_.size();
+    fwrite("PR2TRACE", 1, 8, trace_);
+    fwrite(&version, sizeof(version), 1, trace_);
+    fwrite(&num_channels, sizeof(num_channels), 1, trace_);
+    for (size_t i = 0; i < names_.size(); ++i)
+    {
+      uint32_t length = names_[i].size();
+      fwrite(&length, sizeof(length), 1, trace_);
+      fwrite(names_[i].data(), 1, length, trace_);
+    }
+  }
+  else
+  {
+    msg_.channels.resize(names_.size());
+    for (size_t i = 0; i < names_.size(); ++i)
+    {
+      msg_.channels[i].name = names_[i];
+      msg_.channels[i].values.resize(FRAMES_PER_MESSAGE);
+    }
+    pub_ = node_.advertise<pr2_mechanism_msgs::BufferedData>(topic, 2);
   }
 
-  node_ = node;
-  pub_ = node_.advertise<pr2_mechanism_msgs::BufferedData>(topic, 2);
+  times_.resize(RING_FRAMES);
+  values_.resize(RING_FRAMES * names_.size());
+  head_ = tail_ = 0;
+  filling_ = false;
+  dropped_ = 0;
+  msg_frames_ = 0;
 
-  filling_ = 0;
-  publishing_ = 0;
+  robot_ = robot;
 
   keep_running_ = true;
-  thread_ = boost::thread(&Recorder::publishingLoop, this);
+  thread_ = boost::thread(&Recorder::writingLoop, this);
 
   return true;
 }
@@ -82,42 +114,113 @@ void Recorder::record(unsigned int index, float value)
 {
   if (!robot_)
     return; // init wasn't called
-  assert(index >= 0 && index < msg_[filling_].channels.size());
+  assert(index < names_.size());
 
-  int ms = (int)fmod(robot_->getTime().toSec() * 1000.0, 1000.0);
-  if (ms % 100 == 0)
+  // The first value of each cycle finishes the previous frame and starts a new one
+  ros::Time time = robot_->getTime();
+  if (!filling_ || time != times_[head_])
   {
-    if (publishing_ != other(filling_))
+    if (filling_)
     {
-      filling_ = other(filling_);
-      msg_[filling_].header.stamp = robot_->getTime();
+      unsigned int next = (head_ + 1) % RING_FRAMES;
+      if (next != tail_)
+      {
+        __sync_synchronize();  // The frame is written before the writing thread can see it
+        head_ = next;
+      }
+      else
+        ++dropped_;  // Full, so the frame at head_ is reused
     }
+
+    times_[head_] = time;
+    std::fill(values_.begin() + head_ * names_.size(), values_.begin() + (head_ + 1) * names_.size(),
+              std::numeric_limits<float>::quiet_NaN());
+    filling_ = true;
+  }
+
+  values_[head_ * names_.size() + index] = value;
+}
+
+void Recorder::writeFrame(unsigned int frame)
+{
+  const float *values = &values_[frame * names_.size()];
+
+  if (trace_)
+  {
+    uint32_t stamp[2] = { times_[frame].sec, times_[frame].nsec };
+    fwrite(stamp, sizeof(stamp[0]), 2, trace_);
+    fwrite(values, sizeof(float), names_.size(), trace_);
+    return;
   }
 
-  pr2_mechanism_msgs::BufferedData &msg = msg_[filling_];
-  msg.channels[index].values[ms % 100] = value;
+  if (msg_frames_ == 0)
+    msg_.header.stamp = times_[frame];
+  for (size_t i = 0; i < names_.size(); ++i)
+    msg_.channels[i].values[msg_frames_] = values[i];
+
+  if (++msg_frames_ == FRAMES_PER_MESSAGE)
+  {
+    pub_.publish(msg_);
+    msg_frames_ = 0;
+  }
 }
 
-void Recorder::publishingLoop()
+void Recorder::writingLoop()
 {
-  ROS_DEBUG("Entering publishing loop (namespace: %s)", node_.getNamespace().c_str());
+  ROS_DEBUG("Entering writing loop (namespace: %s)", node_.getNamespace().c_str());
   is_running_ = true;
-  while (keep_running_)
+  while (true)
   {
-    ros::spinOnce();
-    if (publishing_ == filling_)
+    bool keep_running = keep_running_;
+    if (!trace_)
+      ros::spinOnce();
+
+    unsigned int head = head_;
+    __sync_synchronize();  // Read the frames only after seeing head_
+
+    // Drains what's left before exiting
+    if (tail_ == head)
     {
+      if (!keep_running)
+        break;
       usleep(10000);
+      continue;
     }
-    else
+
+    while (tail_ != head)
     {
-      pub_.publish(msg_[publishing_]);
-      publishing_ = other(publishing_);
+      writeFrame(tail_);
+      __sync_synchronize();  // Done with the frame before the realtime thread can reuse it
+      tail_ = (tail_ + 1) % RING_FRAMES;
     }
   }
-  ROS_DEBUG("Exiting publishing loop (namespace: %s)", node_.getNamespace().c_str());
-  is_running_ = false;
 
+  // stop() is only called once record() can no longer be called, so the
+  // frame being filled is complete
+  if (filling_)
+  {
+    writeFrame(head_);
+    filling_ = false;
+  }
+
+  // Sends out the last, partial message
+  if (!trace_ && msg_frames_ > 0)
+  {
+    for (size_t i = 0; i < msg_.channels.size(); ++i)
+      msg_.channels[i].values.resize(msg_frames_);
+    pub_.publish(msg_);
+    msg_frames_ = 0;
+  }
+
+  if (trace_)
+  {
+    fclose(trace_);
+    trace_ = NULL;
+  }
+  if (dropped_ > 0)
+    ROS_WARN("Recorder dropped %u frames (namespace: %s)", dropped_, node_.getNamespace().c_str());
+  ROS_DEBUG("Exiting writing loop (namespace: %s)", node_.getNamespace().c_str());
+  is_running_ = false;
 }
 
 }
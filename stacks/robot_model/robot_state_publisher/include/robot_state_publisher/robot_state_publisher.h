@@ -39,6 +39,9 @@
 
 #include <ros/ros.h>
 #include <boost/scoped_ptr.hpp>
+#include <vector>
+#include <map>
+#include <string>
 #include <tf/tf.h>
 #include <tf/tfMessage.h>
 #include "robot_state_publisher/treefksolverposfull_recursive.hpp"
@@ -53,15 +56,46 @@ public:
 
   bool publishTransforms(const std::map<std::string, double>& joint_positions, const ros::Time& time);
 
+  /// Same as above, for joint names and positions as in a joint state message.
+  /// The names are only matched to the joints of the tree when they differ
+  /// from the names of the previous call.
+  bool publishTransforms(const std::vector<std::string>& joint_names,
+                         const std::vector<double>& joint_positions, const ros::Time& time);
+
 private:
+  void setJointLayout(const std::vector<std::string>& joint_names);
+  void publishFixedTransforms(const ros::Time& time);
+
   ros::NodeHandle n_;
   ros::Publisher tf_publisher_;
   KDL::Tree tree_;
   boost::scoped_ptr<KDL::TreeFkSolverPosFull_recursive> solver_;
   std::string root_;
+  int root_index_;
   std::string tf_prefix_;
+
+  // per segment of the solver: tf frame id, and whether its pose relative to
+  // root_ depends on the joint positions
+  std::vector<std::string> frame_ids_;
+  std::vector<bool> moving_;
+
+  // the joint names of the last call, their index in the solver's joints,
+  // and the segments they make available in tf_msg_
+  std::vector<std::string> layout_names_;
+  std::vector<int> layout_;
+  std::vector<int> published_;
+  bool root_present_;
+
+  std::vector<double> jnt_pos_;
+  std::vector<KDL::Frame> link_poses_;
   tf::tfMessage tf_msg_;
 
+  // transforms that never change are republished at a low rate, stamped
+  // with the time of the joint state that triggered them
+  tf::tfMessage tf_fixed_msg_;
+  ros::Duration fixed_period_;
+  ros::Time last_fixed_publish_;
+
   class empty_tree_exception: public std::exception{
     virtual const char* what() const throw(){
       return "Tree is empty";}
@@ -24,6 +24,9 @@
 #define KDLTREEFKSOLVERPOSFULL_RECURSIVE_HPP
 
 #include <kdl/tree.hpp>
+#include <vector>
+#include <map>
+#include <string>
 
 namespace KDL {
 
@@ -36,12 +39,35 @@ public:
 
   int JntToCart(const std::map<std::string, double>& q_in, std::map<std::string, Frame>& p_out);
 
+  /// Poses of all segments, in the order of segmentNames(), for joint
+  /// positions in the order of jointNames(). Segment 0 is the root segment
+  /// and every segment comes after its parent, so this is a single pass
+  /// over flat arrays without any name lookups.
+  int JntToCart(const std::vector<double>& q_in, std::vector<Frame>& p_out);
+
+  const std::vector<std::string>& segmentNames() const {return segment_names;};
+  const std::vector<std::string>& jointNames() const {return joint_names;};
+  /// Index of the parent of each segment, -1 for the root segment
+  const std::vector<int>& parents() const {return parent_indices;};
+  /// Index in jointNames() of the joint of each segment, -1 for fixed joints
+  const std::vector<int>& jointIndices() const {return joint_indices;};
+
 private:
   void addFrameToMap(const std::map<std::string, double>& q_in, std::map<std::string, Frame>& p_out,
                      const Frame& previous_frame, const SegmentMap::const_iterator this_segment);
 
+  void addSegment(const SegmentMap::const_iterator this_segment, int parent,
+                  std::map<std::string, int>& joint_map);
+
   Tree tree;
 
+  // the tree flattened depth-first
+  std::vector<Segment> segments;
+  std::vector<std::string> segment_names;
+  std::vector<int> parent_indices;
+  std::vector<int> joint_indices;
+  std::vector<std::string> joint_names;
+
 };
 }
 
@@ -76,11 +76,7 @@ void JointStateListener::callbackJointState(const JointStateConstPtr& state)
     return;
   }
 
-  // get joint positions from state message
-  map<string, double> joint_positions;
-  for (unsigned int i=0; i<state->name.size(); i++)
-    joint_positions.insert(make_pair(state->name[i], state->position[i]));
-  state_publisher_.publishTransforms(joint_positions, state->header.stamp);
+  state_publisher_.publishTransforms(state->name, state->position, state->header.stamp);
   publish_rate_.sleep();
 }
 
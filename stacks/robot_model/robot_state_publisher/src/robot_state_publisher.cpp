@@ -37,6 +37,7 @@
 #include "robot_state_publisher/robot_state_publisher.h"
 #include <kdl/frames_io.hpp>
 #include <tf_conversions/tf_kdl.h>
+#include <algorithm>
 
 using namespace std;
 using namespace ros;
@@ -47,17 +48,22 @@ using namespace KDL;
 namespace robot_state_publisher{
 
 RobotStatePublisher::RobotStatePublisher(const Tree& tree)
-   :tree_(tree)
+   :tree_(tree), root_present_(false)
 {
   // get tf prefix
   n_.param("~tf_prefix", tf_prefix_, string());
 
+  // get rate for transforms that don't depend on the joint positions
+  double publish_fixed_freq;
+  n_.param("~publish_fixed_frequency", publish_fixed_freq, 2.0);
+  if (publish_fixed_freq > 0.0)
+    fixed_period_ = Duration(1.0 / publish_fixed_freq);
+
   // build tree solver
   solver_.reset(new TreeFkSolverPosFull_recursive(tree_));
 
   // advertise tf message
   tf_publisher_ = n_.advertise<tf::tfMessage>("/tf_message", 5);
-  tf_msg_.transforms.resize(tree.getNrOfSegments()-1);
 
   // get the 'real' root segment of the tree, which is the first child of "root"
   SegmentMap::const_iterator root = tree.getRootSegment();
@@ -65,42 +71,155 @@ RobotStatePublisher::RobotStatePublisher(const Tree& tree)
     throw empty_tree_ex;
 
   root_ = (*root->second.children.begin())->first;
+
+  // resolve frame ids once, and find the segments whose pose relative to
+  // root_ is constant: those connected to it by fixed joints only
+  const vector<string>& segments = solver_->segmentNames();
+  const vector<int>& parents = solver_->parents();
+  const vector<int>& joints = solver_->jointIndices();
+  root_index_ = find(segments.begin(), segments.end(), root_) - segments.begin();
+  frame_ids_.resize(segments.size());
+  moving_.resize(segments.size());
+  for (unsigned int i=0; i<segments.size(); i++){
+    frame_ids_[i] = tf::remap(tf_prefix_, segments[i]);
+    if (parents[i] < 0 || (int)i == root_index_)
+      moving_[i] = false;
+    else if (parents[i] == parents[root_index_])
+      moving_[i] = joints[i] >= 0 || joints[root_index_] >= 0;
+    else
+      moving_[i] = moving_[parents[i]] || joints[i] >= 0;
+  }
+
+  // compute the fixed transforms, for any joint positions
+  jnt_pos_.resize(solver_->jointNames().size(), 0.0);
+  solver_->JntToCart(jnt_pos_, link_poses_);
+  Frame offset = link_poses_[root_index_].Inverse();
+  for (unsigned int i=0; i<segments.size(); i++){
+    if (parents[i] < 0 || (int)i == root_index_ || moving_[i])
+      continue;
+    geometry_msgs::TransformStamped trans;
+    tf::Transform tf_frame;
+    tf::TransformKDLToTF(offset * link_poses_[i], tf_frame);
+    trans.header.frame_id = frame_ids_[root_index_];
+    trans.child_frame_id = frame_ids_[i];
+    tf::transformTFToMsg(tf_frame, trans.transform);
+    tf_fixed_msg_.transforms.push_back(trans);
+  }
+}
+
+
+
+void RobotStatePublisher::setJointLayout(const vector<string>& joint_names)
+{
+  const vector<string>& joints = solver_->jointNames();
+  const vector<int>& parents = solver_->parents();
+  const vector<int>& segment_joints = solver_->jointIndices();
+
+  map<string, int> joint_map;
+  for (unsigned int i=0; i<joints.size(); i++)
+    joint_map.insert(make_pair(joints[i], i));
+
+  layout_names_ = joint_names;
+  layout_.resize(joint_names.size());
+  vector<bool> have_position(joints.size(), false);
+  for (unsigned int i=0; i<joint_names.size(); i++){
+    map<string, int>::const_iterator jnt = joint_map.find(joint_names[i]);
+    layout_[i] = (jnt == joint_map.end()) ? -1 : jnt->second;
+    if (layout_[i] >= 0)
+      have_position[layout_[i]] = true;
+  }
+
+  // a segment is only published if the positions of all joints between it
+  // and the root are known
+  vector<bool> present(parents.size(), false);
+  published_.clear();
+  for (unsigned int i=0; i<parents.size(); i++){
+    present[i] = parents[i] < 0 || present[parents[i]];
+    if (present[i] && segment_joints[i] >= 0 && !have_position[segment_joints[i]]){
+      ROS_WARN("Could not find value for joint %s", joints[segment_joints[i]].c_str());
+      present[i] = false;
+    }
+    if (present[i] && moving_[i])
+      published_.push_back(i);
+  }
+  root_present_ = present[root_index_];
+
+  tf_msg_.transforms.resize(published_.size());
+  for (unsigned int i=0; i<published_.size(); i++){
+    tf_msg_.transforms[i].header.frame_id = frame_ids_[root_index_];
+    tf_msg_.transforms[i].child_frame_id = frame_ids_[published_[i]];
+  }
+}
+
+
+
+void RobotStatePublisher::publishFixedTransforms(const Time& time)
+{
+  if (tf_fixed_msg_.transforms.empty())
+    return;
+
+  // publish once per period, and again if time jumped back (e.g. a bag restarted)
+  if (!last_fixed_publish_.isZero() && time >= last_fixed_publish_ &&
+      time < last_fixed_publish_ + fixed_period_)
+    return;
+  last_fixed_publish_ = time;
+
+  for (unsigned int i=0; i<tf_fixed_msg_.transforms.size(); i++)
+    tf_fixed_msg_.transforms[i].header.stamp = time;
+  tf_publisher_.publish(tf_fixed_msg_);
 }
 
 
 
 bool RobotStatePublisher::publishTransforms(const map<string, double>& joint_positions, const Time& time)
 {
-  // calculate transforms form root to every segment in tree
-  map<string, Frame> link_poses;
-  solver_->JntToCart(joint_positions, link_poses);
+  vector<string> names;
+  vector<double> positions;
+  names.reserve(joint_positions.size());
+  positions.reserve(joint_positions.size());
+  for (map<string, double>::const_iterator jnt=joint_positions.begin(); jnt!=joint_positions.end(); jnt++){
+    names.push_back(jnt->first);
+    positions.push_back(jnt->second);
+  }
+  return publishTransforms(names, positions, time);
+}
 
-  // publish the transforms to tf, converting the transforms from "root" to the 'real' root 
-  geometry_msgs::TransformStamped trans; 
-  map<string, Frame>::const_iterator root = link_poses.find(root_);
-  if (root == link_poses.end()){
+
+
+bool RobotStatePublisher::publishTransforms(const vector<string>& joint_names,
+                                            const vector<double>& joint_positions, const Time& time)
+{
+  if (joint_names.size() != joint_positions.size()){
+    ROS_ERROR("Got %d joint names but %d joint positions", (int)joint_names.size(), (int)joint_positions.size());
+    return false;
+  }
+  if (joint_names != layout_names_)
+    setJointLayout(joint_names);
+
+  if (!root_present_){
     ROS_ERROR("Did not find root of tree");
     return false;
   }
 
-  // remove root from published poses
-  Frame offset = root->second.Inverse();
-  unsigned int i = 0;
-  // send transforms to tf
-  for (map<string, Frame>::const_iterator f=link_poses.begin(); f!=link_poses.end(); f++){
-    if (f != root){
-      Frame frame = offset * f->second;
-      tf::Transform tf_frame;
-      tf::TransformKDLToTF(frame, tf_frame);
-      trans.header.stamp = time;
-      trans.header.frame_id = tf::remap(tf_prefix_, root->first);
-      trans.child_frame_id = tf::remap(tf_prefix_, f->first);
-      tf::transformTFToMsg(tf_frame, trans.transform);
-	tf_msg_.transforms[i++] = trans;
-    }
+  // calculate transforms form root to every segment in tree
+  for (unsigned int i=0; i<layout_.size(); i++)
+    if (layout_[i] >= 0)
+      jnt_pos_[layout_[i]] = joint_positions[i];
+  solver_->JntToCart(jnt_pos_, link_poses_);
+
+  // publish the transforms to tf, converting the transforms from "root" to the 'real' root 
+  Frame offset = link_poses_[root_index_].Inverse();
+  for (unsigned int i=0; i<published_.size(); i++){
+    geometry_msgs::TransformStamped& trans = tf_msg_.transforms[i];
+    tf::Transform tf_frame;
+    tf::TransformKDLToTF(offset * link_poses_[published_[i]], tf_frame);
+    trans.header.stamp = time;
+    tf::transformTFToMsg(tf_frame, trans.transform);
   }
   tf_publisher_.publish(tf_msg_);
 
+  publishFixedTransforms(time);
+
   return true;
 }
 }
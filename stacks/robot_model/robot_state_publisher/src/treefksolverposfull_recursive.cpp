@@ -30,6 +30,8 @@ namespace KDL {
 TreeFkSolverPosFull_recursive::TreeFkSolverPosFull_recursive(const Tree& _tree):
   tree(_tree)
 {
+  map<string, int> joint_map;
+  addSegment(tree.getRootSegment(), -1, joint_map);
 }
 
 TreeFkSolverPosFull_recursive::~TreeFkSolverPosFull_recursive()
@@ -48,6 +50,25 @@ int TreeFkSolverPosFull_recursive::JntToCart(const map<string, double>& q_in, ma
 
 
 
+int TreeFkSolverPosFull_recursive::JntToCart(const vector<double>& q_in, vector<Frame>& p_out)
+{
+  if (q_in.size() != joint_names.size())
+    return -1;
+
+  p_out.resize(segments.size());
+  for (unsigned int i=0; i<segments.size(); i++){
+    double jnt_p = (joint_indices[i] < 0) ? 0 : q_in[joint_indices[i]];
+    if (parent_indices[i] < 0)
+      p_out[i] = segments[i].pose(jnt_p);
+    else
+      p_out[i] = p_out[parent_indices[i]] * segments[i].pose(jnt_p);
+  }
+
+  return 0;
+}
+
+
+
 void TreeFkSolverPosFull_recursive::addFrameToMap(const map<string, double>& q_in, map<string, Frame>& p_out,
                                                   const Frame& previous_frame, const SegmentMap::const_iterator this_segment)
 {
@@ -73,4 +94,33 @@ void TreeFkSolverPosFull_recursive::addFrameToMap(const map<string, double>& q_i
 }
 
 
+
+void TreeFkSolverPosFull_recursive::addSegment(const SegmentMap::const_iterator this_segment, int parent,
+                                               map<string, int>& joint_map)
+{
+  int index = segments.size();
+  const Segment& segment = this_segment->second.segment;
+  segments.push_back(segment);
+  segment_names.push_back(this_segment->first);
+  parent_indices.push_back(parent);
+
+  // segments moved by the same joint share its position
+  int joint = -1;
+  if (segment.getJoint().getType() != Joint::None){
+    map<string, int>::const_iterator jnt = joint_map.find(segment.getJoint().getName());
+    if (jnt == joint_map.end()){
+      joint = joint_names.size();
+      joint_names.push_back(segment.getJoint().getName());
+      joint_map.insert(make_pair(segment.getJoint().getName(), joint));
+    }
+    else
+      joint = jnt->second;
+  }
+  joint_indices.push_back(joint);
+
+  for (vector<SegmentMap::const_iterator>::const_iterator child=this_segment->second.children.begin(); child !=this_segment->second.children.end(); child++)
+    addSegment(*child, index, joint_map);
+}
+
+
 }
@@ -0,0 +1,120 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <string>
+#include <ros/ros.h>
+#include <urdf/model.h>
+#include <kdl_parser/dom_parser.hpp>
+#include <sensor_msgs/JointState.h>
+#include "robot_state_publisher/robot_state_publisher.h"
+
+using namespace std;
+using namespace ros;
+using namespace KDL;
+using namespace robot_state_publisher;
+
+
+// Joint state messages per second through the forward kinematics and the
+// publisher, for the robot model given as argument (e.g. test/pr2.urdf).
+// Run with a master, like the other nodes.
+
+static const unsigned int NUM_MSGS = 10000;
+
+static void report(const char* name, const WallTime& start)
+{
+  double seconds = (WallTime::now() - start).toSec();
+  printf("%-36s %10.0f msgs/s\n", name, NUM_MSGS / seconds);
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "benchmark_robot_state_publisher");
+  NodeHandle node;
+
+  if (argc < 2){
+    printf("Usage: %s robot.urdf\n", argv[0]);
+    return -1;
+  }
+  urdf::Model robot_model;
+  Tree tree;
+  if (!robot_model.initFile(argv[1]) || !kdl_parser::treeFromRobotModel(robot_model, tree)){
+    ROS_ERROR("Failed to extract kdl tree from %s", argv[1]);
+    return -1;
+  }
+
+  // a joint state message with all joints of the tree
+  TreeFkSolverPosFull_recursive solver(tree);
+  sensor_msgs::JointState state;
+  state.name = solver.jointNames();
+  state.position.resize(state.name.size());
+  for (unsigned int i=0; i<state.position.size(); i++)
+    state.position[i] = 0.01 * i;
+  printf("%d segments, %d joints, %d messages\n", (int)solver.segmentNames().size(),
+         (int)state.name.size(), NUM_MSGS);
+
+  WallTime start = WallTime::now();
+  map<string, Frame> link_poses;
+  for (unsigned int m=0; m<NUM_MSGS; m++){
+    map<string, double> joint_positions;
+    for (unsigned int i=0; i<state.name.size(); i++)
+      joint_positions.insert(make_pair(state.name[i], state.position[i]));
+    solver.JntToCart(joint_positions, link_poses);
+  }
+  report("FK, by name", start);
+
+  start = WallTime::now();
+  vector<Frame> link_frames;
+  for (unsigned int m=0; m<NUM_MSGS; m++)
+    solver.JntToCart(state.position, link_frames);
+  report("FK, compiled", start);
+
+  RobotStatePublisher publisher(tree);
+  Time time = Time::now();
+
+  start = WallTime::now();
+  for (unsigned int m=0; m<NUM_MSGS; m++){
+    map<string, double> joint_positions;
+    for (unsigned int i=0; i<state.name.size(); i++)
+      joint_positions.insert(make_pair(state.name[i], state.position[i]));
+    publisher.publishTransforms(joint_positions, time + Duration(0.001 * m));
+  }
+  report("publishTransforms, by name", start);
+
+  start = WallTime::now();
+  for (unsigned int m=0; m<NUM_MSGS; m++)
+    publisher.publishTransforms(state.name, state.position, time + Duration(0.001 * m));
+  report("publishTransforms, joint state", start);
+
+  return 0;
+}
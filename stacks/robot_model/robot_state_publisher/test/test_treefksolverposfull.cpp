@@ -0,0 +1,173 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2008, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <kdl/tree.hpp>
+#include <kdl_parser/dom_parser.hpp>
+#include "robot_state_publisher/treefksolverposfull_recursive.hpp"
+
+
+using namespace std;
+using namespace KDL;
+
+#define EPS 1e-9
+
+
+class TestTreeFkSolver : public testing::Test
+{
+public:
+  Tree tree;
+  TreeFkSolverPosFull_recursive* solver;
+
+  // random positions for all joints, both as a map and in the order of jointNames()
+  map<string, double> q_map;
+  vector<double> q_vec;
+
+protected:
+  TestTreeFkSolver()
+  {
+    if (!kdl_parser::treeFromFile("test/pr2.urdf", tree))
+      ADD_FAILURE() << "Failed to extract kdl tree from test/pr2.urdf";
+    solver = new TreeFkSolverPosFull_recursive(tree);
+
+    srand(0);
+    const vector<string>& joints = solver->jointNames();
+    for (unsigned int i=0; i<joints.size(); i++){
+      q_vec.push_back(2.0 * rand() / (double)RAND_MAX - 1.0);
+      q_map[joints[i]] = q_vec.back();
+    }
+  }
+
+  ~TestTreeFkSolver()
+  {
+    delete solver;
+  }
+};
+
+
+
+// the flattened solver computes the same pose for every segment as the
+// recursive, map based one
+TEST_F(TestTreeFkSolver, flatMatchesMap)
+{
+  const vector<string>& segments = solver->segmentNames();
+  ASSERT_EQ(tree.getNrOfSegments() + 1, segments.size());
+  ASSERT_EQ(tree.getNrOfJoints(), solver->jointNames().size());
+  EXPECT_EQ(tree.getRootSegment()->first, segments[0]);
+
+  map<string, Frame> p_map;
+  vector<Frame> p_vec;
+  ASSERT_EQ(0, solver->JntToCart(q_map, p_map));
+  ASSERT_EQ(0, solver->JntToCart(q_vec, p_vec));
+  ASSERT_EQ(segments.size(), p_vec.size());
+
+  // the map leaves out the root segment
+  EXPECT_EQ(segments.size() - 1, p_map.size());
+  for (unsigned int i=1; i<segments.size(); i++){
+    map<string, Frame>::const_iterator pose = p_map.find(segments[i]);
+    ASSERT_TRUE(pose != p_map.end()) << segments[i];
+    EXPECT_TRUE(Equal(pose->second, p_vec[i], EPS)) << segments[i];
+  }
+}
+
+
+
+// a joint missing from the message hides the segments below it; the
+// publisher finds them from parents() and jointIndices(), and all other
+// segments have the same pose as in the map based solver
+TEST_F(TestTreeFkSolver, missingJoint)
+{
+  const string missing = "r_shoulder_pan_joint";
+  ASSERT_EQ(1u, q_map.erase(missing));
+
+  map<string, Frame> p_map;
+  vector<Frame> p_vec;
+  ASSERT_EQ(0, solver->JntToCart(q_map, p_map));
+  ASSERT_EQ(0, solver->JntToCart(q_vec, p_vec));
+
+  const vector<string>& segments = solver->segmentNames();
+  const vector<string>& joints = solver->jointNames();
+  const vector<int>& parents = solver->parents();
+  const vector<int>& segment_joints = solver->jointIndices();
+  ASSERT_EQ(segments.size(), parents.size());
+  ASSERT_EQ(segments.size(), segment_joints.size());
+
+  vector<bool> present(segments.size(), false);
+  unsigned int hidden = 0;
+  for (unsigned int i=0; i<segments.size(); i++){
+    if (parents[i] >= 0)
+      ASSERT_LT(parents[i], (int)i) << segments[i];
+    present[i] = parents[i] < 0 || present[parents[i]];
+    if (present[i] && segment_joints[i] >= 0 && joints[segment_joints[i]] == missing)
+      present[i] = false;
+    if (i == 0)
+      continue;
+
+    map<string, Frame>::const_iterator pose = p_map.find(segments[i]);
+    if (present[i]){
+      ASSERT_TRUE(pose != p_map.end()) << segments[i];
+      EXPECT_TRUE(Equal(pose->second, p_vec[i], EPS)) << segments[i];
+    }
+    else{
+      EXPECT_TRUE(pose == p_map.end()) << segments[i];
+      hidden++;
+    }
+  }
+  EXPECT_GT(hidden, 1u);
+  EXPECT_TRUE(p_map.find("r_gripper_palm_link") == p_map.end());
+  EXPECT_TRUE(p_map.find("l_gripper_palm_link") != p_map.end());
+}
+
+
+
+// the flattened solver only takes a position for every joint
+TEST_F(TestTreeFkSolver, wrongSize)
+{
+  vector<Frame> p_vec;
+  q_vec.pop_back();
+  EXPECT_EQ(-1, solver->JntToCart(q_vec, p_vec));
+}
+
+
+
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -91,6 +91,80 @@ inline int L1Distance_176(const uint8_t *s1, const uint8_t *s2)
 #endif
 }
 
+// L1 distance with early termination: gives up as soon as the partial
+// sum exceeds bound, and returns that partial sum. A result <= bound is
+// the exact distance.
+// s2 must be 16-byte aligned, s1 need not be
+inline int L1Distance_176(const uint8_t *s1, const uint8_t *s2, int bound)
+{
+#ifdef __SSE2__
+  __m128i acc, *acc2;
+  acc2 = (__m128i *)s2;
+
+  // first 64 bytes, then check
+  acc = _mm_sad_epu8(_mm_loadu_si128((__m128i *)s1), acc2[0]);
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+16)), acc2[1]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+32)), acc2[2]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+48)), acc2[3]));
+  int partial = _mm_cvtsi128_si32(_mm_add_epi16(acc, _mm_srli_si128(acc, 8)));
+  if (partial > bound)
+    return partial;
+
+  // next 64 bytes, then check
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+64)), acc2[4]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+80)), acc2[5]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+96)), acc2[6]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+112)), acc2[7]));
+  partial = _mm_cvtsi128_si32(_mm_add_epi16(acc, _mm_srli_si128(acc, 8)));
+  if (partial > bound)
+    return partial;
+
+  // last 48 bytes
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+128)), acc2[8]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+144)), acc2[9]));
+  acc = _mm_add_epi16(acc, _mm_sad_epu8(_mm_loadu_si128((__m128i *)(s1+160)), acc2[10]));
+
+  acc = _mm_add_epi16(acc, _mm_srli_si128(acc, 8)); // add both halves
+  return _mm_cvtsi128_si32(acc);
+#else
+  return L1Distance(176, s1, s2);
+#endif
+}
+
+// L1 distance with early termination, as above; the check is done every
+// 32 elements
+inline float L1Distance(int size, const float* a, const float* b, float bound)
+{
+#ifdef __SSE2__
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 acc = _mm_setzero_ps();
+  __m128 sum;
+  float result;
+  int i = 0;
+  while (i + 32 <= size) {
+    for (int end = i + 32; i < end; i += 4)
+      acc = _mm_add_ps(acc, _mm_and_ps(abs_mask,
+                                       _mm_sub_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i))));
+    sum = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    _mm_store_ss(&result, sum);
+    if (result > bound)
+      return result;
+  }
+  for (; i + 4 <= size; i += 4)
+    acc = _mm_add_ps(acc, _mm_and_ps(abs_mask,
+                                     _mm_sub_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i))));
+  sum = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  _mm_store_ss(&result, sum);
+  for (; i < size; ++i)
+    result += fabs(a[i] - b[i]);
+  return result;
+#else
+  return L1Distance(size, a, b);
+#endif
+}
+
 // sum up 50 byte vectors of length 176
 // assume 4 bits max for input vector values
 // final shift is 2 bits right
@@ -126,7 +200,7 @@ inline void sum_50t_176c(uint8_t **pp, uint8_t *sig, uint16_t *temp)
 	  // add next four columns
 	  acc = _mm_adds_epu8(acc1[0],acc2[0]);
 	  acc = _mm_adds_epu8(acc,acc3[0]);
-	  acc = _mm_adds_epu8(acc,acc4[1]);
+	  acc = _mm_adds_epu8(acc,acc4[0]);
 	  ssig[0] = _mm_adds_epu8(acc,ssig[0]);
 	  // add four columns
 	  acc = _mm_adds_epu8(acc1[1],acc2[1]);
@@ -235,6 +309,10 @@ template<> struct L1DistanceFunc<float>
   inline float operator()(const float* a, const float* b) const {
     return L1Distance(dim, a, b);
   }
+  // stops early once the distance exceeds bound
+  inline float operator()(const float* a, const float* b, float bound) const {
+    return L1Distance(dim, a, b, bound);
+  }
 };
 
 // TODO: currently assumes dimension == 176
@@ -245,6 +323,10 @@ template<> struct L1DistanceFunc<uint8_t>
     return L1Distance_176(a, b);
     //return L1Distance(128, a, b);
   }
+  // stops early once the distance exceeds bound, b must be aligned
+  inline int operator()(const uint8_t* a, const uint8_t* b, int bound) const {
+    return L1Distance_176(a, b, bound);
+  }
 };
 
 inline float L2Distance(int size, const float* a, const float* b)
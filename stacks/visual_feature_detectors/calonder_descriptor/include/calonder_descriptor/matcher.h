@@ -6,6 +6,9 @@
 #include <limits>
 #include <vector>
 #include <utility>
+#include <cstring>
+#include <cstdlib>
+#include <new>
 #include <boost/foreach.hpp>
 
 namespace features {
@@ -206,6 +209,280 @@ int BruteForceMatcher<SigElem, Data>::findMatches(const SigElem* query_sig,
   return best_match;
 }
 
+// Matcher for image features, where most queries are limited to a window
+// around the predicted position (e.g. frame to frame matching in VO).
+// Signatures are copied into one 16-byte aligned buffer, and their indices
+// are bucketed in a grid of cell_size x cell_size pixel cells, so that
+// findMatchInWindow only looks at the cells overlapping the window.
+// Distances are computed with early termination once a candidate can't
+// beat the current best.
+// Data must have x and y members (CvPoint, Keypoint...). Matches and
+// indices are the same as for BruteForceMatcher.
+template < typename SigElem, typename Data >
+class GridMatcher
+{
+public:
+  typedef typename Promote<SigElem>::type distance_type;
+
+  GridMatcher(size_t signature_dimension, CvSize image_size, int cell_size = 32);
+  ~GridMatcher();
+
+  // GridMatcher copies the signature
+  void addSignature(const SigElem* signature, Data const& data);
+  // removes all signatures, keeping the memory
+  void clear();
+
+  size_t numSignatures() const;
+
+  const SigElem* getSignature(int index) const;
+  Data& getData(int index);
+  const Data& getData(int index) const;
+
+  int findMatch(const SigElem* signature, distance_type *distance) const;
+
+  int findMatchInWindow(const SigElem* signature, CvRect window,
+                        distance_type *distance) const;
+  int findMatchPredicated(const SigElem* signature, char *predicates,
+                          distance_type *distance) const;
+
+  // Returns top two matches, useful for ratio test
+  int findMatches(const SigElem* signature, distance_type *d1, int *second,
+                  distance_type *d2) const;
+
+private:
+  // keeps the lower index on ties, as a linear scan does
+  inline void testCandidate(const SigElem* signature, int index,
+                            distance_type *best_distance, int *match) const;
+  inline int cellIndex(int x, int y) const;
+
+  SigElem* sigs_;               // 16-bytes aligned, stride_ elements apart
+  size_t stride_;
+  size_t capacity_;
+  std::vector< Data > data_;
+  std::vector< std::vector<int> > cells_;
+  int cell_size_, grid_cols_, grid_rows_;
+  distance_type threshold_;
+  size_t dimension_;
+  L1DistanceFunc<SigElem> distance_func;
+
+  // owns its buffer, no copies
+  GridMatcher(const GridMatcher&);
+  GridMatcher& operator=(const GridMatcher&);
+};
+
+template < typename SigElem, typename Data >
+inline
+GridMatcher<SigElem, Data>::GridMatcher(size_t signature_dimension,
+                                        CvSize image_size, int cell_size)
+  : sigs_(NULL),
+    capacity_(0),
+    cell_size_(cell_size),
+    grid_cols_((image_size.width + cell_size - 1) / cell_size),
+    grid_rows_((image_size.height + cell_size - 1) / cell_size),
+    threshold_(std::numeric_limits<distance_type>::max()),
+    dimension_(signature_dimension),
+    distance_func(signature_dimension)
+{
+  // round rows up to 16 bytes
+  size_t per_row = 16 / sizeof(SigElem);
+  stride_ = (signature_dimension + per_row - 1) / per_row * per_row;
+  if (grid_cols_ < 1) grid_cols_ = 1;
+  if (grid_rows_ < 1) grid_rows_ = 1;
+  cells_.resize(grid_cols_ * grid_rows_);
+}
+
+template < typename SigElem, typename Data >
+inline
+GridMatcher<SigElem, Data>::~GridMatcher()
+{
+  free(sigs_);
+}
+
+template < typename SigElem, typename Data >
+inline
+int GridMatcher<SigElem, Data>::cellIndex(int x, int y) const
+{
+  int col = x / cell_size_, row = y / cell_size_;
+  col = col < 0 ? 0 : (col >= grid_cols_ ? grid_cols_ - 1 : col);
+  row = row < 0 ? 0 : (row >= grid_rows_ ? grid_rows_ - 1 : row);
+  return row * grid_cols_ + col;
+}
+
+template < typename SigElem, typename Data >
+inline
+void GridMatcher<SigElem, Data>::addSignature(const SigElem* signature,
+                                              Data const& data)
+{
+  size_t index = data_.size();
+  if (index == capacity_) {
+    size_t capacity = capacity_ ? 2*capacity_ : 256;
+    SigElem* sigs = NULL;
+    if (posix_memalign(reinterpret_cast<void**>(&sigs), 16,
+                       capacity * stride_ * sizeof(SigElem)) != 0)
+      throw std::bad_alloc();
+    if (sigs_)
+      memcpy(sigs, sigs_, index * stride_ * sizeof(SigElem));
+    free(sigs_);
+    sigs_ = sigs;
+    capacity_ = capacity;
+  }
+  SigElem* dst = sigs_ + index * stride_;
+  memcpy(dst, signature, dimension_ * sizeof(SigElem));
+  memset(dst + dimension_, 0, (stride_ - dimension_) * sizeof(SigElem));
+
+  data_.push_back(data);
+  cells_[cellIndex(data.x, data.y)].push_back(index);
+}
+
+template < typename SigElem, typename Data >
+inline
+void GridMatcher<SigElem, Data>::clear()
+{
+  data_.clear();
+  BOOST_FOREACH( std::vector<int>& cell, cells_ )
+    cell.clear();
+}
+
+template < typename SigElem, typename Data >
+inline
+size_t GridMatcher<SigElem, Data>::numSignatures() const
+{
+  return data_.size();
+}
+
+template < typename SigElem, typename Data >
+inline
+const SigElem* GridMatcher<SigElem, Data>::getSignature(int index) const
+{
+  return sigs_ + index * stride_;
+}
+
+template < typename SigElem, typename Data >
+inline
+Data& GridMatcher<SigElem, Data>::getData(int index)
+{
+  return data_[index];
+}
+
+template < typename SigElem, typename Data >
+inline
+const Data& GridMatcher<SigElem, Data>::getData(int index) const
+{
+  return data_[index];
+}
+
+template < typename SigElem, typename Data >
+inline
+void GridMatcher<SigElem, Data>::testCandidate(const SigElem* signature, int index,
+                                               distance_type *best_distance,
+                                               int *match) const
+{
+  distance_type next_distance = distance_func(signature, sigs_ + index * stride_,
+                                              *best_distance);
+  if (next_distance < *best_distance ||
+      (next_distance == *best_distance && *match > index)) {
+    *best_distance = next_distance;
+    *match = index;
+  }
+}
+
+template < typename SigElem, typename Data >
+inline
+int GridMatcher<SigElem, Data>::findMatch(const SigElem* signature,
+                                          distance_type *distance) const
+{
+  int match = -1;
+  distance_type best_distance = threshold_;
+
+  for (int i = 0; i < (int)data_.size(); ++i)
+    testCandidate(signature, i, &best_distance, &match);
+
+  *distance = best_distance;
+  return match;
+}
+
+template < typename SigElem, typename Data >
+inline
+int GridMatcher<SigElem, Data>::findMatchInWindow(const SigElem* signature,
+                                                  CvRect window,
+                                                  distance_type *distance) const
+{
+  int match = -1;
+  distance_type best_distance = threshold_;
+
+  if (window.width > 0 && window.height > 0) {
+    int first = cellIndex(window.x, window.y);
+    int last = cellIndex(window.x + window.width - 1, window.y + window.height - 1);
+    int col0 = first % grid_cols_, col1 = last % grid_cols_;
+    for (int row = first / grid_cols_; row <= last / grid_cols_; ++row) {
+      for (int col = col0; col <= col1; ++col) {
+        BOOST_FOREACH( int i, cells_[row * grid_cols_ + col] ) {
+          Data const& data = data_[i];
+          if (data.x < window.x || data.y < window.y ||
+              data.x >= window.x + window.width ||
+              data.y >= window.y + window.height)
+            continue;
+          testCandidate(signature, i, &best_distance, &match);
+        }
+      }
+    }
+  }
+
+  *distance = best_distance;
+  return match;
+}
+
+template < typename SigElem, typename Data >
+inline
+int GridMatcher<SigElem, Data>::findMatchPredicated(const SigElem* signature,
+                                                    char *predicates,
+                                                    distance_type *distance) const
+{
+  int match = -1;
+  distance_type best_distance = threshold_;
+
+  for (int i = 0; i < (int)data_.size(); ++i) {
+    if (predicates[i])
+      testCandidate(signature, i, &best_distance, &match);
+  }
+
+  *distance = best_distance;
+  return match;
+}
+
+template < typename SigElem, typename Data >
+inline
+int GridMatcher<SigElem, Data>::findMatches(const SigElem* signature,
+                                            distance_type *d1, int *second,
+                                            distance_type *d2) const
+{
+  int best_match = -1;
+  distance_type best_distance = threshold_;
+  int second_match = -1;
+  distance_type second_distance = threshold_;
+
+  for (int i = 0; i < (int)data_.size(); ++i) {
+    // only needs to beat the second best
+    distance_type next_distance = distance_func(signature, sigs_ + i * stride_,
+                                                second_distance);
+    if (next_distance < best_distance) {
+      second_distance = best_distance;
+      second_match = best_match;
+      best_distance = next_distance;
+      best_match = i;
+    } else if (next_distance < second_distance) {
+      second_distance = next_distance;
+      second_match = i;
+    }
+  }
+
+  *d1 = best_distance;
+  *second = second_match;
+  *d2 = second_distance;
+
+  return best_match;
+}
+
 } // namespace features
 
 #endif
@@ -105,6 +105,9 @@ private:
   void addExample(int class_id, uchar* patch_data);
   void finalize(size_t reduced_num_dim, int num_quant_bits);  
   int getIndex(uchar* patch_data) const;
+  // Leaf indices of num patches stored one after the other, written to
+  // indices[0], indices[stride], ...
+  void getIndices(uchar* patches, int num, int* indices, int stride) const;
   inline float* getPosteriorByIndex(int index);
   inline uint8_t* getPosteriorByIndex2(int index);
   inline const float* getPosteriorByIndex(int index) const;
@@ -3,6 +3,7 @@
 
 #include "calonder_descriptor/randomized_tree.h"
 #include "calonder_descriptor/basic_math.h"
+#include <vector>
 
 class RTTester;
 
@@ -14,6 +15,7 @@ public:
   friend class ::RTTester;
   static const int DEFAULT_TREES = 48;
   static const size_t DEFAULT_NUM_QUANT_BITS = 4;  
+  static const int SIGNATURE_BATCH = 16; // patches getSignatures() walks the trees with at once
     
   RTreeClassifier();
 
@@ -36,6 +38,13 @@ public:
   // sig must point to a memory block of at least classes()*sizeof(float|uint8_t) bytes
   void getSignature(IplImage *patch, uint8_t *sig);
   void getSignature(IplImage *patch, float *sig);
+  // Signatures of the PATCH_SIZE x PATCH_SIZE patches centered on each point,
+  // as getSignature() on extractPatch() gives them. The patches must lie inside
+  // the image. sigs must hold num_pts*classes() bytes and be 16-byte aligned,
+  // see safeSignatureAlloc(). The points are split across threads() threads.
+  void getSignatures(IplImage *image, const CvPoint *centers, int num_pts, uint8_t *sigs);
+  template < typename PointIterator >
+  void getSignatures(IplImage *image, PointIterator begin, PointIterator end, uint8_t *sigs);
   void getSparseSignature(IplImage *patch, float *sig, float thresh);
   // TODO: deprecated in favor of getSignature overload, remove
   void getFloatSignature(IplImage *patch, float *sig) { getSignature(patch, sig); }
@@ -46,6 +55,9 @@ public:
     
   inline int classes() { return classes_; }
   inline int original_num_classes() { return original_num_classes_; }
+
+  inline int threads() const { return threads_; }
+  void setThreads(int n);
   
   void setQuantization(int num_quant_bits);
   void discardFloatPosteriors();
@@ -64,14 +76,39 @@ public:
   std::vector<RandomizedTree> trees_;
 
 private:    
+  // Aligned buffers used to compute signatures, one set per thread
+  struct SignatureScratch
+  {
+    uchar *patches;         // SIGNATURE_BATCH patches without row padding
+    uint16_t *sum;          // temporary of sum_50t_176c
+    int *leaves;            // leaf reached in each tree, for each patch
+    uint8_t **posteriors;   // posteriors of one patch
+  };
+
   int classes_;
   int num_quant_bits_;
-  uint8_t **posteriors_;
-  uint16_t *ptemp_;
   int original_num_classes_;  
   bool keep_floats_;
+  int threads_;
+  std::vector<uint8_t> scratch_memory_;
+  std::vector<CvPoint> centers_;
+
+  size_t scratchBytes() const;
+  void allocScratch(int num_threads);
+  SignatureScratch getScratch(int thread);
+  void computeSignatures(int thread, IplImage *image, const CvPoint *centers,
+                         int num_pts, uint8_t *sigs);
 };
 
+template < typename PointIterator >
+void RTreeClassifier::getSignatures(IplImage *image, PointIterator begin, PointIterator end, uint8_t *sigs)
+{
+  centers_.clear();
+  for (; begin != end; ++begin)
+    centers_.push_back(cvPoint(begin->x, begin->y));
+  getSignatures(image, centers_.empty() ? NULL : &centers_[0], centers_.size(), sigs);
+}
+
 // Returns 16-byte aligned signatures that can be passed to getSignature().
 // Release by calling free() - NOT delete!
 //
@@ -379,37 +379,60 @@ PyObject *getSignatures(PyObject *self, PyObject *args)
   int imgdata_size, w, h;
   if (!PyArg_ParseTuple(args, "(ii)s#O", &w, &h, &imgdata, &imgdata_size, &coords))
     return NULL;
+  if (w <= 0 || h <= 0 || imgdata_size < w * h) {
+    PyErr_SetString(PyExc_ValueError, "Image data is smaller than its width * height");
+    return NULL;
+  }
 
-  IplImage *cva = cvCreateImageHeader(cvSize(w, h), IPL_DEPTH_8U, 1);
-  cvSetData(cva, imgdata, w);
-  IplImage *input = cvCreateImage(cvSize(32, 32), IPL_DEPTH_8U, 1);
-
+  // getSignatures reads the patches without bounds checks, so every patch
+  // must be inside the image
+  static const int offset = RandomizedTree::PATCH_SIZE / 2;
   PyObject *fi = PySequence_Fast(coords, "coords");
   if (fi == NULL)
     return NULL;
-  PyObject *r = PyList_New(PySequence_Fast_GET_SIZE(fi));
-  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(fi); i++) {
+  Py_ssize_t num_pts = PySequence_Fast_GET_SIZE(fi);
+  std::vector<CvPoint> centers(num_pts);
+  for (Py_ssize_t i = 0; i < num_pts; i++) {
     PyObject *t = PySequence_Fast_GET_ITEM(fi, i);
-    if (!PyTuple_Check(t)) {
+    if (!PyTuple_Check(t) || PyTuple_GET_SIZE(t) < 2) {
       PyErr_SetString(PyExc_TypeError, "Expected tuple");
+      Py_DECREF(fi);
       return NULL;
     }
-    int x, y;
-    x = PyInt_AS_LONG(PyTuple_GET_ITEM(t, 0));
-    y = PyInt_AS_LONG(PyTuple_GET_ITEM(t, 1));
+    int x = PyInt_AsLong(PyTuple_GET_ITEM(t, 0));
+    int y = PyInt_AsLong(PyTuple_GET_ITEM(t, 1));
+    if (PyErr_Occurred()) {
+      Py_DECREF(fi);
+      return NULL;
+    }
+    if (x < offset || x > w - offset || y < offset || y > h - offset) {
+      PyErr_Format(PyExc_ValueError, "The patch around keypoint (%d, %d) is not inside the %dx%d image",
+                   x, y, w, h);
+      Py_DECREF(fi);
+      return NULL;
+    }
+    centers[i].x = x;
+    centers[i].y = y;
+  }
+  Py_DECREF(fi);
 
-    cvSetImageROI(cva, cvRect(x - 16, y - 16, 32, 32));
-    cvCopy(cva, input);
+  // All signatures in one call, then copied into the signature objects
+  IplImage *cva = cvCreateImageHeader(cvSize(w, h), IPL_DEPTH_8U, 1);
+  cvSetData(cva, imgdata, w);
+  int size = pc->classifier->classes();
+  uint8_t *sigs = RTreeClassifier::safeSignatureAlloc(std::max((int)num_pts, 1), size);
+  pc->classifier->getSignatures(cva, num_pts ? &centers[0] : NULL, num_pts, sigs);
+  cvReleaseImageHeader(&cva);
 
+  PyObject *r = PyList_New(num_pts);
+  for (Py_ssize_t i = 0; i < num_pts; i++) {
     signature_t *object = PyObject_NEW(signature_t, &signature_Type);
-    object->size = pc->classifier->classes();
+    object->size = size;
     posix_memalign((void**)&object->data, 16, object->size * sizeof(SigType));
-    pc->classifier->getSignature(input, object->data);
+    memcpy(object->data, sigs + i * size, size * sizeof(SigType));
     PyList_SET_ITEM(r, i, (PyObject*)object);
   }
-  Py_DECREF(fi);
-  cvReleaseImage(&input);
-  cvReleaseImageHeader(&cva);
+  free(sigs);
   return r;
 }
 
@@ -42,6 +42,31 @@ int RandomizedTree::getIndex(uchar* patch_data) const
   return index - nodes_.size();
 }
 
+void RandomizedTree::getIndices(uchar* patches, int num, int* indices, int stride) const
+{
+  static const int PATCH_BYTES = PATCH_SIZE * PATCH_SIZE;
+  const int first_leaf = nodes_.size();
+  int i = 0;
+  // Four patches at a time; the walks are independent, so their loads overlap
+  for (; i + 4 <= num; i += 4) {
+    uchar *p0 = patches + i*PATCH_BYTES;
+    uchar *p1 = p0 + PATCH_BYTES, *p2 = p1 + PATCH_BYTES, *p3 = p2 + PATCH_BYTES;
+    int index0 = 0, index1 = 0, index2 = 0, index3 = 0;
+    for (int d = 0; d < depth_; ++d) {
+      index0 = 2*index0 + 1 + nodes_[index0](p0);
+      index1 = 2*index1 + 1 + nodes_[index1](p1);
+      index2 = 2*index2 + 1 + nodes_[index2](p2);
+      index3 = 2*index3 + 1 + nodes_[index3](p3);
+    }
+    indices[i*stride] = index0 - first_leaf;
+    indices[(i+1)*stride] = index1 - first_leaf;
+    indices[(i+2)*stride] = index2 - first_leaf;
+    indices[(i+3)*stride] = index3 - first_leaf;
+  }
+  for (; i < num; ++i)
+    indices[i*stride] = getIndex(patches + i*PATCH_BYTES);
+}
+
 void RandomizedTree::train(std::vector<BaseKeypoint> const& base_set,
                            Rng &rng, int depth, int views, size_t reduced_num_dim,
                            int num_quant_bits)
@@ -3,15 +3,16 @@
 #include <fstream>
 #include <cstring>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <cmath>
 
 namespace features {
 
 
 RTreeClassifier::RTreeClassifier()
-  : classes_(0)
+  : classes_(0), threads_(1)
 {
-  posteriors_ = NULL;  
 }
 
 void RTreeClassifier::train(std::vector<BaseKeypoint> const& base_set,
@@ -79,21 +80,12 @@ void RTreeClassifier::getSignature(IplImage* patch, float *sig)
   memset((void*)sig, 0, classes_ * sizeof(float));
   std::vector<RandomizedTree>::iterator tree_it;
  
-  // get posteriors
-  float **posteriors = new float*[trees_.size()];  // TODO: move alloc outside this func
-  float **pp = posteriors;    
-  for (tree_it = trees_.begin(); tree_it != trees_.end(); ++tree_it, pp++) {
-    *pp = tree_it->getPosterior(patch_data);       
-    assert(*pp != NULL);
+  // get posteriors and sum them up
+  for (tree_it = trees_.begin(); tree_it != trees_.end(); ++tree_it) {
+    float *posterior = tree_it->getPosterior(patch_data);
+    assert(posterior != NULL);
+    add(classes_, sig, posterior, sig);
   }
-
-  // sum them up
-  pp = posteriors;
-  for (tree_it = trees_.begin(); tree_it != trees_.end(); ++tree_it, pp++)
-    add(classes_, sig, *pp, sig);
-
-  delete [] posteriors;
-  posteriors = NULL;
       
   // full quantization (experimental)
   #if 0
@@ -153,23 +145,20 @@ void RTreeClassifier::getSignature(IplImage* patch, uint8_t *sig)
   std::vector<RandomizedTree>::iterator tree_it;
  
   // get posteriors
-  if (posteriors_ == NULL)
-    {
-      posteriors_ = new uint8_t*[trees_.size()];  
-      posix_memalign((void **)&ptemp_, 16, classes_*sizeof(uint16_t));
-    }
-  uint8_t **pp = posteriors_;    
+  allocScratch(1);
+  SignatureScratch scratch = getScratch(0);
+  uint8_t **pp = scratch.posteriors;
   for (tree_it = trees_.begin(); tree_it != trees_.end(); ++tree_it, pp++)
     *pp = tree_it->getPosterior2(patch_data);       
-  pp = posteriors_;
+  pp = scratch.posteriors;
 
    #if 1    // SSE2 optimized code     
-     sum_50t_176c(pp, sig, ptemp_);    // sum them up  
+     sum_50t_176c(pp, sig, scratch.sum);    // sum them up  
    #else
      static bool warned = false;
      
      memset((void*)sig, 0, classes_ * sizeof(sig[0]));
-     uint16_t *sig16 = new uint16_t[classes_];           // TODO: make member, no alloc here
+     uint16_t *sig16 = scratch.sum;
      memset((void*)sig16, 0, classes_ * sizeof(sig16[0]));
      for (tree_it = trees_.begin(); tree_it != trees_.end(); ++tree_it, pp++)
        add(classes_, sig16, *pp, sig16);
@@ -203,6 +192,109 @@ void RTreeClassifier::getSignature(IplImage* patch, uint8_t *sig)
 }
 
 
+void RTreeClassifier::getSignatures(IplImage *image, const CvPoint *centers, int num_pts, uint8_t *sigs)
+{
+  // Don't start threads for less than a batch of points each
+  int num_threads = std::min(threads_, (num_pts + SIGNATURE_BATCH - 1) / SIGNATURE_BATCH);
+  num_threads = std::max(num_threads, 1);
+  allocScratch(num_threads);
+
+  boost::thread_group threads;
+  for (int i = 0; i < num_threads; ++i) {
+    int begin = num_pts * i / num_threads;
+    int end = num_pts * (i + 1) / num_threads;
+    // classes_ is a multiple of 16, so each thread's signatures stay aligned
+    boost::function<void()> task = boost::bind(&RTreeClassifier::computeSignatures, this, i, image,
+                                               centers + begin, end - begin, sigs + begin * classes_);
+    if (i == num_threads - 1)
+      task();                   // last chunk on this thread
+    else
+      threads.create_thread(task);
+  }
+  threads.join_all();
+}
+
+void RTreeClassifier::computeSignatures(int thread, IplImage *image, const CvPoint *centers,
+                                        int num_pts, uint8_t *sigs)
+{
+  static const int PATCH_SIZE = RandomizedTree::PATCH_SIZE;
+  const int num_trees = trees_.size();
+  SignatureScratch scratch = getScratch(thread);
+
+  for (int first = 0; first < num_pts; first += SIGNATURE_BATCH) {
+    int batch = std::min(SIGNATURE_BATCH, num_pts - first);
+
+    // Copy the patches next to each other, without row padding
+    for (int i = 0; i < batch; ++i) {
+      const CvPoint &center = centers[first + i];
+      const uchar *src = getData(image) + (center.y - PATCH_SIZE/2) * image->widthStep
+        + center.x - PATCH_SIZE/2;
+      uchar *dst = scratch.patches + i * PATCH_SIZE * PATCH_SIZE;
+      for (int row = 0; row < PATCH_SIZE; ++row, src += image->widthStep, dst += PATCH_SIZE)
+        memcpy(dst, src, PATCH_SIZE);
+    }
+
+    // Drop the whole batch down each tree in turn, so the nodes of a tree are
+    // only loaded once per batch
+    for (int t = 0; t < num_trees; ++t)
+      trees_[t].getIndices(scratch.patches, batch, scratch.leaves + t, num_trees);
+
+    for (int i = 0; i < batch; ++i) {
+      const int *leaves = scratch.leaves + i * num_trees;
+      for (int t = 0; t < num_trees; ++t)
+        scratch.posteriors[t] = trees_[t].getPosteriorByIndex2(leaves[t]);
+      sum_50t_176c(scratch.posteriors, sigs + (first + i) * classes_, scratch.sum);
+    }
+  }
+}
+
+// Layout of the scratch memory of one thread: patches, sum, leaves,
+// posteriors, each part starting 16-byte aligned
+static inline size_t alignTo16(size_t bytes)
+{
+  return (bytes + 15) & ~size_t(15);
+}
+
+size_t RTreeClassifier::scratchBytes() const
+{
+  static const int PATCH_BYTES = RandomizedTree::PATCH_SIZE * RandomizedTree::PATCH_SIZE;
+  // sum_50t_176c clears 176 16-bit sums whatever the number of classes
+  return alignTo16(SIGNATURE_BATCH * PATCH_BYTES)
+    + alignTo16(std::max(classes_, 176) * sizeof(uint16_t))
+    + alignTo16(SIGNATURE_BATCH * trees_.size() * sizeof(int))
+    + alignTo16(trees_.size() * sizeof(uint8_t*));
+}
+
+void RTreeClassifier::allocScratch(int num_threads)
+{
+  // Extra 15 bytes to align the start
+  size_t bytes = num_threads * scratchBytes() + 15;
+  if (scratch_memory_.size() < bytes)
+    scratch_memory_.resize(bytes);
+}
+
+RTreeClassifier::SignatureScratch RTreeClassifier::getScratch(int thread)
+{
+  static const int PATCH_BYTES = RandomizedTree::PATCH_SIZE * RandomizedTree::PATCH_SIZE;
+  size_t start = reinterpret_cast<size_t>(&scratch_memory_[0]);
+  uint8_t *p = reinterpret_cast<uint8_t*>(alignTo16(start)) + thread * scratchBytes();
+
+  SignatureScratch scratch;
+  scratch.patches = p;
+  p += alignTo16(SIGNATURE_BATCH * PATCH_BYTES);
+  scratch.sum = reinterpret_cast<uint16_t*>(p);
+  p += alignTo16(std::max(classes_, 176) * sizeof(uint16_t));
+  scratch.leaves = reinterpret_cast<int*>(p);
+  p += alignTo16(SIGNATURE_BATCH * trees_.size() * sizeof(int));
+  scratch.posteriors = reinterpret_cast<uint8_t**>(p);
+  return scratch;
+}
+
+void RTreeClassifier::setThreads(int n)
+{
+  threads_ = std::max(n, 1);
+}
+
 void RTreeClassifier::getSparseSignature(IplImage *patch, float *sig, float thresh)
 {   
    getFloatSignature(patch, sig);
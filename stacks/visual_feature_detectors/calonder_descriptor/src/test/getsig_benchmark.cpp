@@ -0,0 +1,83 @@
+// calonder_descriptor
+#include "calonder_descriptor/rtree_classifier.h"
+// star_detector
+#include "star_detector/detector.h"
+#include <cvwimage.h> // Google C++ wrappers
+#include <highgui.h>
+#include <boost/foreach.hpp>
+#include <sys/time.h>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+using namespace features;
+
+static double wallTime()
+{
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// Signature computation for all keypoints of a frame: getSignature() on
+// each patch against the batched getSignatures() with 1..max threads.
+// Usage: ./getsig_benchmark land30.trees frame.pgm [max threads]
+int main( int argc, char** argv )
+{
+  static const unsigned NUM_PTS = 1000;
+  static const int REPEATS = 20;
+
+  assert(argc > 2);
+  int max_threads = argc > 3 ? atoi(argv[3]) : 4;
+
+  RTreeClassifier classifier;
+  classifier.read(argv[1]);
+  cv::WImageBuffer1_b frame( cvLoadImage(argv[2], CV_LOAD_IMAGE_GRAYSCALE) );
+  int sig_size = classifier.classes();
+
+  StarDetector detector(cvSize(frame.Width(), frame.Height()));
+  std::vector<Keypoint> keypts;
+  detector.DetectPoints(frame.Ipl(), std::back_inserter(keypts));
+  KeepBestPoints(keypts, NUM_PTS);
+  int num_pts = keypts.size();
+  printf("%d keypoints, %d repeats\n", num_pts, REPEATS);
+
+  uint8_t* ref_sigs = RTreeClassifier::safeSignatureAlloc(num_pts, sig_size);
+  uint8_t* sigs = RTreeClassifier::safeSignatureAlloc(num_pts, sig_size);
+
+  double start = wallTime();
+  for (int r = 0; r < REPEATS; ++r) {
+    uint8_t* sig = ref_sigs;
+    BOOST_FOREACH( Keypoint &pt, keypts ) {
+      classifier.getSignature(extractPatch(frame.Ipl(), pt).Ipl(), sig);
+      sig += sig_size;
+    }
+  }
+  double seconds = wallTime() - start;
+  printf("%-24s %10.0f signatures/s\n", "getSignature", num_pts * REPEATS / seconds);
+
+  int different = 0;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    classifier.setThreads(threads);
+    memset(sigs, 0, num_pts * sig_size);
+    start = wallTime();
+    for (int r = 0; r < REPEATS; ++r)
+      classifier.getSignatures(frame.Ipl(), keypts.begin(), keypts.end(), sigs);
+    seconds = wallTime() - start;
+
+    char name[32];
+    snprintf(name, sizeof(name), "getSignatures, %d thr", threads);
+    printf("%-24s %10.0f signatures/s\n", name, num_pts * REPEATS / seconds);
+
+    if (memcmp(sigs, ref_sigs, num_pts * sig_size) != 0)
+      ++different;
+  }
+  printf("%d of the batched runs differ from getSignature\n", different);
+
+  free(ref_sigs);
+  free(sigs);
+
+  return different == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// calonder_descriptor
+#include "calonder_descriptor/matcher.h"
+#include "calonder_descriptor/rtree_classifier.h"
+// star_detector
+#include "star_detector/detector.h"
+#include "timer.h"
+#include <cvwimage.h> // Google C++ wrappers
+#include <highgui.h>
+#include <boost/foreach.hpp>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace features;
+
+// Frame to frame matching as done in visual odometry: each keypoint of the
+// second frame is matched to the keypoints of the first frame in a window
+// around its own position. Compares BruteForceMatcher and GridMatcher.
+// Usage: ./window_match_benchmark land30.trees frame0.pgm frame1.pgm [window size]
+int main( int argc, char** argv )
+{
+  static const unsigned NUM_PTS = 1000;
+  static const int REPEATS = 20;
+
+  assert(argc > 3);
+  int window_size = argc > 4 ? atoi(argv[4]) : 64;
+
+  typedef uint8_t SigType;
+  typedef Promote<SigType>::type DistanceType;
+
+  RTreeClassifier classifier;
+  classifier.read(argv[1]);
+  cv::WImageBuffer1_b frame0( cvLoadImage(argv[2], CV_LOAD_IMAGE_GRAYSCALE) );
+  cv::WImageBuffer1_b frame1( cvLoadImage(argv[3], CV_LOAD_IMAGE_GRAYSCALE) );
+  CvSize size = cvSize(frame0.Width(), frame0.Height());
+  int sig_size = classifier.classes();
+
+  // Detect points in both frames
+  StarDetector detector(size);
+  std::vector<Keypoint> keypts0, keypts1;
+  detector.DetectPoints(frame0.Ipl(), std::back_inserter(keypts0));
+  KeepBestPoints(keypts0, NUM_PTS);
+  detector.DetectPoints(frame1.Ipl(), std::back_inserter(keypts1));
+  KeepBestPoints(keypts1, NUM_PTS);
+  printf("%u and %u keypoints\n", (unsigned int)keypts0.size(), (unsigned int)keypts1.size());
+
+  // Signatures of both frames
+  SigType* sig_buffer = NULL;
+  posix_memalign(reinterpret_cast<void**>(&sig_buffer), 16,
+                 sig_size * sizeof(SigType) * (keypts0.size() + keypts1.size()));
+  SigType* sig = sig_buffer;
+  BOOST_FOREACH( Keypoint &pt, keypts0 ) {
+    classifier.getSignature(extractPatch(frame0.Ipl(), pt).Ipl(), sig);
+    sig += sig_size;
+  }
+  SigType* query_sigs = sig;
+  BOOST_FOREACH( Keypoint &pt, keypts1 ) {
+    classifier.getSignature(extractPatch(frame1.Ipl(), pt).Ipl(), sig);
+    sig += sig_size;
+  }
+
+  BruteForceMatcher<SigType, CvPoint> brute_matcher(sig_size);
+  GridMatcher<SigType, CvPoint> grid_matcher(sig_size, size);
+  sig = sig_buffer;
+  BOOST_FOREACH( Keypoint &pt, keypts0 ) {
+    brute_matcher.addSignature(sig, cvPoint(pt.x, pt.y));
+    grid_matcher.addSignature(sig, cvPoint(pt.x, pt.y));
+    sig += sig_size;
+  }
+
+  std::vector<int> brute_matches(keypts1.size()), grid_matches(keypts1.size());
+  DistanceType distance;
+  int half = window_size / 2;
+  {
+    Timer timer("BruteForceMatcher::findMatchInWindow");
+    for (int r = 0; r < REPEATS; ++r) {
+      sig = query_sigs;
+      for (size_t i = 0; i < keypts1.size(); ++i, sig += sig_size) {
+        CvRect window = cvRect(keypts1[i].x - half, keypts1[i].y - half,
+                               window_size, window_size);
+        brute_matches[i] = brute_matcher.findMatchInWindow(sig, window, &distance);
+      }
+    }
+  }
+  {
+    Timer timer("GridMatcher::findMatchInWindow");
+    for (int r = 0; r < REPEATS; ++r) {
+      sig = query_sigs;
+      for (size_t i = 0; i < keypts1.size(); ++i, sig += sig_size) {
+        CvRect window = cvRect(keypts1[i].x - half, keypts1[i].y - half,
+                               window_size, window_size);
+        grid_matches[i] = grid_matcher.findMatchInWindow(sig, window, &distance);
+      }
+    }
+  }
+  printf("%d repeats, window %dx%d\n", REPEATS, window_size, window_size);
+
+  int different = 0;
+  for (size_t i = 0; i < keypts1.size(); ++i)
+    if (brute_matches[i] != grid_matches[i])
+      ++different;
+  printf("%d of %u matches differ\n", different, (unsigned int)keypts1.size());
+
+  free(sig_buffer);
+
+  return different == 0 ? 0 : 1;
+}
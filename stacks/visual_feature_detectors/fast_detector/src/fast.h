@@ -15,6 +15,9 @@ xy*  fast_corner_detect_10(const byte* im, int xsize, int ysize, int barrier, in
 xy*  fast_corner_detect_11(const byte* im, int xsize, int ysize, int barrier, int* numcorners);
 xy*  fast_corner_detect_12(const byte* im, int xsize, int ysize, int barrier, int* numcorners);
 
+/* fast_corner_detect_9 on num_threads horizontal bands of the image, one thread each */
+xyr*  fast_corner_detect_9_threads(const byte* im, int xsize, int ysize, int barrier, int num_threads, int* numcorners);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "fast.h"
+
+/* Multi-threaded fast_corner_detect_9. The image is split into horizontal
+   bands, each detected on its own thread, and the corners of the bands are
+   concatenated in band order. The result is the same list, in the same
+   raster order, as fast_corner_detect_9 over the whole image, so fast_nonmax
+   on it compares corners across the band seams exactly as it would for a
+   single thread. */
+
+typedef struct
+{
+	const byte* im;
+	int xsize, barrier;
+	int y0, y1; /* Rows [y0, y1) of the image are searched for corners */
+	xyr* corners;
+	int num;
+} fast_band;
+
+static void* fast_detect_band(void* arg)
+{
+	fast_band* band = (fast_band*)arg;
+	/* The detector skips the 3 rows at the top and bottom of the image it is
+	   given, so give it the band along with 3 rows of each neighbour. */
+	int top = band->y0 - 3;
+	int i;
+
+	band->corners = fast_corner_detect_9(band->im + top * band->xsize, band->xsize, band->y1 - top + 3, band->barrier, &band->num);
+
+	for(i=0; i < band->num; i++)
+		band->corners[i].y += top;
+
+	return 0;
+}
+
+xyr* fast_corner_detect_9_threads(const byte* im, int xsize, int ysize, int barrier, int num_threads, int* num)
+{
+	fast_band* bands;
+	pthread_t* threads;
+	xyr* ret;
+	int rows = ysize - 6;
+	int total = 0;
+	int i;
+
+	if(num_threads > rows)
+		num_threads = rows;
+	if(num_threads <= 1)
+		return fast_corner_detect_9(im, xsize, ysize, barrier, num);
+
+	bands = (fast_band*)malloc(num_threads * sizeof(fast_band));
+	threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+
+	for(i=0; i < num_threads; i++)
+	{
+		bands[i].im = im;
+		bands[i].xsize = xsize;
+		bands[i].barrier = barrier;
+		bands[i].y0 = 3 + rows * i / num_threads;
+		bands[i].y1 = 3 + rows * (i+1) / num_threads;
+	}
+
+	/* The last band runs on this thread. A band whose thread can't be
+	   started is detected here as well. */
+	for(i=0; i < num_threads - 1; i++)
+		if(pthread_create(&threads[i], 0, fast_detect_band, &bands[i]) != 0)
+		{
+			fast_detect_band(&bands[i]);
+			threads[i] = pthread_self();
+		}
+	fast_detect_band(&bands[num_threads - 1]);
+
+	for(i=0; i < num_threads - 1; i++)
+		if(!pthread_equal(threads[i], pthread_self()))
+			pthread_join(threads[i], 0);
+
+	for(i=0; i < num_threads; i++)
+		total += bands[i].num;
+
+	ret = (xyr*)malloc((total > 0 ? total : 1) * sizeof(xyr));
+	total = 0;
+	for(i=0; i < num_threads; i++)
+	{
+		memcpy(ret + total, bands[i].corners, bands[i].num * sizeof(xyr));
+		total += bands[i].num;
+		free(bands[i].corners);
+	}
+
+	free(threads);
+	free(bands);
+
+	*num = total;
+	return ret;
+}
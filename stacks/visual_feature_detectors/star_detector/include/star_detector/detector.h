@@ -7,6 +7,8 @@
 #include "star_detector/optimized_width.h"
 #include <cv.h>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 
 /*!
   This class offers a simple interface for keypoint detection.
@@ -29,6 +31,13 @@
 
   The default response threshold (30) is most appropriate for outdoor
   scenes. For indoor scenes, a smaller threshold (~10) may be needed.
+
+  With setThreads(n), n > 1, the upright and tilted integral images are
+  computed concurrently, and the filter responses and non-maximal
+  suppression run on n horizontal bands of the image. The bands line up
+  with the suppression tiles and each pass finishes before the next
+  starts, so the keypoints are the same, in the same order, as with a
+  single thread.
  */
 class StarDetector
 {
@@ -72,6 +81,10 @@ public:
   //! StarDetector will not find keypoints within 'border' pixels of the edge.
   inline int border() const { return m_border; }
 
+  //! Number of threads used by DetectPoints, 1 by default
+  inline int threads() const { return m_threads; }
+  void setThreads(int n);
+
 private:
   //! Scale/spatial dimensions
   int m_n, m_W, m_H;
@@ -91,6 +104,13 @@ private:
   NonmaxSuppressWxH<5, 5, float, LineSuppressHybrid> m_nonmax;
   //! Border size for non-max suppression
   int m_border;
+  //! Number of bands to detect in
+  int m_threads;
+  //! Keypoints found in each band, kept to reuse their memory
+  std::vector< std::vector<Keypoint> > m_band_keypoints;
+  //! Threads for the bands, started on first use and kept between images
+  class BandWorkers;
+  BandWorkers* m_workers;
 
   struct FilterParams
   {
@@ -115,23 +135,29 @@ private:
   //! are counted twice.
   int StarPixels(int radius, int offset);
   
-  //! Calculate the filter responses over the range of desired scales.
-  void FilterResponses();
-  void FilterResponsesFallback(); // pure C++ implementation
-  void FilterResponsesGen3();
-  void FilterResponsesGen4();
-  void FilterResponsesGen5();
-  void FilterResponsesGen6();
-  void FilterResponsesGen7();
-  void FilterResponsesGen8();
-  void FilterResponsesGen9();
-  void FilterResponsesGen10();
-  void FilterResponsesGen11();
-  void FilterResponsesGen12();
+  //! Calculate the filter responses over the range of desired scales,
+  //! for image rows [y0, y1).
+  void FilterResponses(int y0, int y1);
+  void FilterResponsesFallback(int y0, int y1); // pure C++ implementation
+  void FilterResponsesGen3(int y0, int y1);
+  void FilterResponsesGen4(int y0, int y1);
+  void FilterResponsesGen5(int y0, int y1);
+  void FilterResponsesGen6(int y0, int y1);
+  void FilterResponsesGen7(int y0, int y1);
+  void FilterResponsesGen8(int y0, int y1);
+  void FilterResponsesGen9(int y0, int y1);
+  void FilterResponsesGen10(int y0, int y1);
+  void FilterResponsesGen11(int y0, int y1);
+  void FilterResponsesGen12(int y0, int y1);
   
   //! Return extrema which satisfy the strength and line response thresholds
   template< typename OutputIterator >
   int FindExtrema(OutputIterator inserter);
+
+  //! Multi-threaded DetectPoints, leaves the keypoints in m_band_keypoints.
+  void DetectBands(IplImage* source);
+  //! Find the extrema in the tiles starting in rows [y0, y1).
+  void FindExtremaBand(int band, int y0, int y1);
 };
 
 
@@ -140,10 +166,20 @@ int StarDetector::DetectPoints(IplImage* source, OutputIterator inserter)
 {
   assert(source && source->depth == (int)IPL_DEPTH_8U);
 
+  if (m_threads > 1) {
+    DetectBands(source);
+    int num_pts = 0;
+    for (size_t b = 0; b < m_band_keypoints.size(); ++b) {
+      inserter = std::copy(m_band_keypoints[b].begin(), m_band_keypoints[b].end(), inserter);
+      num_pts += m_band_keypoints[b].size();
+    }
+    return num_pts;
+  }
+
   cvIntegral(source, m_upright, NULL, NULL);
   TiltedIntegral(source, m_tilted, m_flat);
 
-  FilterResponses();
+  FilterResponses(0, m_H);
 
   return FindExtrema(inserter);
 }
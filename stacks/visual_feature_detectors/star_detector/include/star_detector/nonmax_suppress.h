@@ -52,10 +52,22 @@ public:
   inline PostThreshold& thresholdFunction() { return m_post_thresh; }
   inline const PostThreshold& thresholdFunction() const { return m_post_thresh; }
   
+  //! Height of the tiles; rows of tiles start at border + k*TILE_HEIGHT.
+  static const int TILE_HEIGHT = H / 2 + 1;
+
   //! Outputs (through inserter) all maxima found and returns how many were found.
   template< typename OutputIterator >
   int operator() (IplImage* projected, IplImage* scales, int n,
                   OutputIterator inserter, int border) {
+    return (*this)(projected, scales, n, inserter, border, border, projected->height);
+  }
+
+  //! As above, but only searches the rows of tiles starting in [begin_y, stop_y).
+  //! begin_y must be border + k*TILE_HEIGHT, so that consecutive ranges find
+  //! the same maxima, in the same order, as a single call over the image.
+  template< typename OutputIterator >
+  int operator() (IplImage* projected, IplImage* scales, int n,
+                  OutputIterator inserter, int border, int begin_y, int stop_y) {
     int num_pts = 0;
     int max_x = 0, max_y = 0, min_x = 0, min_y = 0;
 
@@ -63,7 +75,7 @@ public:
     // small features near the edges of the image.
     int end_y = projected->height - border - 1;
     int end_x = projected->width - border - 1;
-    for (int y = border; y <= end_y; y += Y_OFFSET + 1) {
+    for (int y = begin_y; y <= end_y && y < stop_y; y += Y_OFFSET + 1) {
       for (int x = border; x <= end_x; x += X_OFFSET + 1) {
         T max_response = 0, min_response = 0;
 
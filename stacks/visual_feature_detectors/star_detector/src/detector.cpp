@@ -1,5 +1,95 @@
 #include "star_detector/detector.h"
 #include "star_detector/optimized_width.h"
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+
+// Persistent worker threads. On each Run(), worker i runs job i and the
+// calling thread runs the last job; Run() returns when all jobs are done.
+class StarDetector::BandWorkers
+{
+public:
+  BandWorkers(int n);
+  ~BandWorkers();
+  int size() const { return m_n; }
+  //! Runs at most size()+1 jobs
+  void Run(const std::vector< boost::function<void ()> >& jobs);
+
+private:
+  void Loop(int index);
+
+  int m_n;
+  boost::thread_group m_threads;
+  boost::mutex m_lock;
+  boost::condition m_work_available, m_work_done;
+  const std::vector< boost::function<void ()> >* m_jobs;
+  int m_njobs;           // jobs for the workers in this round
+  int m_pending;         // worker jobs not done yet
+  unsigned int m_round;  // incremented on each Run()
+  bool m_stop;
+};
+
+StarDetector::BandWorkers::BandWorkers(int n)
+  : m_n(n), m_jobs(NULL), m_njobs(0), m_pending(0), m_round(0), m_stop(false)
+{
+  for (int i = 0; i < n; ++i)
+    m_threads.create_thread(boost::bind(&BandWorkers::Loop, this, i));
+}
+
+StarDetector::BandWorkers::~BandWorkers()
+{
+  {
+    boost::mutex::scoped_lock lock(m_lock);
+    m_stop = true;
+  }
+  m_work_available.notify_all();
+  m_threads.join_all();
+}
+
+void StarDetector::BandWorkers::Run(const std::vector< boost::function<void ()> >& jobs)
+{
+  int n = jobs.size() - 1;
+  {
+    boost::mutex::scoped_lock lock(m_lock);
+    m_jobs = &jobs;
+    m_njobs = n;
+    m_pending = n;
+    ++m_round;
+  }
+  m_work_available.notify_all();
+
+  jobs[n]();
+
+  boost::mutex::scoped_lock lock(m_lock);
+  while (m_pending > 0)
+    m_work_done.wait(lock);
+}
+
+void StarDetector::BandWorkers::Loop(int index)
+{
+  unsigned int seen = 0;
+  while (true) {
+    const boost::function<void ()>* job;
+    {
+      boost::mutex::scoped_lock lock(m_lock);
+      while (!m_stop && m_round == seen)
+        m_work_available.wait(lock);
+      if (m_stop)
+        return;
+      seen = m_round;
+      if (index >= m_njobs)
+        continue; // nothing for this thread this round
+      job = &(*m_jobs)[index];
+    }
+
+    (*job)();
+
+    boost::mutex::scoped_lock lock(m_lock);
+    if (--m_pending == 0)
+      m_work_done.notify_one();
+  }
+}
 
 StarDetector::StarDetector(CvSize size, int n, float response_threshold,
                            float line_threshold_projected,
@@ -13,6 +103,8 @@ StarDetector::StarDetector(CvSize size, int n, float response_threshold,
     m_nonmax(response_threshold,
              LineSuppressHybrid(line_threshold_projected,
                                 line_threshold_binarized)),
+    m_threads(1),
+    m_workers(NULL),
     m_filter_params(NULL)
 {
   // Pre-allocate all the memory we need
@@ -34,6 +126,7 @@ StarDetector::~StarDetector()
   releaseImages();
   delete[] m_filter_sizes;
   delete[] m_filter_params;
+  delete m_workers;
 }
 
 void StarDetector::setScales(int n)
@@ -58,6 +151,27 @@ void StarDetector::setScales(int n)
 
   // Set border to size of maximum offset
   m_border = m_filter_sizes[m_n - 1] * 3;
+
+  // Cache constants associated with each scale for the fallback filter code.
+  // Done here rather than on first use, as bands may run it concurrently.
+  delete[] m_filter_params;
+  m_filter_params = new FilterParams[m_n];
+  for (int s = 0; s < m_n; ++s) {
+    FilterParams &fp = m_filter_params[s];
+    fp.inner_r = m_filter_sizes[s];
+    fp.outer_r = 2*fp.inner_r;
+    fp.inner_offset = fp.inner_r + fp.inner_r / 2;
+    fp.outer_offset = fp.outer_r + fp.outer_r / 2;
+    int inner_pix = StarPixels(fp.inner_r, fp.inner_offset);
+    int outer_pix = StarPixels(fp.outer_r, fp.outer_offset) - inner_pix;
+    fp.inner_normalizer = 1.0f / inner_pix;
+    fp.outer_normalizer = 1.0f / outer_pix;
+  }
+}
+
+void StarDetector::setThreads(int n)
+{
+  m_threads = std::max(n, 1);
 }
 
 void StarDetector::setImageSize(CvSize size)
@@ -104,54 +218,39 @@ int StarDetector::StarPixels(int radius, int offset)
   return upright_pixels + tilt_pixels;
 }
 
-void StarDetector::FilterResponses()
+void StarDetector::FilterResponses(int y0, int y1)
 {
   // If possible, run one of the optimized versions
 #ifdef __SSE2__
   if ((m_W < OPTIMIZED_WIDTH) && (3 <= m_n) && (m_n <= 12)) {
     switch (m_n) {
-      case 3: FilterResponsesGen3(); break;
-      case 4: FilterResponsesGen4(); break;
-      case 5: FilterResponsesGen5(); break;
-      case 6: FilterResponsesGen6(); break;
-      case 7: FilterResponsesGen7(); break;
-      case 8: FilterResponsesGen8(); break;
-      case 9: FilterResponsesGen9(); break;
-      case 10: FilterResponsesGen10(); break;
-      case 11: FilterResponsesGen11(); break;
-      case 12: FilterResponsesGen12(); break;
+      case 3: FilterResponsesGen3(y0, y1); break;
+      case 4: FilterResponsesGen4(y0, y1); break;
+      case 5: FilterResponsesGen5(y0, y1); break;
+      case 6: FilterResponsesGen6(y0, y1); break;
+      case 7: FilterResponsesGen7(y0, y1); break;
+      case 8: FilterResponsesGen8(y0, y1); break;
+      case 9: FilterResponsesGen9(y0, y1); break;
+      case 10: FilterResponsesGen10(y0, y1); break;
+      case 11: FilterResponsesGen11(y0, y1); break;
+      case 12: FilterResponsesGen12(y0, y1); break;
     }
   } else {
-    FilterResponsesFallback();
+    FilterResponsesFallback(y0, y1);
   }
 #else
 #warning "SSE instructions unavailable, using slower C++ fallback code."
-  FilterResponsesFallback();
+  FilterResponsesFallback(y0, y1);
 #endif
 }
 
 // Lightly optimized pure C++ version. If possible, one of the SIMD versions
 // in generated.i will be used instead.
-void StarDetector::FilterResponsesFallback()
-{
-  if (!m_filter_params) {
-    // Cache constants associated with each scale
-    m_filter_params = new FilterParams[m_n];
-    for (int s = 0; s < m_n; ++s) {
-      FilterParams &fp = m_filter_params[s];
-      fp.inner_r = m_filter_sizes[s];
-      fp.outer_r = 2*fp.inner_r;
-      fp.inner_offset = fp.inner_r + fp.inner_r / 2;
-      fp.outer_offset = fp.outer_r + fp.outer_r / 2;
-      int inner_pix = StarPixels(fp.inner_r, fp.inner_offset);
-      int outer_pix = StarPixels(fp.outer_r, fp.outer_offset) - inner_pix;
-      fp.inner_normalizer = 1.0f / inner_pix;
-      fp.outer_normalizer = 1.0f / outer_pix;
-    }
-  }
-  
+void StarDetector::FilterResponsesFallback(int y0, int y1)
+{
   // Calculate responses over all scales and project into single maximal image
-  for (int y = m_border; y < m_H - m_border; ++y) {
+  int begin_y = std::max(m_border, y0), end_y = std::min(m_H - m_border, y1);
+  for (int y = begin_y; y < end_y; ++y) {
     for (int x = m_border; x < m_W - m_border; ++x) {
       uchar scale = 0;
       float max_response = 0.0f;
@@ -175,6 +274,58 @@ void StarDetector::FilterResponsesFallback()
   }
 }
 
+static void UprightIntegral(IplImage* source, IplImage* upright)
+{
+  cvIntegral(source, upright, NULL, NULL);
+}
+
+void StarDetector::FindExtremaBand(int band, int y0, int y1)
+{
+  std::vector<Keypoint>& keypts = m_band_keypoints[band];
+  keypts.clear();
+  m_nonmax(m_projected, m_scales, m_n, std::back_inserter(keypts), m_border, y0, y1);
+}
+
+void StarDetector::DetectBands(IplImage* source)
+{
+  typedef NonmaxSuppressWxH<5, 5, float, LineSuppressHybrid> Nonmax;
+  int tiles = (m_H - 2*m_border + Nonmax::TILE_HEIGHT - 1) / Nonmax::TILE_HEIGHT;
+  int bands = std::max(std::min(m_threads, tiles), 1);
+
+  // At least one worker for the upright integral image
+  int workers = std::max(bands - 1, 1);
+  if (!m_workers || m_workers->size() < workers) {
+    delete m_workers;
+    m_workers = new BandWorkers(workers);
+  }
+
+  // The two integral images are independent scans of the whole image
+  std::vector< boost::function<void ()> > jobs(2);
+  jobs[0] = boost::bind(UprightIntegral, source, m_upright);
+  jobs[1] = boost::bind(TiltedIntegral, source, m_tilted, m_flat);
+  m_workers->Run(jobs);
+
+  // Split the suppression tiles into bands; each band also computes the
+  // responses in its rows, the last one those down to the bottom border
+  std::vector<int> band_y(bands + 1);
+  band_y[0] = m_border;
+  for (int b = 1; b < bands; ++b)
+    band_y[b] = m_border + Nonmax::TILE_HEIGHT * (tiles * b / bands);
+  band_y[bands] = m_H;
+  m_band_keypoints.resize(bands);
+
+  // Non-maximal suppression and line suppression look at responses
+  // outside their band, so all responses are done before suppression starts
+  jobs.resize(bands);
+  for (int b = 0; b < bands; ++b)
+    jobs[b] = boost::bind(&StarDetector::FilterResponses, this, band_y[b], band_y[b+1]);
+  m_workers->Run(jobs);
+
+  for (int b = 0; b < bands; ++b)
+    jobs[b] = boost::bind(&StarDetector::FindExtremaBand, this, b, band_y[b], band_y[b+1]);
+  m_workers->Run(jobs);
+}
+
 #ifdef __SSE2__
 #include "generated.i"
 #endif
@@ -76,13 +76,13 @@ for n in range(3,13):
 
   uniqs = sorted(list(set(m_filter_sizes) | set(m_filter_sizes_2)))
 
-  print "void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen%d() {" % n
+  print "void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen%d(int y0, int y1) {" % n
 
   if TARGET_C:
       print "int", ",".join(["w%d" % r for r in uniqs]), ";"
   else:
       print "__m128i", ",".join(["w%d" % r for r in uniqs]), ";"
-  print "for (int y = %d; y < m_H - %d; ++y) { " % (border,border)
+  print "for (int y = std::max(%d, y0); y < std::min(m_H - %d, y1); ++y) { " % (border,border)
 
   print "float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, %d);" % border
   print "uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, %d);" % border
@@ -7,9 +7,9 @@
 #define ABS(x)      AND(x, K(0x7fffffff))
 #define PRED(m,a,b) OR(AND((m),(a)), ANDNOT((m),(b)))
 // [1, 2, 3]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen3() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen3(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6 ;
-for (int y = 12; y < m_H - 12; ++y) { 
+for (int y = std::max(12, y0); y < std::min(m_H - 12, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 12);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 12);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 12);
@@ -62,9 +62,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen4() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen4(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8 ;
-for (int y = 12; y < m_H - 12; ++y) { 
+for (int y = std::max(12, y0); y < std::min(m_H - 12, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 12);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 12);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 12);
@@ -127,9 +127,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen5() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen5(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w12 ;
-for (int y = 20; y < m_H - 20; ++y) { 
+for (int y = std::max(20, y0); y < std::min(m_H - 20, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 20);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 20);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 20);
@@ -202,9 +202,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen6() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen6(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w12,w16 ;
-for (int y = 24; y < m_H - 24; ++y) { 
+for (int y = std::max(24, y0); y < std::min(m_H - 24, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 24);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 24);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 24);
@@ -287,9 +287,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8, 11]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen7() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen7(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w11,w12,w16,w22 ;
-for (int y = 36; y < m_H - 36; ++y) { 
+for (int y = std::max(36, y0); y < std::min(m_H - 36, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 36);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 36);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 36);
@@ -383,9 +383,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8, 11, 16]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen8() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen8(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w11,w12,w16,w22,w32 ;
-for (int y = 48; y < m_H - 48; ++y) { 
+for (int y = std::max(48, y0); y < std::min(m_H - 48, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 48);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 48);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 48);
@@ -489,9 +489,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8, 11, 16, 23]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen9() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen9(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w11,w12,w16,w22,w23,w32,w46 ;
-for (int y = 72; y < m_H - 72; ++y) { 
+for (int y = std::max(72, y0); y < std::min(m_H - 72, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 72);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 72);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 72);
@@ -606,9 +606,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8, 11, 16, 23, 32]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen10() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen10(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w11,w12,w16,w22,w23,w32,w46,w64 ;
-for (int y = 96; y < m_H - 96; ++y) { 
+for (int y = std::max(96, y0); y < std::min(m_H - 96, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 96);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 96);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 96);
@@ -733,9 +733,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8, 11, 16, 23, 32, 45]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen11() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen11(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w11,w12,w16,w22,w23,w32,w45,w46,w64,w90 ;
-for (int y = 136; y < m_H - 136; ++y) { 
+for (int y = std::max(136, y0); y < std::min(m_H - 136, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 136);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 136);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 136);
@@ -871,9 +871,9 @@ m_flat_p += 4;
 }}
 }
 // [1, 2, 3, 4, 6, 8, 11, 16, 23, 32, 45, 64]
-void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen12() {
+void __attribute__ ((force_align_arg_pointer)) StarDetector::FilterResponsesGen12(int y0, int y1) {
 __m128i w1,w2,w3,w4,w6,w8,w11,w12,w16,w22,w23,w32,w45,w46,w64,w90,w128 ;
-for (int y = 192; y < m_H - 192; ++y) { 
+for (int y = std::max(192, y0); y < std::min(m_H - 192, y1); ++y) { 
 float *p_prj = &CV_IMAGE_ELEM(m_projected, float, y, 192);
 uchar *p_scl = &CV_IMAGE_ELEM(m_scales, uchar, y, 192);
 int *m_upright_p = &CV_IMAGE_ELEM(m_upright, int, y, 192);
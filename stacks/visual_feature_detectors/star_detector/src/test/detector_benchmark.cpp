@@ -0,0 +1,130 @@
+#include "star_detector/detector.h"
+#include <fast.h>
+#include <cv.h>
+#include <highgui.h>
+#include <sys/time.h>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+// Keypoint detection throughput of the Star and FAST detectors with
+// increasing numbers of threads, over a sequence of images (e.g. the left
+// and right frames of a stereo sequence). Checks that the threaded
+// detectors find the same keypoints as the single-threaded ones.
+// Usage: ./detector_benchmark [-t max_threads] [-r repeats] left0.png right0.png ...
+
+static const int FAST_THRESHOLD = 20;
+
+static double wallTime()
+{
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static bool samePoints(const std::vector<Keypoint>& a, const std::vector<Keypoint>& b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i)
+    if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].scale != b[i].scale)
+      return false;
+  return true;
+}
+
+// FAST-9 with non-maximal suppression, as Keypoints with the corner score
+// as response.
+static void detectFast(IplImage* image, int threads, std::vector<Keypoint>& keypts)
+{
+  // fast_corner_detect_9 wants a packed image
+  assert(image->widthStep == image->width);
+  const byte* data = (const byte*)image->imageData;
+  int num_corners = 0, num_nonmax = 0;
+  xyr* corners = fast_corner_detect_9_threads(data, image->width, image->height,
+                                              FAST_THRESHOLD, threads, &num_corners);
+  xyr* nonmax = fast_nonmax(data, image->width, image->height, corners, num_corners,
+                            FAST_THRESHOLD, &num_nonmax);
+  keypts.clear();
+  if (nonmax) {
+    for (int i = 0; i < num_nonmax; ++i)
+      keypts.push_back(Keypoint(nonmax[i].x, nonmax[i].y, 1, nonmax[i].r));
+  }
+  free(corners);
+  free(nonmax);
+}
+
+int main( int argc, char** argv )
+{
+  int max_threads = 4, repeats = 10;
+  std::vector<IplImage*> images;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      max_threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      repeats = atoi(argv[++i]);
+    else {
+      IplImage* image = cvLoadImage(argv[i], CV_LOAD_IMAGE_GRAYSCALE);
+      if (!image) {
+        fprintf(stderr, "Couldn't load %s\n", argv[i]);
+        return 1;
+      }
+      images.push_back(image);
+    }
+  }
+  assert(!images.empty());
+  CvSize size = cvSize(images[0]->width, images[0]->height);
+
+  // Reference keypoints from the single-threaded detectors
+  std::vector< std::vector<Keypoint> > star_ref(images.size()), fast_ref(images.size());
+  {
+    StarDetector detector(size);
+    for (size_t i = 0; i < images.size(); ++i) {
+      detector.DetectPoints(images[i], std::back_inserter(star_ref[i]));
+      detectFast(images[i], 1, fast_ref[i]);
+    }
+  }
+
+  printf("%u images of %dx%d, %d repeats\n", images.size(), size.width, size.height, repeats);
+  printf("%8s %18s %18s\n", "threads", "Star keypts/ms", "FAST keypts/ms");
+  int mismatches = 0;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    StarDetector detector(size);
+    detector.setThreads(threads);
+    std::vector<Keypoint> keypts;
+
+    size_t star_pts = 0;
+    double start = wallTime();
+    for (int r = 0; r < repeats; ++r) {
+      for (size_t i = 0; i < images.size(); ++i) {
+        keypts.clear();
+        detector.DetectPoints(images[i], std::back_inserter(keypts));
+        star_pts += keypts.size();
+        if (r == 0 && !samePoints(keypts, star_ref[i]))
+          ++mismatches;
+      }
+    }
+    double star_ms = (wallTime() - start) * 1000.0;
+
+    size_t fast_pts = 0;
+    start = wallTime();
+    for (int r = 0; r < repeats; ++r) {
+      for (size_t i = 0; i < images.size(); ++i) {
+        detectFast(images[i], threads, keypts);
+        fast_pts += keypts.size();
+        if (r == 0 && !samePoints(keypts, fast_ref[i]))
+          ++mismatches;
+      }
+    }
+    double fast_ms = (wallTime() - start) * 1000.0;
+
+    printf("%8d %18.1f %18.1f\n", threads, star_pts / star_ms, fast_pts / fast_ms);
+  }
+  printf("%d images differ from the single-threaded keypoints\n", mismatches);
+
+  for (size_t i = 0; i < images.size(); ++i)
+    cvReleaseImage(&images[i]);
+
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/**
+ * \file 
+ * 
+ * Internally used grid bucket index over 2d points, for nearest neighbor queries
+ *
+ * \author Bhaskara Marthi
+ */
+
+
+#ifndef TOPOLOGICAL_MAP_POINT_INDEX_H
+#define TOPOLOGICAL_MAP_POINT_INDEX_H
+
+#include <topological_map/topological_map.h>
+
+namespace topological_map
+{
+
+using std::map;
+using std::pair;
+using std::vector;
+
+/// Index over a set of points with integer ids (e.g., doors or outlets).  Points are kept in square
+/// buckets of a fixed size, and nearest neighbor queries look at rings of buckets around the query
+/// point, moving outwards until the rest of the buckets are further away than the best point so far.
+class PointIndex
+{
+public:
+
+  PointIndex (double bucket_size);
+
+  /// Add point \a p with id \a id, replacing the existing point with that id if any
+  void insert (unsigned id, const Point2D& p);
+
+  /// Remove the point with id \a id if there is one
+  void remove (unsigned id);
+
+  unsigned size () const { return points_.size(); }
+
+  /// \return (true, id) of the closest point to \a p, with ties going to the lower id, or (false, 0)
+  /// if the index is empty
+  pair<bool, unsigned> nearest (const Point2D& p) const;
+
+private:
+
+  typedef pair<int, int> Bucket;
+  typedef pair<unsigned, Point2D> Entry;
+  typedef map<Bucket, vector<Entry> > BucketMap;
+
+  Bucket bucket (const Point2D& p) const;
+  void searchBucket (int r, int c, const Point2D& p, unsigned* best, double* best_sq_dist) const;
+
+  const double bucket_size_;
+  BucketMap buckets_;
+  map<unsigned, Point2D> points_;
+
+  // Bounds of the nonempty buckets; may be loose after removals
+  int min_r_, max_r_, min_c_, max_c_;
+};
+
+
+} // namespace
+
+#endif
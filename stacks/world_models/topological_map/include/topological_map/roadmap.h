@@ -44,6 +44,8 @@
 #include <topological_map/topological_map.h>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
+#include <set>
+#include <queue>
 
 namespace topological_map {
 
@@ -57,10 +59,10 @@ using std::vector;
 
 struct NodeInfo
 {
-  NodeInfo(ConnectorId id, const Point2D& point) : id(id), point(point) {}
+  NodeInfo(ConnectorId id, const Point2D& point) : id(id), point(point), temporary(false) {}
   ConnectorId id; // Stable id 
-  uint index; // Not stable; used internally by dijkstra search
   Point2D point;
+  bool temporary; // Start or goal of a query; never an intermediate point of a cached tree
 };
 
 struct EdgeInfo
@@ -79,8 +81,29 @@ typedef vector<ConnectorCost> ConnectorCosts;
 
 typedef vector<ConnectorId> ConnectorIdVector;
 
+typedef map<RoadmapVertex, double> DistanceMap;
+typedef map<RoadmapVertex, RoadmapVertex> PredecessorMap;
+
+/// Result of a single source search over the permanent nodes
+struct ShortestPathTree
+{
+  DistanceMap distances;
+  PredecessorMap predecessors;
+};
+
+typedef map<RoadmapVertex, ShortestPathTree> ShortestPathTreeMap;
+typedef pair<double, RoadmapVertex> QueueItem;
+typedef std::priority_queue<QueueItem, vector<QueueItem>, std::greater<QueueItem> > UpdateQueue;
+
 /// Internally used graph that wraps a boost graph over connectors (and also the start and end
 /// point of a given navigation problem)
+///
+/// Shortest path trees over the permanent nodes are cached per source, and kept up to date as
+/// costs change: a lower cost is propagated into the cached trees, a higher cost regrows the
+/// subtrees below the edge, and removing a node drops the trees that went through it.
+/// Temporary nodes are left out of the trees, and queries combine the trees of the neighbors
+/// of the temporary nodes, so adding and removing the start and goal of a query doesn't
+/// invalidate anything.
 class Roadmap
 {
 public:
@@ -92,6 +115,7 @@ public:
   void writeToStream (ostream& stream) const;
 
   ConnectorId addNode (const Point2D& p);
+  ConnectorId addTemporaryNode (const Point2D& p);
   void setCost (ConnectorId i, ConnectorId j, double cost);
   double getCost (const ConnectorId i, const ConnectorId j) const;
   void removeNode (ConnectorId i);
@@ -112,12 +136,20 @@ private:
   RoadmapEdge ensureEdge(RoadmapVertex v, RoadmapVertex w);
   RoadmapVertex idVertex(ConnectorId i) const;
   bool idExists(ConnectorId i) const;
-  void resetIndices();
   void addNode (const Point2D& p, ConnectorId id);
 
+  const ShortestPathTree& sourceTree (RoadmapVertex v);
+  double overlayDistance (RoadmapVertex v, RoadmapVertex w, PredecessorMap* predecessors);
+  void lowerTreeCosts (RoadmapVertex v, RoadmapVertex w, double cost);
+  void raiseTreeCosts (RoadmapVertex v, RoadmapVertex w);
+  void dropTreesUsingVertex (RoadmapVertex v);
+  void growTree (ShortestPathTree& tree, UpdateQueue& queue);
+
   ConnectorId next_id_;
   ConnectorIdVertexMap id_vertex_map_;
   RoadmapImpl graph_;
+  ShortestPathTreeMap trees_;
+  std::set<RoadmapVertex> temporary_vertices_;
 
 };
 
@@ -51,12 +51,14 @@ using ros::Time;
 class RegionGraph;
 class Roadmap;
 class GridGraph;
+class PointIndex;
 struct DoorInfo;
 
 typedef map<RegionPair, tuple<ConnectorId,Cell2D,Cell2D> > RegionConnectorMap;
 typedef shared_ptr<DoorInfo> DoorInfoPtr;
 typedef map<RegionId, DoorInfoPtr> RegionDoorMap;
 typedef boost::multi_array<int, 2> ObstacleDistanceArray;
+typedef boost::multi_array<RegionId, 2> RegionIdArray;
 typedef shared_ptr<OccupancyGrid> GridPtr;
 typedef vector<OutletInfo> OutletVector;
 
@@ -292,11 +294,12 @@ private:
   void setDoorCosts (const Time& t);
   void updateDistances (const RegionId region_id);
   bool connectorsTouchSameRegion (ConnectorId c1, ConnectorId c2, ConnectorId c3) const;
-  bool notDoor (const RegionId id) const;
-  bool doorCloser (const double x, const double y, const RegionId id1, const RegionId id2) const;
 
 
   RegionPtr squareRegion (const Point2D& p, double radius) const;
+  void indexRegion (RegionId id, RegionId value);
+  void indexDoor (RegionId id);
+  void buildIndices ();
 
   GridPtr grid_;
   ObstacleDistanceArray obstacle_distances_;
@@ -322,7 +325,12 @@ private:
 
   map<OutletId, Point2D> outlet_approach_overrides_;
   map<ConnectorId, Point2D> door_approach_overrides_;
-  map<pair<Point2D, Point2D>, double> roadmap_distance_cache_;
+  map<pair<Point2D, Point2D>, ReachableCost> roadmap_distance_cache_;
+
+  // Spatial indices, kept up to date as regions, doors and outlets change
+  RegionIdArray cell_regions_; // 0 for cells not in any region
+  shared_ptr<PointIndex> door_index_;
+  shared_ptr<PointIndex> outlet_index_;
 };
 
 
@@ -38,8 +38,8 @@
  */
 
 #include <topological_map/roadmap.h>
-#include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <algorithm>
+#include <limits>
 #include <ros/console.h>
 #include <ros/assert.h>
 #include <topological_map/exception.h>
@@ -52,11 +52,6 @@ using boost::tie;
 using std::map;
 using std::endl;
 
-typedef map<RoadmapVertex, double> DistanceMap;
-typedef map<RoadmapVertex, RoadmapVertex> PredecessorMap;
-typedef boost::associative_property_map<DistanceMap> DistancePmap;
-typedef boost::associative_property_map<PredecessorMap> PredecessorPmap;
-
 
 /************************************************************
  * Basic ops
@@ -68,6 +63,15 @@ ConnectorId Roadmap::addNode (const Point2D& p)
   return next_id_++;
 }
 
+ConnectorId Roadmap::addTemporaryNode (const Point2D& p)
+{
+  const ConnectorId id = addNode(p);
+  const RoadmapVertex v = idVertex(id);
+  graph_[v].temporary = true;
+  temporary_vertices_.insert(v);
+  return id;
+}
+
 void Roadmap::addNode (const Point2D& p, const ConnectorId id)
 {
   ROS_ASSERT_MSG (id_vertex_map_.find(id)==id_vertex_map_.end(), "Attempted to add duplicate connector id %u", id);
@@ -78,8 +82,24 @@ void Roadmap::addNode (const Point2D& p, const ConnectorId id)
 
 void Roadmap::setCost (const ConnectorId i, const ConnectorId j, double cost)
 {
-  const RoadmapEdge e = ensureEdge(idVertex(i),idVertex(j));
+  const RoadmapVertex v = idVertex(i);
+  const RoadmapVertex w = idVertex(j);
+  const bool existed = edge(v, w, graph_).second;
+  const RoadmapEdge e = ensureEdge(v,w);
+  const double old_cost = existed ? graph_[e].cost : cost;
+  if (graph_[v].temporary || graph_[w].temporary) {
+    graph_[e].cost = cost;
+    ROS_DEBUG_STREAM_NAMED ("roadmap", "Set cost between connectors " << i << " and " << j << " to " << cost);
+    return;
+  }
+  if (existed && cost==old_cost)
+    return;
+
   graph_[e].cost = cost;
+  if (existed && cost>old_cost)
+    raiseTreeCosts(v, w);
+  else
+    lowerTreeCosts(v, w, cost);
   ROS_DEBUG_STREAM_NAMED ("roadmap", "Set cost between connectors " << i << " and " << j << " to " << cost);
 }
 
@@ -95,6 +115,12 @@ double Roadmap::getCost (const ConnectorId i, const ConnectorId j) const
 void Roadmap::removeNode (const ConnectorId i)
 {
   const RoadmapVertex v = idVertex(i);
+  if (graph_[v].temporary) {
+    temporary_vertices_.erase(v);
+  }
+  else {
+    dropTreesUsingVertex(v);
+  }
   clear_vertex(v, graph_);
   remove_vertex(v, graph_);
   id_vertex_map_.erase(id_vertex_map_.find(i));
@@ -148,40 +174,21 @@ Point2D Roadmap::connectorPoint (const ConnectorId id) const
  ************************************************************/
 
 
-struct DijkstraVisitor : public boost::default_dijkstra_visitor
-{
-  DijkstraVisitor () {}
-  void discover_vertex(const RoadmapVertex& v, const RoadmapImpl& graph) const
-  {
-    ROS_DEBUG_STREAM_NAMED("dijkstra", "Discovering vertex " << graph[v].id << " at point " << graph[v].point);
-  }
-};
-
-
 ConnectorCosts Roadmap::connectorCosts (const ConnectorId i, const ConnectorId j)
 {
   ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Looking for connector costs between " << i << " and " << j);
   const RoadmapVertex v=idVertex(i);
   const RoadmapVertex w=idVertex(j);
-  resetIndices();
-  DistanceMap distances;
   ConnectorCosts costs;
-  PredecessorMap predecessors; // We shouldn't actually need this, but adding it removes a warning about boost/dijkstra_shortest_paths.hpp...
-  
-  dijkstra_shortest_paths(graph_, w, weight_map(get(&EdgeInfo::cost, graph_)).
-                          vertex_index_map(get(&NodeInfo::index, graph_)).
-                          distance_map(DistancePmap(distances)).visitor(DijkstraVisitor()).
-                          predecessor_map(PredecessorPmap(predecessors)));
 
   RoadmapAdjacencyIterator adj_iter, adj_end;
   for (tie(adj_iter, adj_end)=adjacent_vertices(v, graph_); adj_iter!=adj_end; ++adj_iter) {
-    DistanceMap::iterator pos = distances.find(*adj_iter);
-    if (pos!=distances.end()) {
+    const double d = overlayDistance(*adj_iter, w, 0);
+    if (d<std::numeric_limits<double>::max()) {
       ConnectorId id = graph_[*adj_iter].id;
       double edge_cost = graph_[edge(*adj_iter, v, graph_).first].cost;
-      ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", " Connector " << id << " has cost " << edge_cost+pos->second << "=" << edge_cost << "+" << pos->second);
-      shortestPath(id,j);
-      costs.push_back(ConnectorCost(id, edge_cost+pos->second));
+      ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", " Connector " << id << " has cost " << edge_cost+d << "=" << edge_cost << "+" << d);
+      costs.push_back(ConnectorCost(id, edge_cost+d));
     }
   }
   return costs;
@@ -192,68 +199,295 @@ pair<bool, double> Roadmap::costBetween (const ConnectorId i, const ConnectorId
 {
   ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Looking for shortest path between roadmap nodes " << i << " and " << j);
   
-  const RoadmapVertex v = idVertex(i);
-  const RoadmapVertex w = idVertex(j);
-
-  resetIndices();
-  DistanceMap distances;
-  PredecessorMap predecessors; // We shouldn't actually need this, but adding it removes a warning about boost/dijkstra_shortest_paths.hpp...
-
-  dijkstra_shortest_paths(graph_, v, weight_map(get(&EdgeInfo::cost, graph_)).
-                          vertex_index_map(get(&NodeInfo::index, graph_)).
-                          distance_map(DistancePmap(distances)).visitor(DijkstraVisitor()).
-                          predecessor_map(PredecessorPmap(predecessors)));
-  if (distances.find(w)==distances.end()) {
+  const double d = overlayDistance(idVertex(i), idVertex(j), 0);
+  if (d==std::numeric_limits<double>::max()) {
     ROS_DEBUG_NAMED ("roadmap_shortest_path", "Path not found");
     return pair<bool, double>(false, -1);
   }
   else {
-    ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Path found with length " << distances[w]);
-    return pair<bool, double>(true, distances[w]);
+    ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Path found with length " << d);
+    return pair<bool, double>(true, d);
   }
 }
 
 
-struct TransformVertexToId
+// Vertices added since the tree was computed, and temporary ones, are unreached
+inline
+RoadmapVertex treePredecessor (const ShortestPathTree& tree, const RoadmapVertex v)
 {
-  TransformVertexToId(const RoadmapImpl& graph) : graph(graph) {}
-  ConnectorId operator() (const RoadmapVertex& v) { return graph[v].id; }
-  const RoadmapImpl& graph;
-};
+  PredecessorMap::const_iterator pos = tree.predecessors.find(v);
+  return pos==tree.predecessors.end() ? v : pos->second;
+}
+
+inline
+double treeDistance (const ShortestPathTree& tree, const RoadmapVertex v)
+{
+  DistanceMap::const_iterator pos = tree.distances.find(v);
+  return pos==tree.distances.end() ? std::numeric_limits<double>::max() : pos->second;
+}
 
                          
 ConnectorIdVector Roadmap::shortestPath (const ConnectorId i, const ConnectorId j)
 {
   const RoadmapVertex v = idVertex(i);
   const RoadmapVertex w = idVertex(j);
-
-  resetIndices();
   PredecessorMap predecessors;
+  if (overlayDistance(v, w, &predecessors)==std::numeric_limits<double>::max()) {
+    throw NoPathFoundException(i,j);
+  }
 
-  dijkstra_shortest_paths(graph_, v, weight_map(get(&EdgeInfo::cost, graph_)).
-                          vertex_index_map(get(&NodeInfo::index, graph_)).
-                          predecessor_map(PredecessorPmap(predecessors)).
-                          visitor(DijkstraVisitor()));
-    
+  // Walk back from w.  A step between two permanent vertices stands for a path in the
+  // tree of the earlier one, which is walked back in turn.
+  vector<RoadmapVertex> reversed_path(1, w);
+  for (RoadmapVertex current=w; current!=v; ) {
+    const RoadmapVertex pred = predecessors[current];
+    if (!graph_[pred].temporary && !graph_[current].temporary) {
+      const ShortestPathTree& tree = sourceTree(pred);
+      for (RoadmapVertex u=treePredecessor(tree, current); u!=pred; u=treePredecessor(tree, u)) {
+        reversed_path.push_back(u);
+      }
+    }
+    reversed_path.push_back(current=pred);
+  }
 
+  ConnectorIdVector path;
+  for (vector<RoadmapVertex>::reverse_iterator iter=reversed_path.rbegin(); iter!=reversed_path.rend(); ++iter) {
+    ROS_DEBUG_STREAM_NAMED("roadmap_dijkstra", "  Path includes connector " << graph_[*iter].id);
+    path.push_back(graph_[*iter].id);
+  }
+  return path;
+}
 
-  // Extract path from predecessor map
-  vector<RoadmapVertex> reverse_path(1,w);
-  RoadmapVertex current = w;
 
-  while (current!=predecessors[current]) {
-    ROS_DEBUG_NAMED("roadmap_dijkstra", "  Predecessor of %d is %d with cost %f", graph_[current].id, 
-                    graph_[predecessors[current]].id, graph_[edge(current, predecessors[current], graph_).first].cost);
-    reverse_path.push_back(current=predecessors[current]);
+/************************************************************
+ * Shortest path trees
+ ************************************************************/
+
+const ShortestPathTree& Roadmap::sourceTree (const RoadmapVertex v)
+{
+  ShortestPathTreeMap::iterator pos = trees_.find(v);
+  if (pos!=trees_.end()) {
+    return pos->second;
   }
-  if (current!=v){
-    throw NoPathFoundException(i,j);
+
+  ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Computing shortest path tree from " << graph_[v].id);
+  ShortestPathTree& tree = trees_[v];
+  tree.distances[v] = 0.0;
+  tree.predecessors[v] = v;
+  UpdateQueue queue;
+  queue.push(QueueItem(0.0, v));
+  growTree(tree, queue);
+  return tree;
+}
+
+
+// Dijkstra search from v to w over a small graph made of v, w, the temporary vertices and
+// their neighbors.  Edges out of temporary vertices are the roadmap edges, and two permanent
+// vertices are joined by their distance in the cached trees.  Returns the max double if w
+// can't be reached, and the predecessors in the small graph if requested.
+double Roadmap::overlayDistance (const RoadmapVertex v, const RoadmapVertex w, PredecessorMap* predecessors)
+{
+  vector<RoadmapVertex> permanent;
+  if (!graph_[v].temporary) {
+    permanent.push_back(v);
+  }
+  if (!graph_[w].temporary && w!=v) {
+    permanent.push_back(w);
+  }
+  for (std::set<RoadmapVertex>::const_iterator iter=temporary_vertices_.begin(); iter!=temporary_vertices_.end(); ++iter) {
+    RoadmapAdjacencyIterator adj_iter, adj_end;
+    for (tie(adj_iter, adj_end)=adjacent_vertices(*iter, graph_); adj_iter!=adj_end; ++adj_iter) {
+      if (!graph_[*adj_iter].temporary && find(permanent.begin(), permanent.end(), *adj_iter)==permanent.end()) {
+        permanent.push_back(*adj_iter);
+      }
+    }
   }
 
-  // Put it in source-to-goal order, replace vertex descriptors with ids, and return
-  ConnectorIdVector path(reverse_path.size());
-  transform(reverse_path.rbegin(), reverse_path.rend(), path.begin(), TransformVertexToId(graph_));
-  return path;
+  DistanceMap distances;
+  PredecessorMap local_predecessors;
+  if (!predecessors) {
+    predecessors = &local_predecessors;
+  }
+  distances[v] = 0.0;
+  UpdateQueue queue;
+  queue.push(QueueItem(0.0, v));
+  while (!queue.empty()) {
+    const QueueItem item = queue.top();
+    queue.pop();
+    const RoadmapVertex u = item.second;
+    if (u==w) {
+      return item.first;
+    }
+    if (item.first>distances[u]) {
+      continue;
+    }
+
+    // Roadmap edges, which for permanent vertices are only needed to get to temporary ones
+    RoadmapAdjacencyIterator adj_iter, adj_end;
+    for (tie(adj_iter, adj_end)=adjacent_vertices(u, graph_); adj_iter!=adj_end; ++adj_iter) {
+      if (graph_[u].temporary || graph_[*adj_iter].temporary) {
+        const double d = item.first + graph_[edge(u, *adj_iter, graph_).first].cost;
+        DistanceMap::iterator pos = distances.find(*adj_iter);
+        if (pos==distances.end() || d<pos->second) {
+          distances[*adj_iter] = d;
+          (*predecessors)[*adj_iter] = u;
+          queue.push(QueueItem(d, *adj_iter));
+        }
+      }
+    }
+
+    if (!graph_[u].temporary) {
+      const ShortestPathTree& tree = sourceTree(u);
+      for (vector<RoadmapVertex>::const_iterator iter=permanent.begin(); iter!=permanent.end(); ++iter) {
+        const double tree_distance = treeDistance(tree, *iter);
+        if (*iter==u || tree_distance==std::numeric_limits<double>::max()) {
+          continue;
+        }
+        const double d = item.first + tree_distance;
+        DistanceMap::iterator pos = distances.find(*iter);
+        if (pos==distances.end() || d<pos->second) {
+          distances[*iter] = d;
+          (*predecessors)[*iter] = u;
+          queue.push(QueueItem(d, *iter));
+        }
+      }
+    }
+  }
+  return std::numeric_limits<double>::max();
+}
+
+
+// Continue a dijkstra search in tree from the vertices in the queue.  Temporary vertices
+// are never reached.
+void Roadmap::growTree (ShortestPathTree& tree, UpdateQueue& queue)
+{
+  while (!queue.empty()) {
+    const QueueItem item = queue.top();
+    queue.pop();
+    const RoadmapVertex u = item.second;
+    if (item.first>treeDistance(tree, u)) {
+      continue;
+    }
+    RoadmapAdjacencyIterator adj_iter, adj_end;
+    for (tie(adj_iter, adj_end)=adjacent_vertices(u, graph_); adj_iter!=adj_end; ++adj_iter) {
+      if (graph_[*adj_iter].temporary) {
+        continue;
+      }
+      const double d = item.first + graph_[edge(u, *adj_iter, graph_).first].cost;
+      if (d<treeDistance(tree, *adj_iter)) {
+        tree.distances[*adj_iter] = d;
+        tree.predecessors[*adj_iter] = u;
+        queue.push(QueueItem(d, *adj_iter));
+      }
+    }
+  }
+}
+
+
+// The edge between v and w was added or got cheaper: propagate the decrease through each
+// cached tree, as a dijkstra search started at the vertices whose distance went down
+void Roadmap::lowerTreeCosts (const RoadmapVertex v, const RoadmapVertex w, const double cost)
+{
+  for (ShortestPathTreeMap::iterator iter=trees_.begin(); iter!=trees_.end(); ++iter) {
+    ShortestPathTree& tree = iter->second;
+    UpdateQueue queue;
+    const double dv = treeDistance(tree, v);
+    const double dw = treeDistance(tree, w);
+    if (dv<std::numeric_limits<double>::max() && dv+cost<dw) {
+      tree.distances[w] = dv+cost;
+      tree.predecessors[w] = v;
+      queue.push(QueueItem(dv+cost, w));
+    }
+    else if (dw<std::numeric_limits<double>::max() && dw+cost<dv) {
+      tree.distances[v] = dw+cost;
+      tree.predecessors[v] = w;
+      queue.push(QueueItem(dw+cost, v));
+    }
+
+    growTree(tree, queue);
+  }
+}
+
+
+// The edge between v and w got more expensive.  In each tree that uses it, the subtree below
+// it is cut off and then regrown from its best neighbors in the rest of the tree.
+void Roadmap::raiseTreeCosts (const RoadmapVertex v, const RoadmapVertex w)
+{
+  for (ShortestPathTreeMap::iterator iter=trees_.begin(); iter!=trees_.end(); ++iter) {
+    ShortestPathTree& tree = iter->second;
+    RoadmapVertex child;
+    if (treePredecessor(tree, w)==v) {
+      child = w;
+    }
+    else if (treePredecessor(tree, v)==w) {
+      child = v;
+    }
+    else {
+      continue;
+    }
+
+    // The children of a vertex in the tree are among its neighbors in the graph
+    vector<RoadmapVertex> subtree(1, child);
+    for (uint k=0; k<subtree.size(); ++k) {
+      RoadmapAdjacencyIterator adj_iter, adj_end;
+      for (tie(adj_iter, adj_end)=adjacent_vertices(subtree[k], graph_); adj_iter!=adj_end; ++adj_iter) {
+        if (*adj_iter!=subtree[k] && treePredecessor(tree, *adj_iter)==subtree[k]) {
+          subtree.push_back(*adj_iter);
+        }
+      }
+    }
+    for (vector<RoadmapVertex>::const_iterator u=subtree.begin(); u!=subtree.end(); ++u) {
+      tree.distances.erase(*u);
+      tree.predecessors.erase(*u);
+    }
+
+    UpdateQueue queue;
+    for (vector<RoadmapVertex>::const_iterator u=subtree.begin(); u!=subtree.end(); ++u) {
+      RoadmapAdjacencyIterator adj_iter, adj_end;
+      for (tie(adj_iter, adj_end)=adjacent_vertices(*u, graph_); adj_iter!=adj_end; ++adj_iter) {
+        const double dist = treeDistance(tree, *adj_iter);
+        if (graph_[*adj_iter].temporary || dist==std::numeric_limits<double>::max()) {
+          continue;
+        }
+        const double d = dist + graph_[edge(*u, *adj_iter, graph_).first].cost;
+        if (d<treeDistance(tree, *u)) {
+          tree.distances[*u] = d;
+          tree.predecessors[*u] = *adj_iter;
+        }
+      }
+      if (tree.distances.find(*u)!=tree.distances.end()) {
+        queue.push(QueueItem(tree.distances[*u], *u));
+      }
+    }
+    growTree(tree, queue);
+  }
+}
+
+
+// v is about to be removed: drop its own tree and the trees in which it has descendants,
+// and forget about it in the others
+void Roadmap::dropTreesUsingVertex (const RoadmapVertex v)
+{
+  trees_.erase(v);
+  for (ShortestPathTreeMap::iterator iter=trees_.begin(); iter!=trees_.end(); ) {
+    ShortestPathTree& tree = iter->second;
+    bool used = false;
+    RoadmapAdjacencyIterator adj_iter, adj_end;
+    for (tie(adj_iter, adj_end)=adjacent_vertices(v, graph_); adj_iter!=adj_end; ++adj_iter) {
+      if (*adj_iter!=v && treePredecessor(tree, *adj_iter)==v) {
+        used = true;
+        break;
+      }
+    }
+    if (used) {
+      trees_.erase(iter++);
+    }
+    else {
+      tree.distances.erase(v);
+      tree.predecessors.erase(v);
+      ++iter;
+    }
+  }
 }
 
 
@@ -333,14 +567,6 @@ RoadmapVertex Roadmap::idVertex(const ConnectorId i) const
   }
 }
 
-void Roadmap::resetIndices()
-{
-  VertexIterator iter, end;
-  uint ind=0;
-  for (tie(iter,end) = vertices(graph_); iter!=end; ++iter) {
-    graph_[*iter].index=ind++;
-  }
-}
 
 
 
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/**
+ * \file
+ *
+ * Implements internally used PointIndex data structure
+ *
+ * \author Bhaskara Marthi
+ */
+
+#include <topological_map/point_index.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ros/assert.h>
+
+
+namespace topological_map
+{
+
+using std::min;
+using std::max;
+
+PointIndex::PointIndex (const double bucket_size) :
+  bucket_size_(bucket_size), min_r_(0), max_r_(-1), min_c_(0), max_c_(-1)
+{
+  ROS_ASSERT_MSG (bucket_size>0, "Bucket size %f of point index was not positive", bucket_size);
+}
+
+PointIndex::Bucket PointIndex::bucket (const Point2D& p) const
+{
+  return Bucket(floor(p.y/bucket_size_), floor(p.x/bucket_size_));
+}
+
+void PointIndex::insert (const unsigned id, const Point2D& p)
+{
+  remove(id);
+  points_[id] = p;
+  const Bucket b = bucket(p);
+  buckets_[b].push_back(Entry(id, p));
+  if (points_.size()==1) {
+    min_r_ = max_r_ = b.first;
+    min_c_ = max_c_ = b.second;
+  }
+  else {
+    min_r_ = min(min_r_, b.first);
+    max_r_ = max(max_r_, b.first);
+    min_c_ = min(min_c_, b.second);
+    max_c_ = max(max_c_, b.second);
+  }
+}
+
+void PointIndex::remove (const unsigned id)
+{
+  map<unsigned, Point2D>::iterator pos = points_.find(id);
+  if (pos==points_.end()) {
+    return;
+  }
+  BucketMap::iterator bucket_pos = buckets_.find(bucket(pos->second));
+  vector<Entry>& entries = bucket_pos->second;
+  for (vector<Entry>::iterator iter=entries.begin(); iter!=entries.end(); ++iter) {
+    if (iter->first==id) {
+      entries.erase(iter);
+      break;
+    }
+  }
+  if (entries.empty()) {
+    buckets_.erase(bucket_pos);
+  }
+  points_.erase(pos);
+}
+
+
+void PointIndex::searchBucket (const int r, const int c, const Point2D& p, unsigned* best, double* best_sq_dist) const
+{
+  BucketMap::const_iterator pos = buckets_.find(Bucket(r, c));
+  if (pos==buckets_.end()) {
+    return;
+  }
+  for (vector<Entry>::const_iterator iter=pos->second.begin(); iter!=pos->second.end(); ++iter) {
+    const Point2D& q = iter->second;
+    const double sq_dist = (q.x-p.x)*(q.x-p.x) + (q.y-p.y)*(q.y-p.y);
+    if (sq_dist<*best_sq_dist || (sq_dist==*best_sq_dist && iter->first<*best)) {
+      *best = iter->first;
+      *best_sq_dist = sq_dist;
+    }
+  }
+}
+
+
+pair<bool, unsigned> PointIndex::nearest (const Point2D& p) const
+{
+  if (points_.empty()) {
+    return pair<bool, unsigned>(false, 0);
+  }
+
+  // Rings of buckets at distance k from the one containing p, in the max norm, skipping the
+  // ones outside the bounds.  Points beyond ring k are more than k*bucket_size_ away from p.
+  const Bucket b = bucket(p);
+  const int r0 = b.first;
+  const int c0 = b.second;
+  const int k_min = max(max(min_r_-r0, r0-max_r_), max(max(min_c_-c0, c0-max_c_), 0));
+  const int k_max = max(max(r0-min_r_, max_r_-r0), max(c0-min_c_, max_c_-c0));
+
+  unsigned best = 0;
+  double best_sq_dist = std::numeric_limits<double>::max();
+  for (int k=k_min; k<=k_max; ++k) {
+    const int rmin = max(r0-k, min_r_);
+    const int rmax = min(r0+k, max_r_);
+    const int cmin = max(c0-k, min_c_);
+    const int cmax = min(c0+k, max_c_);
+    for (int r=rmin; r<=rmax; ++r) {
+      if (r==r0-k || r==r0+k) {
+        for (int c=cmin; c<=cmax; ++c) {
+          searchBucket(r, c, p, &best, &best_sq_dist);
+        }
+      }
+      else {
+        if (c0-k>=min_c_) {
+          searchBucket(r, c0-k, p, &best, &best_sq_dist);
+        }
+        if (k>0 && c0+k<=max_c_) {
+          searchBucket(r, c0+k, p, &best, &best_sq_dist);
+        }
+      }
+    }
+    const double covered = k*bucket_size_;
+    if (best_sq_dist<=covered*covered) {
+      break;
+    }
+  }
+  ROS_ASSERT (best_sq_dist<std::numeric_limits<double>::max());
+  return pair<bool, unsigned>(true, best);
+}
+
+
+} // namespace
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/**
+ * \file
+ *
+ * Times the spatial lookups made by the executive (containing region, nearest door and nearest
+ * outlet) at random free points of a topological map, e.g. 
+ *   bin/query_benchmark -t willow.tmap -n 100000
+ */
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <sys/time.h>
+#include <boost/program_options.hpp>
+#include <boost/foreach.hpp>
+#include <topological_map/topological_map.h>
+#include <topological_map/exception.h>
+
+#define foreach BOOST_FOREACH
+
+using std::vector;
+using std::string;
+using std::cout;
+using std::endl;
+using std::ifstream;
+namespace tmap=topological_map;
+using tmap::Point2D;
+using tmap::Cell2D;
+using tmap::RegionId;
+using tmap::TopologicalMap;
+
+namespace po=boost::program_options;
+
+double wallTime ()
+{
+  timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + 1e-6*t.tv_usec;
+}
+
+void report (const string& name, const double start, const unsigned num_queries)
+{
+  cout << name << ": " << 1e6*(wallTime()-start)/num_queries << " us per query" << endl;
+}
+
+int main (int argc, char* argv[])
+{
+  string top_map_file("");
+  unsigned num_queries = 10000;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("num_queries,n", po::value<unsigned>(&num_queries), "Number of queries of each type.  Defaults to 10000.")
+    ("topological_map,t", po::value<string>(&top_map_file), "Topological map file.  Required.");
+  
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  po::notify(vm);    
+
+  if (vm.count("help") || !vm.count("topological_map")) {
+    cout << desc;
+    return 1;
+  }
+
+  ifstream str(top_map_file.c_str());
+  TopologicalMap m(str, 1.0, 1e9, 1e9);
+
+  // Query points are the centers of random cells that belong to some region
+  vector<Cell2D> cells;
+  foreach (const RegionId id, m.allRegions()) {
+    tmap::RegionPtr region = m.regionCells(id);
+    cells.insert(cells.end(), region->begin(), region->end());
+  }
+  srand(42);
+  vector<Point2D> points(num_queries);
+  for (unsigned i=0; i<num_queries; ++i) {
+    points[i] = m.centerPoint(cells[rand()%cells.size()]);
+  }
+  cout << m.allRegions().size() << " regions, " << m.allOutlets().size() << " outlets" << endl;
+
+  double start = wallTime();
+  foreach (const Point2D& p, points) {
+    m.containingRegion(p);
+  }
+  report("containingRegion", start, num_queries);
+
+  start = wallTime();
+  foreach (const Point2D& p, points) {
+    m.nearestDoor(p);
+  }
+  report("nearestDoor", start, num_queries);
+
+  if (!m.allOutlets().empty()) {
+    start = wallTime();
+    foreach (const Point2D& p, points) {
+      m.nearestOutlet(p);
+    }
+    report("nearestOutlet", start, num_queries);
+  }
+}
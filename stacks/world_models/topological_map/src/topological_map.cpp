@@ -41,6 +41,7 @@
 #include <topological_map/region_graph.h>
 #include <topological_map/grid_graph.h>
 #include <topological_map/roadmap.h>
+#include <topological_map/point_index.h>
 #include <topological_map/door_info.h>
 #include <algorithm>
 #include <cmath>
@@ -94,6 +95,16 @@ namespace topological_map
 
 typedef boost::counting_iterator<unsigned int> Counter;
 
+/************************************************************
+ * Constants
+ ************************************************************/
+
+namespace
+{
+// Size in metres of the buckets used to index door and outlet positions
+const double INDEX_BUCKET_SIZE = 5.0;
+}
+
 /************************************************************
  * Utility
  ************************************************************/
@@ -633,6 +644,7 @@ TopologicalMap::MapImpl::MapImpl(const OccupancyGrid& grid, double resolution, d
   roadmap_(new Roadmap), grid_graph_(new GridGraph(grid_)), door_open_prior_prob_(door_open_prior_prob), 
   door_reversion_rate_(door_reversion_rate), locked_door_cost_(locked_door_cost), resolution_(resolution)
 {
+  buildIndices();
 }
 
 TopologicalMap::MapImpl::MapImpl (istream& str, double door_open_prior_prob, double door_reversion_rate,
@@ -644,6 +656,42 @@ TopologicalMap::MapImpl::MapImpl (istream& str, double door_open_prior_prob, dou
   region_door_map_(readRegionDoorMap(str, door_open_prior_prob_)), 
   outlets_(readOutlets(str)), resolution_(readResolution(str))
 {
+  buildIndices();
+}
+
+void TopologicalMap::MapImpl::buildIndices ()
+{
+  cell_regions_.resize(extents[numRows(*grid_)][numCols(*grid_)]);
+  door_index_ = shared_ptr<PointIndex>(new PointIndex(INDEX_BUCKET_SIZE));
+  outlet_index_ = shared_ptr<PointIndex>(new PointIndex(INDEX_BUCKET_SIZE));
+
+  foreach (const RegionId id, allRegions()) {
+    indexRegion(id, id);
+  }
+  for (RegionDoorMap::const_iterator iter=region_door_map_.begin(); iter!=region_door_map_.end(); ++iter) {
+    indexDoor(iter->first);
+  }
+  for (uint i=0; i<outlets_.size(); ++i) {
+    outlet_index_->insert(i+1, Point2D(outlets_[i].x, outlets_[i].y));
+  }
+}
+
+// Set the entries of the cells of region id in the cell index to value
+void TopologicalMap::MapImpl::indexRegion (const RegionId id, const RegionId value)
+{
+  RegionPtr region = regionCells(id);
+  for (Region::const_iterator iter=region->begin(); iter!=region->end(); ++iter) {
+    if (cellOnMap(*iter)) {
+      cell_regions_[iter->r][iter->c] = value;
+    }
+  }
+}
+
+// Doors are indexed by the first endpoint of the door in the latest door message
+void TopologicalMap::MapImpl::indexDoor (const RegionId id)
+{
+  const Door door = regionDoor(id);
+  door_index_->insert(id, Point2D(door.door_p1.x, door.door_p1.y));
 }
 
 
@@ -679,7 +727,10 @@ RegionId TopologicalMap::MapImpl::containingRegion (const Cell2D& c) const
       }
       
       else {
-        RegionId region = region_graph_->containingRegion(cell);
+        RegionId region = cell_regions_[cell.r][cell.c];
+        if (region==0) {
+          throw UnknownGridCellException(cell);
+        }
 
         // The old way found all such regions and made sure there was just one
         // Now we just return the first one we find (which will be the closest)
@@ -757,6 +808,7 @@ void TopologicalMap::MapImpl::observeDoorMessage (RegionId id, const Door& msg)
   else {
     iter->second->observeDoorMessage(msg);
   }
+  indexDoor(id);
 }
 
 void TopologicalMap::MapImpl::observeDoorTraversal (RegionId id, bool succeeded, const Time& stamp)
@@ -895,27 +947,6 @@ Point2D TopologicalMap::MapImpl::doorApproachPosition (const ConnectorId id, con
 
 
 
-bool TopologicalMap::MapImpl::notDoor (const RegionId id) const
-{
-  return regionType(id)!=DOORWAY;
-}
-
-
-bool TopologicalMap::MapImpl::doorCloser (const double x, const double y, const RegionId id1, const RegionId id2) const
-{
-  const double x1=regionDoor(id1).door_p1.x;
-  const double y1=regionDoor(id1).door_p1.y;
-  const double x2=regionDoor(id2).door_p2.x;
-  const double y2=regionDoor(id2).door_p2.y;
-
-  const double dist1 = pow(x1-x,2)+pow(y1-y,2);
-  const double dist2 = pow(x2-x,2)+pow(y2-y,2);
-  // ROS_DEBUG_STREAM ("Distance from " << id1 << ": " << x1 << ", " << y1 << " to " << x << ", " << y << " is " << dist1);
-
-  return dist1 < dist2;
-}
-
-
 RegionId TopologicalMap::nearestDoor (const Point2D& p) const
 {
   return map_impl_->nearestDoor(p);
@@ -923,11 +954,9 @@ RegionId TopologicalMap::nearestDoor (const Point2D& p) const
 
 RegionId TopologicalMap::MapImpl::nearestDoor (const Point2D& p) const
 {
-  RegionIdSet doors;
-  remove_copy_if (allRegions().begin(), allRegions().end(), inserter(doors, doors.begin()), bind(&TopologicalMap::MapImpl::notDoor, this, _1));
-  RegionIdSet::iterator best = min_element (doors.begin(), doors.end(), bind(&TopologicalMap::MapImpl::doorCloser, this, p.x, p.y, _1, _2));
-  ROS_ASSERT_MSG (best!=doors.end(), "Unexpectedly could not find doors near %f, %f", p.x, p.y);
-  return *best;
+  pair<bool, RegionId> best = door_index_->nearest(p);
+  ROS_ASSERT_MSG (best.first, "Unexpectedly could not find doors near %f, %f", p.x, p.y);
+  return best.second;
 }
 
   
@@ -959,27 +988,12 @@ const OutletInfo& getOutletInfo (const OutletVector& outlets, const OutletId id)
     return outlets[id-1];
 }
 
-struct CloserTo
-{
-  CloserTo(const double x, const double y) : x(x), y(y) {}
-  bool operator() (const OutletInfo& o1, const OutletInfo& o2) 
-  {
-    return sqDist(o1.x, o1.y)<sqDist(o2.x,o2.y);
-  }
-  double sqDist(double x2, double y2)
-  {
-    return (pow(x2-x,2)+pow(y2-y,2));
-  }
-  double x, y;
-};
-  
-
 OutletId TopologicalMap::MapImpl::nearestOutlet (const Point2D& p) const
 {
-  OutletVector::const_iterator pos = min_element(outlets_.begin(), outlets_.end(), CloserTo(p.x, p.y));
-  if (pos==outlets_.end()) 
+  pair<bool, OutletId> best = outlet_index_->nearest(p);
+  if (!best.first) 
     throw NoOutletException(p.x, p.y);
-  return 1+(pos-outlets_.begin());
+  return best.second;
 }
 
 void TopologicalMap::MapImpl::observeOutletBlocked (const OutletId id)
@@ -995,6 +1009,7 @@ OutletInfo TopologicalMap::MapImpl::outletInfo (const OutletId id) const
 OutletId TopologicalMap::MapImpl::addOutlet (const OutletInfo& outlet)
 {
   outlets_.push_back(outlet);
+  outlet_index_->insert(outlets_.size(), Point2D(outlet.x, outlet.y));
   return outlets_.size();
 }
 
@@ -1055,6 +1070,8 @@ Point2D TopologicalMap::MapImpl::outletApproachPosition (const OutletId id, cons
 /// \todo this doesn't deal with connectors
 void TopologicalMap::MapImpl::removeRegion (const RegionId id)
 {
+  indexRegion(id, 0);
+  door_index_->remove(id);
   region_graph_->removeRegion(id);
 }
 
@@ -1098,6 +1115,7 @@ struct NeighborFinder
 RegionId TopologicalMap::MapImpl::addRegion (const RegionPtr region, const int type, bool update_distances)
 {
   RegionId region_id = region_graph_->addRegion(region, type);
+  indexRegion(region_id, region_id);
   RegionIdVector neighbors = region_graph_->neighbors(region_id);
 
 
@@ -1385,15 +1403,14 @@ ReachableCost TopologicalMap::MapImpl::getDistance (const Point2D& p1, const Poi
     TemporaryRoadmapNode start(this, p1);
     TemporaryRoadmapNode goal(this, p2);
     ReachableCost rcost = roadmap_->costBetween(start.id, goal.id);
-    double cost = rcost.second;
-    ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Adding roadmap distance cache entry " << p1 << " " << p2 << " " << cost);
-    roadmap_distance_cache_[pair] = cost;
+    ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Adding roadmap distance cache entry " << p1 << " " << p2 << " " << rcost.second);
+    roadmap_distance_cache_[pair] = rcost;
     return rcost;
   }
   else {
-    double cached_cost = roadmap_distance_cache_[pair];
-    ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Using cached roadmap cost " << cached_cost);
-    return ReachableCost(true, cached_cost);
+    ReachableCost cached_cost = roadmap_distance_cache_[pair];
+    ROS_DEBUG_STREAM_NAMED ("roadmap_shortest_path", "Using cached roadmap cost " << cached_cost.second);
+    return cached_cost;
   }
                             
 }
@@ -1468,7 +1485,7 @@ Cell2D getCell (const ConnectorDesc& desc)
 }
 
 TopologicalMap::MapImpl::TemporaryRoadmapNode::TemporaryRoadmapNode (TopologicalMap::MapImpl* m, const Point2D& p)
-  : map(m), id(m->roadmap_->addNode(p))
+  : map(m), id(m->roadmap_->addTemporaryNode(p))
 {
   Cell2D cell = m->containingCell(p);
   RegionId r = m->containingRegion(cell);
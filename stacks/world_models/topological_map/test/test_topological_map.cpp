@@ -29,6 +29,8 @@
 
 #include "topological_map/topological_map.h"
 #include "topological_map/exception.h"
+#include "topological_map/roadmap.h"
+#include "topological_map/point_index.h"
 #include <iostream>
 #include <sstream>
 #include <cmath>
@@ -273,6 +275,79 @@ TEST(TopologicalMap, Creation)
   EXPECT_TRUE(path.size()<=100);
 }
 
+TEST(Roadmap, CachedShortestPaths)
+{
+  Roadmap r;
+  ConnectorId a=r.addNode(Point2D(0,0));
+  ConnectorId b=r.addNode(Point2D(1,0));
+  ConnectorId c=r.addNode(Point2D(2,0));
+  ConnectorId d=r.addNode(Point2D(3,0));
+  r.setCost(a,b,1);
+  r.setCost(b,c,1);
+  r.setCost(c,d,1);
+  r.setCost(a,d,10);
+
+  EXPECT_EQ(r.costBetween(a,d), ReachableCost(true, 3));
+  ConnectorIdVector path = r.shortestPath(a,d);
+  ASSERT_EQ(path.size(), 4u);
+  EXPECT_EQ(path[1], b);
+  EXPECT_EQ(path[2], c);
+
+  // Raising and lowering costs updates the cached trees
+  r.setCost(b,c,20);
+  EXPECT_EQ(r.costBetween(a,d), ReachableCost(true, 10));
+  EXPECT_EQ(r.shortestPath(a,d).size(), 2u);
+  r.setCost(b,c,2);
+  EXPECT_EQ(r.costBetween(d,a), ReachableCost(true, 4));
+
+  // Paths may go through temporary nodes, which don't affect the trees once removed
+  ConnectorId s=r.addTemporaryNode(Point2D(1,1));
+  r.setCost(s,a,1);
+  r.setCost(s,d,1);
+  EXPECT_EQ(r.costBetween(a,d), ReachableCost(true, 2));
+  path = r.shortestPath(a,d);
+  ASSERT_EQ(path.size(), 3u);
+  EXPECT_EQ(path[1], s);
+  r.removeNode(s);
+  EXPECT_EQ(r.costBetween(a,d), ReachableCost(true, 4));
+
+  r.removeNode(c);
+  EXPECT_EQ(r.costBetween(a,d), ReachableCost(true, 10));
+  ConnectorCosts costs = r.connectorCosts(a,d);
+  ASSERT_EQ(costs.size(), 2u);
+  for (unsigned int i=0; i<costs.size(); i++) {
+    EXPECT_EQ(costs[i].second, costs[i].first==b ? 12 : 10);
+  }
+
+  ConnectorId e=r.addNode(Point2D(4,0));
+  EXPECT_FALSE(r.costBetween(a,e).first);
+  EXPECT_THROW(r.shortestPath(a,e), NoPathFoundException);
+}
+
+TEST(PointIndex, Nearest)
+{
+  PointIndex index(2.0);
+  EXPECT_FALSE(index.nearest(Point2D(0,0)).first);
+
+  index.insert(1, Point2D(0.5, 0.5));
+  index.insert(2, Point2D(10.5, 3));
+  index.insert(3, Point2D(-7, -20));
+  EXPECT_EQ(index.nearest(Point2D(1,1)), make_pair(true, 1u));
+  EXPECT_EQ(index.nearest(Point2D(7,2)), make_pair(true, 2u));
+  EXPECT_EQ(index.nearest(Point2D(100,-100)), make_pair(true, 3u));
+
+  // Ties go to the lower id
+  index.insert(4, Point2D(1.5, 0.5));
+  EXPECT_EQ(index.nearest(Point2D(1,0.5)), make_pair(true, 1u));
+
+  // Moving and removing points
+  index.insert(1, Point2D(50, 50));
+  EXPECT_EQ(index.nearest(Point2D(1,0.5)), make_pair(true, 4u));
+  index.remove(4);
+  EXPECT_EQ(index.nearest(Point2D(1,0.5)), make_pair(true, 2u));
+  EXPECT_EQ(index.size(), 3u);
+}
+
 int main (int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
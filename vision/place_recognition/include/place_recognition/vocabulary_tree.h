@@ -10,7 +10,6 @@
 #include <string>
 #include <Eigen/Core>
 #include <boost/pool/object_pool.hpp>
-#include <boost/noncopyable.hpp>
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/tail.hpp>
 #include <boost/cstdint.hpp>
@@ -27,7 +26,7 @@ using boost::uint8_t;
 //       good for speed, memory management...
 // TODO: const correctness in API
 // NOTE: training requires float signatures, query/insert require uchar signatures
-class VocabularyTree : boost::noncopyable
+class VocabularyTree
 {
 public:
   
@@ -99,15 +98,27 @@ public:
   unsigned int databaseSize() { return db_vectors_.size(); }
   
   // File I/O
+  //! Save in the text format
   void save(const std::string& file);
+  //! Save in the binary format, which load() memory-maps
+  void saveBinary(const std::string& file);
+  //! Load a tree saved in either format
   void load(const std::string& file);
+
+  ~VocabularyTree();
   
 //private:
   typedef std::map<unsigned int, unsigned int> InvertedFile;
   typedef std::back_insert_iterator< std::vector<unsigned int> > IdOutputIterator;
-  
-  // TODO: better to keep child centroids together in parent? (locality)
-  // TODO: think more on child memory management
+
+#ifdef USE_BYTE_SIGNATURES
+  typedef uint8_t Centroid;
+#else
+  typedef float Centroid;
+#endif
+
+  // Nodes as built by kmeans or read from the text format. They only exist
+  // until flatten() lays them out breadth-first.
   struct Node
   {
     Node() : weight(0.0f) {
@@ -128,57 +139,107 @@ public:
     float weight;
   };
 
-  typedef std::map< Node*, float > ImageVector;
+  typedef boost::object_pool<Node> NodePool;
 
-  Node* newNode();
-  
-  void clearDatabaseAux(Node* node);
+  // Database vectors are indexed by node
+  typedef std::map< unsigned int, float > ImageVector;
+
+  // Header of the binary format. Sections are at the given byte offsets from
+  // the start of the file, in native byte order:
+  //   first_child   uint32[num_nodes + 1]
+  //   weights       float[num_nodes]
+  //   centroids     Centroid[num_nodes * dim], 16-byte aligned
+  //   database      uint32[num_nodes + 1] offsets into (id, frequency)
+  //                 uint32 pairs, the inverted files; only if database_images > 0
+  struct BinaryHeader
+  {
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t centroid_size; // sizeof(Centroid)
+    boost::uint32_t k, levels, dim;
+    boost::uint32_t num_nodes;
+    boost::uint32_t database_images;
+    boost::uint32_t reserved;
+    float bounds[2];
+    boost::uint64_t first_child_offset, weights_offset, centroids_offset;
+    boost::uint64_t database_offset, file_size;
+  };
+
+  static const char BINARY_MAGIC[8];
+  static const boost::uint32_t BINARY_VERSION = 1;
+
+  Node* newNode(NodePool& pool);
+
+  unsigned int numChildren(unsigned int node) const
+  {
+    return first_child_[node + 1] - first_child_[node];
+  }
+
+  bool isLeaf(unsigned int node) const
+  {
+    return first_child_[node + 1] == first_child_[node];
+  }
+
+  const Centroid* centroid(unsigned int node) const
+  {
+    return centroids_ + node * dim_;
+  }
+
+  void flatten(Node* root);
+
+  void releaseVocabulary();
+
+  InvertedFile& invertedFile(unsigned int node);
   
-  void saveAux(Node* node, FILE* out, std::string indentation = "");
+  void saveAux(unsigned int node, FILE* out, std::string indentation = "");
+
+  void loadAux(Node* node, NodePool& pool, FILE* in, unsigned int indent_level = 0);
 
-  void loadAux(Node* node, FILE* in, unsigned int indent_level = 0);
+  void loadText(FILE* in);
+
+  void loadBinary(const std::string& file);
 
   void constructVocabulary(const FeatureMatrix& features,
                            const std::vector<unsigned int>& input);
   
   void constructVocabularyAux(const FeatureMatrix& features,
                               const std::vector<unsigned int>& input,
-                              Node* node, unsigned int level);
+                              Node* node, NodePool& pool, unsigned int level);
 
-  boost::uint64_t findWordAux(Node* node, const uint8_t* feature);
+  unsigned int findWordAux(unsigned int node, const uint8_t* feature);
   
 #ifdef USE_BYTE_SIGNATURES
-  Node* findNearestChild(Node* node, const uint8_t* feature);
+  unsigned int findNearestChild(unsigned int node, const uint8_t* feature);
 #else
-  Node* findNearestChild(Node* node, const FeatureMatrix::RowXpr& feature);
+  unsigned int findNearestChild(unsigned int node, const FeatureMatrix::RowXpr& feature);
 #endif
 
-  void addFeature(Node* node, unsigned int object_id,
+  void addFeature(unsigned int node, unsigned int object_id,
                   const FeatureMatrix::RowXpr& feature);
 #ifdef USE_BYTE_SIGNATURES
-  void addFeature(Node* node, unsigned int object_id, const uint8_t* feature);
+  void addFeature(unsigned int node, unsigned int object_id, const uint8_t* feature);
 
-  void addFeatureToQuery(Node* node, ImageVector& vec, const uint8_t* feature);
+  void addFeatureToQuery(unsigned int node, ImageVector& vec, const uint8_t* feature);
 
-  void addFeatureToDatabaseVector(Node* node, unsigned int object_id,
+  void addFeatureToDatabaseVector(unsigned int node, unsigned int object_id,
                                   const uint8_t* feature);
 #else  
-  void addFeatureToQuery(Node* node, ImageVector& vec,
+  void addFeatureToQuery(unsigned int node, ImageVector& vec,
                          const FeatureMatrix::RowXpr& feature);
 
-  void addFeatureToDatabaseVector(Node* node, unsigned int object_id,
+  void addFeatureToDatabaseVector(unsigned int node, unsigned int object_id,
                                   const FeatureMatrix::RowXpr& feature);
 #endif
 
   float tfIdfWeight(size_t N_i);
   
-  void recursiveTfIdfWeighting(Node* node, IdOutputIterator output);
+  void recursiveTfIdfWeighting(unsigned int node, IdOutputIterator output);
   
   void assignWeights();
 
-  void updateFiles(Node* node, InvertedFile& file, InvertedFile& parent_file);
+  void updateFiles(unsigned int node, InvertedFile& file, InvertedFile& parent_file);
   
-  void calculateDatabaseVectorsAux(Node* node, InvertedFile& parent_file);
+  void calculateDatabaseVectorsAux(unsigned int node, InvertedFile& parent_file);
 
   void calculateDatabaseVectors();
 
@@ -186,25 +247,47 @@ public:
 
   float distanceL1(const ImageVector& v1, const ImageVector& v2);
 
-  // TODO: problematic if multiple pools instantiated? weird I/O issue...
-  Node* root_;
-  boost::object_pool<Node> pool_; // for fast node allocation
+  // The vocabulary, flattened breadth-first. Node 0 is the root, the children
+  // of node i are nodes [first_child_[i], first_child_[i+1]), so each level
+  // is a contiguous run of nodes and so are the centroids of any node's
+  // children. The root has an (unused) centroid too.
+  unsigned int num_nodes_;
+  const boost::uint32_t* first_child_;
+  const float* weights_;
+  const Centroid* centroids_;
+  // Storage behind the arrays above for a built or text-loaded tree...
+  std::vector<boost::uint32_t> first_child_storage_;
+  std::vector<float> weight_storage_;
+  std::vector<Centroid> centroid_storage_;
+  // ...or the read-only mapping of a binary file
+  void* mapping_;
+  size_t mapping_size_;
+  // Inverted files, indexed by node; empty until a feature is added
+  std::vector<InvertedFile> inverted_files_;
+  
   unsigned int k_; // branching factor
   unsigned int levels_; // max # levels
   unsigned int dim_; // descriptor dimension
   std::vector< ImageVector > db_vectors_; // precomputed database vectors
   float bounds_[2];
   static const int QUANTIZE_N = 15; // TODO: OK to leave this hard-coded?
+
+private:
+  // Not copyable: first_child_, weights_ and centroids_ point into this
+  // object's own storage or its mapping, which the destructor unmaps
+  VocabularyTree(const VocabularyTree&);
+  VocabularyTree& operator=(const VocabularyTree&);
 };
 
 
 inline VocabularyTree::VocabularyTree()
-  : root_(NULL), k_(0), levels_(0), dim_(0)
+  : num_nodes_(0), first_child_(NULL), weights_(NULL), centroids_(NULL),
+    mapping_(NULL), mapping_size_(0), k_(0), levels_(0), dim_(0)
 {}
 
-inline VocabularyTree::Node* VocabularyTree::newNode()
+inline VocabularyTree::Node* VocabularyTree::newNode(NodePool& pool)
 {
-  Node* node = pool_.construct();
+  Node* node = pool.construct();
   if (node == NULL) {
     printf("Unable to construct node - pool out of memory!\n");
     abort();
@@ -220,7 +303,7 @@ void VocabularyTree::find(const uint8_t* query, unsigned int num_features,
   ImageVector query_vec;
 
   for (unsigned int i = 0; i < num_features; ++i)
-    addFeatureToQuery(root_, query_vec, query + i*dim_);
+    addFeatureToQuery(0, query_vec, query + i*dim_);
   normalizeL1(query_vec);
   //printf("Size of query_vec: %u\n", query_vec.size());
 
@@ -246,7 +329,7 @@ void VocabularyTree::find(const FeatureMatrix& query, unsigned int N,
   ImageVector query_vec;
 
   for (int i = 0; i < query.rows(); ++i)
-    addFeatureToQuery(root_, query_vec, query.row(i));
+    addFeatureToQuery(0, query_vec, query.row(i));
   normalizeL1(query_vec);
   //printf("Size of query_vec: %u\n", query_vec.size());
 
@@ -275,7 +358,7 @@ unsigned int VocabularyTree::findAndInsert(const uint8_t* features,
   unsigned int id = db_vectors_.size();
   db_vectors_.resize(id + 1);
   for (unsigned int i = 0; i < num_features; ++i)
-    addFeatureToDatabaseVector(root_, id, features + i*dim_);
+    addFeatureToDatabaseVector(0, id, features + i*dim_);
   normalizeL1(db_vectors_[id]);
 
   // accumulate the best N matches
@@ -303,7 +386,7 @@ unsigned int VocabularyTree::findAndInsert(const FeatureMatrix& features,
   unsigned int id = db_vectors_.size();
   db_vectors_.resize(id + 1);
   for (int i = 0; i < features.rows(); ++i)
-    addFeatureToDatabaseVector(root_, id, features.row(i));
+    addFeatureToDatabaseVector(0, id, features.row(i));
   normalizeL1(db_vectors_[id]);
 
   // accumulate the best N matches
@@ -0,0 +1,25 @@
+#include "place_recognition/vocabulary_tree.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace vision;
+
+// Converts a vocabulary tree between the text and binary formats. The input
+// may be in either format; the output is binary unless -t is given.
+int main(int argc, char** argv)
+{
+  bool text = argc > 1 && !strcmp(argv[1], "-t");
+  if (argc < 3 + text) {
+    printf("Usage: %s [-t] input.tree output.tree\n", argv[0]);
+    return 0;
+  }
+  
+  VocabularyTree tree;
+  tree.load(argv[1 + text]);
+  if (text)
+    tree.save(argv[2 + text]);
+  else
+    tree.saveBinary(argv[2 + text]);
+
+  return 0;
+}
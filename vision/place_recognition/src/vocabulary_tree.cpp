@@ -3,6 +3,11 @@
 #include <boost/foreach.hpp>
 #include <boost/accumulators/statistics/p_square_quantile.hpp>
 #include <limits>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #ifdef USE_BYTE_SIGNATURES
 #include <cstdlib> // posix_memalign
 #include "calonder_descriptor/randomized_tree.h" // quantizeVector
@@ -11,6 +16,13 @@
 
 namespace vision {
 
+const char VocabularyTree::BINARY_MAGIC[8] = "VOCTREE";
+
+VocabularyTree::~VocabularyTree()
+{
+  releaseVocabulary();
+}
+
 // TODO: currently assume objs contains indices in [0, nObjs)
 // TODO: choose between calculating database vectors or clearing objects
 void VocabularyTree::build( const FeatureMatrix& features,
@@ -50,7 +62,7 @@ void VocabularyTree::build( const FeatureMatrix& features,
   // step 2: add objects
   printf("Adding objects...\n");
   for (int i = 0; i < features.rows(); ++i)
-    addFeature(root_, objs[i], features.row(i));
+    addFeature(0, objs[i], features.row(i));
 
   // step 3: assign weight
   printf("Assigning weights...\n");
@@ -66,17 +78,77 @@ void VocabularyTree::build( const FeatureMatrix& features,
     clearDatabase();
 }
 
-void VocabularyTree::clearDatabaseAux(Node* node)
+void VocabularyTree::clearDatabase()
 {
-  node->inverted_file.clear();
-  BOOST_FOREACH( Node* child, node->children )
-    clearDatabaseAux(child);
+  db_vectors_.clear();
+  inverted_files_.clear();
 }
 
-void VocabularyTree::clearDatabase()
+VocabularyTree::InvertedFile& VocabularyTree::invertedFile(unsigned int node)
 {
-  db_vectors_.clear();
-  clearDatabaseAux(root_);
+  if (inverted_files_.empty())
+    inverted_files_.resize(num_nodes_);
+  return inverted_files_[node];
+}
+
+void VocabularyTree::releaseVocabulary()
+{
+  if (mapping_ != NULL) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = NULL;
+    mapping_size_ = 0;
+  }
+  std::vector<boost::uint32_t>().swap(first_child_storage_);
+  std::vector<float>().swap(weight_storage_);
+  std::vector<Centroid>().swap(centroid_storage_);
+  std::vector<InvertedFile>().swap(inverted_files_);
+  num_nodes_ = 0;
+  first_child_ = NULL;
+  weights_ = NULL;
+  centroids_ = NULL;
+}
+
+// Lays out the tree under root breadth-first into the flat arrays
+void VocabularyTree::flatten(Node* root)
+{
+  releaseVocabulary();
+
+  std::vector<Node*> nodes(1, root);
+  for (size_t i = 0; i < nodes.size(); ++i)
+    nodes.insert(nodes.end(), nodes[i]->children.begin(), nodes[i]->children.end());
+  
+  num_nodes_ = nodes.size();
+  first_child_storage_.resize(num_nodes_ + 1);
+  weight_storage_.resize(num_nodes_);
+  centroid_storage_.resize(num_nodes_ * dim_);
+  bool have_files = false;
+  unsigned int next_child = 1;
+  for (unsigned int i = 0; i < num_nodes_; ++i) {
+    Node* node = nodes[i];
+    first_child_storage_[i] = next_child;
+    next_child += node->children.size();
+    weight_storage_[i] = node->weight;
+    if (i != 0) {
+#ifdef USE_BYTE_SIGNATURES
+      memcpy(&centroid_storage_[i * dim_], node->centroid, dim_);
+#else
+      std::copy(node->centroid.data(), node->centroid.data() + dim_,
+                centroid_storage_.begin() + i * dim_);
+#endif
+    }
+    have_files = have_files || !node->inverted_file.empty();
+  }
+  first_child_storage_[num_nodes_] = next_child;
+
+  if (have_files) {
+    inverted_files_.resize(num_nodes_);
+    for (unsigned int i = 0; i < num_nodes_; ++i)
+      inverted_files_[i].swap(nodes[i]->inverted_file);
+  }
+
+  first_child_ = &first_child_storage_[0];
+  weights_ = &weight_storage_[0];
+  centroids_ = centroid_storage_.empty() ? NULL : &centroid_storage_[0];
 }
 
 #ifdef USE_BYTE_SIGNATURES
@@ -86,7 +158,7 @@ unsigned int VocabularyTree::insert(const uint8_t* image_features,
   unsigned int id = db_vectors_.size();
   db_vectors_.resize(id + 1);
   for (unsigned int i = 0; i < num_features; ++i)
-    addFeatureToDatabaseVector(root_, id, image_features + i*dim_);
+    addFeatureToDatabaseVector(0, id, image_features + i*dim_);
   normalizeL1(db_vectors_[id]);
   
   return id;
@@ -97,7 +169,7 @@ unsigned int VocabularyTree::insert(const FeatureMatrix& image_features)
   unsigned int id = db_vectors_.size();
   db_vectors_.resize(id + 1);
   for (int i = 0; i < image_features.rows(); ++i)
-    addFeatureToDatabaseVector(root_, id, image_features.row(i));    
+    addFeatureToDatabaseVector(0, id, image_features.row(i));    
   normalizeL1(db_vectors_[id]);
   
   return id;
@@ -108,14 +180,17 @@ unsigned int VocabularyTree::insert(const FeatureMatrix& image_features)
 void VocabularyTree::constructVocabulary(const FeatureMatrix& features,
                                          const std::vector<unsigned int>& input)
 {
-  root_ = newNode();
-  constructVocabularyAux(features, input, root_, 0);
+  NodePool pool; // for fast node allocation
+  Node* root = newNode(pool);
+  constructVocabularyAux(features, input, root, pool, 0);
+  flatten(root);
 }
 
 // TODO: input can be partitioned (sorted?) in place, passed as iterator range
 void VocabularyTree::constructVocabularyAux(const FeatureMatrix& features,
                                             const std::vector<unsigned int>& input,
-                                            Node* node, unsigned int level)
+                                            Node* node, NodePool& pool,
+                                            unsigned int level)
 {
   if (level >= levels_ || input.size() == 0)
     return; // leaf node
@@ -144,7 +219,7 @@ void VocabularyTree::constructVocabularyAux(const FeatureMatrix& features,
   node->children.resize(num_clusters);
   for(int i = 0; i < num_clusters; ++i)
   {
-    node->children[i] = newNode();
+    node->children[i] = newNode(pool);
 #ifdef USE_BYTE_SIGNATURES
     uint8_t** child_centroid = &node->children[i]->centroid;
     posix_memalign(reinterpret_cast<void**>(child_centroid), 16, dim_);
@@ -153,45 +228,52 @@ void VocabularyTree::constructVocabularyAux(const FeatureMatrix& features,
 #else
     node->children[i]->centroid.set( centroids.row(i) );
 #endif
-    constructVocabularyAux(features, children_input[i], node->children[i], level);
+    constructVocabularyAux(features, children_input[i], node->children[i], pool, level);
   }
 }
 
+// The children's centroids are contiguous, so this is a scan through
+// numChildren(node) * dim_ consecutive elements.
 #ifdef USE_BYTE_SIGNATURES
-VocabularyTree::Node*
-VocabularyTree::findNearestChild(Node* node, const uint8_t* feature)
+unsigned int VocabularyTree::findNearestChild(unsigned int node, const uint8_t* feature)
 {
-  Node* nearest = NULL;
+  unsigned int nearest = 0;
   int d_min = std::numeric_limits<int>::max();
-  for (std::vector<Node*>::iterator i = node->children.begin(),
-         ie = node->children.end(); i != ie; ++i) {
-    int distance = features::L2Distance(dim_, feature, (*i)->centroid);
+  const uint8_t* c = centroid(first_child_[node]);
+  for (unsigned int i = first_child_[node], ie = first_child_[node + 1];
+       i != ie; ++i, c += dim_) {
+    int distance = features::L2Distance(dim_, feature, c);
     if (distance < d_min) {
-      nearest = *i;
+      nearest = i;
       d_min = distance;
     }
   }
   return nearest;
 }
 #else
-VocabularyTree::Node*
-VocabularyTree::findNearestChild(Node* node, const FeatureMatrix::RowXpr& feature)
+unsigned int VocabularyTree::findNearestChild(unsigned int node,
+                                              const FeatureMatrix::RowXpr& feature)
 {
-  Node* nearest = NULL;
+  unsigned int nearest = 0;
   float d_min = std::numeric_limits<float>::max();
-  for (std::vector<Node*>::iterator i = node->children.begin(),
-         ie = node->children.end(); i != ie; ++i) {
-    float distance = distanceL2(feature.transpose(), (*i)->centroid);
+  for (unsigned int i = first_child_[node], ie = first_child_[node + 1];
+       i != ie; ++i) {
+    float distance = 0.0f;
+    const float* c = centroid(i);
+    for (unsigned int j = 0; j < dim_; ++j) {
+      float diff = feature(j) - c[j];
+      distance += diff * diff;
+    }
     if (distance < d_min) {
-      nearest = *i;
+      nearest = i;
       d_min = distance;
     }
   }
   // TODO: debugging code, remove
   /*
-  if (nearest == NULL) {
-    printf("ERROR: findNearestChild returning NULL\n");
-    if (node->children.empty())
+  if (nearest == 0) {
+    printf("ERROR: findNearestChild returning root\n");
+    if (isLeaf(node))
       printf("node->children is empty\n");
     else
       printf("node->children is not empty\n");
@@ -204,7 +286,7 @@ VocabularyTree::findNearestChild(Node* node, const FeatureMatrix::RowXpr& featur
 // TODO: next 3 functions basically the same, would be nice to abstract
 //       this a bit
 #ifdef USE_BYTE_SIGNATURES
-void VocabularyTree::addFeature(Node* node, unsigned int object_id,
+void VocabularyTree::addFeature(unsigned int node, unsigned int object_id,
                                 const FeatureMatrix::RowXpr& feature)
 {
   // Quantize feature
@@ -214,82 +296,83 @@ void VocabularyTree::addFeature(Node* node, unsigned int object_id,
   posix_memalign(reinterpret_cast<void**>(&qf), 16, dim_);
   features::RandomizedTree::quantizeVector(f, dim_, QUANTIZE_N, bounds_, qf);
   addFeature(node, object_id, qf);
+  free(qf);
 }
 
-void VocabularyTree::addFeature(Node* node, unsigned int object_id,
+void VocabularyTree::addFeature(unsigned int node, unsigned int object_id,
                                 const uint8_t* feature)
 {
-  if ( node->children.empty() ) {
+  if ( isLeaf(node) ) {
     // leaf node: increment entry for obj in inverted file
-    node->inverted_file[object_id]++;
+    invertedFile(node)[object_id]++;
   }
   else {
-    Node* nearest = findNearestChild(node, feature);
+    unsigned int nearest = findNearestChild(node, feature);
     addFeature(nearest, object_id, feature);
   }
 }
 #else
-void VocabularyTree::addFeature(Node* node, unsigned int object_id,
+void VocabularyTree::addFeature(unsigned int node, unsigned int object_id,
                                 const FeatureMatrix::RowXpr& feature)
 {
-  if ( node->children.empty() ) {
+  if ( isLeaf(node) ) {
     // leaf node: increment entry for obj in inverted file
-    node->inverted_file[object_id]++;
+    invertedFile(node)[object_id]++;
   }
   else {
-    Node* nearest = findNearestChild(node, feature);
+    unsigned int nearest = findNearestChild(node, feature);
     addFeature(nearest, object_id, feature);
   }
 }
 #endif
 
 #ifdef USE_BYTE_SIGNATURES
-void VocabularyTree::addFeatureToQuery(Node* node, ImageVector& vec,
+void VocabularyTree::addFeatureToQuery(unsigned int node, ImageVector& vec,
                                        const uint8_t* feature)
 {
-  if (node->weight > 0.0f)
-    vec[node] += node->weight;
-  if ( !node->children.empty() ) {
-    Node* nearest = findNearestChild(node, feature);
+  if (weights_[node] > 0.0f)
+    vec[node] += weights_[node];
+  if ( !isLeaf(node) ) {
+    unsigned int nearest = findNearestChild(node, feature);
     addFeatureToQuery(nearest, vec, feature);
   }
 }
 
-void VocabularyTree::addFeatureToDatabaseVector(Node* node, unsigned int object_id,
+void VocabularyTree::addFeatureToDatabaseVector(unsigned int node, unsigned int object_id,
                                                 const uint8_t* feature)
 {
-  if (node->weight > 0.0f)
-    db_vectors_[object_id][node] += node->weight;
-  if ( node->children.empty() ) {
-    node->inverted_file[object_id]++;
+  if (weights_[node] > 0.0f)
+    db_vectors_[object_id][node] += weights_[node];
+  if ( isLeaf(node) ) {
+    invertedFile(node)[object_id]++;
   }
   else {
-    Node* nearest = findNearestChild(node, feature);
+    unsigned int nearest = findNearestChild(node, feature);
     addFeatureToDatabaseVector(nearest, object_id, feature);
   }
 }
 #else
-void VocabularyTree::addFeatureToQuery(Node* node, ImageVector& vec,
+void VocabularyTree::addFeatureToQuery(unsigned int node, ImageVector& vec,
                                        const FeatureMatrix::RowXpr& feature)
 {
-  if (node->weight > 0.0f)
-    vec[node] += node->weight;
-  if ( !node->children.empty() ) {
-    Node* nearest = findNearestChild(node, feature);
+  if (weights_[node] > 0.0f)
+    vec[node] += weights_[node];
+  if ( !isLeaf(node) ) {
+    unsigned int nearest = findNearestChild(node, feature);
     addFeatureToQuery(nearest, vec, feature);
   }
 }
 
-void VocabularyTree::addFeatureToDatabaseVector(Node* node, unsigned int object_id,
+void VocabularyTree::addFeatureToDatabaseVector(unsigned int node, unsigned int object_id,
                                                 const FeatureMatrix::RowXpr& feature)
 {
-  if (node->weight > 0.0f)
-    db_vectors_[object_id][node] += node->weight;
-  if ( node->children.empty() ) {
-    node->inverted_file[object_id]++;
+  if (weights_[node] > 0.0f)
+    db_vectors_[object_id][node] += weights_[node];
+  if ( isLeaf(node) ) {
+    invertedFile(node)[object_id]++;
   }
   else {
-    Node* nearest = findNearestChild(node, feature);
+    unsigned int nearest = findNearestChild(node, feature);
     addFeatureToDatabaseVector(nearest, object_id, feature);
   }
 }
@@ -297,24 +380,25 @@ void VocabularyTree::addFeatureToDatabaseVector(Node* node, unsigned int object_
 
 // TODO: could perhaps be optimized more, restructured
 // TODO: block longer lists?
-void VocabularyTree::recursiveTfIdfWeighting(Node* node, IdOutputIterator output)
+// Only called on built trees, whose weights are writable
+void VocabularyTree::recursiveTfIdfWeighting(unsigned int node, IdOutputIterator output)
 {
-  if ( node->children.empty() )
+  if ( isLeaf(node) )
   {
-    node->weight = tfIdfWeight(node->inverted_file.size());
+    InvertedFile& file = invertedFile(node);
+    weight_storage_[node] = tfIdfWeight(file.size());
 
     // pass object ids to parent
-    for (InvertedFile::iterator i = node->inverted_file.begin(),
-           ie = node->inverted_file.end(); i != ie; ++i)
+    for (InvertedFile::iterator i = file.begin(), ie = file.end(); i != ie; ++i)
       *output = i->first;
   }
   else
   {
     // recursively build id set
     std::vector<unsigned int> id_set, child_id_set, union_id_set;
-    for (std::vector<Node*>::iterator i = node->children.begin(),
-           ie = node->children.end(); i != ie; ++i) {
-      recursiveTfIdfWeighting(*i, std::back_inserter(child_id_set));
+    for (unsigned int i = first_child_[node], ie = first_child_[node + 1];
+         i != ie; ++i) {
+      recursiveTfIdfWeighting(i, std::back_inserter(child_id_set));
       std::set_union(id_set.begin(), id_set.end(),
                      child_id_set.begin(), child_id_set.end(),
                      std::back_inserter(union_id_set));
@@ -323,10 +407,10 @@ void VocabularyTree::recursiveTfIdfWeighting(Node* node, IdOutputIterator output
       union_id_set.resize(0);
     }
     
-    node->weight = tfIdfWeight(id_set.size());
+    weight_storage_[node] = tfIdfWeight(id_set.size());
     
     // pass object ids to parent
-    if (node != root_)
+    if (node != 0)
       std::copy(id_set.begin(), id_set.end(), output);
   }
 }
@@ -334,34 +418,36 @@ void VocabularyTree::recursiveTfIdfWeighting(Node* node, IdOutputIterator output
 void VocabularyTree::assignWeights()
 {
   std::vector<unsigned int> dummy;
-  recursiveTfIdfWeighting(root_, std::back_inserter(dummy));
+  recursiveTfIdfWeighting(0, std::back_inserter(dummy));
 }
 
-void VocabularyTree::updateFiles(Node* node, InvertedFile& file, InvertedFile& parent_file)
+void VocabularyTree::updateFiles(unsigned int node, InvertedFile& file,
+                                 InvertedFile& parent_file)
 {
-  if (node->weight == 0.0f) return;
+  float weight = weights_[node];
+  if (weight == 0.0f) return;
   for (InvertedFile::iterator i = file.begin(), ie = file.end(); i != ie; ++i) {
     unsigned int id = i->first;
     unsigned int frequency = i->second;
     parent_file[id] += frequency;
-    db_vectors_[id][node] += node->weight * frequency;
+    db_vectors_[id][node] += weight * frequency;
   }
 }
 
 // TODO: somewhat wasteful of memory
-void VocabularyTree::calculateDatabaseVectorsAux(Node* node,
+void VocabularyTree::calculateDatabaseVectorsAux(unsigned int node,
                                                  InvertedFile& parent_file)
 {
-  if ( node->children.empty() )
+  if ( isLeaf(node) )
   {
-    updateFiles(node, node->inverted_file, parent_file);
+    updateFiles(node, invertedFile(node), parent_file);
   }
   else
   {
     InvertedFile virtual_file;
-    for (std::vector<Node*>::iterator i = node->children.begin(),
-           ie = node->children.end(); i != ie; ++i) {
-      calculateDatabaseVectorsAux(*i, virtual_file);
+    for (unsigned int i = first_child_[node], ie = first_child_[node + 1];
+         i != ie; ++i) {
+      calculateDatabaseVectorsAux(i, virtual_file);
     }
     updateFiles(node, virtual_file, parent_file);
   }
@@ -370,7 +456,7 @@ void VocabularyTree::calculateDatabaseVectorsAux(Node* node,
 void VocabularyTree::calculateDatabaseVectors()
 {
   InvertedFile dummy;
-  calculateDatabaseVectorsAux(root_, dummy);
+  calculateDatabaseVectorsAux(0, dummy);
 
   BOOST_FOREACH( ImageVector& vec, db_vectors_ ) {
     normalizeL1(vec);
@@ -379,34 +465,36 @@ void VocabularyTree::calculateDatabaseVectors()
 
 // TODO: fix indentation, ugh
 // TODO: change to uint8_t centroids, don't bother saying centroid size
-void VocabularyTree::saveAux(Node* node, FILE* out, std::string indentation)
+void VocabularyTree::saveAux(unsigned int node, FILE* out, std::string indentation)
 {
-  if (node == root_)
+  if (node == 0)
     fprintf(out, "%sCentroid[0]: \n", indentation.c_str());
   else {
     fprintf(out, "%sCentroid[%d]: ", indentation.c_str(), dim_);
+    const Centroid* c = centroid(node);
     for (unsigned int i = 0; i < dim_; ++i) {
 #ifdef USE_BYTE_SIGNATURES
-      fprintf(out, "%u ", node->centroid[i]);
+      fprintf(out, "%u ", c[i]);
 #else
-      fprintf(out, "%f ", node->centroid[i]);
+      fprintf(out, "%f ", c[i]);
 #endif
     }
     fprintf(out, "\n");
   }
 
-  fprintf(out, "%sWeight: %f\n", indentation.c_str(), node->weight);
-  
-  fprintf(out, "%sInverted file[%u]: ", indentation.c_str(), node->inverted_file.size());
-  for (InvertedFile::iterator i = node->inverted_file.begin(),
-         ie = node->inverted_file.end(); i != ie; ++i)
+  fprintf(out, "%sWeight: %f\n", indentation.c_str(), weights_[node]);
+
+  static const InvertedFile empty_file;
+  const InvertedFile& file = inverted_files_.empty() ? empty_file : inverted_files_[node];
+  fprintf(out, "%sInverted file[%u]: ", indentation.c_str(), file.size());
+  for (InvertedFile::const_iterator i = file.begin(), ie = file.end(); i != ie; ++i)
     fprintf(out, "(%u,%u) ", i->first, i->second);
   fprintf(out, "\n");
   
-  fprintf(out, "%sChildren: %u\n", indentation.c_str(), node->children.size());
+  fprintf(out, "%sChildren: %u\n", indentation.c_str(), numChildren(node));
   //indentation += "    ";
-  BOOST_FOREACH( Node* child, node->children )
-    saveAux(child, out, indentation);
+  for (unsigned int i = first_child_[node], ie = first_child_[node + 1]; i != ie; ++i)
+    saveAux(i, out, indentation);
 }
 
 void VocabularyTree::save(const std::string& file)
@@ -416,10 +504,77 @@ void VocabularyTree::save(const std::string& file)
   fprintf(out, "Levels: %u\n", levels_);
   fprintf(out, "Dimension: %u\n", dim_);
   fprintf(out, "Database images: %u\n", db_vectors_.size());
-  saveAux(root_, out);
+  saveAux(0, out);
+  fclose(out);
 }
 
-void VocabularyTree::loadAux(Node* node, FILE* in, unsigned int indent_level)
+static void writeAt(FILE* out, boost::uint64_t offset, const void* data, size_t size)
+{
+  fseek(out, offset, SEEK_SET);
+  fwrite(data, 1, size, out);
+}
+
+void VocabularyTree::saveBinary(const std::string& file)
+{
+  BinaryHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+  header.version = BINARY_VERSION;
+  header.centroid_size = sizeof(Centroid);
+  header.k = k_;
+  header.levels = levels_;
+  header.dim = dim_;
+  header.num_nodes = num_nodes_;
+  header.database_images = db_vectors_.size();
+  header.bounds[0] = bounds_[0];
+  header.bounds[1] = bounds_[1];
+
+  header.first_child_offset = sizeof(BinaryHeader);
+  header.weights_offset = header.first_child_offset + (num_nodes_ + 1) * sizeof(boost::uint32_t);
+  header.centroids_offset = (header.weights_offset + num_nodes_ * sizeof(float) + 15) & ~15ULL;
+  header.database_offset = header.centroids_offset + num_nodes_ * dim_ * sizeof(Centroid);
+  header.file_size = header.database_offset;
+
+  // Inverted files as offsets + (id, frequency) pairs
+  std::vector<boost::uint32_t> file_begin, entries;
+  if (header.database_images > 0) {
+    file_begin.resize(num_nodes_ + 1, 0);
+    for (unsigned int i = 0; i < num_nodes_; ++i) {
+      file_begin[i] = entries.size() / 2;
+      if (inverted_files_.empty())
+        continue;
+      for (InvertedFile::iterator j = inverted_files_[i].begin(),
+             je = inverted_files_[i].end(); j != je; ++j) {
+        entries.push_back(j->first);
+        entries.push_back(j->second);
+      }
+    }
+    file_begin[num_nodes_] = entries.size() / 2;
+    header.file_size += (file_begin.size() + entries.size()) * sizeof(boost::uint32_t);
+  }
+
+  FILE* out = fopen(file.c_str(), "wb");
+  if (out == NULL) {
+    printf("Unable to open %s for writing!\n", file.c_str());
+    return;
+  }
+  writeAt(out, 0, &header, sizeof(header));
+  writeAt(out, header.first_child_offset, first_child_, (num_nodes_ + 1) * sizeof(boost::uint32_t));
+  writeAt(out, header.weights_offset, weights_, num_nodes_ * sizeof(float));
+  // zero padding up to the centroids
+  static const char zeros[16] = {0};
+  size_t pad = header.centroids_offset - (header.weights_offset + num_nodes_ * sizeof(float));
+  fwrite(zeros, 1, pad, out);
+  writeAt(out, header.centroids_offset, centroids_, num_nodes_ * dim_ * sizeof(Centroid));
+  if (!file_begin.empty()) {
+    writeAt(out, header.database_offset, &file_begin[0], file_begin.size() * sizeof(boost::uint32_t));
+    if (!entries.empty())
+      fwrite(&entries[0], sizeof(boost::uint32_t), entries.size(), out);
+  }
+  fclose(out);
+}
+
+void VocabularyTree::loadAux(Node* node, NodePool& pool, FILE* in, unsigned int indent_level)
 {
   int centroid_size = 0;
   //fseek(in, indentation, SEEK_CUR);
@@ -461,38 +616,119 @@ void VocabularyTree::loadAux(Node* node, FILE* in, unsigned int indent_level)
   fscanf(in, "Children: %u\n", &num_children);
   node->children.reserve(num_children);
   for (unsigned int i = 0; i < num_children; ++i) {
-    Node* child = newNode();
+    Node* child = newNode(pool);
     node->children.push_back(child);
-    loadAux(child, in, indent_level + 1);
+    loadAux(child, pool, in, indent_level + 1);
   }
 }
 
-void VocabularyTree::load(const std::string& file)
+void VocabularyTree::loadText(FILE* in)
 {
   unsigned int db_size;
-  FILE* in = fopen(file.c_str(), "r");
   fscanf(in, "Branching factor: %u\n", &k_);
   fscanf(in, "Levels: %u\n", &levels_);
   fscanf(in, "Dimension: %u\n", &dim_);
   fscanf(in, "Database images: %u\n", &db_size);
-  root_ = newNode();
-  loadAux(root_, in);
+  {
+    NodePool pool;
+    Node* root = newNode(pool);
+    loadAux(root, pool, in);
+    flatten(root);
+  }
+  db_vectors_.clear();
   if (db_size > 0) {
     db_vectors_.resize(db_size);
     calculateDatabaseVectors();
   }
 }
 
+// Maps the file read-only; the vocabulary is used in place. Only the
+// inverted files of a saved database are copied out.
+void VocabularyTree::loadBinary(const std::string& file)
+{
+  int fd = open(file.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    printf("Unable to open %s!\n", file.c_str());
+    abort();
+  }
+  size_t size = st.st_size;
+  void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    printf("Unable to map %s!\n", file.c_str());
+    abort();
+  }
+  
+  const BinaryHeader& header = *static_cast<const BinaryHeader*>(mapping);
+  if (size < sizeof(BinaryHeader) || header.version != BINARY_VERSION ||
+      header.centroid_size != sizeof(Centroid) || header.file_size != size) {
+    printf("%s is not a vocabulary tree of this version and signature type!\n",
+           file.c_str());
+    abort();
+  }
+
+  releaseVocabulary();
+  db_vectors_.clear();
+  mapping_ = mapping;
+  mapping_size_ = size;
+  
+  const char* base = static_cast<const char*>(mapping);
+  k_ = header.k;
+  levels_ = header.levels;
+  dim_ = header.dim;
+  bounds_[0] = header.bounds[0];
+  bounds_[1] = header.bounds[1];
+  num_nodes_ = header.num_nodes;
+  first_child_ = reinterpret_cast<const boost::uint32_t*>(base + header.first_child_offset);
+  weights_ = reinterpret_cast<const float*>(base + header.weights_offset);
+  centroids_ = reinterpret_cast<const Centroid*>(base + header.centroids_offset);
+
+  if (header.database_images > 0) {
+    const boost::uint32_t* file_begin =
+      reinterpret_cast<const boost::uint32_t*>(base + header.database_offset);
+    const boost::uint32_t* entries = file_begin + num_nodes_ + 1;
+    inverted_files_.resize(num_nodes_);
+    for (unsigned int i = 0; i < num_nodes_; ++i) {
+      for (boost::uint32_t j = file_begin[i]; j < file_begin[i + 1]; ++j)
+        inverted_files_[i].insert(inverted_files_[i].end(),
+                                  InvertedFile::value_type(entries[2*j], entries[2*j + 1]));
+    }
+    db_vectors_.resize(header.database_images);
+    calculateDatabaseVectors();
+  }
+}
+
+void VocabularyTree::load(const std::string& file)
+{
+  FILE* in = fopen(file.c_str(), "rb");
+  if (in == NULL) {
+    printf("Unable to open %s!\n", file.c_str());
+    abort();
+  }
+  char magic[sizeof(BINARY_MAGIC)] = {0};
+  size_t read = fread(magic, 1, sizeof(magic), in);
+  if (read == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
+    fclose(in);
+    loadBinary(file);
+  }
+  else {
+    rewind(in);
+    loadText(in);
+    fclose(in);
+  }
+}
+
 boost::uint64_t VocabularyTree::findWord(const uint8_t* feature)
 {
-  return findWordAux(root_, feature);
+  return findWordAux(0, feature);
 }
 
-boost::uint64_t VocabularyTree::findWordAux(Node* node, const uint8_t* feature)
+unsigned int VocabularyTree::findWordAux(unsigned int node, const uint8_t* feature)
 {
-  if ( node->children.empty() )
-    return reinterpret_cast<boost::uint64_t>(node);
-  Node* nearest = findNearestChild(node, feature);
+  if ( isLeaf(node) )
+    return node;
+  unsigned int nearest = findNearestChild(node, feature);
   return findWordAux(nearest, feature);
 }
 
@@ -0,0 +1,213 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "place_recognition/vocabulary_tree.h"
+#include "calonder_descriptor/randomized_tree.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace vision;
+
+static const unsigned int DIM = 32;
+static const unsigned int NUM_IMAGES = 20;
+static const unsigned int FEATURES_PER_IMAGE = 50;
+
+// Random features around a handful of cluster centers, so kmeans has
+// something to find
+static void makeFeatures(FeatureMatrix& features, std::vector<unsigned int>& objs)
+{
+  srand(0);
+  FeatureMatrix centers(8, (int)DIM);
+  for (int i = 0; i < centers.rows(); ++i)
+    for (unsigned int j = 0; j < DIM; ++j)
+      centers(i, j) = rand() / (float)RAND_MAX;
+
+  features.resize(NUM_IMAGES * FEATURES_PER_IMAGE, DIM);
+  objs.resize(features.rows());
+  for (int i = 0; i < features.rows(); ++i) {
+    int c = rand() % centers.rows();
+    for (unsigned int j = 0; j < DIM; ++j)
+      features(i, j) = centers(c, j) + 0.1f * (rand() / (float)RAND_MAX - 0.5f);
+    objs[i] = i / FEATURES_PER_IMAGE;
+  }
+}
+
+// Features quantized the way the tree expects for find() and insert()
+static std::vector<uint8_t> quantize(const VocabularyTree& tree, const FeatureMatrix& features)
+{
+  std::vector<uint8_t> quantized(features.rows() * DIM);
+  float bounds[2] = { tree.bounds_[0], tree.bounds_[1] };
+  std::vector<float> row(DIM);
+  for (int i = 0; i < features.rows(); ++i) {
+    for (unsigned int j = 0; j < DIM; ++j)
+      row[j] = features(i, j);
+    features::RandomizedTree::quantizeVector(&row[0], DIM, VocabularyTree::QUANTIZE_N,
+                                             bounds, &quantized[i * DIM]);
+  }
+  return quantized;
+}
+
+static std::string tempFile(const char* name)
+{
+  std::ostringstream ss;
+  ss << "/tmp/" << name << "_" << getpid();
+  return ss.str();
+}
+
+static std::string readFile(const std::string& file)
+{
+  std::ifstream in(file.c_str());
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+static void expectSameVocabulary(const VocabularyTree& a, const VocabularyTree& b)
+{
+  EXPECT_EQ(a.k_, b.k_);
+  EXPECT_EQ(a.levels_, b.levels_);
+  ASSERT_EQ(a.dim_, b.dim_);
+  EXPECT_EQ(a.bounds_[0], b.bounds_[0]);
+  EXPECT_EQ(a.bounds_[1], b.bounds_[1]);
+  ASSERT_EQ(a.num_nodes_, b.num_nodes_);
+  EXPECT_EQ(0, memcmp(a.first_child_, b.first_child_,
+                      (a.num_nodes_ + 1) * sizeof(boost::uint32_t)));
+  EXPECT_EQ(0, memcmp(a.weights_, b.weights_, a.num_nodes_ * sizeof(float)));
+  EXPECT_EQ(0, memcmp(a.centroids_, b.centroids_,
+                      a.num_nodes_ * a.dim_ * sizeof(VocabularyTree::Centroid)));
+}
+
+static void expectSameMatches(VocabularyTree& a, VocabularyTree& b, const std::vector<uint8_t>& query)
+{
+  for (unsigned int i = 0; i < NUM_IMAGES; ++i) {
+    std::vector<VocabularyTree::Match> ma, mb;
+    a.find(&query[i * FEATURES_PER_IMAGE * DIM], FEATURES_PER_IMAGE, 5, std::back_inserter(ma));
+    b.find(&query[i * FEATURES_PER_IMAGE * DIM], FEATURES_PER_IMAGE, 5, std::back_inserter(mb));
+    ASSERT_EQ(ma.size(), mb.size());
+    for (unsigned int j = 0; j < ma.size(); ++j) {
+      EXPECT_EQ(ma[j].id, mb[j].id);
+      EXPECT_EQ(ma[j].score, mb[j].score);
+    }
+  }
+}
+
+// A tree with its database saved in the binary format and mapped back in
+// is the same tree, and saves to the same files
+TEST(VocabularyTree, BinaryRoundTrip)
+{
+  FeatureMatrix features;
+  std::vector<unsigned int> objs;
+  makeFeatures(features, objs);
+
+  VocabularyTree tree;
+  tree.build(features, objs, 4, 3);
+  ASSERT_GT(tree.num_nodes_, 1u);
+  ASSERT_EQ(NUM_IMAGES, tree.databaseSize());
+
+  std::string binary = tempFile("voctree_bin"), binary2 = tempFile("voctree_bin2");
+  std::string text = tempFile("voctree_txt"), text2 = tempFile("voctree_txt2");
+  tree.saveBinary(binary);
+
+  VocabularyTree loaded;
+  loaded.load(binary);
+  EXPECT_TRUE(loaded.mapping_ != NULL);
+  EXPECT_EQ(NUM_IMAGES, loaded.databaseSize());
+  expectSameVocabulary(tree, loaded);
+
+  std::vector<uint8_t> query = quantize(tree, features);
+  for (int i = 0; i < features.rows(); ++i)
+    EXPECT_EQ(tree.findWord(&query[i * DIM]), loaded.findWord(&query[i * DIM]));
+  expectSameMatches(tree, loaded, query);
+
+  // the database (inverted files) survives too
+  tree.save(text);
+  loaded.save(text2);
+  EXPECT_EQ(readFile(text), readFile(text2));
+  loaded.saveBinary(binary2);
+  EXPECT_EQ(readFile(binary), readFile(binary2));
+
+  unlink(binary.c_str());
+  unlink(binary2.c_str());
+  unlink(text.c_str());
+  unlink(text2.c_str());
+}
+
+// A mapped tree saved without a database can be filled in place, the same
+// as the tree it was saved from
+TEST(VocabularyTree, BinaryRoundTripEmptyDatabase)
+{
+  FeatureMatrix features;
+  std::vector<unsigned int> objs;
+  makeFeatures(features, objs);
+
+  VocabularyTree tree;
+  tree.build(features, objs, 4, 3, false);
+  ASSERT_EQ(0u, tree.databaseSize());
+
+  std::string binary = tempFile("voctree_empty");
+  tree.saveBinary(binary);
+
+  VocabularyTree loaded;
+  loaded.load(binary);
+  EXPECT_TRUE(loaded.mapping_ != NULL);
+  EXPECT_EQ(0u, loaded.databaseSize());
+  EXPECT_TRUE(loaded.inverted_files_.empty());
+  expectSameVocabulary(tree, loaded);
+
+  std::vector<uint8_t> query = quantize(tree, features);
+  for (unsigned int i = 0; i < NUM_IMAGES; ++i) {
+    EXPECT_EQ(i, tree.insert(&query[i * FEATURES_PER_IMAGE * DIM], FEATURES_PER_IMAGE));
+    EXPECT_EQ(i, loaded.insert(&query[i * FEATURES_PER_IMAGE * DIM], FEATURES_PER_IMAGE));
+  }
+  expectSameMatches(tree, loaded, query);
+
+  // loading over a mapped tree replaces the mapping
+  loaded.load(binary);
+  EXPECT_EQ(0u, loaded.databaseSize());
+  expectSameVocabulary(tree, loaded);
+
+  unlink(binary.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
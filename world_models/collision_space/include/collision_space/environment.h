@@ -39,6 +39,7 @@
 
 #include "collision_space/environment_objects.h"
 #include <planning_models/kinematic_model.h>
+#include <planning_models/kinematic_transforms.h>
 #include <geometric_shapes/bodies.h>
 #include <LinearMath/btVector3.h>
 #include <boost/thread/mutex.hpp>
@@ -135,6 +136,14 @@ namespace collision_space
 	/** \brief Update the positions of the geometry used in collision detection */
 	virtual void updateRobotModel(void) = 0;
 
+	/** \brief Update the positions of the geometry used in collision
+	    detection from transforms computed outside the robot
+	    model. The transforms must be computed for the same robot
+	    model this environment uses. Since the robot model is
+	    only read, multiple environments (e.g., clones used by
+	    different threads) can do this concurrently. */
+	virtual void updateRobotModel(const planning_models::KinematicTransforms &transforms) = 0;
+
 	/** \brief Update the set of bodies that are attached to the robot (re-creates them) */
 	virtual void updateAttachedBodies(void) = 0;
 		
@@ -99,6 +99,9 @@ namespace collision_space
 	/** \brief Update the positions of the geometry used in collision detection */
 	virtual void updateRobotModel(void);
 
+	/** \brief Update the positions of the geometry used in collision detection from transforms computed outside the robot model */
+	virtual void updateRobotModel(const planning_models::KinematicTransforms &transforms);
+
 	/** \brief Update the set of bodies that are attached to the robot (re-creates them) */
 	virtual void updateAttachedBodies(void);
 
@@ -35,6 +35,7 @@
 /** \author Ioan Sucan */
 
 #include "collision_space/environmentBullet.h"
+#include <algorithm>
 
 void collision_space::EnvironmentModelBullet::freeMemory(void)
 {
@@ -214,6 +215,19 @@ void collision_space::EnvironmentModelBullet::updateRobotModel(void)
     }
 }
 
+void collision_space::EnvironmentModelBullet::updateRobotModel(const planning_models::KinematicTransforms &transforms)
+{ 
+    const unsigned int n = m_modelGeom.linkGeom.size();
+    for (unsigned int i = 0 ; i < n ; ++i)
+    {
+	const planning_models::KinematicModel::Link *link = m_modelGeom.linkGeom[i]->link;
+	m_modelGeom.linkGeom[i]->geom[0]->setWorldTransform(transforms.getLinkTransform(link));
+	const unsigned int nab = std::min<unsigned int>(m_modelGeom.linkGeom[i]->geom.size() - 1, transforms.getAttachedBodyCount(link));
+	for (unsigned int k = 0 ; k < nab ; ++k)
+	    m_modelGeom.linkGeom[i]->geom[k + 1]->setWorldTransform(transforms.getAttachedBodyTransform(link, k));
+    }
+}
+
 bool collision_space::EnvironmentModelBullet::isCollision(void)
 {   
     m_world->getPairCache()->setOverlapFilterCallback(&m_genericCollisionFilterCallback);
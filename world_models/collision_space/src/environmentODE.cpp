@@ -293,6 +293,20 @@ void collision_space::EnvironmentModelODE::updateRobotModel(void)
     }    
 }
 
+void collision_space::EnvironmentModelODE::updateRobotModel(const planning_models::KinematicTransforms &transforms)
+{ 
+    const unsigned int n = m_modelGeom.linkGeom.size();
+    
+    for (unsigned int i = 0 ; i < n ; ++i)
+    {
+	const planning_models::KinematicModel::Link *link = m_modelGeom.linkGeom[i]->link;
+	updateGeom(m_modelGeom.linkGeom[i]->geom[0], transforms.getLinkTransform(link));
+	const unsigned int nab = std::min<unsigned int>(m_modelGeom.linkGeom[i]->geom.size() - 1, transforms.getAttachedBodyCount(link));
+	for (unsigned int k = 0 ; k < nab ; ++k)
+	    updateGeom(m_modelGeom.linkGeom[i]->geom[k + 1], transforms.getAttachedBodyTransform(link, k));
+    }    
+}
+
 bool collision_space::EnvironmentModelODE::ODECollide2::empty(void) const
 {
     return m_geomsX.empty();